@@ -0,0 +1,39 @@
+/**
+ * @file camera_calibration.h
+ * @brief Measured image scale of the pan and tilt axes.
+ */
+#pragma once
+
+#include <stdint.h>
+
+/**
+ * @struct CameraCalibration
+ * @brief How far the image moves per actuator unit, as measured by the Calibrator.
+ * @details Replaces the scale implied by the nominal lens field of view with values
+ * measured on the assembled turret: gear ratio, lens and mounting included. Both
+ * scales are positive. A target @p e pixels right of centre is centred by turning
+ * e / pan_px_per_step steps right, and likewise for tilt. The scales are linear in
+ * resolution, so a calibration taken at one frame size carries over to others.
+ */
+struct CameraCalibration {
+    uint16_t frame_width = 0;        /**< Frame width the scales were measured at. */
+    uint16_t frame_height = 0;       /**< Frame height the scales were measured at. */
+    float pan_px_per_step = 0.0f;    /**< Horizontal image shift per pan step. */
+    float tilt_px_per_degree = 0.0f; /**< Vertical image shift per servo degree. */
+
+    /** @return true if both scales were measured. */
+    bool is_valid() const
+    {
+        return this->frame_width > 0 && this->frame_height > 0 && this->pan_px_per_step > 0.0f &&
+               this->tilt_px_per_degree > 0.0f;
+    }
+
+    /** @return pan_px_per_step rescaled to a frame @p width pixels wide. */
+    float pan_px_per_step_at(uint16_t width) const { return this->pan_px_per_step * width / this->frame_width; }
+
+    /** @return tilt_px_per_degree rescaled to a frame @p height pixels tall. */
+    float tilt_px_per_degree_at(uint16_t height) const
+    {
+        return this->tilt_px_per_degree * height / this->frame_height;
+    }
+};
@@ -9,10 +9,16 @@
 
 // --- Servo Config ---
 #define SERVO_PIN 15
+#define CENTIDEGREES_PER_DEGREE 100 /**< Tilt is passed around in centidegrees, finer than one pulse microsecond. */
 
 // --- Stepper Config ---
 #define STEPPER_NUMBER_OF_STEPS 2048
 #define STEPPER_PIN1 13
 #define STEPPER_PIN2 33
 #define STEPPER_PIN3 5
-#define STEPPER_PIN4 18
\ No newline at end of file
+#define STEPPER_PIN4 18
+
+// --- Camera Optics ---
+#define CAMERA_HFOV_DEG 53          /**< Horizontal field of view of the stock OV2640 lens. */
+#define CAMERA_VFOV_DEG 41          /**< Vertical field of view of the stock OV2640 lens. */
+#define CAMERA_DISTORTION_K1 -0.12f /**< Radial barrel term of the stock lens, r_d = r_u * (1 + k1 * r_u^2). */
@@ -0,0 +1,95 @@
+/**
+ * @file detection_result.h
+ * @brief Rich per-frame detection output shared by detection and motion modules.
+ * @details Replaces the bare Left/Right/None, Up/Down/None contract with the
+ * information a proportional controller needs: how far off-centre the target is,
+ * how sure the detector is, where the target is, and when the frame was captured.
+ */
+#pragma once
+
+#include <stdint.h>
+#include <sys/time.h>
+#include <tuple>
+
+#include "move_types.h"
+
+#define DETECTION_SUBPIXEL_BITS 4       /**< error_x/error_y carry 1/16 pixel resolution (Q4). */
+#define DETECTION_DIRECTION_ERROR_PX 16 /**< Nominal error assumed for a bare direction without magnitude. */
+
+/**
+ * @struct BoundingBox
+ * @brief Axis-aligned box in frame pixel coordinates.
+ */
+struct BoundingBox {
+    uint16_t x = 0;      /**< Left column. */
+    uint16_t y = 0;      /**< Top row. */
+    uint16_t width = 0;  /**< Width in pixels (0 when empty). */
+    uint16_t height = 0; /**< Height in pixels (0 when empty). */
+};
+
+/**
+ * @struct DetectionResult
+ * @brief Where the target is relative to the frame centre, and how reliable that is.
+ */
+struct DetectionResult {
+    int16_t error_x = 0;       /**< Target centre minus frame centre, Q4 pixels; positive = right. */
+    int16_t error_y = 0;       /**< Target centre minus frame centre, Q4 pixels; positive = down (image rows). */
+    uint8_t confidence = 0;    /**< 0 = no target, 255 = certain. */
+    BoundingBox box;           /**< Extent of the target in the frame. */
+    uint16_t frame_width = 0;  /**< Width of the analysed frame in pixels. */
+    uint16_t frame_height = 0; /**< Height of the analysed frame in pixels. */
+    int64_t timestamp_us = 0;  /**< Capture time of the frame (camera_fb_t::timestamp), microseconds. */
+
+    /** @return true if a target was found in the frame. */
+    bool has_target() const { return this->confidence > 0; }
+
+    /**
+     * @brief Collapses the result to the legacy direction tuple.
+     * @param deadzone_px Error (whole pixels) around the centre that maps to None.
+     */
+    std::tuple<MoveDirectionX, MoveDirectionY> to_directions(int deadzone_px) const
+    {
+        if (!has_target())
+        {
+            return std::make_tuple(MoveDirectionX::None, MoveDirectionY::None);
+        }
+
+        int deadzone = deadzone_px << DETECTION_SUBPIXEL_BITS;
+
+        MoveDirectionX x_axis_movement = (this->error_x > deadzone)    ? MoveDirectionX::Right
+                                         : (this->error_x < -deadzone) ? MoveDirectionX::Left
+                                                                       : MoveDirectionX::None;
+
+        // Image rows grow downwards, so a target above the centre means tilting up
+        MoveDirectionY y_axis_movement = (this->error_y < -deadzone)  ? MoveDirectionY::Up
+                                         : (this->error_y > deadzone) ? MoveDirectionY::Down
+                                                                      : MoveDirectionY::None;
+
+        return std::make_tuple(x_axis_movement, y_axis_movement);
+    }
+
+    /**
+     * @brief Builds a result from a legacy direction tuple.
+     * @details The tuple has no magnitude, so each active axis reports
+     * DETECTION_DIRECTION_ERROR_PX in its direction.
+     */
+    static DetectionResult from_directions(const std::tuple<MoveDirectionX, MoveDirectionY>& directions)
+    {
+        DetectionResult result;
+        const int16_t nominal = DETECTION_DIRECTION_ERROR_PX << DETECTION_SUBPIXEL_BITS;
+
+        MoveDirectionX x = std::get<0>(directions);
+        MoveDirectionY y = std::get<1>(directions);
+
+        result.error_x = (x == MoveDirectionX::Right) ? nominal : (x == MoveDirectionX::Left) ? -nominal : 0;
+        result.error_y = (y == MoveDirectionY::Down) ? nominal : (y == MoveDirectionY::Up) ? -nominal : 0;
+        result.confidence = (!x && !y) ? 0 : 255;
+        return result;
+    }
+
+    /** @brief Converts a camera_fb_t timestamp to microseconds. */
+    static int64_t timeval_to_us(const struct timeval& time)
+    {
+        return (int64_t)time.tv_sec * 1000000LL + time.tv_usec;
+    }
+};
@@ -0,0 +1,246 @@
+/**
+ * @file latency_probe.h
+ * @brief Scoped timing probes that feed per-stage log2 latency histograms.
+ * @details Build with -D LATENCY_PROBES=1 to record; without it every
+ * LATENCY_PROBE() compiles to nothing and the report says so.
+ */
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include <atomic>
+
+#include <esp_timer.h>
+
+#include "trace.h"
+
+#ifndef LATENCY_PROBES
+#define LATENCY_PROBES 0 /**< 1 to compile the probes in. */
+#endif
+
+#define LATENCY_BUCKETS 24      /**< Bucket b > 0 holds [2^(b-1), 2^b) µs; the last one everything above 4 s. */
+#define LATENCY_REPORT_SIZE 512 /**< Buffer that holds a full latency_report(). */
+
+/**
+ * @enum LatencyStage
+ * @brief The tracker stages that carry a probe.
+ */
+enum class LatencyStage : uint8_t {
+    Capture = 0,   /**< Waiting for the camera driver to hand over a frame. */
+    Decode = 1,    /**< JPEG to RGB565. */
+    Greyscale = 2, /**< RGB565 to the luma plane. */
+    Kernel = 3,    /**< Differencing kernel over all row bands. */
+    Centroid = 4,  /**< Moments to a DetectionResult. */
+    Control = 5,   /**< Lens lookup, PID and the move command. */
+    Actuation = 6, /**< Handing a move to the stepper and servo drivers. */
+    Count = 7
+};
+
+static_assert((int)TraceId::Capture == (int)LatencyStage::Capture &&
+                  (int)TraceId::Actuation == (int)LatencyStage::Actuation,
+              "Trace ids 0-6 mirror LatencyStage");
+
+/** @return Short label for @p stage, as printed in reports. */
+inline const char* latency_stage_name(LatencyStage stage)
+{
+    static const char* const names[] = {"capture", "decode", "greyscale", "kernel", "centroid", "control", "actuation"};
+    return (size_t)stage < (size_t)LatencyStage::Count ? names[(size_t)stage] : "?";
+}
+
+/**
+ * @class LatencyHistogram
+ * @brief Lock-free histogram of durations in power-of-two buckets.
+ * @details record() is a few relaxed atomic operations, so any task or core can
+ * record without a lock and without disturbing what it measures. Percentiles are
+ * estimated by interpolating inside the bucket, so they are accurate to within a
+ * factor of two at worst, which is what a "where do the milliseconds go" view needs.
+ * Readers see a consistent enough snapshot, not an exact one, while writers run.
+ */
+class LatencyHistogram
+{
+private:
+    std::atomic<uint32_t> _buckets[LATENCY_BUCKETS];
+    std::atomic<uint32_t> _count;
+    std::atomic<uint32_t> _min_us;
+    std::atomic<uint32_t> _max_us;
+
+public:
+    LatencyHistogram() { reset(); }
+
+    LatencyHistogram(const LatencyHistogram&) = delete;
+    LatencyHistogram& operator=(const LatencyHistogram&) = delete;
+
+    /** @return Bucket that @p us falls in. */
+    static size_t bucket_of(uint32_t us)
+    {
+        size_t bucket = us ? (size_t)(32 - __builtin_clz(us)) : 0;
+        return bucket < LATENCY_BUCKETS ? bucket : LATENCY_BUCKETS - 1;
+    }
+
+    /** @return Smallest duration bucket @p bucket holds. */
+    static uint32_t bucket_floor(size_t bucket) { return bucket ? (uint32_t)1 << (bucket - 1) : 0; }
+
+    /** @brief Adds one sample. */
+    void record(uint32_t us)
+    {
+        this->_buckets[bucket_of(us)].fetch_add(1, std::memory_order_relaxed);
+        this->_count.fetch_add(1, std::memory_order_relaxed);
+
+        uint32_t seen = this->_min_us.load(std::memory_order_relaxed);
+        while (us < seen && !this->_min_us.compare_exchange_weak(seen, us, std::memory_order_relaxed))
+        {
+        }
+        seen = this->_max_us.load(std::memory_order_relaxed);
+        while (us > seen && !this->_max_us.compare_exchange_weak(seen, us, std::memory_order_relaxed))
+        {
+        }
+    }
+
+    /** @brief Forgets every sample. Not atomic with respect to concurrent record(). */
+    void reset()
+    {
+        for (std::atomic<uint32_t>& bucket : this->_buckets)
+        {
+            bucket.store(0, std::memory_order_relaxed);
+        }
+        this->_count.store(0, std::memory_order_relaxed);
+        this->_min_us.store(UINT32_MAX, std::memory_order_relaxed);
+        this->_max_us.store(0, std::memory_order_relaxed);
+    }
+
+    /** @return Samples recorded. */
+    uint32_t count() const { return this->_count.load(std::memory_order_relaxed); }
+
+    /** @return Shortest sample, 0 without samples. */
+    uint32_t min_us() const { return count() ? this->_min_us.load(std::memory_order_relaxed) : 0; }
+
+    /** @return Longest sample. */
+    uint32_t max_us() const { return this->_max_us.load(std::memory_order_relaxed); }
+
+    /**
+     * @brief Estimates the duration below which @p percent of the samples fall.
+     * @param percent 0 to 100.
+     * @return The estimate, clamped to [min_us(), max_us()]; 0 without samples.
+     */
+    uint32_t percentile_us(uint32_t percent) const
+    {
+        uint32_t counts[LATENCY_BUCKETS];
+        uint32_t total = 0;
+        for (size_t b = 0; b < LATENCY_BUCKETS; b++)
+        {
+            counts[b] = this->_buckets[b].load(std::memory_order_relaxed);
+            total += counts[b];
+        }
+        if (total == 0)
+        {
+            return 0;
+        }
+
+        // Rank of the wanted sample, 1-based, then walk up to the bucket holding it
+        uint32_t rank = (uint32_t)(((uint64_t)total * percent + 99) / 100);
+        rank = rank ? rank : 1;
+        uint32_t below = 0;
+        size_t bucket = 0;
+        while (bucket < LATENCY_BUCKETS - 1 && below + counts[bucket] < rank)
+        {
+            below += counts[bucket++];
+        }
+
+        // Spread the bucket's samples evenly over its range
+        uint32_t floor = bucket_floor(bucket);
+        uint32_t width = bucket ? floor : 1;
+        uint32_t in_bucket = counts[bucket] ? counts[bucket] : 1;
+        uint32_t estimate = floor + (uint32_t)((uint64_t)width * (rank - below) / in_bucket);
+
+        uint32_t lowest = min_us();
+        uint32_t highest = max_us();
+        return estimate < lowest ? lowest : (estimate > highest ? highest : estimate);
+    }
+};
+
+/** @return The histogram of @p stage; one per stage for the whole program. */
+inline LatencyHistogram& latency_histogram(LatencyStage stage)
+{
+    static LatencyHistogram histograms[(size_t)LatencyStage::Count];
+    return histograms[(size_t)stage < (size_t)LatencyStage::Count ? (size_t)stage : 0];
+}
+
+/** @brief Clears every stage's histogram, e.g. to measure one scenario. */
+inline void latency_reset()
+{
+    for (size_t stage = 0; stage < (size_t)LatencyStage::Count; stage++)
+    {
+        latency_histogram((LatencyStage)stage).reset();
+    }
+}
+
+/**
+ * @brief Writes one line per stage with its count, min, p50, p99 and max in µs.
+ * @param buffer Destination; always NUL-terminated when @p size > 0.
+ * @param size Capacity of @p buffer.
+ * @return Characters written, without the terminator.
+ */
+inline size_t latency_report(char* buffer, size_t size)
+{
+    if (!buffer || size == 0)
+    {
+        return 0;
+    }
+
+    int written = LATENCY_PROBES ? snprintf(buffer, size, "%-10s %8s %8s %8s %8s %8s\n", "stage", "count", "min",
+                                            "p50", "p99", "max")
+                                 : snprintf(buffer, size, "latency probes disabled, build with -D LATENCY_PROBES=1\n");
+    size_t used = written > 0 ? ((size_t)written < size ? (size_t)written : size - 1) : 0;
+
+    for (size_t stage = 0; LATENCY_PROBES && stage < (size_t)LatencyStage::Count && used < size - 1; stage++)
+    {
+        const LatencyHistogram& histogram = latency_histogram((LatencyStage)stage);
+        written = snprintf(buffer + used, size - used, "%-10s %8u %8u %8u %8u %8u\n",
+                           latency_stage_name((LatencyStage)stage), (unsigned)histogram.count(),
+                           (unsigned)histogram.min_us(), (unsigned)histogram.percentile_us(50),
+                           (unsigned)histogram.percentile_us(99), (unsigned)histogram.max_us());
+        used += written > 0 ? ((size_t)written < size - used ? (size_t)written : size - used - 1) : 0;
+    }
+
+    return used;
+}
+
+/**
+ * @class LatencyScope
+ * @brief Records the lifetime of the enclosing scope into a stage's histogram.
+ * @details Use through LATENCY_PROBE() so it disappears when probes are disabled.
+ * With TRACE_EVENTS, each measurement also goes on the timeline as a slice.
+ */
+class LatencyScope
+{
+private:
+    LatencyStage _stage;
+    int64_t _start_us;
+
+public:
+    explicit LatencyScope(LatencyStage stage) : _stage(stage), _start_us(esp_timer_get_time()) {}
+
+    ~LatencyScope()
+    {
+        uint32_t duration = (uint32_t)(esp_timer_get_time() - this->_start_us);
+        latency_histogram(this->_stage).record(duration);
+#if TRACE_EVENTS
+        trace_record((TraceId)this->_stage, TracePhase::Complete, (uint32_t)this->_start_us, duration, 0);
+#endif
+    }
+
+    LatencyScope(const LatencyScope&) = delete;
+    LatencyScope& operator=(const LatencyScope&) = delete;
+};
+
+#define LATENCY_CONCAT_INNER(a, b) a##b
+#define LATENCY_CONCAT(a, b) LATENCY_CONCAT_INNER(a, b)
+
+#if LATENCY_PROBES
+/** @brief Times the rest of the enclosing scope as LatencyStage::@p stage. */
+#define LATENCY_PROBE(stage) LatencyScope LATENCY_CONCAT(_latency_probe_, __LINE__)(LatencyStage::stage)
+#else
+#define LATENCY_PROBE(stage) ((void)0)
+#endif
@@ -0,0 +1,294 @@
+/**
+ * @file trace.h
+ * @brief Per-core binary event trace, for looking at task timing on a timeline.
+ * @details Build with -D TRACE_EVENTS=1 to record; without it every TRACE_*()
+ * macro compiles to nothing. A dump converts to Chrome trace JSON with
+ * src/tools/trace_to_chrome.py, for chrome://tracing or ui.perfetto.dev.
+ */
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <atomic>
+
+#include <esp_timer.h>
+#include <freertos/FreeRTOS.h>
+
+#ifndef TRACE_EVENTS
+#define TRACE_EVENTS 0 /**< 1 to compile the trace points in. */
+#endif
+
+#define TRACE_CORES 2               /**< ESP32 cores; each has its own ring. */
+#define TRACE_RING_SIZE 512         /**< Events kept per core, a power of two; 10 KB of DRAM per ring. */
+#define TRACE_DUMP_MAGIC 0x31435254 /**< "TRC1" as the first bytes of a dump. */
+#define TRACE_DUMP_VERSION 1
+#define TRACE_DUMP_CHUNK 32 /**< Events trace_dump() hands to the writer at once. */
+
+/**
+ * @enum TracePhase
+ * @brief How the viewer draws an event.
+ */
+enum class TracePhase : uint8_t {
+    Complete = 0, /**< A slice: timestamp is the start, arg0 the duration in µs. */
+    Instant = 1,  /**< A point in time. */
+    Counter = 2   /**< A value over time: arg0. */
+};
+
+/**
+ * @enum TraceId
+ * @brief What an event stands for. Keep src/tools/trace_to_chrome.py in step.
+ */
+enum class TraceId : uint16_t {
+    Capture = 0,           /**< 0-6 mirror LatencyStage; every LATENCY_PROBE() emits its slice. */
+    Decode = 1,            /**< See LatencyStage. */
+    Greyscale = 2,         /**< See LatencyStage. */
+    Kernel = 3,            /**< See LatencyStage. */
+    Centroid = 4,          /**< See LatencyStage. */
+    Control = 5,           /**< See LatencyStage. */
+    Actuation = 6,         /**< See LatencyStage. */
+    LoopIteration = 16,    /**< One Controller::run(); arg1: detection divider. */
+    LoopDeadlineMiss = 17, /**< Instant; arg0: iteration time, arg1: budget, in µs. */
+    Detect = 18,           /**< One detector call. */
+    FramePublish = 32,     /**< FrameBroker hands a frame out; arg1: subscribers. */
+    FrameDropped = 33,     /**< Instant; a subscriber had not collected the previous frame. arg0: slot. */
+    StreamFrame = 34,      /**< One MJPEG part sent to a stream client; arg1: bytes. */
+    FramesInUse = 35,      /**< Counter; camera buffers held through FrameRef after a publish. */
+    WifiCheck = 48         /**< Instant from WifiManager::maintain(); arg0: 1 if connected. */
+};
+
+/**
+ * @struct TraceEvent
+ * @brief One decoded event; also the 16-byte little-endian record of a dump.
+ */
+struct TraceEvent {
+    uint32_t timestamp_us = 0; /**< Low 32 bits of esp_timer_get_time(). */
+    uint16_t id = 0;           /**< TraceId. */
+    uint8_t phase = 0;         /**< TracePhase. */
+    uint8_t core = 0;          /**< Core that recorded it. */
+    uint32_t arg0 = 0;         /**< Meaning depends on id and phase. */
+    uint32_t arg1 = 0;         /**< Meaning depends on id. */
+};
+
+static_assert(sizeof(TraceEvent) == 16, "TraceEvent is the dump record");
+
+/**
+ * @struct TraceDumpHeader
+ * @brief Starts a dump; TraceEvent records follow until the end of the stream.
+ */
+struct TraceDumpHeader {
+    uint32_t magic = TRACE_DUMP_MAGIC;
+    uint16_t version = TRACE_DUMP_VERSION;
+    uint16_t event_size = sizeof(TraceEvent);
+    uint32_t ring_size = TRACE_RING_SIZE;
+    uint32_t overwritten = 0; /**< Events lost to wrap-around before the dump. */
+    uint64_t now_us = 0;      /**< esp_timer_get_time() at the dump, to unwrap the 32-bit timestamps. */
+};
+
+/** @brief Sends part of a dump; returns false to abort it. */
+typedef bool (*TraceWriter)(const void* data, size_t size, void* arg);
+
+/**
+ * @class TraceRing
+ * @brief Fixed ring of events for one core, written without locks.
+ * @details A writer claims a slot with one atomic increment, so tasks and ISRs that
+ * preempt each other on the core never wait. Every slot carries a sequence number,
+ * written last: a reader that finds it changed while copying drops the event
+ * instead of reporting a torn one. The oldest events are overwritten when full.
+ */
+class TraceRing
+{
+private:
+    struct Slot {
+        std::atomic<uint32_t> sequence; ///< Claim index + 1 once written, 0 while being written.
+        std::atomic<uint32_t> words[4]; ///< Timestamp, id/phase/core, arg0, arg1.
+    };
+
+    std::atomic<uint32_t> _head; ///< Slots ever claimed.
+    Slot _slots[TRACE_RING_SIZE];
+
+public:
+    TraceRing() { clear(); }
+
+    TraceRing(const TraceRing&) = delete;
+    TraceRing& operator=(const TraceRing&) = delete;
+
+    /** @brief Appends @p event, overwriting the oldest once full. */
+    void record(const TraceEvent& event)
+    {
+        uint32_t index = this->_head.fetch_add(1, std::memory_order_relaxed);
+        Slot& slot = this->_slots[index & (TRACE_RING_SIZE - 1)];
+
+        slot.sequence.store(0, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        slot.words[0].store(event.timestamp_us, std::memory_order_relaxed);
+        slot.words[1].store(event.id | ((uint32_t)event.phase << 16) | ((uint32_t)event.core << 24),
+                            std::memory_order_relaxed);
+        slot.words[2].store(event.arg0, std::memory_order_relaxed);
+        slot.words[3].store(event.arg1, std::memory_order_relaxed);
+        slot.sequence.store(index + 1, std::memory_order_release);
+    }
+
+    /**
+     * @brief Copies the event claimed as @p index.
+     * @return false if it is still being written or has been overwritten since.
+     */
+    bool read(uint32_t index, TraceEvent& event) const
+    {
+        const Slot& slot = this->_slots[index & (TRACE_RING_SIZE - 1)];
+        if (slot.sequence.load(std::memory_order_acquire) != index + 1)
+        {
+            return false;
+        }
+
+        uint32_t header = slot.words[1].load(std::memory_order_relaxed);
+        event.timestamp_us = slot.words[0].load(std::memory_order_relaxed);
+        event.id = (uint16_t)header;
+        event.phase = (uint8_t)(header >> 16);
+        event.core = (uint8_t)(header >> 24);
+        event.arg0 = slot.words[2].load(std::memory_order_relaxed);
+        event.arg1 = slot.words[3].load(std::memory_order_relaxed);
+
+        std::atomic_thread_fence(std::memory_order_acquire);
+        return slot.sequence.load(std::memory_order_relaxed) == index + 1;
+    }
+
+    /** @return Events ever recorded; the ring holds the last TRACE_RING_SIZE of them. */
+    uint32_t head() const { return this->_head.load(std::memory_order_acquire); }
+
+    /** @brief Forgets every event. Not safe against concurrent record(). */
+    void clear()
+    {
+        this->_head.store(0, std::memory_order_relaxed);
+        for (Slot& slot : this->_slots)
+        {
+            slot.sequence.store(0, std::memory_order_relaxed);
+        }
+    }
+};
+
+/** @return The ring of @p core; one per core for the whole program. */
+inline TraceRing& trace_ring(size_t core)
+{
+    static TraceRing rings[TRACE_CORES];
+    return rings[core < TRACE_CORES ? core : 0];
+}
+
+/** @brief Records an event on the calling core's ring. */
+inline void trace_record(TraceId id, TracePhase phase, uint32_t timestamp_us, uint32_t arg0, uint32_t arg1)
+{
+    TraceEvent event;
+    event.timestamp_us = timestamp_us;
+    event.id = (uint16_t)id;
+    event.phase = (uint8_t)phase;
+    event.core = (uint8_t)xPortGetCoreID();
+    event.arg0 = arg0;
+    event.arg1 = arg1;
+    trace_ring(event.core).record(event);
+}
+
+/** @brief Forgets every core's events. Not safe against concurrent recording. */
+inline void trace_clear()
+{
+    for (size_t core = 0; core < TRACE_CORES; core++)
+    {
+        trace_ring(core).clear();
+    }
+}
+
+/**
+ * @brief Streams a TraceDumpHeader and then every event still held, core by core.
+ * @details Recording carries on meanwhile: events claimed after the dump started are
+ * left out, and events overwritten while it runs are dropped rather than sent torn.
+ * @param write Receives the bytes in pieces of at most TRACE_DUMP_CHUNK events.
+ * @param arg Passed to @p write.
+ * @return Events written, not counting the header.
+ */
+inline size_t trace_dump(TraceWriter write, void* arg)
+{
+    uint32_t heads[TRACE_CORES];
+    TraceDumpHeader header;
+    header.now_us = (uint64_t)esp_timer_get_time();
+    for (size_t core = 0; core < TRACE_CORES; core++)
+    {
+        heads[core] = trace_ring(core).head();
+        header.overwritten += heads[core] > TRACE_RING_SIZE ? heads[core] - TRACE_RING_SIZE : 0;
+    }
+    if (!write(&header, sizeof(header), arg))
+    {
+        return 0;
+    }
+
+    TraceEvent chunk[TRACE_DUMP_CHUNK];
+    size_t used = 0;
+    size_t written = 0;
+    for (size_t core = 0; core < TRACE_CORES; core++)
+    {
+        const TraceRing& ring = trace_ring(core);
+        for (uint32_t index = heads[core] > TRACE_RING_SIZE ? heads[core] - TRACE_RING_SIZE : 0;
+             index != heads[core]; index++)
+        {
+            if (!ring.read(index, chunk[used]))
+            {
+                continue;
+            }
+            if (++used == TRACE_DUMP_CHUNK)
+            {
+                if (!write(chunk, sizeof(chunk), arg))
+                {
+                    return written;
+                }
+                written += used;
+                used = 0;
+            }
+        }
+    }
+    if (used && write(chunk, used * sizeof(TraceEvent), arg))
+    {
+        written += used;
+    }
+    return written;
+}
+
+/**
+ * @class TraceScope
+ * @brief Records the enclosing scope as one Complete event when it closes.
+ * @details Use through TRACE_SCOPE() so it disappears when tracing is disabled.
+ */
+class TraceScope
+{
+private:
+    TraceId _id;
+    uint32_t _arg;
+    int64_t _start_us;
+
+public:
+    TraceScope(TraceId id, uint32_t arg) : _id(id), _arg(arg), _start_us(esp_timer_get_time()) {}
+
+    ~TraceScope()
+    {
+        uint32_t duration = (uint32_t)(esp_timer_get_time() - this->_start_us);
+        trace_record(this->_id, TracePhase::Complete, (uint32_t)this->_start_us, duration, this->_arg);
+    }
+
+    TraceScope(const TraceScope&) = delete;
+    TraceScope& operator=(const TraceScope&) = delete;
+};
+
+#define TRACE_CONCAT_INNER(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_INNER(a, b)
+
+#if TRACE_EVENTS
+/** @brief Records the rest of the enclosing scope as a TraceId::@p id slice carrying @p arg. */
+#define TRACE_SCOPE(id, arg) TraceScope TRACE_CONCAT(_trace_scope_, __LINE__)(TraceId::id, (uint32_t)(arg))
+/** @brief Records a TraceId::@p id point in time with two arguments. */
+#define TRACE_INSTANT(id, arg0, arg1)                                                                                  \
+    trace_record(TraceId::id, TracePhase::Instant, (uint32_t)esp_timer_get_time(), (uint32_t)(arg0), (uint32_t)(arg1))
+/** @brief Records the value of the TraceId::@p id counter. */
+#define TRACE_COUNTER(id, value)                                                                                       \
+    trace_record(TraceId::id, TracePhase::Counter, (uint32_t)esp_timer_get_time(), (uint32_t)(value), 0)
+#else
+#define TRACE_SCOPE(id, arg) ((void)0)
+#define TRACE_INSTANT(id, arg0, arg1) ((void)0)
+#define TRACE_COUNTER(id, value) ((void)0)
+#endif
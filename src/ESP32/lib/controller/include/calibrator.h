@@ -0,0 +1,92 @@
+/**
+ * @file calibrator.h
+ * @brief Measures the pixel scale of both axes by moving the turret and watching the image.
+ */
+#pragma once
+
+#include <stdint.h>
+
+#include "base_movement_manager.h"
+#include "camera.h"
+#include "camera_calibration.h"
+#include "frame_arena.h"
+#include "frame_context.h"
+#include "global_motion.h"
+
+#define CALIBRATION_PAN_STEPS 48         /**< Pan probe: about 8 degrees, under a sixth of the field of view. */
+#define CALIBRATION_TILT_DEGREES 6       /**< Tilt probe: about a seventh of the field of view. */
+#define CALIBRATION_SETTLE_MS 300        /**< Wait after arriving, for the servo horn and mount to stop ringing. */
+#define CALIBRATION_MOVE_TIMEOUT_MS 3000 /**< Give up on a probe move that never arrives. */
+#define CALIBRATION_SEARCH_MARGIN 2      /**< Search up to this multiple of the shift the nominal lens predicts. */
+
+/**
+ * @class Calibrator
+ * @brief Blocking routine that measures pixels per pan step and per tilt degree.
+ * @details Each axis is probed twice: out by a known amount and back to where it
+ * started. Every move is measured against a frame captured just before it, with the
+ * GlobalMotionEstimator, and the two measurements are averaged so backlash and a
+ * slightly different arrival point cancel out. The scene moves opposite to the
+ * camera, so panning right must shift the image left and tilting up must shift it
+ * down; anything else means a mis-wired axis and fails the calibration.
+ *
+ * The scene must be static and textured while this runs. It drives the movement
+ * manager directly and blocks for a few seconds, so run it from setup() or another
+ * context where nothing else is moving the turret.
+ */
+class Calibrator
+{
+private:
+    BaseMovementManager& _movement_manager;
+    Camera& _camera;
+
+    FrameArena _frame_arena;          ///< Backing storage for the greyscale planes.
+    FrameContext _frame_context;      ///< Current frame being measured.
+    GlobalMotionEstimator _estimator; ///< Compares each frame with the one before the move.
+    uint16_t _frame_width;            ///< Width of the last captured frame.
+    uint16_t _frame_height;           ///< Height of the last captured frame.
+
+    /**
+     * @brief Captures a fresh frame into _frame_context.
+     * @details The driver may hold a frame taken while moving, so one is discarded first.
+     * @return Its luma plane, or nullptr if capture failed.
+     */
+    const uint8_t* _capture();
+
+    /**
+     * @brief Moves to an absolute pose and waits until it has settled.
+     * @return false if the pan axis did not arrive in time.
+     */
+    bool _move_and_settle(int32_t pan_steps, int32_t tilt_centidegrees);
+
+    /**
+     * @brief Measures the image shift of one move.
+     * @param pan_steps Target pan position.
+     * @param tilt_centidegrees Target tilt angle in centidegrees.
+     * @param max_shift Search range in pixels.
+     * @param shift Receives the measured shift.
+     * @return false if the move, the capture or the estimate failed.
+     */
+    bool _measure(int32_t pan_steps, int32_t tilt_centidegrees, int32_t max_shift, GlobalShift& shift);
+
+public:
+    /**
+     * @brief Construct a new Calibrator.
+     * @param movement_manager Motors to probe with.
+     * @param camera Running camera looking at a static scene.
+     */
+    Calibrator(BaseMovementManager& movement_manager, Camera& camera)
+        : _movement_manager(movement_manager), _camera(camera), _frame_context(_frame_arena), _frame_width(0),
+          _frame_height(0)
+    {
+    }
+
+    Calibrator(const Calibrator&) = delete;
+    Calibrator& operator=(const Calibrator&) = delete;
+
+    /**
+     * @brief Probes both axes and returns the turret to where it started.
+     * @param calibration Receives the measured scales; left unchanged on failure.
+     * @return true if both axes were measured with a plausible sign.
+     */
+    bool run(CameraCalibration& calibration);
+};
@@ -9,13 +9,30 @@
 
 #include "base_detection_module.h"
 #include "base_movement_manager.h"
+#include "camera.h"
+#include "camera_calibration.h"
+#include "expo_curve.h"
+#include "frame_context.h"
 #include "joystick.h"
+#include "loop_budget.h"
 #include "move_types.h"
+#include "pid_controller.h"
+#include "pid_profiles.h"
+#include "pixel_angle_lut.h"
 #include "system_control_types.h"
 #include <cstdint>
 #include <stdlib.h>
 #include <tuple>
 
+#define MANUAL_PAN_MIN_RATE 8     /**< Steps/s just past the deadzone: about 1.4 degrees/s for fine aiming. */
+#define MANUAL_PAN_MAX_RATE 400   /**< Steps/s at full deflection: STEPPER_DEFAULT_MAX_SPEED, about 70 degrees/s. */
+#define MANUAL_TILT_MIN_RATE 200  /**< Centidegrees/s just past the deadzone: 2 degrees/s. */
+#define MANUAL_TILT_MAX_RATE 9000 /**< Centidegrees/s at full deflection: 90 degrees/s. */
+#define MANUAL_EXPO_PERCENT 70    /**< Mostly cubic: the first half of the travel stays below a quarter of the speed. */
+
+/** @brief Optional work, e.g. telemetry; run() gives it spare time, a TrackingPipeline its actuation gaps. */
+typedef void (*LoopWork)(void* arg);
+
 /**
  * @class Controller
  * @brief Handles logic for object detection and movement calculations.
@@ -39,6 +56,39 @@ private:
     /** @brief Reference to the physical or virtual joystick input handler. */
     Joystick& _joystick;
 
+    /** @brief Frame source for AI mode; without one the detector runs on an empty context. */
+    Camera* _camera;
+
+    FrameArena _frame_arena;     ///< Backing storage for per-frame representations.
+    FrameContext _frame_context; ///< Cache shared by every stage that looks at the current frame.
+
+    PidController _pan_pid;         ///< Pixel error (Q4) -> stepper steps.
+    PidController _tilt_pid;        ///< Pixel error (Q4) -> servo centidegrees.
+    uint16_t _pid_frame_width;      ///< Frame width the active PID profile was selected for.
+    CameraCalibration _calibration; ///< Measured pixel scale; the nominal profiles are used while invalid.
+
+    PixelAngleLut _lens_lut;        ///< Detector coordinates -> angle offsets for the active frame size.
+    int32_t _pan_px_per_degree_q8;  ///< Average scale the pan gains assume, Q8.
+    int32_t _tilt_px_per_degree_q8; ///< Average scale the tilt gains assume, Q8.
+
+    ExpoCurve _pan_curve;  ///< X deflection -> pan steps per second in USER mode.
+    ExpoCurve _tilt_curve; ///< Y deflection -> tilt centidegrees per second in USER mode.
+    bool _slewing;         ///< The last manual command had a non-zero rate.
+
+    LoopBudget _budget;       ///< Decides what each run() iteration has time for.
+    LoopWork _optional_work;  ///< Deferred first when run() is over budget; may be null.
+    void* _optional_work_arg; ///< Passed to _optional_work.
+
+    /** @brief AI mode: captures a frame and runs the detector on it. */
+    DetectionResult _detect_target();
+
+    /**
+     * @brief Sends manual slew rates while any is non-zero, and once more to stop.
+     * @details Repeated every poll while slewing, so a movement manager without
+     * speed control still moves one nudge per poll.
+     */
+    void _command_rates(int32_t pan_steps_per_s, int32_t tilt_centidegrees_per_s);
+
 public:
     /**
      * @brief Construct a new Controller object.
@@ -47,9 +97,17 @@ public:
      * @param detection_module Reference to an implementation of
      * BaseDetectionModule.
      * @param joystick Reference to the Joystick input handler.
+     * @param camera Optional frame source for AI mode.
      */
-    Controller(BaseMovementManager& movement_manager, BaseDetectionModule& detection_module, Joystick& joystick)
-        : _movement_manager(movement_manager), _detection_module(detection_module), _joystick(joystick)
+    Controller(BaseMovementManager& movement_manager, BaseDetectionModule& detection_module, Joystick& joystick,
+               Camera* camera = nullptr)
+        : _movement_manager(movement_manager), _detection_module(detection_module), _joystick(joystick),
+          _camera(camera), _frame_context(_frame_arena), _pan_pid(pid_profile_for_frame(0).pan),
+          _tilt_pid(pid_profile_for_frame(0).tilt), _pid_frame_width(0), _pan_px_per_degree_q8(0),
+          _tilt_px_per_degree_q8(0),
+          _pan_curve{MANUAL_PAN_MIN_RATE, MANUAL_PAN_MAX_RATE, MANUAL_EXPO_PERCENT, JOYSTICK_DEADZONE},
+          _tilt_curve{MANUAL_TILT_MIN_RATE, MANUAL_TILT_MAX_RATE, MANUAL_EXPO_PERCENT, JOYSTICK_DEADZONE},
+          _slewing(false), _optional_work(nullptr), _optional_work_arg(nullptr)
     {
         this->_system_control_state = SystemControl::AI_MODE;
     }
@@ -60,11 +118,87 @@ public:
      */
     ~Controller() {}
 
+    /**
+     * @brief Uses a measured pixel scale for the tracking gains from the next detection on.
+     * @param calibration Result of a Calibrator run; an invalid one restores the nominal profiles.
+     */
+    void set_calibration(const CameraCalibration& calibration)
+    {
+        this->_calibration = calibration;
+        this->_lens_lut.clear();
+    }
+
+    /**
+     * @brief Replaces the stick response used in USER mode.
+     * @param pan X deflection to pan steps per second.
+     * @param tilt Y deflection to tilt centidegrees per second.
+     */
+    void set_manual_curves(const ExpoCurve& pan, const ExpoCurve& tilt)
+    {
+        this->_pan_curve = pan;
+        this->_tilt_curve = tilt;
+    }
+
+    /**
+     * @brief Registers work that may be postponed whenever run() is short of time.
+     * @param work Called from run() in an iteration that has room for it; nullptr removes it.
+     * @param arg Passed to @p work.
+     */
+    void set_optional_work(LoopWork work, void* arg)
+    {
+        this->_optional_work = work;
+        this->_optional_work_arg = arg;
+    }
+
     /**
      * @brief Main execution loop for the turret system.
      * @details When called, this method polls the detection module for targets
      * and the joystick for user input. It calculates the necessary PWM or
      * step values and updates the movement manager state.
+     *
+     * Iterations are paced by a LoopBudget to one every LOOP_BUDGET_US: run() sleeps
+     * off what is left of its period, so a loop() that calls it back to back polls the
+     * joystick at a steady 20 Hz. Over budget, the optional work waits for a quieter
+     * iteration first, then detection, and the control update that acts on it, runs
+     * only every few iterations; the joystick is polled in every one.
      */
     void run();
+
+    /**
+     * @brief One run() iteration without the pacing sleep.
+     * @details For callers that keep their own schedule, such as a simulator stepping
+     * virtual time per camera frame.
+     */
+    void run_once();
+
+    /** @return Loop period, deadline misses and what the budget has shed so far. */
+    LoopStats loop_stats() const { return this->_budget.stats(); }
+
+    /**
+     * @brief Handles the joystick: the mode toggle, and manual slewing in USER mode.
+     * @details In USER mode each axis' deflection goes through its ExpoCurve to a rate
+     * for BaseMovementManager::move_velocity(), so a small deflection aims slowly and a
+     * full one slews fast; the motors run in the background and this never waits for
+     * them. Leaving USER mode stops the slew.
+     *
+     * run() calls this first. A TrackingPipeline calls it from its actuation task
+     * instead, so the joystick and the tracker share one producer of the movement manager.
+     */
+    void poll_input();
+
+    /**
+     * @brief Closes the loop on one detection with PID; ignored in USER mode.
+     * @details The detector coordinate is first run through the lens lookup table, so a
+     * target near the frame edge is not over-aimed by barrel distortion. The corrected
+     * error becomes step counts and servo centidegrees in one move, instead of a fixed
+     * increment per frame. The move is aimed from the pose the turret had when the
+     * frame was captured, looked up in the movement manager's pose history, so the
+     * result is an absolute target and corrections still in flight are not applied
+     * again. Losing the target resets both loops.
+     * @param target Detector output, from run() or from a TrackingPipeline.
+     */
+    void track(const DetectionResult& target);
+
+    /** @return The active control mode. */
+    SystemControl mode() const { return this->_system_control_state; }
 };
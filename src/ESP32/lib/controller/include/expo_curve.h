@@ -0,0 +1,35 @@
+/**
+ * @file expo_curve.h
+ * @brief Joystick deflection to motor rate, with an RC-style exponential response.
+ */
+#pragma once
+
+#include <stdint.h>
+
+#define EXPO_INPUT_RANGE 2048 /**< Full deflection as reported by Joystick::get_x()/get_y(). */
+#define EXPO_SHIFT 15         /**< Normalised deflection is Q15: 32768 == full deflection. */
+
+/**
+ * @struct ExpoCurve
+ * @brief Maps a joystick deflection to a signed rate.
+ * @details The deflection past the deadzone is normalised to x in [0, 1] and shaped as
+ *
+ *   y = (1 - e) x + e x^3,  e = expo_percent / 100
+ *
+ * then scaled to [min_rate, max_rate]. With expo the first part of the travel is
+ * flattened for fine aiming, while full deflection still reaches max_rate for fast
+ * slews. Inside the deadzone the rate is 0. Integer only.
+ */
+struct ExpoCurve {
+    int32_t min_rate;     /**< Rate just past the deadzone, > 0 so the stick always moves the turret. */
+    int32_t max_rate;     /**< Rate at full deflection. */
+    uint8_t expo_percent; /**< 0 is linear, 100 a pure cubic. */
+    int32_t deadzone;     /**< |deflection| below this gives 0; Joystick already reports 0 there. */
+
+    /**
+     * @brief Shapes @p deflection into a rate.
+     * @param deflection Joystick::get_x() or get_y(), about +-EXPO_INPUT_RANGE.
+     * @return Rate with the sign of @p deflection; 0 inside the deadzone.
+     */
+    int32_t apply(int32_t deflection) const;
+};
@@ -0,0 +1,168 @@
+/**
+ * @file frame_broker.h
+ * @brief Captures each camera frame once and shares it with every consumer.
+ */
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <atomic>
+
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+
+#include "camera.h"
+#include "frame_ref.h"
+#include "latest_queue.h"
+
+#define FRAME_BROKER_MAX_SUBSCRIBERS 4    /**< Stream clients, detector and recorder together. */
+#define FRAME_BROKER_TASK_STACK_SIZE 3072 /**< Bytes; only moves frame handles. */
+#define FRAME_BROKER_TASK_PRIORITY 4      /**< Below the WiFi stack on core 0. */
+#define FRAME_BROKER_TASK_CORE 0          /**< With the camera driver's DMA and WiFi. */
+#define FRAME_BROKER_RETRY_MS 10          /**< Back-off after the camera returned no frame. */
+#define FRAME_BROKER_POLL_MS 1            /**< Sleep while waiting for a publish or the task to finish. */
+
+/**
+ * @class FrameSubscription
+ * @brief One consumer's view of the broker: always the newest frame, never a backlog.
+ * @details Holds at most one frame. A frame the consumer did not collect before the
+ * next one arrived is dropped and counted, so a slow client (e.g. a stream over a
+ * weak link) only lowers its own frame rate, never anyone else's.
+ */
+class FrameSubscription
+{
+    friend class FrameBroker;
+
+private:
+    LatestQueue<FrameRef, 1> _latest; /**< Newest undelivered frame. */
+    bool _claimed;                    /**< Slot is taken; guarded by the broker's lock. */
+    std::atomic<bool> _active;        /**< The broker publishes to this slot. */
+    const char* _name;                /**< Label for logs, e.g. "stream". */
+    uint32_t _dropped_base;           /**< _latest.evicted() when the slot was claimed. */
+    std::atomic<uint32_t> _received;  /**< Frames collected since subscribe(). */
+
+public:
+    FrameSubscription() : _claimed(false), _active(false), _name(""), _dropped_base(0), _received(0) {}
+
+    FrameSubscription(const FrameSubscription&) = delete;
+    FrameSubscription& operator=(const FrameSubscription&) = delete;
+
+    /**
+     * @brief Takes the newest frame, sleeping up to @p ticks for one to arrive.
+     * @details The calling task becomes the one the broker wakes, so each
+     * subscription must be waited on by one task at a time.
+     * @param frame Receives a reference to the frame.
+     * @return false if no frame arrived in time.
+     */
+    bool wait(FrameRef& frame, TickType_t ticks);
+
+    /** @brief Drops the frame waiting to be collected, if any, handing it back sooner. */
+    void clear();
+
+    /** @return Frames collected since subscribe(). */
+    uint32_t received() const { return this->_received.load(); }
+
+    /** @return Frames replaced by a newer one before they were collected, since subscribe(). */
+    uint32_t dropped() const { return this->_latest.evicted() - this->_dropped_base; }
+
+    /** @return Label given to subscribe(). */
+    const char* name() const { return this->_name; }
+};
+
+/**
+ * @class FrameBroker
+ * @brief Single owner of the camera: one task captures each frame once and publishes
+ * a FrameRef to every subscriber.
+ * @details Subscribers share the buffer without copies, and it returns to the driver
+ * when the last of them drops it. Each subscriber collects at its own pace with
+ * latest-frame semantics. A second stream client therefore costs one more reference
+ * instead of halving everyone's frame rate, and clients no longer fight over the
+ * driver's frame buffers. Camera::begin() must be configured with a frame buffer for
+ * the newest frame, one per consumer holding an older one, and one being filled.
+ */
+class FrameBroker
+{
+private:
+    Camera& _camera;
+    FrameSubscription _subscriptions[FRAME_BROKER_MAX_SUBSCRIBERS];
+    portMUX_TYPE _lock = portMUX_INITIALIZER_UNLOCKED; /**< Serialises subscribe() and unsubscribe(). */
+
+    TaskHandle_t _handle;            /**< Null until start(). */
+    std::atomic<bool> _running;      /**< Cleared by stop(); the task loop checks it. */
+    std::atomic<bool> _capturing;    /**< Broker task alive. */
+    std::atomic<bool> _publishing;   /**< A publish() pass is in flight. */
+    std::atomic<uint32_t> _captured; /**< Frames taken from the camera. */
+
+    /** @brief Broker task body. */
+    static void _run(void* arg);
+
+public:
+    /**
+     * @brief Construct a new Frame Broker object.
+     * @param camera Started camera; only the broker captures from it from now on.
+     */
+    explicit FrameBroker(Camera& camera)
+        : _camera(camera), _handle(nullptr), _running(false), _capturing(false), _publishing(false), _captured(0)
+    {
+    }
+
+    /** @brief Stops the task; subscriptions keep their last frame until unsubscribed. */
+    ~FrameBroker() { stop(); }
+
+    FrameBroker(const FrameBroker&) = delete;
+    FrameBroker& operator=(const FrameBroker&) = delete;
+
+    /**
+     * @brief Creates the capture task pinned to FRAME_BROKER_TASK_CORE.
+     * @return true if the task is running.
+     */
+    bool start();
+
+    /** @brief Asks the capture task to exit and waits until it has. */
+    void stop();
+
+    /** @return true between a successful start() and stop(). */
+    bool is_running() const { return this->_running.load(); }
+
+    /**
+     * @brief Claims a subscription slot.
+     * @param name Label for logs; must outlive the subscription.
+     * @return The subscription, or nullptr if all FRAME_BROKER_MAX_SUBSCRIBERS are taken.
+     */
+    FrameSubscription* subscribe(const char* name);
+
+    /**
+     * @brief Frees a subscription and drops its undelivered frame.
+     * @details Waits out a publish in flight, so once this returns the broker no longer
+     * touches the subscription or wakes the task that waited on it.
+     * @param subscription Result of subscribe(); nullptr is ignored.
+     */
+    void unsubscribe(FrameSubscription* subscription);
+
+    /**
+     * @brief Makes sure the broker no longer wakes the task waiting on @p subscription.
+     * @details For a consumer task that exits but keeps its subscription. Waits out a
+     * publish in flight; the next wait() registers its caller again.
+     */
+    void release_waiter(FrameSubscription* subscription);
+
+    /**
+     * @brief Captures one frame and publishes it.
+     * @details The task loop calls this; tests can call it without starting the task.
+     * @return false if the camera had no frame.
+     */
+    bool capture_once();
+
+    /**
+     * @brief Hands @p frame to every active subscription, replacing what they had not collected.
+     * @details Called by one publisher at a time: the broker task, or a test.
+     */
+    void publish(const FrameRef& frame);
+
+    /** @return Frames taken from the camera since construction. */
+    uint32_t captured() const { return this->_captured.load(); }
+
+    /** @return Active subscriptions. */
+    size_t subscribers() const;
+};
@@ -6,15 +6,25 @@
 #pragma once
 
 #include <Arduino.h>
+#include <esp_timer.h>
+
+#include <atomic>
 
 #define JOYSTICK_DEADZONE 150
 #define JOYSTICK_RESOLUTION_BITS 12
-#define JOYSTICK_SAMPLES 5    /**< Number of samples to average for noise reduction. */
-#define BUTTON_DEBOUNCE_MS 50 /**< Debounce time for the Z-axis button. */
+#define JOYSTICK_SAMPLE_PERIOD_US 5000 /**< Background sampling period: 200 Hz, light on the shared timer task. */
+#define JOYSTICK_FILTER_SHIFT 2        /**< IIR weight 1/4 per sample: a time constant of about 17 ms. */
+#define BUTTON_DEBOUNCE_MS 50          /**< Debounce time for the Z-axis button. */
 
 /**
  * @class Joystick
  * @brief Handles 12-bit analog input and debounced button state.
+ * @details After begin(), an esp_timer samples both axes every JOYSTICK_SAMPLE_PERIOD_US
+ * and runs each through a first-order IIR low-pass filter. The axis getters only read
+ * the latest filtered value, so the control loop no longer waits on ADC conversions and
+ * sees the same smoothed position however often it asks. The timer task also drives
+ * the stepper, so the period is kept well above the ADC reads it costs; a hand on a
+ * stick needs nothing faster.
  */
 class Joystick
 {
@@ -27,8 +37,21 @@ private:
     bool _last_btn_state;
     unsigned long _last_debounce_time;
 
-    /** @brief Reads multiple ADC samples and returns the average. */
-    int _read_raw(uint8_t pin);
+    esp_timer_handle_t _sample_timer; /**< Periodic axis sampler; null until begin(). */
+    std::atomic<int32_t> _filtered_x; /**< Filtered raw X, scaled by 2^JOYSTICK_FILTER_SHIFT. */
+    std::atomic<int32_t> _filtered_y; /**< Filtered raw Y, scaled by 2^JOYSTICK_FILTER_SHIFT. */
+
+    /** @brief esp_timer callback: reads each axis once and folds it into its filter. */
+    static void _on_sample(void* arg);
+
+    /** @brief Adds @p raw to the IIR filter state @p filtered. Single writer: the sampler. */
+    static void _filter(std::atomic<int32_t>& filtered, int raw);
+
+    /** @return Latest filtered raw reading held in @p filtered. */
+    static int _filtered_raw(const std::atomic<int32_t>& filtered)
+    {
+        return filtered.load(std::memory_order_relaxed) >> JOYSTICK_FILTER_SHIFT;
+    }
 
     /** @brief Internal processing for axis deflection and deadzone filtering. */
     int _process_axis(int raw_val, int center) const;
@@ -42,7 +65,13 @@ public:
      */
     Joystick(uint8_t pin_x, uint8_t pin_y, uint8_t pin_z, int deadzone = JOYSTICK_DEADZONE)
         : _pin_x(pin_x), _pin_y(pin_y), _pin_z(pin_z), _deadzone(deadzone), _center_x(0), _center_y(0),
-          _last_btn_state(HIGH), _last_debounce_time(0){};
+          _last_btn_state(HIGH), _last_debounce_time(0), _sample_timer(nullptr), _filtered_x(0), _filtered_y(0){};
+
+    /** @brief Stops the background sampler. */
+    ~Joystick();
+
+    Joystick(const Joystick&) = delete;
+    Joystick& operator=(const Joystick&) = delete;
 
     /**
      * @brief Initializes hardware pins and performs auto-calibration of the
@@ -52,14 +81,16 @@ public:
      * 2. Sets Z (button) pin to INPUT_PULLUP to prevent floating states.
      * 3. Configures the Global ADC resolution to 12-bit (0-4095).
      * 4. Calibrates the joystick by averaging the first 10 readings at rest.
+     * 5. Starts the background sampler, with the filters settled on the center.
      * @warning Ensure the joystick is untouched at the moment this is called,
      * as it defines the "zero" point for all future movement logic.
+     * @return false if the sampler could not be created; the axes then read as centered.
      */
-    void begin();
+    bool begin();
 
-    /** @return Relative deflection (-2048 to 2048). */
-    int get_x() { return _process_axis(_read_raw(_pin_x), _center_x); }
-    int get_y() { return _process_axis(_read_raw(_pin_y), _center_y); }
+    /** @return Relative deflection (-2048 to 2048), from the latest filtered sample. */
+    int get_x() const { return _process_axis(_filtered_raw(_filtered_x), _center_x); }
+    int get_y() const { return _process_axis(_filtered_raw(_filtered_y), _center_y); }
 
     /** @return true only on the moment the button is pressed (falling edge). */
     bool is_z_pressed();
@@ -67,8 +98,9 @@ public:
     /** @return true if the button is currently held down. */
     bool is_z_held() const { return digitalRead(_pin_z) == LOW; }
 
-    int get_speed_x(int min_out = -255, int max_out = 255) { return _map_speed(get_x(), min_out, max_out); }
-    int get_speed_y(int min_out = -255, int max_out = 255) { return _map_speed(get_y(), min_out, max_out); }
+    int get_speed_x(int min_out = -255, int max_out = 255) const { return _map_speed(get_x(), min_out, max_out); }
+    int get_speed_y(int min_out = -255, int max_out = 255) const { return _map_speed(get_y(), min_out, max_out); }
 
-    bool is_active();
+    /** @return true if either axis is outside the deadzone. */
+    bool is_active() const { return (get_x() != 0 || get_y() != 0); }
 };
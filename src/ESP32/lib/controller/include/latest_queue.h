@@ -0,0 +1,142 @@
+/**
+ * @file latest_queue.h
+ * @brief Bounded queue between two pipeline stages that keeps the newest items.
+ */
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <utility>
+
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+
+/**
+ * @class LatestQueue
+ * @brief FIFO of at most @p Capacity items where a push into a full queue evicts the oldest.
+ * @details A stage that falls behind then always works on the freshest data instead
+ * of a backlog, and the producer never blocks. Unlike xQueueOverwrite(), the evicted
+ * item is handed back to the producer, so a frame buffer can be returned to the
+ * camera instead of leaking. Every push gives the consumer task a direct-to-task
+ * notification, which wait_pop() sleeps on.
+ * @tparam T Copyable element type, e.g. a FrameRef or a DetectionResult. Items leave
+ * the queue by move, so a slot never keeps a reference alive.
+ * @tparam Capacity Maximum number of queued items.
+ */
+template <typename T, size_t Capacity> class LatestQueue
+{
+    static_assert(Capacity >= 1, "Capacity must be at least one");
+
+private:
+    T _slots[Capacity];
+    size_t _head;                                              /**< Oldest item. */
+    size_t _count;                                             /**< Items queued. */
+    uint32_t _evicted;                                         /**< Items pushed out by newer ones since construction. */
+    TaskHandle_t _consumer;                                    /**< Woken by push(); null until set_consumer(). */
+    mutable portMUX_TYPE _lock = portMUX_INITIALIZER_UNLOCKED; /**< Guards every field above. */
+
+public:
+    LatestQueue() : _slots(), _head(0), _count(0), _evicted(0), _consumer(nullptr) {}
+
+    LatestQueue(const LatestQueue&) = delete;
+    LatestQueue& operator=(const LatestQueue&) = delete;
+
+    /** @brief Registers the task that wait_pop() runs on, so push() can wake it. */
+    void set_consumer(TaskHandle_t consumer)
+    {
+        portENTER_CRITICAL(&this->_lock);
+        this->_consumer = consumer;
+        portEXIT_CRITICAL(&this->_lock);
+    }
+
+    /**
+     * @brief Appends @p item, evicting the oldest item if the queue is full.
+     * @param item Item to queue.
+     * @param evicted Receives the item pushed out, so the caller can release it.
+     * @return true if an item was evicted into @p evicted.
+     */
+    bool push(const T& item, T& evicted)
+    {
+        bool full = false;
+        TaskHandle_t consumer = nullptr;
+
+        portENTER_CRITICAL(&this->_lock);
+        full = this->_count == Capacity;
+        if (full)
+        {
+            evicted = std::move(this->_slots[this->_head]);
+            this->_head = (this->_head + 1) % Capacity;
+            this->_count--;
+            this->_evicted++;
+        }
+        this->_slots[(this->_head + this->_count) % Capacity] = item;
+        this->_count++;
+        consumer = this->_consumer;
+        portEXIT_CRITICAL(&this->_lock);
+
+        if (consumer)
+        {
+            xTaskNotifyGive(consumer);
+        }
+        return full;
+    }
+
+    /**
+     * @brief Removes the oldest item into @p item without blocking.
+     * @return false if the queue is empty.
+     */
+    bool pop(T& item)
+    {
+        bool available = false;
+
+        portENTER_CRITICAL(&this->_lock);
+        available = this->_count > 0;
+        if (available)
+        {
+            item = std::move(this->_slots[this->_head]);
+            this->_head = (this->_head + 1) % Capacity;
+            this->_count--;
+        }
+        portEXIT_CRITICAL(&this->_lock);
+        return available;
+    }
+
+    /**
+     * @brief Removes the oldest item, sleeping up to @p ticks for one to arrive.
+     * @details Must run on the task given to set_consumer(). A notification left over
+     * from an item already popped can end the wait early with nothing queued, so
+     * callers treat false as "nothing yet" and loop.
+     * @return false if nothing arrived in time.
+     */
+    bool wait_pop(T& item, TickType_t ticks)
+    {
+        if (pop(item))
+        {
+            return true;
+        }
+        ulTaskNotifyTake(pdTRUE, ticks);
+        return pop(item);
+    }
+
+    /** @return Items currently queued. */
+    size_t size() const
+    {
+        portENTER_CRITICAL(&this->_lock);
+        size_t count = this->_count;
+        portEXIT_CRITICAL(&this->_lock);
+        return count;
+    }
+
+    /** @return Items evicted by newer ones since construction. */
+    uint32_t evicted() const
+    {
+        portENTER_CRITICAL(&this->_lock);
+        uint32_t evicted = this->_evicted;
+        portEXIT_CRITICAL(&this->_lock);
+        return evicted;
+    }
+
+    /** @return Slot count. */
+    static constexpr size_t capacity() { return Capacity; }
+};
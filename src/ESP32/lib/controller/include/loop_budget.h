@@ -0,0 +1,124 @@
+/**
+ * @file loop_budget.h
+ * @brief Per-iteration time budget for the Controller loop.
+ */
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define LOOP_BUDGET_US 50000             /**< Period of one Controller::run() iteration: 20 Hz joystick polling. */
+#define LOOP_BUDGET_MAX_DETECT_DIVIDER 8 /**< Slowest detection rate: one iteration in eight. */
+#define LOOP_BUDGET_COST_SHIFT 3         /**< Stage costs are running averages with weight 1/8. */
+
+/**
+ * @enum LoopStage
+ * @brief The parts of one iteration the budget measures separately.
+ */
+enum class LoopStage : uint8_t {
+    Input = 0,    /**< Joystick polling; runs every iteration. */
+    Detect = 1,   /**< Frame capture and detection; its rate is lowered first. */
+    Control = 2,  /**< PID and the move command; follows every detection, as there is nothing new between them. */
+    Optional = 3, /**< Telemetry and other work that can wait for a quiet iteration. */
+    Count = 4
+};
+
+/**
+ * @struct LoopStats
+ * @brief Loop timing counters since construction.
+ */
+struct LoopStats {
+    uint32_t iterations = 0;                     /**< Completed iterations. */
+    uint32_t deadline_misses = 0;                /**< Iterations that took longer than the budget on their own. */
+    uint32_t period_us = 0;                      /**< Average start-to-start loop period since the first iteration. */
+    uint32_t worst_us = 0;                       /**< Longest single iteration. */
+    uint32_t detect_divider = 1;                 /**< Detection runs in one iteration out of this many. */
+    uint32_t detections_skipped = 0;             /**< Iterations that left detection out to keep the period. */
+    uint32_t optional_deferred = 0;              /**< Times optional work did not fit and waited. */
+    uint32_t stage_us[(size_t)LoopStage::Count]; /**< Running average cost of each LoopStage. */
+
+    LoopStats() : stage_us() {}
+};
+
+/**
+ * @class LoopBudget
+ * @brief Paces the loop to a fixed period and decides what fits in each iteration.
+ * @details Iterations start on a fixed schedule, one budget apart, like
+ * vTaskDelayUntil(): the caller sleeps off remaining_us() after end(). Every
+ * stage is timed with esp_timer_get_time() and kept as a running average. When
+ * the work would not fit the period, it is shed in order:
+ *
+ *   1. optional work runs only if its average cost fits before the next iteration
+ *      is due; otherwise it waits for one that has room,
+ *   2. detection, with the control update that follows it, is spread over several
+ *      iterations, just often enough that its cost fits next to input polling,
+ *   3. input always runs, so the joystick keeps the loop's rate.
+ *
+ * An iteration that detects can still overrun on its own; it is counted as a
+ * deadline miss, and the iterations after it start late and skip their sleep
+ * until the schedule is met again, so the average period holds. A loop that
+ * falls more than LOOP_BUDGET_MAX_DETECT_DIVIDER periods behind gives up the
+ * missed ones instead of running them back to back. Single-threaded: one loop
+ * owns it.
+ */
+class LoopBudget
+{
+private:
+    uint32_t _budget_us;
+    int64_t _first_start_us;     ///< esp_timer time the first iteration began.
+    int64_t _iteration_start_us; ///< esp_timer time the current iteration began.
+    int64_t _next_start_us;      ///< When the next iteration is due on the schedule.
+    int64_t _mark_us;            ///< End of the last measured stage.
+    uint32_t _until_detect;      ///< Iterations left before detection runs again.
+    LoopStats _stats;
+
+    /** @brief Folds @p sample_us into the running average @p average_us. */
+    static void _average(uint32_t& average_us, uint32_t sample_us);
+
+    /** @brief Picks the detection rate from the current stage costs. */
+    void _update_divider();
+
+public:
+    /**
+     * @brief Construct a new Loop Budget object.
+     * @param budget_us Target iteration time.
+     */
+    explicit LoopBudget(uint32_t budget_us = LOOP_BUDGET_US)
+        : _budget_us(budget_us), _first_start_us(0), _iteration_start_us(0), _next_start_us(0), _mark_us(0),
+          _until_detect(0)
+    {
+    }
+
+    /** @brief Starts an iteration and books the next one a budget later on the schedule. */
+    void begin();
+
+    /** @brief Charges the time since the previous stage ended, or begin(), to @p stage. */
+    void end_stage(LoopStage stage);
+
+    /**
+     * @brief Asks whether this iteration should run detection.
+     * @return true once every detect_divider iterations; otherwise counts a skip.
+     */
+    bool should_detect();
+
+    /**
+     * @brief Asks whether optional work fits in what is left of this iteration.
+     * @return false, counting a deferral, if its average cost would run past the next iteration.
+     */
+    bool should_run_optional();
+
+    /** @brief Ends the iteration: counts a deadline miss and adapts the detection rate. */
+    void end();
+
+    /**
+     * @brief Time left before the next iteration is due; after end(), the time to sleep.
+     * @return Microseconds until the next iteration, 0 once behind the schedule.
+     */
+    uint32_t remaining_us() const;
+
+    /** @return Target iteration time. */
+    uint32_t budget_us() const { return this->_budget_us; }
+
+    /** @return Snapshot of the counters. */
+    LoopStats stats() const { return this->_stats; }
+};
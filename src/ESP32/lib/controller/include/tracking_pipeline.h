@@ -0,0 +1,168 @@
+/**
+ * @file tracking_pipeline.h
+ * @brief Detection and actuation as concurrent FreeRTOS tasks behind the FrameBroker.
+ */
+#pragma once
+
+#include <stdint.h>
+
+#include <atomic>
+
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+
+#include "base_detection_module.h"
+#include "controller.h"
+#include "detection_result.h"
+#include "frame_arena.h"
+#include "frame_broker.h"
+#include "frame_context.h"
+#include "frame_ref.h"
+#include "latest_queue.h"
+
+#define PIPELINE_RESULT_QUEUE_DEPTH 1 /**< Detections waiting for actuation. */
+#define PIPELINE_WAIT_MS 20           /**< Longest stage sleep; also the joystick poll period. */
+#define PIPELINE_STOP_POLL_MS 5       /**< stop() polls the stages this often until they exit. */
+#define DETECT_TASK_STACK_SIZE 8192   /**< Bytes; detectors keep their planes in the FrameArena. */
+#define DETECT_TASK_PRIORITY 2        /**< Above loop() (1), below every latency-bound stage. */
+#define DETECT_TASK_CORE 1            /**< A core of its own, apart from the broker and WiFi. */
+#define ACTUATE_TASK_STACK_SIZE 4096  /**< Bytes; PID, a lookup-table read and the telemetry printf. */
+#define ACTUATE_TASK_PRIORITY 4       /**< Preempts the detector so a result is acted on at once. */
+#define ACTUATE_TASK_CORE 1           /**< Next to MotionTask, which it feeds. */
+
+/**
+ * @struct PipelineStats
+ * @brief Stage counters since construction, for throughput and drop monitoring.
+ */
+struct PipelineStats {
+    uint32_t captured = 0;        /**< Frames the FrameBroker took from the camera. */
+    uint32_t frames_dropped = 0;  /**< Frames replaced by a newer one before the detector got to them. */
+    uint32_t detected = 0;        /**< Frames the detector finished. */
+    uint32_t results_dropped = 0; /**< Detections replaced by a newer one before actuation. */
+    uint32_t actuated = 0;        /**< Detections handed to Controller::track(). */
+};
+
+/**
+ * @class TrackingPipeline
+ * @brief Runs detection and actuation as pinned tasks fed by the FrameBroker.
+ * @details Controller::run() does the three steps in sequence, so one frame period is
+ * the sum of their times. Here each step is its own task. Capture is the FrameBroker's
+ * task, which hands frames to this pipeline's subscription; a LatestQueue carries the
+ * detection results on:
+ *
+ *   broker (core 0) -> subscription -> detect (core 1) -> results -> actuate (core 1)
+ *
+ * While the detector works on frame N the broker already waits for frame N+1, so
+ * throughput is set by the slowest stage instead of the sum. A stage that falls
+ * behind skips to the newest item. Frames travel as FrameRef handles, so a skipped
+ * frame goes straight back to the camera and the stream shares the same capture.
+ * The actuation task is the only caller of the Controller: it polls the joystick at
+ * least every PIPELINE_WAIT_MS and passes each detection to Controller::track(), so
+ * the movement manager keeps a single producer.
+ *
+ * On the host, the FreeRTOS mocks run the same tasks as std::threads, and each stage
+ * is also callable on its own for deterministic tests.
+ */
+class TrackingPipeline
+{
+private:
+    FrameBroker& _broker;
+    FrameSubscription* _frames;     /**< Detector's subscription; nullptr until subscribe() succeeds. */
+    BaseDetectionModule& _detector; /**< Called from the detect task only. */
+    Controller& _controller;        /**< Called from the actuate task only. */
+
+    FrameArena _frame_arena;     ///< Backing storage for the detect task's FrameContext.
+    FrameContext _frame_context; ///< Representation cache for the frame being detected.
+
+    LatestQueue<DetectionResult, PIPELINE_RESULT_QUEUE_DEPTH> _results;
+
+    TaskHandle_t _detect_handle;  /**< Null until start(). */
+    TaskHandle_t _actuate_handle; /**< Null until start(). */
+
+    std::atomic<bool> _running;      /**< Cleared by stop(); every task loop checks it. */
+    std::atomic<bool> _detecting;    /**< Detect task alive; actuate outlives it. */
+    std::atomic<bool> _actuating;    /**< Actuate task alive. */
+    std::atomic<uint32_t> _detected; /**< Written by the detect stage only. */
+    std::atomic<uint32_t> _actuated; /**< Written by the actuate stage only. */
+
+    LoopWork _optional_work;  /**< Run by the actuate task between detections; may be null. */
+    void* _optional_work_arg; /**< Passed to _optional_work. */
+
+    /** @brief Detect task body. */
+    static void _detect_task(void* arg);
+
+    /** @brief Actuate task body. */
+    static void _actuate_task(void* arg);
+
+public:
+    /**
+     * @brief Construct a new Tracking Pipeline object.
+     * @param broker Frame source; the pipeline takes a slot only in subscribe() or start().
+     * @param detector Detection module; only the detect task calls it.
+     * @param controller Control law and joystick handling; only the actuate task calls it.
+     */
+    TrackingPipeline(FrameBroker& broker, BaseDetectionModule& detector, Controller& controller);
+
+    /** @brief Stops the tasks and gives back the broker slot, if it holds one. */
+    ~TrackingPipeline();
+
+    TrackingPipeline(const TrackingPipeline&) = delete;
+    TrackingPipeline& operator=(const TrackingPipeline&) = delete;
+
+    /**
+     * @brief Claims the detector's broker slot; the pipeline keeps it until destruction.
+     * @details start() calls this; tests call it to drive the stages by hand.
+     * @return true if the pipeline holds a subscription.
+     */
+    bool subscribe();
+
+    /**
+     * @brief Subscribes, then creates the detect and actuate tasks pinned to their cores.
+     * @details Frames only arrive once the FrameBroker is started as well.
+     * @return true if both are running; false as well if the broker has no free slot.
+     */
+    bool start();
+
+    /**
+     * @brief Asks every stage to exit and waits until they have.
+     * @details Detection exits before actuation, each after finishing the item it holds,
+     * so this returns within about one detection and PIPELINE_WAIT_MS. The broker keeps
+     * running for its other subscribers.
+     */
+    void stop();
+
+    /**
+     * @brief Registers low-rate work, e.g. telemetry, for the actuate task.
+     * @details Runs after every actuate_once(), once the detection at hand has been
+     * handed on, so it only delays the next one; the work limits its own rate, as with
+     * Controller::set_optional_work(). Call before start().
+     * @param work Called from the actuate task; nullptr removes it.
+     * @param arg Passed to @p work.
+     */
+    void set_optional_work(LoopWork work, void* arg)
+    {
+        this->_optional_work = work;
+        this->_optional_work_arg = arg;
+    }
+
+    /** @return true between a successful start() and stop(). */
+    bool is_running() const { return this->_running.load(); }
+
+    /**
+     * @brief Runs the detector on the newest frame from the broker and queues the result.
+     * @details The detect task loop calls this; tests can call it without starting the task.
+     * @param wait Ticks to wait for a frame.
+     * @return false if no frame arrived in time.
+     */
+    bool detect_once(TickType_t wait);
+
+    /**
+     * @brief Polls the joystick, then hands the newest detection, if any, to the Controller.
+     * @param wait Ticks to wait for a detection.
+     * @return false if no detection arrived in time.
+     */
+    bool actuate_once(TickType_t wait);
+
+    /** @return Snapshot of the stage counters. */
+    PipelineStats stats() const;
+};
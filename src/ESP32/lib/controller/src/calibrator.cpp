@@ -0,0 +1,142 @@
+#include "calibrator.h"
+
+#include <Arduino.h>
+#include <math.h>
+
+#include "constants.h"
+#include "detection_result.h"
+
+#define CALIBRATION_POLL_MS 10         /**< Arrival polling period. */
+#define CALIBRATION_MAX_MISMATCH 0.25f /**< Largest relative difference between the out and back measurements. */
+
+const uint8_t* Calibrator::_capture()
+{
+    camera_fb_t* stale = this->_camera.capture();
+    if (stale)
+    {
+        this->_camera.release(stale);
+    }
+
+    if (!this->_frame_context.attach(this->_camera.capture(), &this->_camera))
+    {
+        this->_frame_context.release();
+        return nullptr;
+    }
+
+    this->_frame_width = (uint16_t)this->_frame_context.width();
+    this->_frame_height = (uint16_t)this->_frame_context.height();
+    return this->_frame_context.greyscale();
+}
+
+bool Calibrator::_move_and_settle(int32_t pan_steps, int32_t tilt_centidegrees)
+{
+    this->_movement_manager.move_absolute(pan_steps, tilt_centidegrees);
+
+    uint32_t waited_ms = 0;
+    while (this->_movement_manager.get_pan_position() != pan_steps)
+    {
+        if (waited_ms >= CALIBRATION_MOVE_TIMEOUT_MS)
+        {
+            return false;
+        }
+        delay(CALIBRATION_POLL_MS);
+        waited_ms += CALIBRATION_POLL_MS;
+    }
+
+    delay(CALIBRATION_SETTLE_MS);
+    return true;
+}
+
+bool Calibrator::_measure(int32_t pan_steps, int32_t tilt_centidegrees, int32_t max_shift, GlobalShift& shift)
+{
+    const uint8_t* luma = _capture();
+    bool ready = luma && this->_estimator.set_reference(luma, this->_frame_width, this->_frame_height);
+    this->_frame_context.release();
+    if (!ready)
+    {
+        Serial.println("[CALIBRATION] Scene has too little texture");
+        return false;
+    }
+
+    if (!_move_and_settle(pan_steps, tilt_centidegrees))
+    {
+        Serial.println("[CALIBRATION] Pan axis did not arrive");
+        return false;
+    }
+
+    luma = _capture();
+    shift = this->_estimator.estimate(luma, this->_frame_width, this->_frame_height, max_shift);
+    this->_frame_context.release();
+    if (!shift.valid)
+    {
+        Serial.println("[CALIBRATION] No distinct image shift");
+        return false;
+    }
+    return true;
+}
+
+/** @brief Averages the out and back shifts of one axis into pixels per unit. @return <= 0 if they disagree. */
+static float average_scale(int32_t out_q4, int32_t back_q4, int32_t units)
+{
+    float out = (float)out_q4 / (1 << DETECTION_SUBPIXEL_BITS);
+    float back = (float)back_q4 / (1 << DETECTION_SUBPIXEL_BITS);
+
+    // Out and back move the image in opposite directions by the same amount
+    if (out <= 0.0f || back >= 0.0f || fabsf(out + back) > CALIBRATION_MAX_MISMATCH * out)
+    {
+        return 0.0f;
+    }
+    return (out - back) / (2.0f * units);
+}
+
+bool Calibrator::run(CameraCalibration& calibration)
+{
+    const int32_t home_pan = this->_movement_manager.get_pan_position();
+    const int32_t home_tilt = this->_movement_manager.get_tilt_centidegrees();
+
+    delay(CALIBRATION_SETTLE_MS);
+    bool captured = _capture() != nullptr;
+    this->_frame_context.release();
+    if (!captured)
+    {
+        Serial.println("[CALIBRATION] Camera returned no frame");
+        return false;
+    }
+
+    // The nominal lens only sizes the search window, the result does not depend on it
+    float pan_nominal = (float)CALIBRATION_PAN_STEPS * 360.0f / STEPPER_NUMBER_OF_STEPS * this->_frame_width /
+                        CAMERA_HFOV_DEG;
+    float tilt_nominal = (float)CALIBRATION_TILT_DEGREES * this->_frame_height / CAMERA_VFOV_DEG;
+    int32_t max_shift = (int32_t)(fmaxf(pan_nominal, tilt_nominal) * CALIBRATION_SEARCH_MARGIN) + 1;
+
+    GlobalShift out;
+    GlobalShift back;
+
+    // Panning right moves the scene left
+    bool pan_ok = _measure(home_pan + CALIBRATION_PAN_STEPS, home_tilt, max_shift, out) &&
+                  _measure(home_pan, home_tilt, max_shift, back);
+    float pan_px_per_step = pan_ok ? average_scale(-out.dx_q4, -back.dx_q4, CALIBRATION_PAN_STEPS) : 0.0f;
+
+    // Tilting up moves the scene down
+    const int32_t tilt_probe = CALIBRATION_TILT_DEGREES * CENTIDEGREES_PER_DEGREE;
+    bool tilt_ok = pan_ok && _measure(home_pan, home_tilt + tilt_probe, max_shift, out) &&
+                   _measure(home_pan, home_tilt, max_shift, back);
+    float tilt_px_per_degree = tilt_ok ? average_scale(out.dy_q4, back.dy_q4, CALIBRATION_TILT_DEGREES) : 0.0f;
+
+    this->_movement_manager.move_absolute(home_pan, home_tilt);
+
+    if (pan_px_per_step <= 0.0f || tilt_px_per_degree <= 0.0f)
+    {
+        Serial.printf("[CALIBRATION] Failed (pan %.3f px/step, tilt %.3f px/deg)\n", pan_px_per_step,
+                      tilt_px_per_degree);
+        return false;
+    }
+
+    calibration.frame_width = this->_frame_width;
+    calibration.frame_height = this->_frame_height;
+    calibration.pan_px_per_step = pan_px_per_step;
+    calibration.tilt_px_per_degree = tilt_px_per_degree;
+    Serial.printf("[CALIBRATION] %ux%u: pan %.3f px/step, tilt %.3f px/deg\n", this->_frame_width,
+                  this->_frame_height, pan_px_per_step, tilt_px_per_degree);
+    return true;
+}
@@ -1,39 +1,142 @@
 #include "controller.h"
 
+#include "latency_probe.h"
+#include "trace.h"
+
 void Controller::run()
+{
+    run_once();
+
+    // Sleep off the rest of the period; an iteration behind the schedule starts at once
+    uint32_t idle_us = this->_budget.remaining_us();
+    if (idle_us > 0)
+    {
+        delay((idle_us + 999) / 1000);
+    }
+}
+
+void Controller::run_once()
+{
+    TRACE_SCOPE(LoopIteration, this->_budget.stats().detect_divider);
+    this->_budget.begin();
+
+    poll_input();
+    this->_budget.end_stage(LoopStage::Input);
+
+    if (this->_system_control_state == SystemControl::AI_MODE && this->_budget.should_detect())
+    {
+        DetectionResult target = _detect_target();
+        this->_budget.end_stage(LoopStage::Detect);
+
+        track(target);
+        this->_budget.end_stage(LoopStage::Control);
+    }
+
+    if (this->_optional_work && this->_budget.should_run_optional())
+    {
+        this->_optional_work(this->_optional_work_arg);
+        this->_budget.end_stage(LoopStage::Optional);
+    }
+
+    this->_budget.end();
+}
+
+void Controller::poll_input()
 {
     if (this->_joystick.is_z_pressed()) // Flip control state
     {
         this->_system_control_state = toggleControlMode(this->_system_control_state);
         Serial.printf("[CONTROLLER] Mode changed to: %s\n", modeToString(this->_system_control_state).c_str());
+        _command_rates(0, 0); // A manual slew never outlives USER mode
     }
 
-    std::tuple<MoveDirectionX, MoveDirectionY> move_directions;
-
     if (this->_system_control_state == SystemControl::USER_MODE) // USER mode
     {
-        // TODO: improve, maybe use the speed functionality of the joystick
-        //? Currently mapped to the move directions instead of an actual speed
+        _command_rates(this->_pan_curve.apply(this->_joystick.get_x()),
+                       this->_tilt_curve.apply(this->_joystick.get_y()));
+    }
+}
 
-        int speed_x = this->_joystick.get_speed_x();
-        int speed_y = this->_joystick.get_speed_y();
+void Controller::_command_rates(int32_t pan_steps_per_s, int32_t tilt_centidegrees_per_s)
+{
+    bool slewing = pan_steps_per_s != 0 || tilt_centidegrees_per_s != 0;
+    if (slewing || this->_slewing)
+    {
+        this->_movement_manager.move_velocity(pan_steps_per_s, tilt_centidegrees_per_s);
+    }
+    this->_slewing = slewing;
+}
 
-        MoveDirectionX user_yaw = (speed_x > 0)   ? MoveDirectionX::Right
-                                  : (speed_x < 0) ? MoveDirectionX::Left
-                                                  : MoveDirectionX::None;
+DetectionResult Controller::_detect_target()
+{
+    TRACE_SCOPE(Detect, 0);
+    if (this->_camera)
+    {
+        this->_frame_context.attach(this->_camera->capture(), this->_camera);
+    }
+
+    DetectionResult target = this->_detection_module.detect(this->_frame_context);
+    this->_frame_context.release();
+    return target;
+}
+
+void Controller::track(const DetectionResult& target)
+{
+    if (this->_system_control_state != SystemControl::AI_MODE)
+    {
+        return;
+    }
+    LATENCY_PROBE(Control);
+
+    if (!target.has_target())
+    {
+        this->_pan_pid.reset();
+        this->_tilt_pid.reset();
+        return;
+    }
+
+    // Pixel scale depends on resolution, so follow the frame size with the gain profile
+    if (!this->_lens_lut.is_built() || target.frame_width != this->_pid_frame_width)
+    {
+        // Detectors that do not report a frame size are assumed to run at the default profile
+        const PidProfile& nominal = pid_profile_for_frame(target.frame_width);
+        uint16_t width = target.frame_width ? target.frame_width : nominal.frame_width;
+        uint16_t height = target.frame_height ? target.frame_height : nominal.frame_height;
+        bool calibrated = this->_calibration.is_valid();
+
+        const PidProfile profile = calibrated ? pid_profile_for_calibration(this->_calibration, width, height) : nominal;
+        this->_pan_pid.set_gains(profile.pan);
+        this->_tilt_pid.set_gains(profile.tilt);
+        this->_pid_frame_width = target.frame_width;
+
+        // Built once per frame size, so the per-frame cost is one table lookup
+        LensModel lens = calibrated ? LensModel::calibrated(this->_calibration, width, height)
+                                    : LensModel::nominal(width, height);
+        this->_lens_lut.build(lens, width, height);
+        this->_pan_px_per_degree_q8 = (int32_t)lroundf(width * (1 << PIXEL_ANGLE_FRACTION_BITS) / lens.hfov_deg);
+        this->_tilt_px_per_degree_q8 = (int32_t)lroundf(height * (1 << PIXEL_ANGLE_FRACTION_BITS) / lens.vfov_deg);
+    }
 
-        MoveDirectionY user_pitch = (speed_y > 0)   ? MoveDirectionY::Up
-                                    : (speed_y < 0) ? MoveDirectionY::Down
-                                                    : MoveDirectionY::None;
+    // Back to Q4 pixels at the scale the gains were tuned for, without the lens bias
+    int32_t pan_q8 = 0;
+    int32_t tilt_q8 = 0;
+    this->_lens_lut.lookup(target.error_x, target.error_y, pan_q8, tilt_q8);
+    const int shift = 2 * PIXEL_ANGLE_FRACTION_BITS - DETECTION_SUBPIXEL_BITS;
+    int32_t error_x = (pan_q8 * this->_pan_px_per_degree_q8) >> shift;
+    int32_t error_y = (tilt_q8 * this->_tilt_px_per_degree_q8) >> shift;
 
-        //? TEMP FIX END
+    int32_t pan_steps = this->_pan_pid.update(error_x);
+    // Image rows grow downwards while positive tilt is up
+    int32_t tilt_centidegrees = this->_tilt_pid.update(-error_y);
 
-        move_directions = std::make_tuple(user_yaw, user_pitch);
-    } else // AI mode
+    // The error was measured from the pose the frame was captured at, so that pose plus
+    // the correction is where the target was; fall back to the live pose without history
+    TurretPose pose;
+    if (target.timestamp_us <= 0 || !this->_movement_manager.get_pose_at(target.timestamp_us, pose))
     {
-        move_directions = this->_detection_module.detect_object(NULL); //! Used Null since it's' currently isn't
-                                                                       //! attached to the camera logic
+        pose.pan_steps = this->_movement_manager.get_pan_position();
+        pose.tilt_centidegrees = this->_movement_manager.get_tilt_centidegrees();
     }
 
-    this->_movement_manager.move_relative(move_directions);
+    this->_movement_manager.move_absolute(pose.pan_steps + pan_steps, pose.tilt_centidegrees + tilt_centidegrees);
 }
@@ -0,0 +1,27 @@
+#include "expo_curve.h"
+
+#include <stdlib.h>
+
+int32_t ExpoCurve::apply(int32_t deflection) const
+{
+    int32_t magnitude = abs(deflection);
+    if (deflection == 0 || magnitude < this->deadzone)
+    {
+        return 0;
+    }
+
+    // 1. Travel past the deadzone, normalised to Q15 and clamped at full deflection
+    const int64_t one = (int64_t)1 << EXPO_SHIFT;
+    int32_t span = EXPO_INPUT_RANGE - this->deadzone;
+    int64_t x = span > 0 ? ((int64_t)(magnitude - this->deadzone) << EXPO_SHIFT) / span : one;
+    x = (x > one) ? one : x;
+
+    // 2. Blend of the linear and the cubic response
+    int64_t expo = (this->expo_percent > 100) ? 100 : this->expo_percent;
+    int64_t cube = (((x * x) >> EXPO_SHIFT) * x) >> EXPO_SHIFT;
+    int64_t shaped = ((100 - expo) * x + expo * cube) / 100;
+
+    // 3. Scale into [min_rate, max_rate], rounded to nearest
+    int64_t rate = this->min_rate + (((int64_t)(this->max_rate - this->min_rate) * shaped + (one >> 1)) >> EXPO_SHIFT);
+    return (int32_t)((deflection > 0) ? rate : -rate);
+}
@@ -0,0 +1,181 @@
+#include "frame_broker.h"
+
+#include <Arduino.h>
+
+#include "trace.h"
+
+bool FrameSubscription::wait(FrameRef& frame, TickType_t ticks)
+{
+    this->_latest.set_consumer(xTaskGetCurrentTaskHandle());
+    if (!this->_latest.wait_pop(frame, ticks))
+    {
+        return false;
+    }
+
+    this->_received++;
+    return true;
+}
+
+void FrameSubscription::clear()
+{
+    FrameRef frame;
+    while (this->_latest.pop(frame))
+    {
+        frame.reset();
+    }
+}
+
+bool FrameBroker::start()
+{
+    if (this->_running.load())
+    {
+        return true;
+    }
+    this->_running.store(true);
+    this->_capturing.store(true);
+
+    if (xTaskCreatePinnedToCore(&FrameBroker::_run, "frame_broker", FRAME_BROKER_TASK_STACK_SIZE, this,
+                                FRAME_BROKER_TASK_PRIORITY, &this->_handle, FRAME_BROKER_TASK_CORE) != pdPASS)
+    {
+        Serial.println("[FrameBroker] Failed to create broker task");
+        this->_capturing.store(false);
+        this->_running.store(false);
+        this->_handle = nullptr;
+        return false;
+    }
+    return true;
+}
+
+void FrameBroker::stop()
+{
+    this->_running.store(false);
+
+    while (this->_capturing.load())
+    {
+        vTaskDelay(pdMS_TO_TICKS(FRAME_BROKER_POLL_MS));
+    }
+    this->_handle = nullptr;
+}
+
+FrameSubscription* FrameBroker::subscribe(const char* name)
+{
+    FrameSubscription* claimed = nullptr;
+
+    portENTER_CRITICAL(&this->_lock);
+    for (FrameSubscription& subscription : this->_subscriptions)
+    {
+        if (!subscription._claimed)
+        {
+            subscription._claimed = true;
+            subscription._name = name;
+            subscription._dropped_base = subscription._latest.evicted();
+            subscription._received.store(0);
+            subscription._active.store(true);
+            claimed = &subscription;
+            break;
+        }
+    }
+    portEXIT_CRITICAL(&this->_lock);
+
+    if (!claimed)
+    {
+        Serial.printf("[FrameBroker] No free subscription for %s\n", name);
+    }
+    return claimed;
+}
+
+void FrameBroker::unsubscribe(FrameSubscription* subscription)
+{
+    if (!subscription)
+    {
+        return;
+    }
+
+    // Stop publishing first, then drop what the last publish left behind
+    subscription->_active.store(false);
+    release_waiter(subscription);
+    subscription->clear();
+
+    // Claimable again only now, so a new subscriber never sees the old frame
+    portENTER_CRITICAL(&this->_lock);
+    subscription->_claimed = false;
+    portEXIT_CRITICAL(&this->_lock);
+}
+
+void FrameBroker::release_waiter(FrameSubscription* subscription)
+{
+    if (!subscription)
+    {
+        return;
+    }
+
+    subscription->_latest.set_consumer(nullptr);
+
+    // A publish that read the old waiter before the line above finishes before this returns
+    while (this->_publishing.load())
+    {
+        vTaskDelay(pdMS_TO_TICKS(FRAME_BROKER_POLL_MS));
+    }
+}
+
+bool FrameBroker::capture_once()
+{
+    FrameRef frame = this->_camera.capture_ref();
+    if (!frame)
+    {
+        return false;
+    }
+
+    this->_captured++;
+    publish(frame);
+    return true;
+}
+
+void FrameBroker::publish(const FrameRef& frame)
+{
+    TRACE_SCOPE(FramePublish, subscribers());
+    this->_publishing.store(true);
+
+    for (size_t slot = 0; slot < FRAME_BROKER_MAX_SUBSCRIBERS; slot++)
+    {
+        FrameSubscription& subscription = this->_subscriptions[slot];
+        if (subscription._active.load())
+        {
+            // An uncollected frame is evicted into stale and released here, on the broker
+            FrameRef stale;
+            if (subscription._latest.push(frame, stale))
+            {
+                TRACE_INSTANT(FrameDropped, slot, 0);
+            }
+        }
+    }
+
+    this->_publishing.store(false);
+    TRACE_COUNTER(FramesInUse, FrameRef::frames_in_use());
+}
+
+size_t FrameBroker::subscribers() const
+{
+    size_t count = 0;
+    for (const FrameSubscription& subscription : this->_subscriptions)
+    {
+        count += subscription._active.load() ? 1 : 0;
+    }
+    return count;
+}
+
+void FrameBroker::_run(void* arg)
+{
+    FrameBroker* broker = static_cast<FrameBroker*>(arg);
+
+    while (broker->_running.load())
+    {
+        if (!broker->capture_once())
+        {
+            vTaskDelay(pdMS_TO_TICKS(FRAME_BROKER_RETRY_MS));
+        }
+    }
+
+    broker->_capturing.store(false);
+    vTaskDelete(nullptr);
+}
@@ -1,6 +1,15 @@
-#include "Joystick.h"
+#include "joystick.h"
 
-void Joystick::begin()
+Joystick::~Joystick()
+{
+    if (this->_sample_timer)
+    {
+        esp_timer_stop(this->_sample_timer);
+        esp_timer_delete(this->_sample_timer);
+    }
+}
+
+bool Joystick::begin()
 {
     pinMode(this->_pin_x, INPUT);
     pinMode(this->_pin_y, INPUT);
@@ -21,16 +30,45 @@ void Joystick::begin()
     }
     this->_center_x = sum_x / average_factor;
     this->_center_y = sum_y / average_factor;
-}
 
-int Joystick::_read_raw(uint8_t pin)
-{
-    long sum = 0;
-    for (int i = 0; i < JOYSTICK_SAMPLES; i++)
+    // Start the filters settled on the rest position, so the stick reads centered at once
+    this->_filtered_x.store(this->_center_x << JOYSTICK_FILTER_SHIFT, std::memory_order_relaxed);
+    this->_filtered_y.store(this->_center_y << JOYSTICK_FILTER_SHIFT, std::memory_order_relaxed);
+
+    if (this->_sample_timer)
     {
-        sum += analogRead(pin);
+        return true;
     }
-    return sum / JOYSTICK_SAMPLES;
+
+    esp_timer_create_args_t args = {};
+    args.callback = &Joystick::_on_sample;
+    args.arg = this;
+    args.dispatch_method = ESP_TIMER_TASK;
+    args.name = "joystick";
+
+    if (esp_timer_create(&args, &this->_sample_timer) != ESP_OK)
+    {
+        Serial.println("[Joystick] Failed to create axis sampler");
+        this->_sample_timer = nullptr;
+        return false;
+    }
+
+    esp_timer_start_periodic(this->_sample_timer, JOYSTICK_SAMPLE_PERIOD_US);
+    return true;
+}
+
+void Joystick::_on_sample(void* arg)
+{
+    Joystick* joystick = static_cast<Joystick*>(arg);
+    _filter(joystick->_filtered_x, analogRead(joystick->_pin_x));
+    _filter(joystick->_filtered_y, analogRead(joystick->_pin_y));
+}
+
+void Joystick::_filter(std::atomic<int32_t>& filtered, int raw)
+{
+    // y += (x - y) / 2^shift, kept scaled by 2^shift so small steps are not rounded away
+    int32_t state = filtered.load(std::memory_order_relaxed);
+    filtered.store(state + raw - (state >> JOYSTICK_FILTER_SHIFT), std::memory_order_relaxed);
 }
 
 int Joystick::_process_axis(int raw_val, int center) const
@@ -88,6 +126,4 @@ bool Joystick::is_z_pressed()
 
     _last_btn_state = current_reading; // Always track the very last reading
     return pressed;
-}
-
-bool Joystick::is_active() { return (get_x() != 0 || get_y() != 0); }
\ No newline at end of file
+}
\ No newline at end of file
@@ -0,0 +1,118 @@
+#include "loop_budget.h"
+
+#include <esp_timer.h>
+
+#include "trace.h"
+
+void LoopBudget::begin()
+{
+    int64_t now = esp_timer_get_time();
+    if (this->_stats.iterations == 0)
+    {
+        this->_first_start_us = now;
+        this->_next_start_us = now;
+    } else
+    {
+        this->_stats.period_us = (uint32_t)((now - this->_first_start_us) / this->_stats.iterations);
+    }
+
+    // Too far behind to catch up without a burst of back-to-back iterations: start the schedule over
+    if (now - this->_next_start_us > (int64_t)this->_budget_us * LOOP_BUDGET_MAX_DETECT_DIVIDER)
+    {
+        this->_next_start_us = now;
+    }
+
+    this->_iteration_start_us = now;
+    this->_next_start_us += this->_budget_us;
+    this->_mark_us = now;
+}
+
+void LoopBudget::end_stage(LoopStage stage)
+{
+    int64_t now = esp_timer_get_time();
+    _average(this->_stats.stage_us[(size_t)stage], (uint32_t)(now - this->_mark_us));
+    this->_mark_us = now;
+}
+
+bool LoopBudget::should_detect()
+{
+    if (this->_until_detect > 0)
+    {
+        this->_until_detect--;
+        this->_stats.detections_skipped++;
+        return false;
+    }
+
+    this->_until_detect = this->_stats.detect_divider - 1;
+    return true;
+}
+
+bool LoopBudget::should_run_optional()
+{
+    if (this->_stats.stage_us[(size_t)LoopStage::Optional] > remaining_us())
+    {
+        this->_stats.optional_deferred++;
+        return false;
+    }
+    return true;
+}
+
+void LoopBudget::end()
+{
+    uint32_t elapsed = (uint32_t)(esp_timer_get_time() - this->_iteration_start_us);
+    this->_stats.iterations++;
+    if (elapsed > this->_stats.worst_us)
+    {
+        this->_stats.worst_us = elapsed;
+    }
+    if (elapsed > this->_budget_us)
+    {
+        TRACE_INSTANT(LoopDeadlineMiss, elapsed, this->_budget_us);
+        this->_stats.deadline_misses++;
+    }
+
+    _update_divider();
+}
+
+uint32_t LoopBudget::remaining_us() const
+{
+    int64_t left = this->_next_start_us - esp_timer_get_time();
+    return left > 0 ? (uint32_t)left : 0;
+}
+
+void LoopBudget::_average(uint32_t& average_us, uint32_t sample_us)
+{
+    // First sample seeds the average, so a cold start does not read as free
+    if (average_us == 0)
+    {
+        average_us = sample_us;
+        return;
+    }
+    int32_t step = ((int32_t)sample_us - (int32_t)average_us) >> LOOP_BUDGET_COST_SHIFT;
+    average_us = (uint32_t)((int32_t)average_us + step);
+}
+
+void LoopBudget::_update_divider()
+{
+    const uint32_t* cost = this->_stats.stage_us;
+    uint32_t fixed = cost[(size_t)LoopStage::Input];
+    uint32_t detect = cost[(size_t)LoopStage::Detect] + cost[(size_t)LoopStage::Control];
+
+    // Spread detection and its control update over just enough iterations that they fit next to input
+    uint32_t spare = fixed < this->_budget_us ? this->_budget_us - fixed : 1;
+    uint32_t divider = (detect + spare - 1) / spare;
+    if (divider < 1)
+    {
+        divider = 1;
+    } else if (divider > LOOP_BUDGET_MAX_DETECT_DIVIDER)
+    {
+        divider = LOOP_BUDGET_MAX_DETECT_DIVIDER;
+    }
+
+    // Detecting more often takes effect at once instead of after the old gap
+    if (divider < this->_stats.detect_divider && this->_until_detect >= divider)
+    {
+        this->_until_detect = divider - 1;
+    }
+    this->_stats.detect_divider = divider;
+}
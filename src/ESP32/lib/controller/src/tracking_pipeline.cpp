@@ -0,0 +1,187 @@
+#include "tracking_pipeline.h"
+
+#include <Arduino.h>
+
+#include "trace.h"
+
+TrackingPipeline::TrackingPipeline(FrameBroker& broker, BaseDetectionModule& detector, Controller& controller)
+    : _broker(broker), _frames(nullptr), _detector(detector), _controller(controller),
+      _frame_context(_frame_arena), _detect_handle(nullptr), _actuate_handle(nullptr), _running(false),
+      _detecting(false), _actuating(false), _detected(0), _actuated(0), _optional_work(nullptr),
+      _optional_work_arg(nullptr)
+{
+}
+
+TrackingPipeline::~TrackingPipeline()
+{
+    stop();
+    if (this->_frames)
+    {
+        this->_broker.unsubscribe(this->_frames);
+    }
+}
+
+bool TrackingPipeline::subscribe()
+{
+    if (!this->_frames)
+    {
+        this->_frames = this->_broker.subscribe("detector");
+    }
+    return this->_frames != nullptr;
+}
+
+bool TrackingPipeline::start()
+{
+    if (this->_running.load())
+    {
+        return true;
+    }
+    if (!subscribe())
+    {
+        Serial.println("[Pipeline] No frame subscription");
+        return false;
+    }
+    this->_running.store(true);
+
+    struct Stage {
+        TaskFunction_t body;
+        const char* name;
+        uint32_t stack_size;
+        UBaseType_t priority;
+        BaseType_t core;
+        TaskHandle_t* handle;
+        std::atomic<bool>* live;
+    };
+    const Stage stages[] = {
+        {&TrackingPipeline::_actuate_task, "actuate", ACTUATE_TASK_STACK_SIZE, ACTUATE_TASK_PRIORITY,
+         ACTUATE_TASK_CORE, &this->_actuate_handle, &this->_actuating},
+        {&TrackingPipeline::_detect_task, "detect", DETECT_TASK_STACK_SIZE, DETECT_TASK_PRIORITY, DETECT_TASK_CORE,
+         &this->_detect_handle, &this->_detecting},
+    };
+
+    // Consumer first, so the first detection already has an actuator waiting for it
+    for (const Stage& stage : stages)
+    {
+        stage.live->store(true);
+        if (xTaskCreatePinnedToCore(stage.body, stage.name, stage.stack_size, this, stage.priority, stage.handle,
+                                    stage.core) != pdPASS)
+        {
+            Serial.printf("[Pipeline] Failed to create %s task\n", stage.name);
+            stage.live->store(false);
+            *stage.handle = nullptr;
+            stop();
+            return false;
+        }
+    }
+
+    return true;
+}
+
+void TrackingPipeline::stop()
+{
+    this->_running.store(false);
+
+    // Cut the idle waits short
+    if (this->_detect_handle)
+    {
+        xTaskNotifyGive(this->_detect_handle);
+    }
+    if (this->_actuate_handle)
+    {
+        xTaskNotifyGive(this->_actuate_handle);
+    }
+
+    while (this->_detecting.load() || this->_actuating.load())
+    {
+        vTaskDelay(pdMS_TO_TICKS(PIPELINE_STOP_POLL_MS));
+    }
+
+    this->_detect_handle = nullptr;
+    this->_actuate_handle = nullptr;
+
+    // Hand back the frame nobody is going to detect now
+    if (this->_frames)
+    {
+        this->_frames->clear();
+    }
+}
+
+bool TrackingPipeline::detect_once(TickType_t wait)
+{
+    FrameRef frame;
+    if (!this->_frames || !this->_frames->wait(frame, wait))
+    {
+        return false;
+    }
+
+    // From here the context holds this stage's reference until release()
+    TRACE_SCOPE(Detect, 0);
+    this->_frame_context.attach(frame);
+    frame.reset();
+    DetectionResult result = this->_detector.detect(this->_frame_context);
+    this->_frame_context.release();
+    this->_detected++;
+
+    DetectionResult stale;
+    this->_results.push(result, stale);
+    return true;
+}
+
+bool TrackingPipeline::actuate_once(TickType_t wait)
+{
+    DetectionResult result;
+    bool fresh = this->_results.wait_pop(result, wait);
+
+    this->_controller.poll_input();
+    if (fresh)
+    {
+        this->_controller.track(result);
+        this->_actuated++;
+    }
+    return fresh;
+}
+
+PipelineStats TrackingPipeline::stats() const
+{
+    PipelineStats stats;
+    stats.captured = this->_broker.captured();
+    stats.frames_dropped = this->_frames ? this->_frames->dropped() : 0;
+    stats.detected = this->_detected.load();
+    stats.results_dropped = this->_results.evicted();
+    stats.actuated = this->_actuated.load();
+    return stats;
+}
+
+void TrackingPipeline::_detect_task(void* arg)
+{
+    TrackingPipeline* pipeline = static_cast<TrackingPipeline*>(arg);
+
+    while (pipeline->_running.load())
+    {
+        pipeline->detect_once(pdMS_TO_TICKS(PIPELINE_WAIT_MS));
+    }
+
+    // The subscription stays, but the broker must not wake this task once it is deleted
+    pipeline->_broker.release_waiter(pipeline->_frames);
+    pipeline->_detecting.store(false);
+    vTaskDelete(nullptr);
+}
+
+void TrackingPipeline::_actuate_task(void* arg)
+{
+    TrackingPipeline* pipeline = static_cast<TrackingPipeline*>(arg);
+    pipeline->_results.set_consumer(xTaskGetCurrentTaskHandle());
+
+    while (pipeline->_running.load() || pipeline->_detecting.load())
+    {
+        pipeline->actuate_once(pdMS_TO_TICKS(PIPELINE_WAIT_MS));
+
+        if (pipeline->_optional_work)
+        {
+            pipeline->_optional_work(pipeline->_optional_work_arg);
+        }
+    }
+
+    pipeline->_actuating.store(false);
+    vTaskDelete(nullptr);
+}
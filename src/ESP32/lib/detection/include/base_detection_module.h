@@ -5,10 +5,13 @@
 
 #pragma once
 
+#include <detection_result.h>
 #include <esp_camera.h>
 #include <move_types.h>
 #include <tuple>
 
+#include "frame_context.h"
+
 /**
  * @class BaseDetectionModule
  * @brief An abstract base class (Interface) that defines the contract for
@@ -32,4 +35,39 @@ public:
      * - Index 1 (MoveDirectionY): Up   | Down  | Stay
      */
     virtual std::tuple<MoveDirectionX, MoveDirectionY> detect_object(camera_fb_t* frame) = 0;
+
+    /**
+     * @brief Analyzes a frame wrapped in a FrameContext.
+     * @details Modules that override this share the context's cached greyscale, edge,
+     * downsampled and integral planes with every other stage of the frame. The
+     * default forwards the raw frame, so modules that only understand camera_fb_t
+     * keep working unchanged.
+     * @param context Per-frame representation cache.
+     */
+    virtual std::tuple<MoveDirectionX, MoveDirectionY> detect_object(FrameContext& context)
+    {
+        return detect_object(context.frame());
+    }
+
+    /**
+     * @brief Locates the target and reports its sub-pixel offset from the frame centre.
+     * @details Modules that can measure the offset override this. The default adapts
+     * detect_object(): each active direction becomes a nominal error of
+     * DETECTION_DIRECTION_ERROR_PX, so direction-only modules (e.g. TestDetection)
+     * keep working with result-based consumers.
+     * @param context Per-frame representation cache.
+     * @return DetectionResult Error, confidence, bounding box and capture timestamp.
+     */
+    virtual DetectionResult detect(FrameContext& context)
+    {
+        DetectionResult result = DetectionResult::from_directions(detect_object(context));
+
+        result.frame_width = context.width();
+        result.frame_height = context.height();
+        if (context.frame())
+        {
+            result.timestamp_us = DetectionResult::timeval_to_us(context.frame()->timestamp);
+        }
+        return result;
+    }
 };
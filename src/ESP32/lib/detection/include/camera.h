@@ -6,6 +6,7 @@
 #pragma once
 
 #include "esp_camera.h"
+#include "frame_ref.h"
 
 /**
  * @namespace WroverPins
@@ -83,7 +84,7 @@ public:
         _config.pixel_format = PIXFORMAT_JPEG; // Compression for network throughput
         _config.frame_size = FRAMESIZE_QVGA;   // 320x240: Balance between AI speed and detail
         _config.jpeg_quality = 12;             // 0-63 (lower is better quality)
-        _config.fb_count = 2;                  // Double buffering to prevent frame tearing
+        _config.fb_count = 4;                  // Newest, one per consumer holding an older one, one being filled
         _config.fb_location = CAMERA_FB_IN_PSRAM;
         _config.grab_mode = CAMERA_GRAB_LATEST; // Drops old frames to reduce latency
     }
@@ -102,6 +103,14 @@ public:
      */
     camera_fb_t* capture();
 
+    /**
+     * @brief Captures a new image frame as a shared handle.
+     * @details Copies of the handle share the buffer without copying pixels; it goes
+     * back to the driver when the last copy is dropped, so no release() is needed.
+     * @return FrameRef Handle to the frame, empty if none was available.
+     */
+    FrameRef capture_ref();
+
     /**
      * @brief Returns the frame buffer to the driver to be reused.
      * @param fb Pointer to the captured frame buffer.
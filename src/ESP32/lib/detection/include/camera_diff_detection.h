@@ -1,19 +1,186 @@
+/**
+ * @file camera_diff_detection.h
+ * @brief Motion detection by temporal differencing of camera luma frames.
+ */
+
 #pragma once
 
 #include <base_detection_module.h>
 
-// TODO: Add DOCS
+#include "frame_arena.h"
+#include "frame_context.h"
+#include "fork_join.h"
+#include "illumination_compensator.h"
+#include "motion_moments.h"
+#include "sigma_delta_background.h"
+
+#define DIFF_PIXEL_THRESHOLD 25    /**< Minimum |current - reference| for a pixel to count as moving. */
+#define DIFF_MIN_CHANGED_PIXELS 40 /**< Fewer moving pixels than this is treated as noise. */
+#define DIFF_CONFIDENT_PIXELS 320  /**< Blob size (px) at which confidence saturates at 255. */
+#define DIFF_CENTER_DEADZONE 16    /**< Centroid offset (px) from the frame centre that needs no correction. */
+#define DIFF_EDGE_THRESHOLD 40     /**< Minimum edge magnitude change for a pixel to count as moving. */
+
+/**
+ * @enum DiffMode
+ * @brief Selects what the current frame is differenced against.
+ */
+enum class DiffMode : uint8_t {
+    PreviousFrame = 0, /**< Plain two-frame differencing against the last frame. */
+    SigmaDelta = 1,    /**< Σ-Δ background estimate with per-pixel adaptive variance. */
+    ThreeFrame = 2,    /**< Double difference over the last three frames, free of ghosting. */
+    Edge = 3           /**< Difference of Roberts-cross edge maps, robust to lighting changes. */
+};
 
+/**
+ * @class CameraDiffDetection
+ * @brief Locates moving objects by differencing luma frames and steering towards
+ * the centroid of the changed pixels.
+ * @details Luma is taken from a FrameContext, so the frame is decoded once no matter
+ * how many stages look at it. Working planes are allocated once (PSRAM) and reused.
+ * The last three luma frames live in a ring that is rotated by pointer after each
+ * frame, so a reference never has to be captured, copied or decoded again.
+ */
 class CameraDiffDetection : public BaseDetectionModule
 {
+private:
+    DiffMode _mode;
+
+    size_t _width;  ///< Width of the allocated planes.
+    size_t _height; ///< Height of the allocated planes.
+
+    FrameArena _arena; ///< Arena for frames passed in raw, without a caller-owned FrameContext.
+
+    uint8_t* _current;   ///< Luma of the frame being processed (t).
+    uint8_t* _reference; ///< Luma of the previous frame (t - 1).
+    uint8_t* _older;     ///< Luma of the frame before that (t - 2, ThreeFrame mode).
+    uint8_t _history;    ///< Number of valid past frames in the ring (0..2).
+
+    uint8_t* _edges;          ///< Roberts-cross edge map of the current frame (Edge mode).
+    uint8_t* _previous_edges; ///< Edge map of the previous frame (Edge mode).
+
+    SigmaDeltaBackground _background; ///< Background model (SigmaDelta mode).
+
+    IlluminationCompensator _illumination; ///< Global gain/offset correction stage.
+    bool _compensate_illumination;         ///< True to run the correction before differencing.
+    uint32_t _suppressed_lighting_events;  ///< Lighting changes corrected away without reporting motion.
+
+    ForkJoin* _workers; ///< Splits the kernels into row bands; nullptr runs them on the caller.
+
+    /** @brief One fork-join run of the per-frame kernel. */
+    struct BandJob {
+        CameraDiffDetection* detector;            ///< Detector whose planes the bands read.
+        const uint8_t* luma;                      ///< Current frame.
+        MotionMoments moments[FORK_JOIN_WORKERS]; ///< Partial moments, one slot per band.
+    };
+
+    /** @brief (Re)allocates the working planes when the frame geometry changes. */
+    bool _ensure_buffers(size_t width, size_t height);
+
+    /** @brief Releases every working plane. */
+    void _free_buffers();
+
+    /** @return The plane the current frame will be differenced against, or nullptr if none yet. */
+    const uint8_t* _active_reference() const;
+
+    /**
+     * @brief Remaps every reference plane of the active mode through the LUT of the
+     * last lighting estimate, so the history continues at the new exposure.
+     */
+    void _rebaseline();
+
+    /**
+     * @brief Runs the active mode's kernel over the frame, split into row bands on the
+     * workers when set, and merges the partial moments into @p moments.
+     */
+    void _run_kernel(const uint8_t* luma, MotionMoments& moments);
+
+    /** @brief ForkJoinKernel: runs the active mode's kernel over one row band of a BandJob. */
+    static void _run_band(void* arg, size_t band, size_t band_count);
+
+    /** @brief Two-frame absolute difference and threshold over rows [row_begin, row_end). */
+    void _diff_previous(const uint8_t* current, size_t row_begin, size_t row_end, MotionMoments& moments);
+
+    /**
+     * @brief Double difference: a pixel moves when it differs from both t - 1 and t - 2.
+     * @details ANDing |I(t) - I(t-1)| and |I(t) - I(t-2)| keeps only the object's
+     * current position. The spot it just left matches t - 2 again, and the spot it
+     * occupied two frames ago matches t - 1, so neither leaves a ghost.
+     */
+    void _diff_three_frame(const uint8_t* current, size_t row_begin, size_t row_end, MotionMoments& moments);
+
+    /**
+     * @brief Fused edge kernel: computes the Roberts-cross magnitude of the current
+     * frame and differences it against the previous edge map in the same pass.
+     * @details Afterwards the two edge planes are swapped by pointer, so the map just
+     * produced becomes the next reference without a copy, once every band is done.
+     */
+    void _diff_edges(const uint8_t* luma, size_t row_begin, size_t row_end, MotionMoments& moments);
+
+    /** @brief Rotates the luma ring by pointer: t becomes t - 1, t - 1 becomes t - 2. */
+    void _rotate_history();
+
+    /** @brief Converts accumulated moments into a sub-pixel offset, confidence and box. */
+    DetectionResult _moments_to_result(const MotionMoments& moments) const;
+
 public:
-    CameraDiffDetection();
+    /**
+     * @brief Construct a new detector.
+     * @param mode Reference model used for differencing.
+     */
+    explicit CameraDiffDetection(DiffMode mode = DiffMode::PreviousFrame);
     ~CameraDiffDetection();
 
+    CameraDiffDetection(const CameraDiffDetection&) = delete;
+    CameraDiffDetection& operator=(const CameraDiffDetection&) = delete;
+
+    /** @brief Wraps the raw frame in a private FrameContext and runs the detector on it. */
     std::tuple<MoveDirectionX, MoveDirectionY> detect_object(camera_fb_t* frame) override;
 
-    // Take pixel and convert to greyscale pixel
+    /** @brief Runs detect() and collapses the result using DIFF_CENTER_DEADZONE. */
+    std::tuple<MoveDirectionX, MoveDirectionY> detect_object(FrameContext& context) override;
+
+    /**
+     * @brief Runs the detector on the luma plane cached by @p context.
+     * @return The centroid of the moving pixels as a Q4 offset from the frame centre,
+     * with a confidence that grows with the blob size.
+     */
+    DetectionResult detect(FrameContext& context) override;
+
+    /**
+     * @brief Switches the reference model. The new model re-learns from the next frame.
+     * @param mode Reference model used for differencing.
+     */
+    void set_mode(DiffMode mode);
+
+    /** @return The active reference model. */
+    DiffMode get_mode() const { return this->_mode; }
+
+    /**
+     * @brief Enables or disables global illumination compensation (enabled by default).
+     * @param enabled true to correct gain/offset against the reference before differencing.
+     */
+    void set_illumination_compensation(bool enabled) { this->_compensate_illumination = enabled; }
+
+    /**
+     * @brief Splits the difference, threshold and moment kernels into row bands on @p workers.
+     * @details Results are identical to the single-pass kernels; only latency changes.
+     * @param workers Fork-join pool, normally started; nullptr runs on the calling task.
+     */
+    void set_workers(ForkJoin* workers) { this->_workers = workers; }
+
+    /**
+     * @return Number of frames where a global lighting change was corrected and,
+     * as a result, no motion was reported.
+     */
+    uint32_t get_suppressed_lighting_events() const { return this->_suppressed_lighting_events; }
+
+    /** @brief Take an RGB565 pixel and convert it to an 8-bit greyscale value. */
     uint8_t rgb565_to_greyscale(uint16_t pixel);
 
+    /**
+     * @brief Computes the Roberts-cross edge magnitude (L1 norm) of a frame.
+     * @param frame Source frame buffer (JPEG, RGB565 or GRAYSCALE).
+     * @param output_edges Destination, width * height bytes; the last row and column are set to 0.
+     */
     void roberts_cross(camera_fb_t* frame, uint8_t* output_edges);
 };
@@ -0,0 +1,90 @@
+/**
+ * @file fork_join.h
+ * @brief Splits a per-frame kernel across both ESP32 cores and waits for it.
+ */
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <atomic>
+
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+
+#define FORK_JOIN_WORKERS 2       /**< One worker per core; also the number of bands per run. */
+#define FORK_JOIN_STACK_SIZE 4096 /**< Bytes; kernels keep their state in the caller's job. */
+#define FORK_JOIN_PRIORITY 3      /**< Above the detect task, which sleeps while the workers run. */
+
+/**
+ * @brief Work for one band of a fork-join run.
+ * @param arg Job shared by every band.
+ * @param band Index of this band, 0 .. band_count - 1.
+ * @param band_count Number of bands in the run.
+ */
+typedef void (*ForkJoinKernel)(void* arg, size_t band, size_t band_count);
+
+/**
+ * @class ForkJoin
+ * @brief Runs a kernel as FORK_JOIN_WORKERS bands, one per worker task, and returns
+ * once every band is done.
+ * @details Worker i is pinned to core i and sleeps on a direct-to-task notification.
+ * run() publishes the kernel, wakes every worker and sleeps on its own notification,
+ * which the last worker to finish gives. Bands must touch disjoint data, and each
+ * band writes its own result slot, which the caller merges after run() returns.
+ * Before start(), or if a worker could not be created, run() executes the bands
+ * one after another on the caller, so results never depend on the threading.
+ *
+ * run() is meant for one caller task at a time, such as the detect task.
+ */
+class ForkJoin
+{
+private:
+    /** @brief Per-worker state, passed as the task argument. */
+    struct Worker {
+        ForkJoin* owner;     /**< Pool the worker belongs to. */
+        size_t band;         /**< Band this worker runs. */
+        TaskHandle_t handle; /**< Null until start(). */
+    };
+
+    Worker _workers[FORK_JOIN_WORKERS];
+    bool _started;                  /**< Every worker task is running. */
+    ForkJoinKernel _kernel;         /**< Kernel of the current run. */
+    void* _arg;                     /**< Job of the current run. */
+    TaskHandle_t _caller;           /**< Task blocked in run(), woken by the last band. */
+    std::atomic<uint32_t> _pending; /**< Bands of the current run not finished yet. */
+
+    /** @brief Worker task body. */
+    static void _run_worker(void* arg);
+
+public:
+    ForkJoin();
+
+    ForkJoin(const ForkJoin&) = delete;
+    ForkJoin& operator=(const ForkJoin&) = delete;
+
+    /**
+     * @brief Creates the worker tasks, worker i pinned to core i.
+     * @return true if every worker is running; otherwise run() stays serial.
+     */
+    bool start();
+
+    /** @return true once the workers are running. */
+    bool is_started() const { return this->_started; }
+
+    /**
+     * @brief Runs @p kernel for bands 0 .. FORK_JOIN_WORKERS - 1 and waits for all of them.
+     * @param kernel Band function; must only write state owned by its band.
+     * @param arg Job passed to every band.
+     */
+    void run(ForkJoinKernel kernel, void* arg);
+
+    /** @return Number of bands every run is split into. */
+    static constexpr size_t bands() { return FORK_JOIN_WORKERS; }
+
+    /**
+     * @brief First row of @p band when @p rows are split into @p band_count even bands.
+     * @details Band b covers rows band_begin(b) .. band_begin(b + 1) - 1.
+     */
+    static size_t band_begin(size_t rows, size_t band, size_t band_count) { return rows * band / band_count; }
+};
@@ -0,0 +1,71 @@
+/**
+ * @file frame_arena.h
+ * @brief Bump allocator for per-frame scratch buffers.
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define FRAME_ARENA_MAX_BLOCKS 8 /**< Backing blocks kept at most; one per representation is plenty. */
+
+/**
+ * @class FrameArena
+ * @brief PSRAM blocks handed out in aligned slices and recycled as a whole.
+ * @details Buffers derived from a frame (decoded RGB, luma, edges, ...) share the
+ * lifetime of that frame, so they never need individual frees: reset() makes every
+ * block available again for the next frame. Blocks are added on demand, sized for
+ * the slice that did not fit, and kept across frames. The arena therefore grows to
+ * what the consumers actually ask for, and a slice never moves once handed out.
+ */
+class FrameArena
+{
+private:
+    /** @brief One backing block, bumped from its start. */
+    struct Block {
+        uint8_t* base;   ///< Start of the block.
+        size_t capacity; ///< Size of the block in bytes.
+        size_t used;     ///< Bytes handed out since the last reset().
+    };
+
+    Block _blocks[FRAME_ARENA_MAX_BLOCKS];
+    size_t _block_count; ///< Blocks allocated so far.
+
+    /** @return Slice of @p bytes from @p block, or nullptr if it does not fit. */
+    static void* _take(Block& block, size_t bytes, size_t alignment);
+
+    /** @return A free block of at least @p capacity bytes, or nullptr if none can be allocated. */
+    Block* _add_block(size_t capacity);
+
+public:
+    FrameArena() : _blocks(), _block_count(0) {}
+    ~FrameArena();
+
+    FrameArena(const FrameArena&) = delete;
+    FrameArena& operator=(const FrameArena&) = delete;
+
+    /**
+     * @brief Allocates a block of @p capacity bytes up front, so the first frames
+     * do not allocate as they go.
+     * @return true if the arena can serve @p capacity bytes in one slice.
+     */
+    bool reserve(size_t capacity);
+
+    /**
+     * @brief Hands out a slice, adding a block when none has room for it.
+     * @param bytes Requested size.
+     * @param alignment Power-of-two alignment of the returned pointer.
+     * @return Pointer to the slice, or nullptr if no block could be allocated.
+     */
+    void* allocate(size_t bytes, size_t alignment = 4);
+
+    /** @brief Invalidates every slice handed out so far; the blocks are kept. */
+    void reset();
+
+    /** @return Bytes currently handed out. */
+    size_t used() const;
+
+    /** @return Size of all backing blocks in bytes. */
+    size_t capacity() const;
+};
@@ -0,0 +1,111 @@
+/**
+ * @file frame_context.h
+ * @brief Per-frame cache of derived image representations.
+ */
+
+#pragma once
+
+#include "camera.h"
+#include "frame_arena.h"
+#include "frame_ref.h"
+
+/**
+ * @class FrameContext
+ * @brief Wraps one captured frame and lazily derives its representations.
+ * @details Every accessor computes its representation on first use, stores it in
+ * the shared FrameArena and returns the cached buffer on later calls. Detectors,
+ * trackers and debug views can therefore ask for greyscale, edges, a downsampled
+ * plane or an integral image in any order and the frame is still decoded and
+ * converted at most once. Arena space is only taken when a representation is
+ * first asked for, so a frame costs what its consumers use: a detector reading
+ * luma never pays for edges or the integral image. release() invalidates every
+ * cached buffer together with the frame itself.
+ */
+class FrameContext
+{
+private:
+    FrameArena& _arena;  ///< Backing storage for every derived buffer.
+    camera_fb_t* _frame; ///< Wrapped frame, nullptr when detached.
+    Camera* _owner;      ///< Camera the frame is returned to on release (optional).
+    FrameRef _ref;       ///< Reference held while a shared frame is attached.
+
+    const uint8_t* _rgb565;      ///< Big-endian RGB565 plane (decoded or the frame itself).
+    const uint8_t* _greyscale;   ///< 8-bit luma plane.
+    const uint8_t* _edges;       ///< Roberts-cross edge map.
+    const uint8_t* _downsampled; ///< Half resolution luma plane.
+    const uint32_t* _integral;   ///< Summed-area table of the luma plane.
+    bool _decode_attempted;      ///< Set once JPEG decoding ran, so a corrupt frame is not decoded twice.
+
+    /** @brief Drops every cached pointer (the arena is reset separately). */
+    void _invalidate();
+
+public:
+    /**
+     * @brief Construct an empty context.
+     * @param arena Arena that will back the derived buffers of each attached frame.
+     */
+    explicit FrameContext(FrameArena& arena);
+
+    /** @brief Releases the attached frame, if any. */
+    ~FrameContext() { release(); }
+
+    FrameContext(const FrameContext&) = delete;
+    FrameContext& operator=(const FrameContext&) = delete;
+
+    /**
+     * @brief Wraps a freshly captured frame, releasing the previous one first.
+     * @param frame Frame to wrap.
+     * @param owner Camera to hand the frame back to on release(), or nullptr if the
+     * caller keeps ownership.
+     * @return true if a frame was attached.
+     */
+    bool attach(camera_fb_t* frame, Camera* owner = nullptr);
+
+    /**
+     * @brief Wraps a shared frame, holding a reference to it until release().
+     * @param frame Handle to wrap; other holders keep the buffer alive independently.
+     * @return true if a frame was attached.
+     */
+    bool attach(const FrameRef& frame);
+
+    /**
+     * @brief Invalidates every cached representation, resets the arena and returns
+     * the frame to its owner, or drops the reference to a shared frame.
+     */
+    void release();
+
+    /** @return The wrapped frame, or nullptr when detached. */
+    camera_fb_t* frame() const { return this->_frame; }
+
+    /** @return Frame width in pixels (0 when detached). */
+    size_t width() const { return this->_frame ? this->_frame->width : 0; }
+
+    /** @return Frame height in pixels (0 when detached). */
+    size_t height() const { return this->_frame ? this->_frame->height : 0; }
+
+    /** @return Big-endian RGB565 plane, decoding JPEG on first use (nullptr for greyscale frames). */
+    const uint8_t* rgb565();
+
+    /** @return 8-bit luma plane, width * height bytes. */
+    const uint8_t* greyscale();
+
+    /**
+     * @brief Converts the luma plane straight into a caller-owned buffer and caches it there.
+     * @details Lets a detector that keeps luma across frames have it written into its
+     * history slot instead of copying it out of the arena afterwards. Later greyscale(),
+     * edges() etc. calls read the same buffer, so it must stay untouched until release().
+     * Greyscale frames, and luma another consumer already derived, are copied once.
+     * @param destination Buffer of width * height bytes.
+     * @return destination, or nullptr if the frame has no luma.
+     */
+    const uint8_t* greyscale_into(uint8_t* destination);
+
+    /** @return Roberts-cross edge map, width * height bytes. */
+    const uint8_t* edges();
+
+    /** @return 2x2 box-filtered luma plane, (width / 2) * (height / 2) bytes. */
+    const uint8_t* downsampled();
+
+    /** @return Summed-area table of the luma plane, (width + 1) * (height + 1) entries. */
+    const uint32_t* integral();
+};
@@ -0,0 +1,82 @@
+/**
+ * @file frame_ref.h
+ * @brief Reference-counted handle to a camera frame buffer.
+ */
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <atomic>
+
+#include "esp_camera.h"
+
+#define FRAME_REF_POOL_SIZE 8 /**< Frames shared at once; above the driver's fb_count with room to spare. */
+
+/**
+ * @struct FrameRefBlock
+ * @brief Shared state of one referenced frame; lives in a static pool, never on the heap.
+ */
+struct FrameRefBlock {
+    camera_fb_t* frame = nullptr;  /**< Valid while refs > 0. */
+    std::atomic<uint32_t> refs{0}; /**< Live FrameRef handles; 0 marks the block free. */
+};
+
+/**
+ * @class FrameRef
+ * @brief Shared, zero-copy ownership of a camera_fb_t.
+ * @details Copying a FrameRef adds a reference; destroying or resetting one drops it.
+ * When the last reference goes, the buffer goes back to esp_camera_fb_return(), so
+ * the stream, the detector and the recorder can each hold the same capture for as
+ * long as they need it without copying pixels or coordinating who returns it.
+ * Reference counts are atomic, so handles can be copied and dropped on any core.
+ * A handle itself is not thread-safe: share it by copy, not by reference.
+ *
+ * Control blocks come from a fixed pool of FRAME_REF_POOL_SIZE. If the pool is
+ * exhausted, adopt() returns the frame to the driver at once and gives an empty handle.
+ */
+class FrameRef
+{
+private:
+    FrameRefBlock* _block; /**< nullptr for an empty handle. */
+
+    explicit FrameRef(FrameRefBlock* block) : _block(block) {}
+
+    /** @brief Drops this handle's reference, returning the frame if it was the last. */
+    void _drop();
+
+public:
+    /** @brief Construct an empty handle. */
+    FrameRef() : _block(nullptr) {}
+
+    FrameRef(const FrameRef& other);
+    FrameRef(FrameRef&& other) noexcept : _block(other._block) { other._block = nullptr; }
+    FrameRef& operator=(const FrameRef& other);
+    FrameRef& operator=(FrameRef&& other) noexcept;
+    ~FrameRef() { _drop(); }
+
+    /**
+     * @brief Takes ownership of a frame from esp_camera_fb_get().
+     * @param frame Captured frame, or nullptr.
+     * @return A handle holding the only reference, or an empty handle if @p frame is
+     * nullptr or the pool is exhausted (the frame has then already been returned).
+     */
+    static FrameRef adopt(camera_fb_t* frame);
+
+    /** @brief Drops the reference now instead of at destruction. */
+    void reset() { _drop(); }
+
+    /** @return The frame, or nullptr for an empty handle. */
+    camera_fb_t* get() const { return this->_block ? this->_block->frame : nullptr; }
+
+    camera_fb_t* operator->() const { return get(); }
+
+    /** @return true if the handle holds a frame. */
+    explicit operator bool() const { return this->_block != nullptr; }
+
+    /** @return Handles sharing this frame, 0 for an empty handle; a snapshot under concurrency. */
+    uint32_t use_count() const { return this->_block ? this->_block->refs.load(std::memory_order_relaxed) : 0; }
+
+    /** @return Pool blocks currently in use, i.e. distinct frames held through FrameRef. */
+    static size_t frames_in_use();
+};
@@ -0,0 +1,105 @@
+/**
+ * @file global_motion.h
+ * @brief Whole-frame translation estimate from row and column intensity projections.
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define GLOBAL_MOTION_MIN_CONTRAST 2    /**< Mean deviation of a projection, in grey levels, below which it is flat. */
+#define GLOBAL_MOTION_MAX_SHIFT 128     /**< Upper bound of the search range in pixels. */
+#define GLOBAL_MOTION_MIN_OVERLAP_DIV 2 /**< The search never leaves less than 1/N of a projection overlapping. */
+#define GLOBAL_MOTION_DISTINCT_RATIO 2  /**< The best shift must beat the average shift by this factor. */
+
+/**
+ * @struct GlobalShift
+ * @brief Translation of the current frame relative to the reference.
+ * @details Positive dx means the scene content moved right, positive dy that it
+ * moved down (image rows), both in 1/16 pixel like DetectionResult errors.
+ */
+struct GlobalShift {
+    int32_t dx_q4 = 0;  /**< Horizontal shift, Q4 pixels. */
+    int32_t dy_q4 = 0;  /**< Vertical shift, Q4 pixels. */
+    bool valid = false; /**< false if either axis had no usable texture or no distinct match. */
+};
+
+/**
+ * @class GlobalMotionEstimator
+ * @brief Measures how far the whole image moved between a reference and a later frame.
+ * @details Each frame is reduced to its column sums and row sums, so a W x H frame
+ * costs one pass and leaves only W + H values to match. Each axis is matched on its
+ * own: for every integer shift in range, the mean absolute difference over the
+ * overlap is taken after removing the mean offset between the two profiles, which
+ * keeps an exposure change from looking like motion. The best shift is refined to
+ * 1/16 pixel with an equiangular line fit, which suits the V-shaped SAD curve
+ * better than a parabola.
+ *
+ * This assumes the motion is a pure translation, which holds for the small pan and
+ * tilt steps the Calibrator makes; it does not handle rotation or parallax.
+ */
+class GlobalMotionEstimator
+{
+private:
+    int32_t* _reference_cols; ///< Mean-free column projection of the reference, Q4 grey levels.
+    int32_t* _reference_rows; ///< Mean-free row projection of the reference, Q4 grey levels.
+    int32_t* _cols;           ///< Scratch column projection of the current frame.
+    int32_t* _rows;           ///< Scratch row projection of the current frame.
+    size_t _width;            ///< Frame width the buffers were allocated for.
+    size_t _height;           ///< Frame height the buffers were allocated for.
+    bool _has_reference;      ///< True once set_reference() accepted a frame.
+
+    /** @brief Allocates the projection buffers for a new geometry. */
+    bool _allocate(size_t width, size_t height);
+
+    /**
+     * @brief Computes both mean-free projections of @p luma.
+     * @return false if either projection is too flat to match.
+     */
+    bool _project(const uint8_t* luma, int32_t* cols, int32_t* rows) const;
+
+    /**
+     * @brief Finds the shift of @p current against @p reference along one axis.
+     * @param length Number of entries in both projections.
+     * @param max_shift Largest shift tried in either direction.
+     * @param shift_q4 Receives the sub-pixel shift.
+     * @return false if the best match is at the edge of the search or not distinct.
+     */
+    static bool _match(const int32_t* reference, const int32_t* current, size_t length, int32_t max_shift,
+                       int32_t& shift_q4);
+
+public:
+    GlobalMotionEstimator()
+        : _reference_cols(nullptr), _reference_rows(nullptr), _cols(nullptr), _rows(nullptr), _width(0), _height(0),
+          _has_reference(false)
+    {
+    }
+    ~GlobalMotionEstimator();
+
+    GlobalMotionEstimator(const GlobalMotionEstimator&) = delete;
+    GlobalMotionEstimator& operator=(const GlobalMotionEstimator&) = delete;
+
+    /**
+     * @brief Stores the frame later frames are compared against.
+     * @param luma Greyscale frame, width * height bytes.
+     * @param width Frame width in pixels.
+     * @param height Frame height in pixels.
+     * @return false if the frame has too little texture to track or allocation failed.
+     */
+    bool set_reference(const uint8_t* luma, size_t width, size_t height);
+
+    /** @return true once a reference frame is stored. */
+    bool has_reference() const { return this->_has_reference; }
+
+    /**
+     * @brief Estimates the translation of @p luma relative to the reference.
+     * @param luma Greyscale frame with the same geometry as the reference.
+     * @param width Frame width in pixels.
+     * @param height Frame height in pixels.
+     * @param max_shift Search range in pixels, clamped to GLOBAL_MOTION_MAX_SHIFT and
+     * to the overlap limit of each axis.
+     * @return The shift; invalid without a matching reference or usable texture.
+     */
+    GlobalShift estimate(const uint8_t* luma, size_t width, size_t height, int32_t max_shift);
+};
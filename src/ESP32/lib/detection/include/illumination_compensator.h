@@ -0,0 +1,59 @@
+/**
+ * @file illumination_compensator.h
+ * @brief Global gain/offset correction between a frame and its reference.
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define ILLUMINATION_SAMPLE_STRIDE 8 /**< Statistics use every Nth pixel of every Nth row. */
+#define ILLUMINATION_MIN_SHIFT 6     /**< Mean shift (grey levels) below which no correction is applied. */
+#define ILLUMINATION_GAIN_SHIFT 8    /**< Fixed-point fraction bits of the gain (Q8). */
+#define ILLUMINATION_MIN_GAIN 128    /**< 0.5 in Q8; darker changes are not treated as lighting. */
+#define ILLUMINATION_MAX_GAIN 512    /**< 2.0 in Q8; brighter changes are not treated as lighting. */
+
+/**
+ * @class IlluminationCompensator
+ * @brief Cancels auto-exposure steps and passing clouds before frame differencing.
+ * @details The mean and standard deviation of a sparse pixel grid are compared
+ * between two planes, giving a linear model target ≈ gain * source + offset.
+ * When the model differs noticeably from the identity it is baked into a 256-entry
+ * LUT, and applying it costs one table lookup per pixel. The detector maps its
+ * reference onto the new frame, so the reference takes on each lighting change once.
+ */
+class IlluminationCompensator
+{
+private:
+    uint8_t _lut[256]; ///< Source -> target intensity mapping.
+    int32_t _gain_q8;  ///< Last estimated gain (Q8).
+    int32_t _offset;   ///< Last estimated offset in grey levels.
+
+public:
+    IlluminationCompensator() : _gain_q8(1 << ILLUMINATION_GAIN_SHIFT), _offset(0) {}
+
+    /**
+     * @brief Estimates gain and offset mapping @p source onto @p target.
+     * @param source Luma plane to be corrected, e.g. a reference of the detector.
+     * @param target Luma plane whose lighting @p source should match, e.g. the new frame.
+     * @param width Frame width in pixels.
+     * @param height Frame height in pixels.
+     * @return true if a global lighting change was found and the LUT was rebuilt.
+     */
+    bool estimate(const uint8_t* source, const uint8_t* target, size_t width, size_t height);
+
+    /**
+     * @brief Remaps a luma plane through the LUT built by estimate().
+     * @param source Plane to correct.
+     * @param destination Corrected output; may be the same buffer as @p source.
+     * @param size Number of pixels.
+     */
+    void apply(const uint8_t* source, uint8_t* destination, size_t size) const;
+
+    /** @return Last estimated gain in Q8 (256 == 1.0). */
+    int32_t get_gain_q8() const { return this->_gain_q8; }
+
+    /** @return Last estimated offset in grey levels. */
+    int32_t get_offset() const { return this->_offset; }
+};
@@ -0,0 +1,66 @@
+/**
+ * @file image_ops.h
+ * @brief Stateless pixel kernels shared by the detection pipeline.
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * @namespace ImageOps
+ * @brief Plain-buffer image kernels with no allocation and no camera dependency.
+ */
+namespace ImageOps
+{
+/** @brief Converts one RGB565 pixel to 8-bit luma (BT.601 weights, always within [0, 255]). */
+inline uint8_t rgb565_to_greyscale(uint16_t pixel)
+{
+    // Extract R (5 bits), G (6 bits), B (5 bits)
+    uint32_t red = (pixel >> 11) & 0x1f;
+    uint32_t green = (pixel >> 5) & 0x3f;
+    uint32_t blue = pixel & 0x1f;
+
+    // BT.601 weights (77, 150, 29) / 256 folded with the 5/6-bit to 8-bit expansion
+    return (uint8_t)((red * 616 + green * 600 + blue * 232) >> 8);
+}
+
+/** @brief Roberts-cross L1 gradient magnitude of the 2x2 block starting at column x. */
+inline uint8_t roberts_magnitude(const uint8_t* row, const uint8_t* next_row, size_t x)
+{
+    // P1 P2
+    // P3 P4
+    int gx = (int)row[x] - (int)next_row[x + 1];
+    int gy = (int)row[x + 1] - (int)next_row[x];
+    int magnitude = (gx < 0 ? -gx : gx) + (gy < 0 ? -gy : gy);
+
+    return (magnitude > 255) ? 255 : (uint8_t)magnitude;
+}
+
+/**
+ * @brief Converts a big-endian RGB565 plane (camera/decoder byte order) to luma.
+ * @param rgb Source, pixels * 2 bytes.
+ * @param output_grey Destination, pixels bytes.
+ * @param pixels Number of pixels.
+ */
+void rgb565_plane_to_greyscale(const uint8_t* rgb, uint8_t* output_grey, size_t pixels);
+
+/**
+ * @brief Roberts-cross edge map of a luma plane.
+ * @details The last row and column have no 2x2 neighbourhood and are written as 0.
+ */
+void roberts_cross(const uint8_t* luma, uint8_t* output_edges, size_t width, size_t height);
+
+/**
+ * @brief 2x2 box-filter downsample.
+ * @param output Destination, (width / 2) * (height / 2) bytes.
+ */
+void downsample_2x(const uint8_t* luma, uint8_t* output, size_t width, size_t height);
+
+/**
+ * @brief Summed-area table of a luma plane.
+ * @param output Destination, (width + 1) * (height + 1) entries; row 0 and column 0 are zero.
+ */
+void integral_image(const uint8_t* luma, uint32_t* output, size_t width, size_t height);
+} // namespace ImageOps
@@ -0,0 +1,66 @@
+/**
+ * @file lens_model.h
+ * @brief Pinhole camera with radial barrel distortion, mapping pixels to pan/tilt angles.
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+#include "camera_calibration.h"
+
+#define LENS_UNDISTORT_ITERATIONS 6 /**< Fixed-point iterations to invert the distortion; converges well inside 1e-4 px. */
+
+/**
+ * @struct LensModel
+ * @brief Geometry of the camera as the turret sees it.
+ * @details Pixel coordinates are measured from the frame centre, x to the right and
+ * y down, like DetectionResult errors. A pixel is normalised by the focal length,
+ * undistorted with the single radial term k1 (negative for the OV2640 barrel), and
+ * turned into the pan and tilt rotations that bring its ray onto the optical axis:
+ * pan = atan(x_u) and tilt = atan(y_u / sqrt(1 + x_u^2)). Tilt keeps the image sign,
+ * positive down.
+ *
+ * The focal lengths are chosen so the distorted frame edges sit at half the field
+ * of view, which makes the average scale across the frame width / fov pixels per
+ * degree, the scale the nominal PID profiles and the Calibrator both work in.
+ */
+struct LensModel {
+    float fx = 1.0f;       /**< Horizontal focal length, pixels per unit of normalised image plane. */
+    float fy = 1.0f;       /**< Vertical focal length. */
+    float k1 = 0.0f;       /**< Radial distortion coefficient. */
+    float hfov_deg = 0.0f; /**< Horizontal field of view spanned by the frame. */
+    float vfov_deg = 0.0f; /**< Vertical field of view spanned by the frame. */
+
+    /**
+     * @brief Lens whose frame spans the given field of view edge to edge.
+     * @param width Frame width in pixels.
+     * @param height Frame height in pixels.
+     * @param hfov_deg Horizontal field of view.
+     * @param vfov_deg Vertical field of view.
+     * @param k1 Radial distortion coefficient.
+     */
+    static LensModel from_fov(uint16_t width, uint16_t height, float hfov_deg, float vfov_deg, float k1);
+
+    /** @brief The stock lens: CAMERA_HFOV_DEG x CAMERA_VFOV_DEG with CAMERA_DISTORTION_K1. */
+    static LensModel nominal(uint16_t width, uint16_t height);
+
+    /**
+     * @brief The stock distortion, with the field of view implied by a measured calibration.
+     * @details The Calibrator measures the average scale across the frame, so the
+     * effective field of view is the frame size divided by that scale.
+     */
+    static LensModel calibrated(const CameraCalibration& calibration, uint16_t width, uint16_t height);
+
+    /**
+     * @brief Angles from the optical axis to a pixel.
+     * @param x Pixel column relative to the frame centre, positive right.
+     * @param y Pixel row relative to the frame centre, positive down.
+     * @param pan_deg Receives the pan rotation, positive right.
+     * @param tilt_deg Receives the tilt rotation, positive down.
+     */
+    void pixel_to_angles(float x, float y, float& pan_deg, float& tilt_deg) const;
+
+    /** @brief Inverse of pixel_to_angles(): where a direction lands in the frame. */
+    void angles_to_pixel(float pan_deg, float tilt_deg, float& x, float& y) const;
+};
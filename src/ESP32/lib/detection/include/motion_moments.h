@@ -0,0 +1,66 @@
+/**
+ * @file motion_moments.h
+ * @brief Accumulator for the zeroth and first order moments of a motion mask.
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+/**
+ * @struct MotionMoments
+ * @brief Running sums over every pixel flagged as "moving" by a detection kernel.
+ * @details Kernels accumulate into this struct inline instead of materialising a
+ * binary mask, so the centroid falls out of the same pass that classifies pixels.
+ */
+struct MotionMoments {
+    uint32_t count = 0; /**< Number of moving pixels (m00). */
+    uint32_t sum_x = 0; /**< Sum of x coordinates (m10). */
+    uint32_t sum_y = 0; /**< Sum of y coordinates (m01). */
+
+    uint16_t min_x = UINT16_MAX; /**< Left-most moving column. */
+    uint16_t min_y = UINT16_MAX; /**< Top-most moving row. */
+    uint16_t max_x = 0;          /**< Right-most moving column. */
+    uint16_t max_y = 0;          /**< Bottom-most moving row. */
+
+    /** @brief Records a single moving pixel at (x, y). */
+    inline void add(uint32_t x, uint32_t y)
+    {
+        this->count++;
+        this->sum_x += x;
+        this->sum_y += y;
+
+        if (x < this->min_x)
+            this->min_x = x;
+        if (x > this->max_x)
+            this->max_x = x;
+        if (y < this->min_y)
+            this->min_y = y;
+        if (y > this->max_y)
+            this->max_y = y;
+    }
+
+    /**
+     * @brief Folds in the moments of another region, e.g. one row band of the frame.
+     * @details Every field is a sum or an extremum, so merging the bands of a frame
+     * gives exactly the moments of a single pass over the whole frame.
+     */
+    inline void merge(const MotionMoments& other)
+    {
+        this->count += other.count;
+        this->sum_x += other.sum_x;
+        this->sum_y += other.sum_y;
+
+        if (other.min_x < this->min_x)
+            this->min_x = other.min_x;
+        if (other.max_x > this->max_x)
+            this->max_x = other.max_x;
+        if (other.min_y < this->min_y)
+            this->min_y = other.min_y;
+        if (other.max_y > this->max_y)
+            this->max_y = other.max_y;
+    }
+
+    /** @brief Clears all sums. */
+    inline void reset() { *this = MotionMoments(); }
+};
@@ -0,0 +1,66 @@
+/**
+ * @file pixel_angle_lut.h
+ * @brief Precomputed map from detector coordinates to pan/tilt angle offsets.
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+#include "lens_model.h"
+
+#define PIXEL_ANGLE_GRID_COLS 33    /**< Grid nodes across the frame, edges included. */
+#define PIXEL_ANGLE_GRID_ROWS 25    /**< Grid nodes down the frame, edges included. */
+#define PIXEL_ANGLE_FRACTION_BITS 8 /**< Angles are stored and returned in 1/256 degree (Q8). */
+
+/**
+ * @class PixelAngleLut
+ * @brief Tabulates a LensModel so aiming at a detection costs one bilinear lookup.
+ * @details The lens model needs an iterative undistortion and two arctangents per
+ * point. Sampling it once per frame size on a fixed grid and interpolating keeps the
+ * edge and corner bias of the barrel distortion out of the control loop, at the cost
+ * of 3.3 KB and a few integer multiplies per frame. The grid is the same size for
+ * every resolution, so interpolation error is a constant share of the field of view.
+ */
+class PixelAngleLut
+{
+private:
+    int16_t _pan_q8[PIXEL_ANGLE_GRID_ROWS][PIXEL_ANGLE_GRID_COLS];  ///< Pan offset per node, positive right.
+    int16_t _tilt_q8[PIXEL_ANGLE_GRID_ROWS][PIXEL_ANGLE_GRID_COLS]; ///< Tilt offset per node, positive down.
+    uint16_t _width;                                                ///< Frame width the table was built for.
+    uint16_t _height;                                               ///< Frame height the table was built for.
+
+public:
+    PixelAngleLut() : _width(0), _height(0) {}
+
+    /**
+     * @brief Samples @p lens at every grid node of a @p width x @p height frame.
+     */
+    void build(const LensModel& lens, uint16_t width, uint16_t height);
+
+    /** @brief Forgets the table; lookups return zero until the next build(). */
+    void clear()
+    {
+        this->_width = 0;
+        this->_height = 0;
+    }
+
+    /** @return true once build() has run. */
+    bool is_built() const { return this->_width > 0; }
+
+    /** @return Frame width the table was built for (0 before build()). */
+    uint16_t width() const { return this->_width; }
+
+    /** @return Frame height the table was built for (0 before build()). */
+    uint16_t height() const { return this->_height; }
+
+    /**
+     * @brief Angles from the optical axis to a detector coordinate.
+     * @param x_q4 Column relative to the frame centre, Q4 pixels (DetectionResult::error_x).
+     * @param y_q4 Row relative to the frame centre, Q4 pixels (DetectionResult::error_y).
+     * @param pan_q8 Receives the pan offset, Q8 degrees, positive right.
+     * @param tilt_q8 Receives the tilt offset, Q8 degrees, positive down.
+     * @details Coordinates outside the frame are clamped to its edge.
+     */
+    void lookup(int32_t x_q4, int32_t y_q4, int32_t& pan_q8, int32_t& tilt_q8) const;
+};
@@ -0,0 +1,85 @@
+/**
+ * @file sigma_delta_background.h
+ * @brief Sigma-Delta (Σ-Δ) per-pixel background estimator.
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "motion_moments.h"
+
+#define SIGMA_DELTA_AMPLIFICATION 2  /**< N: the variance converges towards N * |I - M|. */
+#define SIGMA_DELTA_MIN_VARIANCE 12  /**< Lower clamp; doubles as the minimum motion threshold. */
+#define SIGMA_DELTA_MAX_VARIANCE 250 /**< Upper clamp so a pixel can never become blind. */
+
+/**
+ * @class SigmaDeltaBackground
+ * @brief Tracks a slowly adapting background using only ±1 updates per pixel.
+ * @details For every pixel the estimator keeps a mean M and a variance V, both as
+ * uint8 planes. Each frame M steps one grey level towards the current intensity I,
+ * and V steps one level towards N * |I - M|. A pixel is foreground when
+ * |I - M| >= V. Gradual lighting drift is absorbed by M, while noisy regions
+ * (foliage, water) raise their own V and stop triggering.
+ */
+class SigmaDeltaBackground
+{
+private:
+    uint8_t* _mean;     ///< M plane: background intensity estimate.
+    uint8_t* _variance; ///< V plane: per-pixel adaptive threshold.
+    size_t _size;       ///< Number of pixels in each plane.
+    bool _primed;       ///< True once M has been seeded from a real frame.
+
+public:
+    SigmaDeltaBackground() : _mean(nullptr), _variance(nullptr), _size(0), _primed(false) {}
+    ~SigmaDeltaBackground();
+
+    SigmaDeltaBackground(const SigmaDeltaBackground&) = delete;
+    SigmaDeltaBackground& operator=(const SigmaDeltaBackground&) = delete;
+
+    /**
+     * @brief Allocates the M and V planes in PSRAM.
+     * @param plane_size Number of pixels per frame (width * height).
+     * @return true if both planes are available.
+     */
+    bool begin(size_t plane_size);
+
+    /**
+     * @brief Forgets the learned background; the next frame re-seeds it.
+     */
+    void reset() { this->_primed = false; }
+
+    /** @return true once the model has been seeded and can classify pixels. */
+    bool is_primed() const { return this->_primed; }
+
+    /** @return Read-only view of the background mean plane (nullptr before begin()). */
+    const uint8_t* mean() const { return this->_mean; }
+
+    /** @return Writable view of the mean plane, to remap it after a global lighting change. */
+    uint8_t* mean() { return this->_mean; }
+
+    /**
+     * @brief Updates the model with a new luma frame and accumulates foreground pixels.
+     * @details The first call after begin()/reset() only seeds the model and reports
+     * no motion.
+     * @param luma Greyscale frame, width * height bytes.
+     * @param width Frame width in pixels.
+     * @param height Frame height in pixels.
+     * @param moments Accumulator receiving every foreground pixel.
+     */
+    void update(const uint8_t* luma, size_t width, size_t height, MotionMoments& moments);
+
+    /**
+     * @brief Runs update() over rows [row_begin, row_end) of a seeded model.
+     * @details Pixels are independent, so disjoint row bands can be updated
+     * concurrently, each into its own accumulator. The caller must have checked
+     * is_primed() and the frame size.
+     * @param luma Greyscale frame, width * height bytes.
+     * @param width Frame width in pixels.
+     * @param row_begin First row of the band.
+     * @param row_end One past the last row of the band.
+     * @param moments Accumulator receiving the band's foreground pixels.
+     */
+    void update_rows(const uint8_t* luma, size_t width, size_t row_begin, size_t row_end, MotionMoments& moments);
+};
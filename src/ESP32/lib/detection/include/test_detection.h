@@ -14,6 +14,8 @@ public:
     TestDetection() {}
     ~TestDetection() {}
 
+    using BaseDetectionModule::detect_object;
+
     std::tuple<MoveDirectionX, MoveDirectionY> detect_object(camera_fb_t* frame)
     {
         srand(time(0));
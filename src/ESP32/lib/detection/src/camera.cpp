@@ -2,6 +2,8 @@
 
 #include <Arduino.h>
 
+#include "latency_probe.h"
+
 bool Camera::begin()
 {
     esp_err_t err = esp_camera_init(&_config);
@@ -17,6 +19,16 @@ bool Camera::begin()
     return true;
 }
 
-camera_fb_t* Camera::capture() { return esp_camera_fb_get(); }
+camera_fb_t* Camera::capture()
+{
+    LATENCY_PROBE(Capture);
+    return esp_camera_fb_get();
+}
+
+FrameRef Camera::capture_ref()
+{
+    LATENCY_PROBE(Capture);
+    return FrameRef::adopt(esp_camera_fb_get());
+}
 
 void Camera::release(camera_fb_t* fb) { esp_camera_fb_return(fb); }
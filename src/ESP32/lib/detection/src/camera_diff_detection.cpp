@@ -2,82 +2,386 @@
 
 #include <esp_camera.h>
 #include <esp_heap_caps.h>
+#include <stdlib.h>
+#include <string.h>
+#include <utility>
 
-CameraDiffDetection::~CameraDiffDetection() {}
+#include "image_ops.h"
+#include "latency_probe.h"
+
+CameraDiffDetection::CameraDiffDetection(DiffMode mode)
+    : _mode(mode), _width(0), _height(0), _current(nullptr), _reference(nullptr), _older(nullptr), _history(0),
+      _edges(nullptr), _previous_edges(nullptr), _compensate_illumination(true), _suppressed_lighting_events(0),
+      _workers(nullptr)
+{
+}
+
+CameraDiffDetection::~CameraDiffDetection() { _free_buffers(); }
+
+void CameraDiffDetection::set_mode(DiffMode mode)
+{
+    this->_mode = mode;
+    this->_history = 0;
+    this->_background.reset();
+}
 
-// TODO: add detecition algorithm corrently half implemented
 std::tuple<MoveDirectionX, MoveDirectionY> CameraDiffDetection::detect_object(camera_fb_t* frame)
 {
-    /*
-    // 1. E_xtract the raw numeric coordinates from the input
-    uint8_t new_x = std::get<0>(current_location);
-    uint8_t new_y = std::get<1>(current_location);
+    FrameContext context(this->_arena);
+    context.attach(frame);
+
+    return detect_object(context);
+}
+
+std::tuple<MoveDirectionX, MoveDirectionY> CameraDiffDetection::detect_object(FrameContext& context)
+{
+    return detect(context).to_directions(DIFF_CENTER_DEADZONE);
+}
+
+DetectionResult CameraDiffDetection::detect(FrameContext& context)
+{
+    if (!_ensure_buffers(context.width(), context.height()))
+    {
+        return DetectionResult();
+    }
+
+    bool keeps_history = (this->_mode == DiffMode::PreviousFrame || this->_mode == DiffMode::ThreeFrame);
+
+    // Modes that diff against earlier frames have luma converted straight into the
+    // ring's free slot, so rotating the history afterwards is a pointer swap
+    const uint8_t* luma = keeps_history ? context.greyscale_into(this->_current) : context.greyscale();
+    if (!luma)
+    {
+        return DetectionResult();
+    }
+
+    // Cancel global exposure/lighting steps so they do not register as motion. The
+    // reference is moved onto the new level rather than the frame onto the old one,
+    // so the model takes on the new exposure and the step is only seen once
+    bool lighting_corrected = false;
+    const uint8_t* reference = _active_reference();
+    if (this->_compensate_illumination && reference)
+    {
+        lighting_corrected = this->_illumination.estimate(reference, luma, this->_width, this->_height);
+    }
+    if (lighting_corrected)
+    {
+        _rebaseline();
+    }
+
+    MotionMoments moments;
+
+    switch (this->_mode)
+    {
+    case DiffMode::PreviousFrame:
+        if (this->_history >= 1)
+        {
+            _run_kernel(luma, moments);
+        }
+        _rotate_history();
+        break;
+
+    case DiffMode::SigmaDelta:
+        if (this->_background.is_primed())
+        {
+            _run_kernel(luma, moments);
+        } else
+        {
+            this->_background.update(luma, this->_width, this->_height, moments); // Seeds the model
+        }
+        break;
 
-    // 2. Compare numbers (this->_x) to numbers (new__x)
-    // 3. Assign the result to an Enum (MoveDirection_x)
-    MoveDirectionX x_axis_movement = (this->_x > new_x ? MoveDirectionX::Left
-        : (this->_x < new_x) ? MoveDirectionX::Right
-        : MoveDirectionX::None);
+    case DiffMode::ThreeFrame:
+        if (this->_history >= 2)
+        {
+            _run_kernel(luma, moments);
+        }
+        _rotate_history();
+        break;
 
-    MoveDirectionY y_axis_movement = (this->_y > new_y ? MoveDirectionY::Down
-        : (this->_y < new_y) ? MoveDirectionY::Up
-        : MoveDirectionY::None);
+    case DiffMode::Edge:
+        _run_kernel(luma, moments);
+        std::swap(this->_edges, this->_previous_edges);
+        this->_history = 1;
+        break;
+    }
 
-    return std::make_tuple(x_axis_movement, y_axis_movement);
-    */
+    if (lighting_corrected && moments.count < DIFF_MIN_CHANGED_PIXELS)
+    {
+        this->_suppressed_lighting_events++;
+    }
 
-    return std::make_tuple(MoveDirectionX::None, MoveDirectionY::None);
+    DetectionResult result = _moments_to_result(moments);
+    result.timestamp_us = DetectionResult::timeval_to_us(context.frame()->timestamp);
+    return result;
 }
 
-void CameraDiffDetection::roberts_cross(camera_fb_t* frame, uint8_t* output_edges)
+const uint8_t* CameraDiffDetection::_active_reference() const
 {
-    int w = frame->width;
-    int h = frame->height;
+    switch (this->_mode)
+    {
+    case DiffMode::PreviousFrame:
+    case DiffMode::ThreeFrame:
+        return (this->_history >= 1) ? this->_reference : nullptr;
+    case DiffMode::SigmaDelta:
+        return this->_background.is_primed() ? this->_background.mean() : nullptr;
+    case DiffMode::Edge:
+        // Gradients already cancel intensity offsets, no luma reference is kept
+        return nullptr;
+    }
+    return nullptr;
+}
 
-    uint16_t* rgb_buf = (uint16_t*)heap_caps_malloc(w * h * 2, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+void CameraDiffDetection::_rebaseline()
+{
+    size_t plane = this->_width * this->_height;
+    switch (this->_mode)
+    {
+    case DiffMode::PreviousFrame:
+    case DiffMode::ThreeFrame:
+        this->_illumination.apply(this->_reference, this->_reference, plane);
+        if (this->_history >= 2)
+        {
+            this->_illumination.apply(this->_older, this->_older, plane);
+        }
+        break;
+    case DiffMode::SigmaDelta:
+        this->_illumination.apply(this->_background.mean(), this->_background.mean(), plane);
+        break;
+    case DiffMode::Edge:
+        break;
+    }
+}
 
-    if (!rgb_buf)
+void CameraDiffDetection::_run_kernel(const uint8_t* luma, MotionMoments& moments)
+{
+    LATENCY_PROBE(Kernel);
+    BandJob job = {this, luma, {}};
+    if (this->_workers)
     {
-        return;
+        this->_workers->run(&CameraDiffDetection::_run_band, &job);
+    } else
+    {
+        _run_band(&job, 0, 1); // One band over the whole frame; the other slots stay empty
+    }
+
+    // Sums and extrema only, so the merged bands equal a single pass over the frame
+    for (size_t band = 0; band < ForkJoin::bands(); band++)
+    {
+        moments.merge(job.moments[band]);
+    }
+}
+
+void CameraDiffDetection::_run_band(void* arg, size_t band, size_t band_count)
+{
+    BandJob* job = static_cast<BandJob*>(arg);
+    CameraDiffDetection* detector = job->detector;
+    size_t row_begin = ForkJoin::band_begin(detector->_height, band, band_count);
+    size_t row_end = ForkJoin::band_begin(detector->_height, band + 1, band_count);
+
+    // Accumulate locally so the two cores never write neighbouring slots in the hot loop
+    MotionMoments moments;
+    switch (detector->_mode)
+    {
+    case DiffMode::PreviousFrame:
+        detector->_diff_previous(job->luma, row_begin, row_end, moments);
+        break;
+    case DiffMode::SigmaDelta:
+        detector->_background.update_rows(job->luma, detector->_width, row_begin, row_end, moments);
+        break;
+    case DiffMode::ThreeFrame:
+        detector->_diff_three_frame(job->luma, row_begin, row_end, moments);
+        break;
+    case DiffMode::Edge:
+        detector->_diff_edges(job->luma, row_begin, row_end, moments);
+        break;
+    }
+    job->moments[band] = moments;
+}
+
+void CameraDiffDetection::_diff_previous(const uint8_t* current, size_t row_begin, size_t row_end,
+                                         MotionMoments& moments)
+{
+    const uint8_t* reference = this->_reference;
+
+    size_t i = row_begin * this->_width;
+    for (size_t y = row_begin; y < row_end; y++)
+    {
+        for (size_t x = 0; x < this->_width; x++, i++)
+        {
+            if (abs((int)current[i] - (int)reference[i]) > DIFF_PIXEL_THRESHOLD)
+            {
+                moments.add(x, y);
+            }
+        }
     }
+}
+
+void CameraDiffDetection::_diff_three_frame(const uint8_t* current, size_t row_begin, size_t row_end,
+                                            MotionMoments& moments)
+{
+    const uint8_t* previous = this->_reference;
+    const uint8_t* older = this->_older;
 
-    if (jpg2rgb565(frame->buf, frame->len, (uint8_t*)rgb_buf, JPG_SCALE_NONE))
+    size_t i = row_begin * this->_width;
+    for (size_t y = row_begin; y < row_end; y++)
     {
-        for (int y = 0; y < h - 1; y++)
+        for (size_t x = 0; x < this->_width; x++, i++)
         {
-            int curr_row = y * w;
-            int next_row = (y + 1) * w;
+            int pixel = current[i];
+            bool changed_since_previous = abs(pixel - (int)previous[i]) > DIFF_PIXEL_THRESHOLD;
+            bool changed_since_older = abs(pixel - (int)older[i]) > DIFF_PIXEL_THRESHOLD;
 
-            for (int x = 0; x < w - 1; x++)
+            if (changed_since_previous && changed_since_older)
             {
-                uint8_t p1 = rgb565_to_greyscale(rgb_buf[curr_row + x]);
-                uint8_t p2 = rgb565_to_greyscale(rgb_buf[curr_row + x + 1]);
-                uint8_t p3 = rgb565_to_greyscale(rgb_buf[next_row + x]);
-                uint8_t p4 = rgb565_to_greyscale(rgb_buf[next_row + x + 1]);
+                moments.add(x, y);
+            }
+        }
+    }
+}
 
-                int gx = p1 - p4;
-                int gy = p2 - p3;
+void CameraDiffDetection::_diff_edges(const uint8_t* luma, size_t row_begin, size_t row_end,
+                                      MotionMoments& moments)
+{
+    uint8_t* edges = this->_edges;
+    const uint8_t* previous_edges = this->_previous_edges;
+    bool compare = this->_history >= 1;
+
+    // Row y also reads row y + 1, which may belong to the next band; luma is read-only
+    for (size_t y = row_begin; y < row_end && y + 1 < this->_height; y++)
+    {
+        const uint8_t* row = &luma[y * this->_width];
+        const uint8_t* next_row = row + this->_width;
+        size_t row_start = y * this->_width;
 
-                // L1 Norm (Manhattan distance)
-                int magnitude = abs(gx) + abs(gy);
+        for (size_t x = 0; x + 1 < this->_width; x++)
+        {
+            uint8_t magnitude = ImageOps::roberts_magnitude(row, next_row, x);
+            edges[row_start + x] = magnitude;
 
-                output_edges[curr_row + x] = (magnitude > 255) ? 255 : (uint8_t)magnitude;
+            if (compare && abs((int)magnitude - (int)previous_edges[row_start + x]) > DIFF_EDGE_THRESHOLD)
+            {
+                moments.add(x, y);
             }
         }
     }
+}
+
+void CameraDiffDetection::_rotate_history()
+{
+    // Pointer rotation only: the oldest plane is recycled as the next capture target
+    uint8_t* recycled = this->_older;
+    this->_older = this->_reference;
+    this->_reference = this->_current;
+    this->_current = recycled;
+
+    if (this->_history < 2)
+    {
+        this->_history++;
+    }
+}
+
+DetectionResult CameraDiffDetection::_moments_to_result(const MotionMoments& moments) const
+{
+    LATENCY_PROBE(Centroid);
+    DetectionResult result;
+    result.frame_width = this->_width;
+    result.frame_height = this->_height;
+
+    if (moments.count < DIFF_MIN_CHANGED_PIXELS)
+    {
+        return result;
+    }
+
+    // Centroid in Q4, measured from pixel centres (+0.5 px) to the geometric frame centre
+    const int64_t one = 1 << DETECTION_SUBPIXEL_BITS;
+    int64_t centroid_x = ((int64_t)moments.sum_x * one) / moments.count + one / 2;
+    int64_t centroid_y = ((int64_t)moments.sum_y * one) / moments.count + one / 2;
+
+    result.error_x = (int16_t)(centroid_x - (int64_t)this->_width * one / 2);
+    result.error_y = (int16_t)(centroid_y - (int64_t)this->_height * one / 2);
 
-    // Ensure we free the memory regardless of success/failure
-    free(rgb_buf);
+    // Confidence ramps up with blob size and saturates at DIFF_CONFIDENT_PIXELS
+    uint32_t confidence = (moments.count * 255) / DIFF_CONFIDENT_PIXELS;
+    result.confidence = (uint8_t)((confidence > 255) ? 255 : (confidence == 0) ? 1 : confidence);
+
+    result.box.x = moments.min_x;
+    result.box.y = moments.min_y;
+    result.box.width = moments.max_x - moments.min_x + 1;
+    result.box.height = moments.max_y - moments.min_y + 1;
+
+    return result;
 }
 
-uint8_t CameraDiffDetection::rgb565_to_greyscale(uint16_t pixel)
+bool CameraDiffDetection::_ensure_buffers(size_t width, size_t height)
 {
-    // Extract R (5 bits), G (6 bits), G (5 bits) and move bits to a gretscale
-    // format
-    uint32_t red = (pixel >> 11) & 0x1f;
-    uint32_t green = (pixel >> 5) & 0x3f;
-    uint32_t blue = pixel & 0x1f;
+    if (width == 0 || height == 0)
+    {
+        return false;
+    }
+
+    if (this->_current && width == this->_width && height == this->_height)
+    {
+        return true;
+    }
+
+    _free_buffers();
+
+    size_t plane = width * height;
+    this->_current = (uint8_t*)heap_caps_malloc(plane, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+    this->_reference = (uint8_t*)heap_caps_malloc(plane, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+    this->_older = (uint8_t*)heap_caps_malloc(plane, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+    // Edge planes are zeroed once: the kernel never writes their last row and column
+    this->_edges = (uint8_t*)heap_caps_calloc(plane, 1, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+    this->_previous_edges = (uint8_t*)heap_caps_calloc(plane, 1, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+
+    if (!this->_current || !this->_reference || !this->_older || !this->_edges ||
+        !this->_previous_edges || !this->_background.begin(plane))
+    {
+        _free_buffers();
+        return false;
+    }
 
-    // Approximation: shift to a [0,255] range
-    return (uint8_t)((red * 2 + green * 5 + blue) << 1);
+    this->_width = width;
+    this->_height = height;
+    this->_history = 0;
+    this->_background.reset();
+    return true;
 }
+
+void CameraDiffDetection::_free_buffers()
+{
+    free(this->_current);
+    free(this->_reference);
+    free(this->_older);
+    free(this->_edges);
+    free(this->_previous_edges);
+    this->_current = nullptr;
+    this->_reference = nullptr;
+    this->_older = nullptr;
+    this->_edges = nullptr;
+    this->_previous_edges = nullptr;
+    this->_width = 0;
+    this->_height = 0;
+    this->_history = 0;
+}
+
+void CameraDiffDetection::roberts_cross(camera_fb_t* frame, uint8_t* output_edges)
+{
+    if (!output_edges)
+    {
+        return;
+    }
+
+    FrameArena arena;
+    FrameContext context(arena);
+    context.attach(frame);
+
+    const uint8_t* edges = context.edges();
+    if (edges)
+    {
+        memcpy(output_edges, edges, context.width() * context.height());
+    }
+}
+
+uint8_t CameraDiffDetection::rgb565_to_greyscale(uint16_t pixel) { return ImageOps::rgb565_to_greyscale(pixel); }
@@ -0,0 +1,89 @@
+#include "fork_join.h"
+
+#include <Arduino.h>
+
+ForkJoin::ForkJoin() : _started(false), _kernel(nullptr), _arg(nullptr), _caller(nullptr), _pending(0)
+{
+    for (size_t i = 0; i < FORK_JOIN_WORKERS; i++)
+    {
+        this->_workers[i].owner = this;
+        this->_workers[i].band = i;
+        this->_workers[i].handle = nullptr;
+    }
+}
+
+bool ForkJoin::start()
+{
+    if (this->_started)
+    {
+        return true;
+    }
+
+    for (size_t i = 0; i < FORK_JOIN_WORKERS; i++)
+    {
+        Worker& worker = this->_workers[i];
+        if (worker.handle)
+        {
+            continue; // Survived an earlier, partly failed start()
+        }
+
+        if (xTaskCreatePinnedToCore(&ForkJoin::_run_worker, "fork_join", FORK_JOIN_STACK_SIZE, &worker,
+                                    FORK_JOIN_PRIORITY, &worker.handle, (BaseType_t)i) != pdPASS)
+        {
+            Serial.printf("[ForkJoin] Failed to create worker %u\n", (unsigned)i);
+            worker.handle = nullptr;
+            return false;
+        }
+    }
+
+    this->_started = true;
+    return true;
+}
+
+void ForkJoin::run(ForkJoinKernel kernel, void* arg)
+{
+    if (!this->_started)
+    {
+        for (size_t band = 0; band < FORK_JOIN_WORKERS; band++)
+        {
+            kernel(arg, band, FORK_JOIN_WORKERS);
+        }
+        return;
+    }
+
+    this->_kernel = kernel;
+    this->_arg = arg;
+    this->_caller = xTaskGetCurrentTaskHandle();
+    this->_pending.store(FORK_JOIN_WORKERS, std::memory_order_release);
+
+    for (size_t i = 0; i < FORK_JOIN_WORKERS; i++)
+    {
+        xTaskNotifyGive(this->_workers[i].handle);
+    }
+
+    // The caller may also hold notifications from elsewhere; only the count says done
+    while (this->_pending.load(std::memory_order_acquire) > 0)
+    {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+    }
+}
+
+void ForkJoin::_run_worker(void* arg)
+{
+    Worker* worker = static_cast<Worker*>(arg);
+    ForkJoin* pool = worker->owner;
+
+    for (;;)
+    {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+
+        pool->_kernel(pool->_arg, worker->band, FORK_JOIN_WORKERS);
+
+        // Read the caller before the release: once _pending hits zero run() may return
+        TaskHandle_t caller = pool->_caller;
+        if (pool->_pending.fetch_sub(1, std::memory_order_acq_rel) == 1)
+        {
+            xTaskNotifyGive(caller);
+        }
+    }
+}
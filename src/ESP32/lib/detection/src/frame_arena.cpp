@@ -0,0 +1,114 @@
+#include "frame_arena.h"
+
+#include <esp_heap_caps.h>
+#include <stdlib.h>
+
+FrameArena::~FrameArena()
+{
+    for (size_t i = 0; i < this->_block_count; i++)
+    {
+        free(this->_blocks[i].base);
+    }
+}
+
+bool FrameArena::reserve(size_t capacity)
+{
+    for (size_t i = 0; i < this->_block_count; i++)
+    {
+        if (this->_blocks[i].capacity - this->_blocks[i].used >= capacity)
+        {
+            return true;
+        }
+    }
+
+    return _add_block(capacity) != nullptr;
+}
+
+void* FrameArena::allocate(size_t bytes, size_t alignment)
+{
+    // First fit: consumers ask in the same order every frame, so the blocks settle
+    for (size_t i = 0; i < this->_block_count; i++)
+    {
+        void* slice = _take(this->_blocks[i], bytes, alignment);
+        if (slice)
+        {
+            return slice;
+        }
+    }
+
+    // Heap blocks are at least 4-byte aligned; pad for anything stricter
+    Block* block = _add_block(bytes + (alignment > 4 ? alignment : 0));
+    return block ? _take(*block, bytes, alignment) : nullptr;
+}
+
+void FrameArena::reset()
+{
+    for (size_t i = 0; i < this->_block_count; i++)
+    {
+        this->_blocks[i].used = 0;
+    }
+}
+
+size_t FrameArena::used() const
+{
+    size_t used = 0;
+    for (size_t i = 0; i < this->_block_count; i++)
+    {
+        used += this->_blocks[i].used;
+    }
+    return used;
+}
+
+size_t FrameArena::capacity() const
+{
+    size_t capacity = 0;
+    for (size_t i = 0; i < this->_block_count; i++)
+    {
+        capacity += this->_blocks[i].capacity;
+    }
+    return capacity;
+}
+
+void* FrameArena::_take(Block& block, size_t bytes, size_t alignment)
+{
+    uintptr_t address = (uintptr_t)block.base + block.used;
+    size_t start = block.used + (((address + alignment - 1) & ~(uintptr_t)(alignment - 1)) - address);
+
+    if (!block.base || start + bytes > block.capacity)
+    {
+        return nullptr;
+    }
+
+    block.used = start + bytes;
+    return block.base + start;
+}
+
+FrameArena::Block* FrameArena::_add_block(size_t capacity)
+{
+    Block* block = nullptr;
+    if (this->_block_count < FRAME_ARENA_MAX_BLOCKS)
+    {
+        block = &this->_blocks[this->_block_count++];
+    } else
+    {
+        // All slots taken, e.g. after the frame size grew: recycle the smallest idle block
+        for (size_t i = 0; i < FRAME_ARENA_MAX_BLOCKS; i++)
+        {
+            Block& candidate = this->_blocks[i];
+            if (candidate.used == 0 && (!block || candidate.capacity < block->capacity))
+            {
+                block = &candidate;
+            }
+        }
+        if (!block)
+        {
+            return nullptr;
+        }
+        free(block->base);
+    }
+
+    block->base = (uint8_t*)heap_caps_malloc(capacity, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+    block->capacity = block->base ? capacity : 0;
+    block->used = 0;
+    return block->base ? block : nullptr;
+}
@@ -0,0 +1,218 @@
+#include "frame_context.h"
+
+#include <string.h>
+
+#include "image_ops.h"
+#include "latency_probe.h"
+
+FrameContext::FrameContext(FrameArena& arena) : _arena(arena), _frame(nullptr), _owner(nullptr) { _invalidate(); }
+
+bool FrameContext::attach(camera_fb_t* frame, Camera* owner)
+{
+    release();
+
+    if (!frame)
+    {
+        return false;
+    }
+
+    this->_frame = frame;
+    this->_owner = owner;
+    return true;
+}
+
+bool FrameContext::attach(const FrameRef& frame)
+{
+    bool attached = attach(frame.get());
+
+    // After attach(), whose release() drops the previous reference
+    this->_ref = frame;
+    return attached;
+}
+
+void FrameContext::release()
+{
+    _invalidate();
+    this->_arena.reset();
+
+    if (this->_frame && this->_owner)
+    {
+        this->_owner->release(this->_frame);
+    }
+
+    this->_frame = nullptr;
+    this->_owner = nullptr;
+    this->_ref.reset();
+}
+
+void FrameContext::_invalidate()
+{
+    this->_rgb565 = nullptr;
+    this->_greyscale = nullptr;
+    this->_edges = nullptr;
+    this->_downsampled = nullptr;
+    this->_integral = nullptr;
+    this->_decode_attempted = false;
+}
+
+const uint8_t* FrameContext::rgb565()
+{
+    if (this->_rgb565 || this->_decode_attempted || !this->_frame || !this->_frame->buf)
+    {
+        return this->_rgb565;
+    }
+
+    size_t plane = this->_frame->width * this->_frame->height;
+
+    switch (this->_frame->format)
+    {
+    case PIXFORMAT_RGB565:
+        if (this->_frame->len >= plane * 2)
+        {
+            this->_rgb565 = this->_frame->buf;
+        }
+        break;
+
+    case PIXFORMAT_JPEG: {
+        LATENCY_PROBE(Decode);
+        this->_decode_attempted = true;
+        uint8_t* decoded = (uint8_t*)this->_arena.allocate(plane * 2);
+        if (decoded && jpg2rgb565(this->_frame->buf, this->_frame->len, decoded, JPG_SCALE_NONE))
+        {
+            this->_rgb565 = decoded;
+        }
+        break;
+    }
+
+    default:
+        break;
+    }
+
+    return this->_rgb565;
+}
+
+const uint8_t* FrameContext::greyscale()
+{
+    if (this->_greyscale || !this->_frame || !this->_frame->buf)
+    {
+        return this->_greyscale;
+    }
+
+    size_t plane = this->_frame->width * this->_frame->height;
+
+    // Greyscale frames are already luma, use them in place
+    if (this->_frame->format == PIXFORMAT_GRAYSCALE)
+    {
+        if (this->_frame->len >= plane)
+        {
+            this->_greyscale = this->_frame->buf;
+        }
+        return this->_greyscale;
+    }
+
+    const uint8_t* rgb = rgb565();
+    uint8_t* grey = rgb ? (uint8_t*)this->_arena.allocate(plane) : nullptr;
+    if (grey)
+    {
+        LATENCY_PROBE(Greyscale);
+        ImageOps::rgb565_plane_to_greyscale(rgb, grey, plane);
+        this->_greyscale = grey;
+    }
+
+    return this->_greyscale;
+}
+
+const uint8_t* FrameContext::greyscale_into(uint8_t* destination)
+{
+    if (!destination || !this->_frame || !this->_frame->buf)
+    {
+        return nullptr;
+    }
+
+    if (this->_greyscale == destination)
+    {
+        return destination;
+    }
+
+    size_t plane = this->_frame->width * this->_frame->height;
+
+    if (this->_greyscale)
+    {
+        memcpy(destination, this->_greyscale, plane);
+    } else if (this->_frame->format == PIXFORMAT_GRAYSCALE)
+    {
+        // The frame goes back to the camera, so its luma has to leave the frame buffer
+        if (this->_frame->len < plane)
+        {
+            return nullptr;
+        }
+        memcpy(destination, this->_frame->buf, plane);
+    } else
+    {
+        const uint8_t* rgb = rgb565();
+        if (!rgb)
+        {
+            return nullptr;
+        }
+        LATENCY_PROBE(Greyscale);
+        ImageOps::rgb565_plane_to_greyscale(rgb, destination, plane);
+    }
+
+    this->_greyscale = destination;
+    return this->_greyscale;
+}
+
+const uint8_t* FrameContext::edges()
+{
+    if (this->_edges)
+    {
+        return this->_edges;
+    }
+
+    const uint8_t* grey = greyscale();
+    uint8_t* output = grey ? (uint8_t*)this->_arena.allocate(width() * height()) : nullptr;
+    if (output)
+    {
+        ImageOps::roberts_cross(grey, output, width(), height());
+        this->_edges = output;
+    }
+
+    return this->_edges;
+}
+
+const uint8_t* FrameContext::downsampled()
+{
+    if (this->_downsampled)
+    {
+        return this->_downsampled;
+    }
+
+    const uint8_t* grey = greyscale();
+    uint8_t* output = grey ? (uint8_t*)this->_arena.allocate((width() / 2) * (height() / 2)) : nullptr;
+    if (output)
+    {
+        ImageOps::downsample_2x(grey, output, width(), height());
+        this->_downsampled = output;
+    }
+
+    return this->_downsampled;
+}
+
+const uint32_t* FrameContext::integral()
+{
+    if (this->_integral)
+    {
+        return this->_integral;
+    }
+
+    const uint8_t* grey = greyscale();
+    size_t entries = (width() + 1) * (height() + 1);
+    uint32_t* output = grey ? (uint32_t*)this->_arena.allocate(entries * sizeof(uint32_t)) : nullptr;
+    if (output)
+    {
+        ImageOps::integral_image(grey, output, width(), height());
+        this->_integral = output;
+    }
+
+    return this->_integral;
+}
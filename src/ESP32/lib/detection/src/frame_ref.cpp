@@ -0,0 +1,82 @@
+#include "frame_ref.h"
+
+static FrameRefBlock frame_ref_pool[FRAME_REF_POOL_SIZE];
+
+FrameRef FrameRef::adopt(camera_fb_t* frame)
+{
+    if (!frame)
+    {
+        return FrameRef();
+    }
+
+    for (FrameRefBlock& block : frame_ref_pool)
+    {
+        uint32_t expected = 0;
+        if (block.refs.compare_exchange_strong(expected, 1, std::memory_order_acquire))
+        {
+            block.frame = frame;
+            return FrameRef(&block);
+        }
+    }
+
+    // Better to lose one frame than to leak a driver buffer
+    esp_camera_fb_return(frame);
+    return FrameRef();
+}
+
+FrameRef::FrameRef(const FrameRef& other) : _block(other._block)
+{
+    if (this->_block)
+    {
+        this->_block->refs.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+FrameRef& FrameRef::operator=(const FrameRef& other)
+{
+    if (other._block)
+    {
+        other._block->refs.fetch_add(1, std::memory_order_relaxed);
+    }
+    _drop();
+    this->_block = other._block;
+    return *this;
+}
+
+FrameRef& FrameRef::operator=(FrameRef&& other) noexcept
+{
+    if (this != &other)
+    {
+        _drop();
+        this->_block = other._block;
+        other._block = nullptr;
+    }
+    return *this;
+}
+
+void FrameRef::_drop()
+{
+    FrameRefBlock* block = this->_block;
+    if (!block)
+    {
+        return;
+    }
+    this->_block = nullptr;
+
+    // Read the frame while still holding a reference: at zero the block may be reused at once
+    camera_fb_t* frame = block->frame;
+    if (block->refs.fetch_sub(1, std::memory_order_acq_rel) == 1)
+    {
+        esp_camera_fb_return(frame);
+    }
+}
+
+size_t FrameRef::frames_in_use()
+{
+    size_t count = 0;
+    for (const FrameRefBlock& block : frame_ref_pool)
+    {
+        count += block.refs.load(std::memory_order_relaxed) > 0 ? 1 : 0;
+    }
+    return count;
+}
@@ -0,0 +1,208 @@
+#include "global_motion.h"
+
+#include <esp_heap_caps.h>
+#include <stdlib.h>
+
+#include "detection_result.h"
+
+GlobalMotionEstimator::~GlobalMotionEstimator()
+{
+    free(this->_reference_cols);
+}
+
+bool GlobalMotionEstimator::_allocate(size_t width, size_t height)
+{
+    if (this->_reference_cols != nullptr && this->_width == width && this->_height == height)
+    {
+        return true;
+    }
+
+    // One block: reference columns, reference rows, current columns, current rows
+    free(this->_reference_cols);
+    this->_reference_cols =
+        (int32_t*)heap_caps_malloc(2 * (width + height) * sizeof(int32_t), MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+    this->_has_reference = false;
+
+    if (!this->_reference_cols)
+    {
+        this->_reference_rows = nullptr;
+        this->_cols = nullptr;
+        this->_rows = nullptr;
+        this->_width = 0;
+        this->_height = 0;
+        return false;
+    }
+
+    this->_reference_rows = this->_reference_cols + width;
+    this->_cols = this->_reference_rows + height;
+    this->_rows = this->_cols + width;
+    this->_width = width;
+    this->_height = height;
+    return true;
+}
+
+/** @brief Removes the mean of a projection. @return Mean absolute deviation that is left. */
+static int32_t remove_mean(int32_t* projection, size_t length)
+{
+    int64_t sum = 0;
+    for (size_t i = 0; i < length; i++)
+    {
+        sum += projection[i];
+    }
+    int32_t mean = (int32_t)(sum / (int64_t)length);
+
+    int64_t deviation = 0;
+    for (size_t i = 0; i < length; i++)
+    {
+        projection[i] -= mean;
+        deviation += abs(projection[i]);
+    }
+    return (int32_t)(deviation / (int64_t)length);
+}
+
+bool GlobalMotionEstimator::_project(const uint8_t* luma, int32_t* cols, int32_t* rows) const
+{
+    const size_t width = this->_width;
+    const size_t height = this->_height;
+
+    for (size_t x = 0; x < width; x++)
+    {
+        cols[x] = 0;
+    }
+
+    const uint8_t* pixel = luma;
+    for (size_t y = 0; y < height; y++)
+    {
+        int32_t row_sum = 0;
+        for (size_t x = 0; x < width; x++, pixel++)
+        {
+            row_sum += *pixel;
+            cols[x] += *pixel;
+        }
+        rows[y] = row_sum;
+    }
+
+    // Average grey level per line in Q4, so both axes share a scale whatever the frame size
+    for (size_t x = 0; x < width; x++)
+    {
+        cols[x] = (int32_t)(((int64_t)cols[x] << DETECTION_SUBPIXEL_BITS) / (int64_t)height);
+    }
+    for (size_t y = 0; y < height; y++)
+    {
+        rows[y] = (int32_t)(((int64_t)rows[y] << DETECTION_SUBPIXEL_BITS) / (int64_t)width);
+    }
+
+    const int32_t min_contrast = GLOBAL_MOTION_MIN_CONTRAST << DETECTION_SUBPIXEL_BITS;
+    bool cols_textured = remove_mean(cols, width) >= min_contrast;
+    bool rows_textured = remove_mean(rows, height) >= min_contrast;
+    return cols_textured && rows_textured;
+}
+
+bool GlobalMotionEstimator::_match(const int32_t* reference, const int32_t* current, size_t length, int32_t max_shift,
+                                   int32_t& shift_q4)
+{
+    int32_t limit = (int32_t)(length / GLOBAL_MOTION_MIN_OVERLAP_DIV);
+    if (max_shift > limit)
+    {
+        max_shift = limit;
+    }
+    if (max_shift > GLOBAL_MOTION_MAX_SHIFT)
+    {
+        max_shift = GLOBAL_MOTION_MAX_SHIFT;
+    }
+    if (max_shift < 1)
+    {
+        return false;
+    }
+
+    // Mean absolute difference per shift, Q8 so short overlaps keep their precision
+    uint32_t costs[2 * GLOBAL_MOTION_MAX_SHIFT + 1];
+    uint64_t cost_total = 0;
+    int32_t best = -max_shift;
+
+    for (int32_t shift = -max_shift; shift <= max_shift; shift++)
+    {
+        // current[i] is compared with reference[i - shift]
+        size_t begin = shift > 0 ? (size_t)shift : 0;
+        size_t end = shift < 0 ? length + shift : length;
+
+        // Different content enters the overlap at each shift, so re-centre it every time
+        int64_t offset = 0;
+        for (size_t i = begin; i < end; i++)
+        {
+            offset += current[i] - reference[i - shift];
+        }
+        int32_t mean_offset = (int32_t)(offset / (int64_t)(end - begin));
+
+        uint64_t sad = 0;
+        for (size_t i = begin; i < end; i++)
+        {
+            sad += abs(current[i] - reference[i - shift] - mean_offset);
+        }
+
+        uint32_t cost = (uint32_t)((sad << 8) / (end - begin));
+        costs[shift + max_shift] = cost;
+        cost_total += cost;
+        if (cost < costs[best + max_shift])
+        {
+            best = shift;
+        }
+    }
+
+    // A minimum on the boundary may continue outside the range
+    if (best == -max_shift || best == max_shift)
+    {
+        return false;
+    }
+
+    // Repetitive or featureless profiles give a shallow curve with no clear winner
+    uint64_t cost_mean = cost_total / (uint64_t)(2 * max_shift + 1);
+    if ((uint64_t)costs[best + max_shift] * GLOBAL_MOTION_DISTINCT_RATIO > cost_mean)
+    {
+        return false;
+    }
+
+    // Equiangular fit: both flanks have the same slope, the steeper one sets it
+    int32_t left = (int32_t)costs[best + max_shift - 1];
+    int32_t centre = (int32_t)costs[best + max_shift];
+    int32_t right = (int32_t)costs[best + max_shift + 1];
+    int32_t slope = (left > right ? left : right) - centre;
+    if (slope <= 0)
+    {
+        return false;
+    }
+
+    int32_t offset_q4 = (left - right) * (1 << DETECTION_SUBPIXEL_BITS) / (2 * slope);
+    shift_q4 = best * (1 << DETECTION_SUBPIXEL_BITS) + offset_q4;
+    return true;
+}
+
+bool GlobalMotionEstimator::set_reference(const uint8_t* luma, size_t width, size_t height)
+{
+    this->_has_reference = false;
+    if (!luma || width == 0 || height == 0 || !_allocate(width, height))
+    {
+        return false;
+    }
+
+    this->_has_reference = _project(luma, this->_reference_cols, this->_reference_rows);
+    return this->_has_reference;
+}
+
+GlobalShift GlobalMotionEstimator::estimate(const uint8_t* luma, size_t width, size_t height, int32_t max_shift)
+{
+    GlobalShift shift;
+    if (!luma || !this->_has_reference || width != this->_width || height != this->_height)
+    {
+        return shift;
+    }
+
+    if (!_project(luma, this->_cols, this->_rows))
+    {
+        return shift;
+    }
+
+    shift.valid = _match(this->_reference_cols, this->_cols, width, max_shift, shift.dx_q4) &&
+                  _match(this->_reference_rows, this->_rows, height, max_shift, shift.dy_q4);
+    return shift;
+}
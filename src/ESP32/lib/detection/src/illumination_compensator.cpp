@@ -0,0 +1,73 @@
+#include "illumination_compensator.h"
+
+#include <math.h>
+#include <stdlib.h>
+
+bool IlluminationCompensator::estimate(const uint8_t* source, const uint8_t* target, size_t width, size_t height)
+{
+    if (!source || !target || width == 0 || height == 0)
+    {
+        return false;
+    }
+
+    // 1. First and second order statistics over a sparse grid of both planes
+    uint32_t samples = 0;
+    uint32_t sum_source = 0, sum_target = 0;
+    uint64_t sq_source = 0, sq_target = 0;
+
+    for (size_t y = 0; y < height; y += ILLUMINATION_SAMPLE_STRIDE)
+    {
+        size_t row = y * width;
+        for (size_t x = 0; x < width; x += ILLUMINATION_SAMPLE_STRIDE)
+        {
+            uint32_t s = source[row + x];
+            uint32_t t = target[row + x];
+            sum_source += s;
+            sum_target += t;
+            sq_source += s * s;
+            sq_target += t * t;
+            samples++;
+        }
+    }
+
+    float mean_source = (float)sum_source / samples;
+    float mean_target = (float)sum_target / samples;
+    float var_source = (float)sq_source / samples - mean_source * mean_source;
+    float var_target = (float)sq_target / samples - mean_target * mean_target;
+
+    // 2. Linear model: target = gain * source + offset
+    int32_t gain_q8 = 1 << ILLUMINATION_GAIN_SHIFT;
+    if (var_source > 1.0f && var_target > 1.0f)
+    {
+        gain_q8 = (int32_t)(sqrtf(var_target / var_source) * (1 << ILLUMINATION_GAIN_SHIFT) + 0.5f);
+    }
+    int32_t offset = (int32_t)lroundf(mean_target - mean_source * gain_q8 / (1 << ILLUMINATION_GAIN_SHIFT));
+
+    this->_gain_q8 = gain_q8;
+    this->_offset = offset;
+
+    // 3. Only a noticeable, plausible global change is treated as lighting
+    bool shifted = fabsf(mean_target - mean_source) >= ILLUMINATION_MIN_SHIFT;
+    bool rescaled = abs(gain_q8 - (1 << ILLUMINATION_GAIN_SHIFT)) >= (1 << ILLUMINATION_GAIN_SHIFT) / 8;
+    bool plausible = gain_q8 >= ILLUMINATION_MIN_GAIN && gain_q8 <= ILLUMINATION_MAX_GAIN;
+
+    if (!(shifted || rescaled) || !plausible)
+    {
+        return false;
+    }
+
+    for (int32_t value = 0; value < 256; value++)
+    {
+        int32_t mapped = ((value * gain_q8) >> ILLUMINATION_GAIN_SHIFT) + offset;
+        this->_lut[value] = (uint8_t)((mapped < 0) ? 0 : (mapped > 255) ? 255 : mapped);
+    }
+    return true;
+}
+
+void IlluminationCompensator::apply(const uint8_t* source, uint8_t* destination, size_t size) const
+{
+    for (size_t i = 0; i < size; i++)
+    {
+        destination[i] = this->_lut[source[i]];
+    }
+}
@@ -0,0 +1,72 @@
+#include "image_ops.h"
+
+#include <string.h>
+
+void ImageOps::rgb565_plane_to_greyscale(const uint8_t* rgb, uint8_t* output_grey, size_t pixels)
+{
+    for (size_t i = 0; i < pixels; i++)
+    {
+        output_grey[i] = rgb565_to_greyscale((uint16_t)((rgb[2 * i] << 8) | rgb[2 * i + 1]));
+    }
+}
+
+void ImageOps::roberts_cross(const uint8_t* luma, uint8_t* output_edges, size_t width, size_t height)
+{
+    for (size_t y = 0; y + 1 < height; y++)
+    {
+        const uint8_t* row = &luma[y * width];
+        const uint8_t* next_row = row + width;
+        uint8_t* out = &output_edges[y * width];
+
+        for (size_t x = 0; x + 1 < width; x++)
+        {
+            out[x] = roberts_magnitude(row, next_row, x);
+        }
+        out[width - 1] = 0;
+    }
+
+    if (height > 0)
+    {
+        memset(&output_edges[(height - 1) * width], 0, width);
+    }
+}
+
+void ImageOps::downsample_2x(const uint8_t* luma, uint8_t* output, size_t width, size_t height)
+{
+    size_t out_width = width / 2;
+    size_t out_height = height / 2;
+
+    for (size_t y = 0; y < out_height; y++)
+    {
+        const uint8_t* row = &luma[2 * y * width];
+        const uint8_t* next_row = row + width;
+        uint8_t* out = &output[y * out_width];
+
+        for (size_t x = 0; x < out_width; x++)
+        {
+            uint32_t sum = row[2 * x] + row[2 * x + 1] + next_row[2 * x] + next_row[2 * x + 1];
+            out[x] = (uint8_t)((sum + 2) >> 2);
+        }
+    }
+}
+
+void ImageOps::integral_image(const uint8_t* luma, uint32_t* output, size_t width, size_t height)
+{
+    size_t stride = width + 1;
+    memset(output, 0, stride * sizeof(uint32_t));
+
+    for (size_t y = 0; y < height; y++)
+    {
+        const uint8_t* row = &luma[y * width];
+        const uint32_t* above = &output[y * stride];
+        uint32_t* out = &output[(y + 1) * stride];
+        uint32_t row_sum = 0;
+
+        out[0] = 0;
+        for (size_t x = 0; x < width; x++)
+        {
+            row_sum += row[x];
+            out[x + 1] = above[x + 1] + row_sum;
+        }
+    }
+}
@@ -0,0 +1,63 @@
+#include "lens_model.h"
+
+#include <math.h>
+
+#include "constants.h"
+
+static const float DEG_PER_RAD = 57.29577951f;
+
+LensModel LensModel::from_fov(uint16_t width, uint16_t height, float hfov_deg, float vfov_deg, float k1)
+{
+    // Along each axis the other coordinate is zero, so the edge lands at t * (1 + k1 * t^2)
+    float tan_x = tanf(hfov_deg / 2.0f / DEG_PER_RAD);
+    float tan_y = tanf(vfov_deg / 2.0f / DEG_PER_RAD);
+
+    LensModel lens;
+    lens.fx = (width / 2.0f) / (tan_x * (1.0f + k1 * tan_x * tan_x));
+    lens.fy = (height / 2.0f) / (tan_y * (1.0f + k1 * tan_y * tan_y));
+    lens.k1 = k1;
+    lens.hfov_deg = hfov_deg;
+    lens.vfov_deg = vfov_deg;
+    return lens;
+}
+
+LensModel LensModel::nominal(uint16_t width, uint16_t height)
+{
+    return from_fov(width, height, CAMERA_HFOV_DEG, CAMERA_VFOV_DEG, CAMERA_DISTORTION_K1);
+}
+
+LensModel LensModel::calibrated(const CameraCalibration& calibration, uint16_t width, uint16_t height)
+{
+    float pan_px_per_degree = calibration.pan_px_per_step_at(width) * STEPPER_NUMBER_OF_STEPS / 360.0f;
+    float tilt_px_per_degree = calibration.tilt_px_per_degree_at(height);
+    return from_fov(width, height, width / pan_px_per_degree, height / tilt_px_per_degree, CAMERA_DISTORTION_K1);
+}
+
+void LensModel::pixel_to_angles(float x, float y, float& pan_deg, float& tilt_deg) const
+{
+    float distorted_x = x / this->fx;
+    float distorted_y = y / this->fy;
+
+    // r_d = r_u * (1 + k1 * r_u^2) has no closed-form inverse; iterate from r_u = r_d
+    float undistorted_x = distorted_x;
+    float undistorted_y = distorted_y;
+    for (int i = 0; i < LENS_UNDISTORT_ITERATIONS; i++)
+    {
+        float factor = 1.0f + this->k1 * (undistorted_x * undistorted_x + undistorted_y * undistorted_y);
+        undistorted_x = distorted_x / factor;
+        undistorted_y = distorted_y / factor;
+    }
+
+    pan_deg = atanf(undistorted_x) * DEG_PER_RAD;
+    tilt_deg = atan2f(undistorted_y, sqrtf(1.0f + undistorted_x * undistorted_x)) * DEG_PER_RAD;
+}
+
+void LensModel::angles_to_pixel(float pan_deg, float tilt_deg, float& x, float& y) const
+{
+    float undistorted_x = tanf(pan_deg / DEG_PER_RAD);
+    float undistorted_y = tanf(tilt_deg / DEG_PER_RAD) * sqrtf(1.0f + undistorted_x * undistorted_x);
+    float factor = 1.0f + this->k1 * (undistorted_x * undistorted_x + undistorted_y * undistorted_y);
+
+    x = undistorted_x * factor * this->fx;
+    y = undistorted_y * factor * this->fy;
+}
@@ -0,0 +1,80 @@
+#include "pixel_angle_lut.h"
+
+#include <math.h>
+
+#include "detection_result.h"
+
+void PixelAngleLut::build(const LensModel& lens, uint16_t width, uint16_t height)
+{
+    const float one = (float)(1 << PIXEL_ANGLE_FRACTION_BITS);
+
+    for (int row = 0; row < PIXEL_ANGLE_GRID_ROWS; row++)
+    {
+        float y = (float)row * height / (PIXEL_ANGLE_GRID_ROWS - 1) - height / 2.0f;
+        for (int col = 0; col < PIXEL_ANGLE_GRID_COLS; col++)
+        {
+            float x = (float)col * width / (PIXEL_ANGLE_GRID_COLS - 1) - width / 2.0f;
+
+            float pan_deg = 0.0f;
+            float tilt_deg = 0.0f;
+            lens.pixel_to_angles(x, y, pan_deg, tilt_deg);
+            this->_pan_q8[row][col] = (int16_t)lroundf(pan_deg * one);
+            this->_tilt_q8[row][col] = (int16_t)lroundf(tilt_deg * one);
+        }
+    }
+
+    this->_width = width;
+    this->_height = height;
+}
+
+/**
+ * @brief Grid position of a centre-relative Q4 coordinate along one axis.
+ * @param node Receives the node left of / above the point.
+ * @param fraction Receives the Q8 distance past that node.
+ */
+static void grid_position(int32_t coordinate_q4, uint16_t size, int nodes, int32_t& node, int32_t& fraction)
+{
+    const int32_t one = 1 << PIXEL_ANGLE_FRACTION_BITS;
+    const int32_t last = (nodes - 1) * one;
+
+    // Offset from the frame edge in Q4, scaled to grid cells in Q8
+    int32_t from_edge_q4 = coordinate_q4 + ((int32_t)size << (DETECTION_SUBPIXEL_BITS - 1));
+    int32_t position = (int32_t)((int64_t)from_edge_q4 * (nodes - 1) * (one >> DETECTION_SUBPIXEL_BITS) / size);
+    position = position < 0 ? 0 : (position > last ? last : position);
+
+    node = position >> PIXEL_ANGLE_FRACTION_BITS;
+    fraction = position & (one - 1);
+    if (node == nodes - 1)
+    {
+        node--;
+        fraction = one;
+    }
+}
+
+void PixelAngleLut::lookup(int32_t x_q4, int32_t y_q4, int32_t& pan_q8, int32_t& tilt_q8) const
+{
+    if (!is_built())
+    {
+        pan_q8 = 0;
+        tilt_q8 = 0;
+        return;
+    }
+
+    const int32_t one = 1 << PIXEL_ANGLE_FRACTION_BITS;
+    int32_t col = 0;
+    int32_t fx = 0;
+    int32_t row = 0;
+    int32_t fy = 0;
+    grid_position(x_q4, this->_width, PIXEL_ANGLE_GRID_COLS, col, fx);
+    grid_position(y_q4, this->_height, PIXEL_ANGLE_GRID_ROWS, row, fy);
+
+    // Bilinear blend of the four surrounding nodes, Q8 weights on each axis
+    const int32_t round = 1 << (2 * PIXEL_ANGLE_FRACTION_BITS - 1);
+    int32_t pan_top = this->_pan_q8[row][col] * (one - fx) + this->_pan_q8[row][col + 1] * fx;
+    int32_t pan_bottom = this->_pan_q8[row + 1][col] * (one - fx) + this->_pan_q8[row + 1][col + 1] * fx;
+    pan_q8 = (pan_top * (one - fy) + pan_bottom * fy + round) >> (2 * PIXEL_ANGLE_FRACTION_BITS);
+
+    int32_t tilt_top = this->_tilt_q8[row][col] * (one - fx) + this->_tilt_q8[row][col + 1] * fx;
+    int32_t tilt_bottom = this->_tilt_q8[row + 1][col] * (one - fx) + this->_tilt_q8[row + 1][col + 1] * fx;
+    tilt_q8 = (tilt_top * (one - fy) + tilt_bottom * fy + round) >> (2 * PIXEL_ANGLE_FRACTION_BITS);
+}
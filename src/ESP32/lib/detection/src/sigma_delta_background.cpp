@@ -0,0 +1,97 @@
+#include "sigma_delta_background.h"
+
+#include <esp_heap_caps.h>
+#include <stdlib.h>
+#include <string.h>
+
+SigmaDeltaBackground::~SigmaDeltaBackground()
+{
+    free(this->_mean);
+    free(this->_variance);
+}
+
+bool SigmaDeltaBackground::begin(size_t plane_size)
+{
+    if (this->_mean != nullptr && this->_size == plane_size)
+    {
+        return true;
+    }
+
+    free(this->_mean);
+    free(this->_variance);
+
+    this->_mean = (uint8_t*)heap_caps_malloc(plane_size, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+    this->_variance = (uint8_t*)heap_caps_malloc(plane_size, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+    this->_primed = false;
+
+    if (!this->_mean || !this->_variance)
+    {
+        free(this->_mean);
+        free(this->_variance);
+        this->_mean = nullptr;
+        this->_variance = nullptr;
+        this->_size = 0;
+        return false;
+    }
+
+    this->_size = plane_size;
+    return true;
+}
+
+void SigmaDeltaBackground::update(const uint8_t* luma, size_t width, size_t height, MotionMoments& moments)
+{
+    if (!luma || !this->_mean || width * height != this->_size)
+    {
+        return;
+    }
+
+    // Seed the background with the first frame, nothing is foreground yet
+    if (!this->_primed)
+    {
+        memcpy(this->_mean, luma, this->_size);
+        memset(this->_variance, SIGMA_DELTA_MIN_VARIANCE, this->_size);
+        this->_primed = true;
+        return;
+    }
+
+    update_rows(luma, width, 0, height, moments);
+}
+
+void SigmaDeltaBackground::update_rows(const uint8_t* luma, size_t width, size_t row_begin, size_t row_end,
+                                       MotionMoments& moments)
+{
+    size_t i = row_begin * width;
+    for (size_t y = row_begin; y < row_end; y++)
+    {
+        for (size_t x = 0; x < width; x++, i++)
+        {
+            int pixel = luma[i];
+            int mean = this->_mean[i];
+
+            // 1. Mean steps one grey level towards the current pixel
+            mean += (pixel > mean) - (pixel < mean);
+            this->_mean[i] = (uint8_t)mean;
+
+            int diff = abs(pixel - mean);
+            if (diff == 0)
+            {
+                continue;
+            }
+
+            // 2. Variance steps one level towards N times the difference
+            int variance = this->_variance[i];
+            int target = SIGMA_DELTA_AMPLIFICATION * diff;
+            variance += (target > variance) - (target < variance);
+            variance = (variance < SIGMA_DELTA_MIN_VARIANCE)   ? SIGMA_DELTA_MIN_VARIANCE
+                       : (variance > SIGMA_DELTA_MAX_VARIANCE) ? SIGMA_DELTA_MAX_VARIANCE
+                                                               : variance;
+            this->_variance[i] = (uint8_t)variance;
+
+            // 3. Foreground when the difference exceeds the local variance
+            if (diff >= variance)
+            {
+                moments.add(x, y);
+            }
+        }
+    }
+}
@@ -5,8 +5,11 @@
  */
 #pragma once
 
+#include "constants.h"
 #include "move_types.h"
+#include "pose_history.h"
 #include "tuple"
+#include <stdint.h>
 
 /**
  * @class BaseMovementManager
@@ -26,4 +29,60 @@ public:
      * @brief Moves the turret relative to its current orientation.
      */
     virtual void move_relative(std::tuple<MoveDirectionX, MoveDirectionY> move_directions) = 0;
+
+    /**
+     * @brief Moves the turret by an exact amount relative to its current orientation.
+     * @param pan_steps Stepper steps; positive rotates right.
+     * @param tilt_centidegrees Servo angle offset in centidegrees; positive tilts up.
+     */
+    virtual void move_by(int32_t pan_steps, int32_t tilt_centidegrees) = 0;
+
+    /**
+     * @brief Moves the turret to an absolute orientation.
+     * @param pan_steps Pan angle in stepper steps from the power-on heading; positive is right.
+     * @param tilt_centidegrees Servo angle in centidegrees; larger is up.
+     */
+    virtual void move_absolute(int32_t pan_steps, int32_t tilt_centidegrees) = 0;
+
+    /**
+     * @brief Keeps both axes moving at constant rates until the next command.
+     * @details A rate of 0 brings that axis to a stop; move_velocity(0, 0) stops both.
+     * The default implementation has no speed control: it nudges one fixed increment
+     * in the direction of each non-zero rate, so call it once per control period.
+     * @param pan_steps_per_s Pan rate in full steps per second; positive rotates right.
+     * @param tilt_centidegrees_per_s Tilt rate in servo centidegrees per second; positive tilts up.
+     */
+    virtual void move_velocity(int32_t pan_steps_per_s, int32_t tilt_centidegrees_per_s)
+    {
+        MoveDirectionX x = (pan_steps_per_s > 0)   ? MoveDirectionX::Right
+                           : (pan_steps_per_s < 0) ? MoveDirectionX::Left
+                                                   : MoveDirectionX::None;
+        MoveDirectionY y = (tilt_centidegrees_per_s > 0)   ? MoveDirectionY::Up
+                           : (tilt_centidegrees_per_s < 0) ? MoveDirectionY::Down
+                                                           : MoveDirectionY::None;
+        if (x != MoveDirectionX::None || y != MoveDirectionY::None)
+        {
+            move_relative(std::make_tuple(x, y));
+        }
+    }
+
+    /** @return Current pan position in stepper steps. */
+    virtual int32_t get_pan_position() = 0;
+
+    /** @return Last commanded tilt angle in servo centidegrees. */
+    virtual int32_t get_tilt_centidegrees() = 0;
+
+    /**
+     * @brief Looks up where the turret was pointing at an earlier time.
+     * @param timestamp_us esp_timer time, e.g. the capture time of a camera frame.
+     * @param pose Receives the pose.
+     * @return false if no history is kept or it does not reach back that far; the
+     * default implementation keeps none.
+     */
+    virtual bool get_pose_at(int64_t timestamp_us, TurretPose& pose)
+    {
+        (void)timestamp_us;
+        (void)pose;
+        return false;
+    }
 };
\ No newline at end of file
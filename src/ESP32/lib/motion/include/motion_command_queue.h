@@ -0,0 +1,128 @@
+/**
+ * @file motion_command_queue.h
+ * @brief Lock-free multi-producer command queue feeding the motor task.
+ */
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <atomic>
+
+#include "base_movement_manager.h"
+#include "move_types.h"
+#include "spsc_ring.h"
+
+#define MOTION_QUEUE_MAX_PRODUCERS 4  /**< Producer contexts (control loop, web, ...). */
+#define MOTION_QUEUE_LANE_CAPACITY 16 /**< Commands buffered per producer; power of two. */
+
+/**
+ * @struct MotionCommand
+ * @brief One request for the motors, as posted by a producer.
+ */
+struct MotionCommand {
+    /** @brief What the command asks for. */
+    enum class Type : uint8_t {
+        Nudge = 0,    /**< move_relative(directions): one fixed increment per axis. */
+        MoveBy = 1,   /**< move_by(pan, tilt): relative, in steps and centidegrees. */
+        MoveTo = 2,   /**< move_absolute(pan, tilt): supersedes everything posted earlier. */
+        Velocity = 3, /**< move_velocity(pan, tilt): rates in steps and centidegrees per second. */
+    };
+
+    Type type;
+    MoveDirectionX nudge_x; /**< Nudge only. */
+    MoveDirectionY nudge_y; /**< Nudge only. */
+    int32_t pan;            /**< Steps; MoveBy / MoveTo. Steps per second; Velocity. */
+    int32_t tilt;           /**< Centidegrees; MoveBy / MoveTo. Centidegrees per second; Velocity. */
+    uint32_t sequence;      /**< Global post order, stamped by the queue. */
+};
+
+/**
+ * @class MotionCommandQueue
+ * @brief Carries motion commands from any number of contexts to one motor task.
+ * @details Each producer context takes its own lane, an SpscRing, so posting is a
+ * lock-free push. A global sequence number restores the cross-lane order. The motor
+ * task calls drain(), which reads every lane and coalesces the batch before touching
+ * the motors:
+ * - the newest MoveTo wins, and everything posted before it is dropped;
+ * - a MoveTo older than one already applied (a producer that lost a race) is stale and dropped;
+ * - consecutive MoveBy commands are summed into a single move;
+ * - of consecutive Velocity commands only the newest rates are applied.
+ *
+ * A burst of tracking updates or web clicks therefore costs one motor command per
+ * drain, instead of queueing up behind each other.
+ */
+class MotionCommandQueue
+{
+public:
+    /**
+     * @class Producer
+     * @brief Posting handle bound to one lane; use it from a single context only.
+     */
+    class Producer
+    {
+    private:
+        MotionCommandQueue* _queue; /**< Null if no lane was free. */
+        uint8_t _lane;              /**< Index into _lanes. */
+
+    public:
+        Producer(MotionCommandQueue* queue, uint8_t lane) : _queue(queue), _lane(lane) {}
+
+        /** @return false if the queue had no free lane for this producer. */
+        bool is_valid() const { return this->_queue != nullptr; }
+
+        /**
+         * @brief Stamps and enqueues @p command.
+         * @return false if the lane is full (the command is counted as dropped).
+         */
+        bool post(MotionCommand command);
+    };
+
+private:
+    /** @brief One SPSC ring per producer context. */
+    SpscRing<MotionCommand, MOTION_QUEUE_LANE_CAPACITY> _lanes[MOTION_QUEUE_MAX_PRODUCERS];
+
+    /** @brief Drain scratch, sorted by sequence; consumer only. */
+    MotionCommand _batch[MOTION_QUEUE_MAX_PRODUCERS * MOTION_QUEUE_LANE_CAPACITY];
+
+    std::atomic<uint8_t> _lane_count;        /**< Lanes handed out so far. */
+    std::atomic<uint32_t> _next_sequence;    /**< Next post order number. */
+    std::atomic<uint32_t> _dropped;          /**< Posts rejected because a lane was full. */
+    uint32_t _coalesced;                     /**< Commands merged or superseded; consumer only. */
+    uint32_t _last_move_to;                  /**< Sequence of the last applied MoveTo; consumer only. */
+    bool _has_move_to;                       /**< _last_move_to is valid; consumer only. */
+    std::atomic<void (*)(void*)> _post_hook; /**< Called after every successful post (wakes the consumer). */
+    std::atomic<void*> _post_hook_arg;       /**< Argument for _post_hook; published before it. */
+
+    /** @brief true if sequence @p a was posted before @p b (wrap-safe). */
+    static bool _before(uint32_t a, uint32_t b) { return (int32_t)(a - b) < 0; }
+
+public:
+    MotionCommandQueue();
+
+    /**
+     * @brief Reserves a lane for the calling context.
+     * @return A Producer; invalid if all MOTION_QUEUE_MAX_PRODUCERS lanes are taken.
+     */
+    Producer make_producer();
+
+    /**
+     * @brief Registers a callback run after each post, e.g. to notify the motor task.
+     * @details May be set while producers post: the argument is published before the
+     * hook, so a producer that sees the hook also sees its argument. Setting nullptr
+     * removes it.
+     */
+    void set_post_hook(void (*hook)(void*), void* arg);
+
+    /**
+     * @brief Applies everything posted so far to @p motors, coalesced. Consumer only.
+     * @return Number of motor calls made.
+     */
+    size_t drain(BaseMovementManager& motors);
+
+    /** @return Posts rejected because their lane was full. */
+    uint32_t get_dropped() const { return this->_dropped.load(std::memory_order_relaxed); }
+
+    /** @return Commands merged into another or superseded before reaching the motors. */
+    uint32_t get_coalesced() const { return this->_coalesced; }
+};
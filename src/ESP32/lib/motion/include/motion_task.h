@@ -0,0 +1,63 @@
+/**
+ * @file motion_task.h
+ * @brief Dedicated FreeRTOS task that owns the motors.
+ */
+#pragma once
+
+#include <atomic>
+
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+
+#include "base_movement_manager.h"
+#include "motion_command_queue.h"
+
+#define MOTION_TASK_STACK_SIZE 4096 /**< Bytes; drain() keeps its batch in the queue, not on the stack. */
+#define MOTION_TASK_PRIORITY 5      /**< Above loop() (1) so commands apply within one tick. */
+#define MOTION_TASK_CORE 1          /**< Same core as loop(); core 0 serves WiFi and the camera. */
+#define MOTION_TASK_IDLE_MS 20      /**< Longest sleep without a post, as a safety net. */
+
+/**
+ * @class MotionTask
+ * @brief The single consumer of a MotionCommandQueue.
+ * @details Only this task calls into the real movement manager, so MovementManager
+ * and StepperDriver never see concurrent callers. The task sleeps on a direct-to-task
+ * notification that every post() gives, then drains and coalesces the queue.
+ */
+class MotionTask
+{
+private:
+    MotionCommandQueue& _queue;        /**< Consumed only by this task. */
+    BaseMovementManager& _motors;      /**< Driven only by this task. */
+    std::atomic<TaskHandle_t> _handle; /**< Null until start(); read by producers in _wake(). */
+
+    /** @brief Task body. */
+    static void _run(void* arg);
+
+    /** @brief Post hook: wakes the task. */
+    static void _wake(void* arg);
+
+public:
+    /**
+     * @brief Construct a new Motion Task object.
+     * @param queue Queue to consume.
+     * @param motors Movement manager that only this task will drive.
+     */
+    MotionTask(MotionCommandQueue& queue, BaseMovementManager& motors)
+        : _queue(queue), _motors(motors), _handle(nullptr)
+    {
+    }
+
+    /**
+     * @brief Creates the task pinned to MOTION_TASK_CORE.
+     * @return true if the task is running.
+     */
+    bool start();
+
+    /**
+     * @brief Drains the queue once on the calling context.
+     * @details The task loop calls this; tests can call it without starting the task.
+     * @return Number of motor calls made.
+     */
+    size_t run_once() { return this->_queue.drain(this->_motors); }
+};
@@ -5,40 +5,141 @@
 #pragma once
 
 #include "base_movement_manager.h"
-#include <ESP32Servo.h>
-#include <Stepper.h>
+
+#include "constants.h"
+#include "pose_history.h"
+#include "servo_driver.h"
+#include "stepper_driver.h"
 
 const int SERVO_MIN_ANGLE = 0;
 const int SERVO_MAX_ANGLE = 180;
+const int SERVO_CENTER_ANGLE = 90;
+
+/** Default pan soft limits: +-270 degrees from the power-on heading (cable wrap). */
+const int32_t PAN_MIN_STEPS = -(STEPPER_NUMBER_OF_STEPS * 3 / 4);
+const int32_t PAN_MAX_STEPS = STEPPER_NUMBER_OF_STEPS * 3 / 4;
 
 /**
  * @class MovementManager
  * @brief Manages physical actuators for turret positioning.
+ * @details Keeps the turret orientation as state: the pan position is counted in
+ * steps by the StepperDriver, and the tilt is the commanded servo angle in
+ * centidegrees, so tracking corrections smaller than a degree reach the servo.
+ * Every move is checked against soft limits, so no command can wind the cable or
+ * drive the servo into its end stops.
+ *
+ * Moves on both axes are coordinated. The servo does not jump to its target while
+ * the stepper ramps. On every pan step it is set to the same fraction of its own
+ * travel as the pan has covered. This uses an integer DDA (Bresenham-style) on the
+ * pulse width, so the servo moves a few microseconds per step, not whole degrees.
+ * Both axes therefore arrive together, and a diagonal correction takes as long as
+ * its slower axis instead of the sum of both. Because tilt follows pan position
+ * rather than time, it tracks the pan's acceleration ramps and in-flight retargets too.
+ *
+ * After begin(), the pose actually being driven is sampled every POSE_HISTORY_PERIOD_US
+ * into a PoseHistory, so callers can ask where the turret was when a frame was taken.
+ *
+ * move_velocity() drives the axes independently at given rates instead, for manual
+ * slewing: the stepper cruises towards its soft limit at the requested speed and the
+ * servo's slew limiter sweeps it towards its own. The next positional move brakes
+ * both and restores the default stepper speed and servo slew rate.
+ *
+ * The move and limit methods expect a single caller at a time: in the firmware that is
+ * the MotionTask draining the MotionCommandQueue, and setup() before it starts. Only
+ * the state shared with the step timer task (the tilt plan) is locked; the command
+ * side, such as the commanded tilt and velocity mode, belongs to that caller. The
+ * getters may be called from any task, as each reads one word that only that caller
+ * or a driver writes.
  */
 class MovementManager : public BaseMovementManager
 {
 private:
-    /** @brief Private Stepper instance for horizontal (X) rotation. */
-    Stepper& _stepper;
+    /** @brief Non-blocking stepper driver for horizontal (X) rotation. */
+    StepperDriver& _stepper;
+
+    /** @brief Microsecond servo driver for vertical (Y) tilting. */
+    ServoDriver& _servo;
+
+    int32_t _pan_min;    /**< Pan soft limit (steps). */
+    int32_t _pan_max;    /**< Pan soft limit (steps). */
+    int32_t _tilt_min;   /**< Tilt soft limit (centidegrees). */
+    int32_t _tilt_max;   /**< Tilt soft limit (centidegrees). */
+    int32_t _tilt_angle; /**< Commanded tilt target in centidegrees; the servo cannot report it. Caller-written. */
+
+    /** @brief Tilt travel slaved to the running pan move. */
+    struct TiltPlan {
+        int32_t pan_start;  /**< Pan position when the move was planned. */
+        int32_t pan_span;   /**< |pan target - pan_start| in steps; > 0 while active. */
+        int8_t pan_sign;    /**< Direction of travel towards the pan target. */
+        int32_t tilt_start; /**< Servo pulse (µs) when the move was planned. */
+        int32_t tilt_delta; /**< Pulse travel (µs) to spread over the pan travel. */
+        bool active;        /**< A coordinated move is in progress. */
+    } _plan;
+
+    /** @brief Guards _plan between the caller and the step timer task; no driver output runs under it. */
+    portMUX_TYPE _lock = portMUX_INITIALIZER_UNLOCKED;
 
-    /** @brief Private Servo instance for vertical (Y) tilting. */
-    Servo& _servo;
+    bool _velocity; /**< A move_velocity() with a non-zero rate is in control; caller-owned, never read by the timer. */
 
-    static constexpr int _SERVO_INCREMENT = 5;
+    PoseHistory _history;             /**< Recent poses, for get_pose_at(). */
+    esp_timer_handle_t _sample_timer; /**< Periodic _history sampler. */
+
+    static constexpr int _SERVO_INCREMENT = 5 * CENTIDEGREES_PER_DEGREE;
     static constexpr int _STEP_INCREMENT = 5;
-    static constexpr int _STEPPER_SPEED = 10;
+
+    /** @return Servo pulse width for a tilt in centidegrees. */
+    uint16_t _to_pulse(int32_t centidegrees) const;
+
+    /** @return Tilt in centidegrees for a servo pulse width, rounded to the nearest. */
+    int32_t _to_centidegrees(uint16_t pulse_us) const;
+
+    /**
+     * @brief Starts a coordinated move to the given targets (steps, centidegrees), clamped to the soft limits.
+     * @details Without pan travel the servo is written at once; otherwise it is slaved
+     * to the stepper through _on_pan_step().
+     */
+    void _move_to(int32_t pan_target, int32_t tilt_target);
+
+    /** @brief StepListener trampoline. */
+    static void _on_pan_step(void* arg, int32_t position);
+
+    /** @brief Interpolates the servo for pan @p position. Runs in the step timer task. */
+    void _follow_pan(int32_t position);
+
+    /**
+     * @brief Leaves velocity mode: brakes the stepper, holds the servo where it is and
+     * restores the default stepper speed and servo slew rate. No-op outside velocity mode.
+     */
+    void _end_velocity();
+
+    /** @brief esp_timer callback recording the current pose into _history. */
+    static void _on_sample(void* arg);
 
 public:
     /**
      * @brief Construct a new Movement Manager object.
-     * @param stepper Reference to the initialized Stepper motor object.
-     * @param servo Reference to the initialized Servo motor object.
+     * @details Assumes the turret is powered on at pan 0 and tilt SERVO_CENTER_ANGLE,
+     * and registers itself as the stepper's step listener.
+     * @param stepper Reference to the stepper driver; begin() is called by the owner.
+     * @param servo Reference to the servo driver; begin() is called by the owner.
      */
-    MovementManager(Stepper& stepper, Servo& servo) : _stepper(stepper), _servo(servo)
+    MovementManager(StepperDriver& stepper, ServoDriver& servo)
+        : _stepper(stepper), _servo(servo), _pan_min(PAN_MIN_STEPS), _pan_max(PAN_MAX_STEPS),
+          _tilt_min(SERVO_MIN_ANGLE * CENTIDEGREES_PER_DEGREE), _tilt_max(SERVO_MAX_ANGLE * CENTIDEGREES_PER_DEGREE),
+          _tilt_angle(SERVO_CENTER_ANGLE * CENTIDEGREES_PER_DEGREE),
+          _plan(), _velocity(false), _sample_timer(nullptr)
     {
-        this->_stepper.setSpeed(this->_STEPPER_SPEED);
+        this->_stepper.set_step_listener(&MovementManager::_on_pan_step, this);
     }
 
+    ~MovementManager();
+
+    /**
+     * @brief Starts recording the pose history.
+     * @return false if the sampling timer could not be created.
+     */
+    bool begin();
+
     /**
      * @brief Implements relative movement using Stepper and Servo hardware.
      * @details Translates MoveDirectionX and MoveDirectionY into actuator
@@ -48,21 +149,80 @@ public:
      */
     virtual void move_relative(const std::tuple<MoveDirectionX, MoveDirectionY> move_directions);
 
+    /**
+     * @brief Steps the stepper by @p pan_steps and offsets the servo by @p tilt_centidegrees.
+     * @details Returns immediately; both axes finish the move together in the background,
+     * blended into any move still in progress. Both axes stop at their soft limits.
+     */
+    virtual void move_by(int32_t pan_steps, int32_t tilt_centidegrees);
+
+    /**
+     * @brief Moves to an absolute orientation along the shortest path.
+     * @details The pan axis is circular, so @p pan_steps is taken modulo one revolution,
+     * and the equivalent position inside the soft limits closest to the current one wins.
+     * @param pan_steps Pan angle in steps from the power-on heading.
+     * @param tilt_centidegrees Servo angle in centidegrees, clamped to the tilt soft limits.
+     */
+    virtual void move_absolute(int32_t pan_steps, int32_t tilt_centidegrees);
+
+    /**
+     * @brief Slews each axis at a constant rate towards its soft limit until the next command.
+     * @details Returns immediately. A pan rate change is ramped by the stepper's
+     * acceleration; a rate of 0 brakes that axis. The rates replace the default
+     * stepper speed and servo slew rate until a positional move or move_velocity(0, 0).
+     * @param pan_steps_per_s Pan rate in full steps per second; positive rotates right.
+     * @param tilt_centidegrees_per_s Tilt rate in centidegrees per second; positive tilts up.
+     */
+    virtual void move_velocity(int32_t pan_steps_per_s, int32_t tilt_centidegrees_per_s);
+
+    /** @return Current pan position in steps. */
+    virtual int32_t get_pan_position() { return this->_stepper.get_position(); }
+
+    /** @return Commanded tilt target in centidegrees (the servo may still be on its way). */
+    virtual int32_t get_tilt_centidegrees() { return this->_tilt_angle; }
+
+    /** @brief Interpolates the recorded pose history; false before begin() or past its reach. */
+    virtual bool get_pose_at(int64_t timestamp_us, TurretPose& pose) { return this->_history.at(timestamp_us, pose); }
+
+    /**
+     * @brief Restricts the pan travel, e.g. to protect the camera cable.
+     * @param min_steps Lowest allowed position (<= 0).
+     * @param max_steps Highest allowed position (>= 0).
+     */
+    void set_pan_limits(int32_t min_steps, int32_t max_steps);
+
+    /**
+     * @brief Restricts the tilt travel to a mechanically safe range.
+     * @param min_degrees Lowest allowed angle, at least SERVO_MIN_ANGLE.
+     * @param max_degrees Highest allowed angle, at most SERVO_MAX_ANGLE.
+     */
+    void set_tilt_limits(int32_t min_degrees, int32_t max_degrees);
+
+    /**
+     * @brief Chooses the pan target reached by the shortest rotation.
+     * @param current_steps Where the pan axis is now.
+     * @param requested_steps Requested heading; any multiple of a revolution away is equivalent.
+     * @param min_steps Soft limit.
+     * @param max_steps Soft limit.
+     * @return Absolute target inside [min_steps, max_steps].
+     */
+    static int32_t shortest_pan_target(int32_t current_steps, int32_t requested_steps, int32_t min_steps,
+                                       int32_t max_steps);
+
     /**
      * @brief Executes horizontal rotation (Yaw) using the stepper motor.
      * @details Checks the MoveDirectionX enum; if Left or Right, the stepper
-     * moves by the predefined _STEP_INCREMENT. Negative steps rotate in one
-     * direction, positive in the other.
+     * target moves by the predefined _STEP_INCREMENT without waiting for the
+     * motor. Negative steps rotate in one direction, positive in the other.
      * @param yaw_direction The direction to rotate (Left, Right, or None).
      */
     void move_stepper(const MoveDirectionX yaw_direction);
 
     /**
      * @brief Executes vertical tilting (Pitch) using the servo motor.
-     * @details Reads current servo position and adjusts it by _SERVO_INCREMENT.
-     * The final position is constrained between SERVO_MIN_ANGLE and
-     * SERVO_MAX_ANGLE to prevent mechanical stall or gear damage.
+     * @details Adjusts the commanded angle by _SERVO_INCREMENT (5 degrees). The final position
+     * is constrained to the tilt soft limits to prevent mechanical stall or gear damage.
      * @param pitch_direction The direction to tilt (Up, Down, or None).
      */
     void move_servo(const MoveDirectionY pitch_direction);
-};
\ No newline at end of file
+};
@@ -0,0 +1,73 @@
+/**
+ * @file pid_controller.h
+ * @brief Fixed-point PID controller with deadband and anti-windup.
+ */
+#pragma once
+
+#include <stdint.h>
+
+#define PID_GAIN_SHIFT 16 /**< Gains are Q16: 65536 == 1.0 output unit per input unit. */
+
+/**
+ * @struct PidGains
+ * @brief Tuning of one PID axis. Input and output units are chosen by the caller.
+ */
+struct PidGains {
+    int32_t kp_q16;         /**< Proportional gain (Q16). */
+    int32_t ki_q16;         /**< Integral gain per update (Q16). */
+    int32_t kd_q16;         /**< Derivative gain per update (Q16). */
+    int32_t deadband;       /**< |error| at or below this produces no output (input units). */
+    int32_t integral_limit; /**< Clamp of the accumulated error (input units). */
+    int32_t output_limit;   /**< Clamp of the returned command (output units). */
+};
+
+/**
+ * @class PidController
+ * @brief Integer PID loop, updated once per detection.
+ * @details The derivative acts on the error, which for a centring loop (set-point
+ * fixed at 0) is the same as acting on the measurement, so there is no derivative
+ * kick. Windup is prevented twice: the integral is clamped, and it stops growing
+ * while the output is saturated in the direction it would push further.
+ */
+class PidController
+{
+private:
+    PidGains _gains;
+    int32_t _integral;       ///< Accumulated error (input units).
+    int32_t _previous_error; ///< Error of the last update, for the derivative term.
+    bool _has_previous;      ///< False until one update has run since reset().
+
+public:
+    /**
+     * @brief Construct a new PID controller.
+     * @param gains Initial tuning.
+     */
+    explicit PidController(const PidGains& gains) : _gains(gains), _integral(0), _previous_error(0), _has_previous(false)
+    {
+    }
+
+    /** @brief Replaces the tuning and clears the loop state. */
+    void set_gains(const PidGains& gains)
+    {
+        this->_gains = gains;
+        reset();
+    }
+
+    /** @return The active tuning. */
+    const PidGains& get_gains() const { return this->_gains; }
+
+    /** @brief Clears the integral and derivative history (e.g. when the target is lost). */
+    void reset()
+    {
+        this->_integral = 0;
+        this->_previous_error = 0;
+        this->_has_previous = false;
+    }
+
+    /**
+     * @brief Runs one control step.
+     * @param error Set-point minus measurement, in input units.
+     * @return Command in output units, clamped to ±output_limit; 0 inside the deadband.
+     */
+    int32_t update(int32_t error);
+};
@@ -0,0 +1,46 @@
+/**
+ * @file pid_profiles.h
+ * @brief Pan/tilt PID tuning for each supported camera frame size.
+ */
+#pragma once
+
+#include <stdint.h>
+
+#include "camera_calibration.h"
+#include "pid_controller.h"
+
+/**
+ * @struct PidProfile
+ * @brief Gains for both axes at one frame size.
+ * @details Both loops take the detector error in Q4 pixels. The pan loop outputs
+ * stepper steps and the tilt loop outputs servo centidegrees, so a correction
+ * finer than a degree is not rounded away. The proportional gains
+ * come from the lens field of view, so a single update removes most of the error.
+ * The deadband grows with resolution, because centroid noise grows in pixels too.
+ */
+struct PidProfile {
+    uint16_t frame_width;  /**< Frame width this profile was tuned for. */
+    uint16_t frame_height; /**< Frame height this profile was tuned for. */
+    PidGains pan;          /**< Q4 px -> stepper steps. */
+    PidGains tilt;         /**< Q4 px -> servo centidegrees. */
+};
+
+/**
+ * @brief Looks up the profile for a frame width.
+ * @param frame_width Width of the analysed frame; widths without an exact entry use
+ * the closest profile, and 0 (unknown) uses the QVGA profile.
+ * @return Reference to a statically allocated profile.
+ */
+const PidProfile& pid_profile_for_frame(uint16_t frame_width);
+
+/**
+ * @brief Builds gains from a measured calibration instead of the nominal lens.
+ * @details The proportional term removes PID_CALIBRATED_KP_FRACTION of the error, so
+ * with a measured scale one move nearly centres the target. Deadband and limits come
+ * from the closest nominal profile.
+ * @param calibration Valid calibration, taken at any frame size.
+ * @param frame_width Width of the analysed frame.
+ * @param frame_height Height of the analysed frame.
+ */
+PidProfile pid_profile_for_calibration(const CameraCalibration& calibration, uint16_t frame_width,
+                                       uint16_t frame_height);
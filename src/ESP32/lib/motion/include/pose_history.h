@@ -0,0 +1,69 @@
+/**
+ * @file pose_history.h
+ * @brief Timestamped ring buffer of turret poses, for looking up where the turret was.
+ */
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <freertos/FreeRTOS.h>
+
+#define POSE_HISTORY_SIZE 128       /**< Samples kept; with the default period, 640 ms of history. */
+#define POSE_HISTORY_PERIOD_US 5000 /**< Sampling period used by MovementManager. */
+
+/**
+ * @struct TurretPose
+ * @brief Orientation of the turret at one instant.
+ */
+struct TurretPose {
+    int64_t timestamp_us = 0;      /**< esp_timer time of the sample. */
+    int32_t pan_steps = 0;         /**< Pan position in steps from the power-on heading. */
+    int32_t tilt_centidegrees = 0; /**< Servo angle actually being driven, slew included, in centidegrees. */
+};
+
+/**
+ * @class PoseHistory
+ * @brief Keeps the last POSE_HISTORY_SIZE poses and interpolates between them.
+ * @details A camera frame shows the scene as it was when the frame was captured,
+ * which can be a good fraction of a second before the detection is handled. While
+ * the turret moves, correcting from its current pose then applies the same error
+ * again from a pose it has already left. Looking up the pose at the frame timestamp
+ * turns the detection into an absolute target instead.
+ *
+ * One context records (the esp_timer task) and others read, so every access takes
+ * a short critical section; a lookup walks back from the newest sample, which is
+ * only a few entries for a recent frame.
+ */
+class PoseHistory
+{
+private:
+    TurretPose _poses[POSE_HISTORY_SIZE]; ///< Ring storage.
+    size_t _next;                         ///< Slot the next sample goes into.
+    size_t _count;                        ///< Valid samples, up to POSE_HISTORY_SIZE.
+
+    portMUX_TYPE _lock = portMUX_INITIALIZER_UNLOCKED;
+
+public:
+    PoseHistory() : _next(0), _count(0) {}
+
+    /** @brief Appends a sample, overwriting the oldest once full. Timestamps must not decrease. */
+    void record(const TurretPose& pose);
+
+    /** @brief Forgets every sample. */
+    void clear();
+
+    /** @return Number of samples held. */
+    size_t size();
+
+    /**
+     * @brief Estimates the pose at @p timestamp_us.
+     * @details Between two samples both axes are interpolated linearly and rounded
+     * to whole steps and centidegrees. A time after the newest sample gets the
+     * newest pose.
+     * @param timestamp_us esp_timer time to look up.
+     * @param pose Receives the estimate, stamped with @p timestamp_us.
+     * @return false if the history is empty or does not reach back that far.
+     */
+    bool at(int64_t timestamp_us, TurretPose& pose);
+};
@@ -0,0 +1,62 @@
+/**
+ * @file queued_movement_manager.h
+ * @brief BaseMovementManager that posts to the motion task instead of driving motors.
+ */
+#pragma once
+
+#include "base_movement_manager.h"
+#include "motion_command_queue.h"
+
+/**
+ * @class QueuedMovementManager
+ * @brief Thread-safe stand-in for MovementManager, one per calling context.
+ * @details Every move becomes a MotionCommand on this instance's own queue lane, so
+ * the Controller, the web handlers and any other task can move the turret without
+ * locks. Give each context its own instance: a lane has exactly one producer.
+ * The getters read the real movement manager. They describe where the turret is,
+ * so they do not yet include commands that are still queued.
+ */
+class QueuedMovementManager : public BaseMovementManager
+{
+private:
+    MotionCommandQueue::Producer _producer;
+    BaseMovementManager& _motors; /**< Read-only here; driven by the MotionTask. */
+
+public:
+    /**
+     * @brief Construct a new Queued Movement Manager object.
+     * @param queue Queue consumed by the MotionTask.
+     * @param motors Movement manager behind the MotionTask, used for the getters.
+     */
+    QueuedMovementManager(MotionCommandQueue& queue, BaseMovementManager& motors)
+        : _producer(queue.make_producer()), _motors(motors)
+    {
+    }
+
+    /** @return false if the queue had no free lane left for this instance. */
+    bool is_valid() const { return this->_producer.is_valid(); }
+
+    /** @brief Posts a Nudge; a command with both axes None is not posted. */
+    virtual void move_relative(std::tuple<MoveDirectionX, MoveDirectionY> move_directions);
+
+    /** @brief Posts a MoveBy; consecutive ones are summed by the motion task. */
+    virtual void move_by(int32_t pan_steps, int32_t tilt_centidegrees);
+
+    /** @brief Posts a MoveTo, superseding every move posted before it. */
+    virtual void move_absolute(int32_t pan_steps, int32_t tilt_centidegrees);
+
+    /** @brief Posts a Velocity; a run of them is applied as the newest one. */
+    virtual void move_velocity(int32_t pan_steps_per_s, int32_t tilt_centidegrees_per_s);
+
+    /** @return Current pan position in steps. */
+    virtual int32_t get_pan_position() { return this->_motors.get_pan_position(); }
+
+    /** @return Last tilt angle applied by the motion task, in centidegrees. */
+    virtual int32_t get_tilt_centidegrees() { return this->_motors.get_tilt_centidegrees(); }
+
+    /** @brief Reads the pose history of the real movement manager. */
+    virtual bool get_pose_at(int64_t timestamp_us, TurretPose& pose)
+    {
+        return this->_motors.get_pose_at(timestamp_us, pose);
+    }
+};
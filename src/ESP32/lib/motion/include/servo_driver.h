@@ -0,0 +1,143 @@
+/**
+ * @file servo_driver.h
+ * @brief Microsecond-resolution, slew-limited hobby servo output at up to 333 Hz.
+ */
+#pragma once
+
+#include <stdint.h>
+
+#include <ESP32Servo.h>
+#include <esp_timer.h>
+#include <freertos/FreeRTOS.h>
+
+#define SERVO_DEFAULT_MIN_PULSE_US 544   /**< Pulse width at 0 degrees (ESP32Servo default). */
+#define SERVO_DEFAULT_MAX_PULSE_US 2400  /**< Pulse width at SERVO_RANGE_DEG degrees (ESP32Servo default). */
+#define SERVO_RANGE_DEG 180              /**< Mechanical travel between the two pulse widths. */
+#define SERVO_MIN_REFRESH_HZ 50          /**< Standard analog servo frame rate. */
+#define SERVO_MAX_REFRESH_HZ 333         /**< Fastest frame rate digital servos accept. */
+#define SERVO_DEFAULT_SLEW_US_PER_S 6000 /**< About an SG90's own top speed (60 degrees in 0.1 s). */
+
+/**
+ * @class ServoDriver
+ * @brief Drives the tilt servo in pulse microseconds instead of whole degrees.
+ * @details Servo::write() rounds every command to a whole degree, about 10 µs of pulse.
+ * It also runs at 50 Hz, so a new command can wait up to 20 ms for the next frame.
+ * This driver keeps the target in microseconds via writeMicroseconds(). The LEDC
+ * frame rate can be raised up to SERVO_MAX_REFRESH_HZ for digital servos.
+ *
+ * Output is slew limited. A write moves the pulse at once, by as much as one frame's
+ * slew budget allows. A periodic esp_timer, running at the refresh rate, then walks
+ * the rest of the way. Large jumps become constant-speed sweeps, and small tracking
+ * corrections go out within one frame, with no whole-degree staircase.
+ *
+ * The pulse state is guarded by a spinlock, but the LEDC driver is only ever called
+ * outside it. set_target_pulse() touches nothing but that state, so callers can
+ * retarget inside their own critical sections and call update_output() afterwards.
+ */
+class ServoDriver
+{
+private:
+    Servo _servo;              /**< ESP32Servo LEDC channel. */
+    uint8_t _pin;              /**< Signal pin. */
+    uint16_t _min_pulse_us;    /**< Pulse width at 0 degrees. */
+    uint16_t _max_pulse_us;    /**< Pulse width at SERVO_RANGE_DEG. */
+    uint16_t _refresh_hz;      /**< LEDC frame rate and slew timer rate. */
+    uint32_t _slew_us_per_s;   /**< Pulse width change per second; 0 is unlimited. */
+    uint16_t _target_us;       /**< Requested pulse width. */
+    uint16_t _output_us;       /**< Pulse width currently on the pin. */
+    int64_t _last_update_us;   /**< esp_timer time of the last slew step. */
+    bool _reattaching;         /**< The LEDC channel is being re-attached; the pin is not written. */
+    uint8_t _writing;          /**< update_output() calls between their check and their pin write. */
+    esp_timer_handle_t _timer; /**< Periodic slew timer. */
+
+    /** @brief Guards the pulse state between callers and the timer task. */
+    portMUX_TYPE _lock = portMUX_INITIALIZER_UNLOCKED;
+
+    /** @brief esp_timer trampoline. */
+    static void _on_timer(void* arg);
+
+    /**
+     * @brief Moves the output towards the target as far as the slew budget allows.
+     * @details Call with _lock held; only the state changes, the pin is left to
+     * update_output(). The budget covers the time since the last step, at most one frame.
+     * @return true if the output moved.
+     */
+    bool _advance(int64_t now_us);
+
+    /** @brief Attaches the LEDC channel at the current refresh rate, without writing it. */
+    void _attach();
+
+public:
+    /**
+     * @brief Construct a new Servo Driver object.
+     * @param pin Signal pin.
+     * @param min_pulse_us Pulse width at 0 degrees.
+     * @param max_pulse_us Pulse width at SERVO_RANGE_DEG degrees.
+     */
+    ServoDriver(uint8_t pin, uint16_t min_pulse_us = SERVO_DEFAULT_MIN_PULSE_US,
+                uint16_t max_pulse_us = SERVO_DEFAULT_MAX_PULSE_US);
+
+    ~ServoDriver();
+
+    /**
+     * @brief Attaches the servo, centres it and starts the slew timer.
+     * @return true on success.
+     */
+    bool begin();
+
+    /**
+     * @brief Sets the PWM frame rate; re-attaches the channel if already running.
+     * @details The slew timer is stopped meanwhile, and no write reaches the pin
+     * until the channel is attached again; it then gets the latest output.
+     * @param hz Clamped to [SERVO_MIN_REFRESH_HZ, SERVO_MAX_REFRESH_HZ]. Only raise it
+     * above 50 Hz for digital servos; analog ones overheat or jitter.
+     */
+    void set_refresh_rate(uint16_t hz);
+
+    /** @brief Limits how fast the pulse width may change; 0 disables the limit. */
+    void set_slew_rate(uint32_t us_per_second);
+
+    /** @brief Requests pulse width @p pulse_us, clamped to the calibrated range. */
+    void write_microseconds(uint16_t pulse_us)
+    {
+        if (set_target_pulse(pulse_us))
+        {
+            update_output();
+        }
+    }
+
+    /**
+     * @brief Requests pulse width @p pulse_us and takes the first slew step, in state only.
+     * @details Never calls the LEDC driver, so it may run inside a critical section.
+     * @return true if the output moved and update_output() should be called once outside it.
+     */
+    bool set_target_pulse(uint16_t pulse_us);
+
+    /**
+     * @brief Writes the current output to the pin. Call outside any critical section.
+     * @details Writers race only on the pin: one that finds the output moved on while
+     * it wrote writes again, so the pin always ends on the latest output.
+     */
+    void update_output();
+
+    /** @brief Requests @p degrees in [0, SERVO_RANGE_DEG], with sub-degree resolution. */
+    void write_angle(float degrees) { write_microseconds(angle_to_pulse(degrees)); }
+
+    /** @return Pulse width for @p degrees, clamped to the calibrated range. */
+    uint16_t angle_to_pulse(float degrees) const;
+
+    /** @return Angle in degrees for @p pulse_us. */
+    float pulse_to_angle(uint16_t pulse_us) const;
+
+    /** @return Pulse width currently on the pin. */
+    uint16_t get_pulse();
+
+    /** @return Requested pulse width. */
+    uint16_t get_target_pulse();
+
+    /** @return Angle currently on the pin, in degrees. */
+    float get_angle() { return pulse_to_angle(get_pulse()); }
+
+    /** @return PWM frame rate in Hz. */
+    uint16_t get_refresh_rate() const { return this->_refresh_hz; }
+};
@@ -0,0 +1,82 @@
+/**
+ * @file spsc_ring.h
+ * @brief Fixed-size lock-free single-producer/single-consumer ring buffer.
+ */
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <atomic>
+
+/**
+ * @class SpscRing
+ * @brief Wait-free FIFO between exactly one producer and one consumer context.
+ * @details The producer writes only _tail and the consumer writes only _head. Each
+ * publishes with a release store and reads the other index with an acquire load,
+ * so no lock or critical section is needed, even across the two ESP32 cores.
+ * Indices run freely and are masked on access, so all @p Capacity slots are usable.
+ * @tparam T Trivially copyable element type.
+ * @tparam Capacity Number of slots; must be a power of two.
+ */
+template <typename T, size_t Capacity> class SpscRing
+{
+    static_assert(Capacity >= 2 && (Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two");
+
+private:
+    T _slots[Capacity];
+    std::atomic<size_t> _head; /**< Next slot to read; written by the consumer only. */
+    std::atomic<size_t> _tail; /**< Next slot to write; written by the producer only. */
+
+public:
+    SpscRing() : _head(0), _tail(0) {}
+
+    SpscRing(const SpscRing&) = delete;
+    SpscRing& operator=(const SpscRing&) = delete;
+
+    /**
+     * @brief Appends @p item. Producer side only.
+     * @return false if the ring is full; the item is not stored.
+     */
+    bool push(const T& item)
+    {
+        size_t tail = this->_tail.load(std::memory_order_relaxed);
+        if (tail - this->_head.load(std::memory_order_acquire) >= Capacity)
+        {
+            return false;
+        }
+
+        this->_slots[tail & (Capacity - 1)] = item;
+        this->_tail.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * @brief Removes the oldest item into @p item. Consumer side only.
+     * @return false if the ring is empty.
+     */
+    bool pop(T& item)
+    {
+        size_t head = this->_head.load(std::memory_order_relaxed);
+        if (head == this->_tail.load(std::memory_order_acquire))
+        {
+            return false;
+        }
+
+        item = this->_slots[head & (Capacity - 1)];
+        this->_head.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    /** @return Items currently queued; exact only when called from one of the two sides. */
+    size_t size() const
+    {
+        return this->_tail.load(std::memory_order_acquire) - this->_head.load(std::memory_order_acquire);
+    }
+
+    /** @return true if nothing is queued. */
+    bool empty() const { return size() == 0; }
+
+    /** @return Slot count. */
+    static constexpr size_t capacity() { return Capacity; }
+};
@@ -0,0 +1,82 @@
+/**
+ * @file step_generator.h
+ * @brief Hardware-independent trapezoidal step timing.
+ */
+#pragma once
+
+#include <stdint.h>
+
+/**
+ * @class StepGenerator
+ * @brief Computes when each step of a move has to happen, one step at a time.
+ * @details Implements the constant-acceleration recurrence from D. Austin,
+ * "Generate stepper-motor speed profiles in real time" (the AccelStepper variant):
+ * c(n) = c(n-1) - 2 c(n-1) / (4n + 1). The ramp counter n is kept signed, so the
+ * target can change at any moment. If the new target is too close, or lies behind
+ * the motor, it decelerates first, reverses if needed, and then ramps towards the
+ * new target without ever exceeding the configured acceleration.
+ *
+ * The generator owns no clock and no pins. A driver calls start() once a target
+ * is set, waits the returned interval, then calls tick() to emit the step and get
+ * the next interval, until 0 signals that the move is finished. The same class
+ * runs unchanged under a virtual clock on the host.
+ */
+class StepGenerator
+{
+private:
+    float _acceleration; /**< Steps per second squared. */
+    float _c0;           /**< First step interval from rest (µs). */
+    float _cmin;         /**< Interval at max speed (µs). */
+    float _cn;           /**< Current step interval (µs). */
+    float _speed;        /**< Current signed speed (steps/s). */
+    int32_t _n;          /**< Signed ramp step counter; negative while decelerating. */
+    int8_t _direction;   /**< Direction of the step about to be emitted (+1 / -1). */
+    int32_t _position;   /**< Steps emitted so far (absolute). */
+    int32_t _target;     /**< Absolute target position. */
+
+    /** @brief Advances the ramp state and returns the interval to the next step (0 = stop). */
+    uint32_t _compute_next_interval();
+
+public:
+    StepGenerator();
+
+    /** @brief Sets the cruise speed in steps per second (> 0). */
+    void set_max_speed(float steps_per_second);
+
+    /** @brief Sets the ramp acceleration in steps per second squared (> 0). */
+    void set_acceleration(float steps_per_second2);
+
+    /** @brief Sets the absolute target. Safe while moving; start() is only needed from rest. */
+    void set_target(int32_t target) { this->_target = target; }
+
+    /**
+     * @brief Starts a move from rest.
+     * @return Delay in µs before the first step, or 0 if already at the target.
+     */
+    uint32_t start();
+
+    /**
+     * @brief Emits the step that is due now and plans the next one.
+     * @param step_direction Set to +1 / -1 for the emitted step, or 0 if none was due.
+     * @return Delay in µs until the next tick(), or 0 when the move is complete.
+     */
+    uint32_t tick(int8_t& step_direction);
+
+    /** @brief Redirects the target to the closest position the motor can stop at. */
+    void stop();
+
+    /** @brief Redefines the current position (and target) without moving; only while idle. */
+    void set_position(int32_t position);
+
+    /** @return Steps emitted so far (absolute). */
+    int32_t get_position() const { return this->_position; }
+
+    /** @return Absolute target position. */
+    int32_t get_target() const { return this->_target; }
+
+    /** @return Current signed speed in steps per second. */
+    float get_speed() const { return this->_speed; }
+
+    /** @return true while a move is in progress. */
+    bool is_moving() const { return this->_speed != 0.0f; }
+};
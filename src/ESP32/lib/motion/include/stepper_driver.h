@@ -0,0 +1,145 @@
+/**
+ * @file stepper_driver.h
+ * @brief Non-blocking, timer-driven driver for 4-coil unipolar steppers (28BYJ-48).
+ */
+#pragma once
+
+#include <stdint.h>
+
+#include <esp_timer.h>
+#include <freertos/FreeRTOS.h>
+
+#include "step_generator.h"
+
+#define STEPPER_DEFAULT_MAX_SPEED 400.0f     /**< Full steps per second (~12 rpm on a 28BYJ-48). */
+#define STEPPER_DEFAULT_ACCELERATION 1600.0f /**< Full steps per second squared. */
+#define STEPPER_SETTLE_US 5000               /**< Final phase hold before the coils are released. */
+
+/** @brief Coil energising sequence. */
+enum class StepMode : uint8_t {
+    FullStep = 0, /**< Two coils on at all times: 4 states per cycle, most torque. */
+    HalfStep = 1, /**< Alternates one and two coils: 8 states per cycle, smoother and quieter. */
+};
+
+/**
+ * @brief Called from the timer task after every full step.
+ * @param arg Context registered with the listener.
+ * @param position New position in full steps.
+ */
+typedef void (*StepListener)(void* arg, int32_t position);
+
+/**
+ * @class StepperDriver
+ * @brief Runs stepper moves in the background from an esp_timer one-shot.
+ * @details Replaces the blocking Arduino Stepper::step(). move_to() and move_relative()
+ * only update the target and return immediately. The timer callback emits one
+ * coil state per step and re-arms itself with the next interval from a
+ * StepGenerator, so every move follows a trapezoidal speed profile. A new target
+ * given mid-move is blended into the running ramp and never causes a hard stop.
+ *
+ * Positions and speeds are always in full steps, as in STEPPER_NUMBER_OF_STEPS,
+ * whatever the StepMode. In half-step mode the generator simply runs at twice the
+ * rate. Pins are given in the same order as the Arduino Stepper constructor,
+ * so existing wiring keeps its direction.
+ */
+class StepperDriver
+{
+private:
+    StepGenerator _generator;  /**< Ramp state, in sequence steps (full or half). */
+    uint8_t _pins[4];          /**< Coil pins, Arduino Stepper order. */
+    StepMode _mode;            /**< Active coil sequence. */
+    uint8_t _phase;            /**< Index into the active coil sequence. */
+    bool _hold_when_idle;      /**< Keep the coils energised after a move. */
+    volatile bool _running;    /**< A step or the final settle time is pending. */
+    esp_timer_handle_t _timer; /**< One-shot step timer. */
+    StepListener _listener;    /**< Optional per-step callback. */
+    void* _listener_arg;       /**< Context for _listener. */
+
+    /** @brief Guards _generator and _running between callers and the timer task. */
+    portMUX_TYPE _lock = portMUX_INITIALIZER_UNLOCKED;
+
+    /** @brief esp_timer trampoline. */
+    static void _on_timer(void* arg);
+
+    /** @brief Emits the due step and re-arms the timer. Runs in the esp_timer task. */
+    void _on_step();
+
+    /** @brief Drives the coil pins for the current phase. */
+    void _write_phase();
+
+    /** @brief Switches every coil off. */
+    void _release_coils();
+
+    /** @brief Sequence steps per full step (1 or 2). */
+    int32_t _microsteps() const { return (this->_mode == StepMode::HalfStep) ? 2 : 1; }
+
+    /** @brief Sequence steps to full steps, rounded down so half-steps read alike on both sides of zero. */
+    int32_t _to_steps(int32_t sequence_steps) const
+    {
+        int32_t steps = sequence_steps / _microsteps();
+        return (sequence_steps % _microsteps() < 0) ? steps - 1 : steps;
+    }
+
+public:
+    /**
+     * @brief Construct a new Stepper Driver object.
+     * @param pin1..pin4 Coil pins in Arduino Stepper constructor order.
+     * @param mode Coil sequence to drive.
+     */
+    StepperDriver(uint8_t pin1, uint8_t pin2, uint8_t pin3, uint8_t pin4, StepMode mode = StepMode::HalfStep);
+
+    ~StepperDriver();
+
+    /**
+     * @brief Configures the pins and creates the step timer.
+     * @return true on success.
+     */
+    bool begin();
+
+    /** @brief Cruise speed in full steps per second. */
+    void set_max_speed(float steps_per_second);
+
+    /** @brief Ramp acceleration in full steps per second squared. */
+    void set_acceleration(float steps_per_second2);
+
+    /**
+     * @brief Registers a callback run after every full step, e.g. to slave another axis.
+     * @details It runs in the esp_timer task between steps, so it must be short. Set it
+     * before the first move.
+     */
+    void set_step_listener(StepListener listener, void* arg);
+
+    /** @brief Keep the coils energised when idle (more holding torque, more heat). */
+    void set_hold_when_idle(bool hold) { this->_hold_when_idle = hold; }
+
+    /**
+     * @brief Moves to an absolute position; returns immediately.
+     * @param position Target in full steps.
+     */
+    void move_to(int32_t position);
+
+    /**
+     * @brief Moves relative to the current target; returns immediately.
+     * @details Consecutive calls add up, like consecutive blocking step() calls.
+     * @param steps Offset in full steps; positive turns in Stepper::step() positive direction.
+     */
+    void move_relative(int32_t steps);
+
+    /** @brief Decelerates to a stop as quickly as the acceleration allows. */
+    void stop();
+
+    /** @brief Redefines the current position without moving; ignored while moving. */
+    void set_position(int32_t position);
+
+    /** @return Current position in full steps. */
+    int32_t get_position();
+
+    /** @return Current position in full steps, keeping the half step get_position() rounds away. */
+    float get_exact_position();
+
+    /** @return Target position in full steps. */
+    int32_t get_target();
+
+    /** @return true while a move (or its final settle time) is in progress. */
+    bool is_moving() const { return this->_running; }
+};
@@ -0,0 +1,148 @@
+#include "motion_command_queue.h"
+
+#include <tuple>
+
+MotionCommandQueue::MotionCommandQueue()
+    : _lane_count(0), _next_sequence(0), _dropped(0), _coalesced(0), _last_move_to(0), _has_move_to(false),
+      _post_hook(nullptr), _post_hook_arg(nullptr)
+{
+}
+
+MotionCommandQueue::Producer MotionCommandQueue::make_producer()
+{
+    uint8_t lane = this->_lane_count.load(std::memory_order_relaxed);
+    do
+    {
+        if (lane >= MOTION_QUEUE_MAX_PRODUCERS)
+        {
+            return Producer(nullptr, 0);
+        }
+    } while (!this->_lane_count.compare_exchange_weak(lane, lane + 1, std::memory_order_relaxed));
+
+    return Producer(this, lane);
+}
+
+void MotionCommandQueue::set_post_hook(void (*hook)(void*), void* arg)
+{
+    this->_post_hook_arg.store(arg, std::memory_order_relaxed);
+    this->_post_hook.store(hook, std::memory_order_release);
+}
+
+bool MotionCommandQueue::Producer::post(MotionCommand command)
+{
+    if (!this->_queue)
+    {
+        return false;
+    }
+
+    command.sequence = this->_queue->_next_sequence.fetch_add(1, std::memory_order_relaxed);
+    if (!this->_queue->_lanes[this->_lane].push(command))
+    {
+        this->_queue->_dropped.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+
+    void (*hook)(void*) = this->_queue->_post_hook.load(std::memory_order_acquire);
+    if (hook)
+    {
+        hook(this->_queue->_post_hook_arg.load(std::memory_order_relaxed));
+    }
+    return true;
+}
+
+size_t MotionCommandQueue::drain(BaseMovementManager& motors)
+{
+    const size_t batch_capacity = sizeof(this->_batch) / sizeof(this->_batch[0]);
+
+    // 1. Collect every lane, dropping anything posted before the last applied MoveTo
+    size_t count = 0;
+    for (size_t lane = 0; lane < MOTION_QUEUE_MAX_PRODUCERS; lane++)
+    {
+        while (count < batch_capacity && this->_lanes[lane].pop(this->_batch[count]))
+        {
+            if (this->_has_move_to && _before(this->_batch[count].sequence, this->_last_move_to))
+            {
+                this->_coalesced++; // Stale: lost the race against a newer absolute target
+                continue;
+            }
+            count++;
+        }
+    }
+
+    if (count == 0)
+    {
+        return 0;
+    }
+
+    // 2. Restore post order; lanes are already sorted, so insertion sort is near linear
+    for (size_t i = 1; i < count; i++)
+    {
+        MotionCommand key = this->_batch[i];
+        size_t j = i;
+        while (j > 0 && _before(key.sequence, this->_batch[j - 1].sequence))
+        {
+            this->_batch[j] = this->_batch[j - 1];
+            j--;
+        }
+        this->_batch[j] = key;
+    }
+
+    // 3. The newest absolute target supersedes everything before it
+    size_t first = 0;
+    for (size_t i = 0; i < count; i++)
+    {
+        if (this->_batch[i].type == MotionCommand::Type::MoveTo)
+        {
+            first = i;
+        }
+    }
+    this->_coalesced += first;
+
+    // 4. Apply the rest in order, folding runs of relative moves into one
+    size_t calls = 0;
+    size_t i = first;
+    while (i < count)
+    {
+        const MotionCommand& command = this->_batch[i];
+
+        if (command.type == MotionCommand::Type::MoveTo)
+        {
+            motors.move_absolute(command.pan, command.tilt);
+            this->_last_move_to = command.sequence;
+            this->_has_move_to = true;
+            i++;
+        } else if (command.type == MotionCommand::Type::Nudge)
+        {
+            motors.move_relative(std::make_tuple(command.nudge_x, command.nudge_y));
+            i++;
+        } else if (command.type == MotionCommand::Type::Velocity)
+        {
+            // Rates replace each other, so only the last of a run matters
+            size_t run = i;
+            while (run + 1 < count && this->_batch[run + 1].type == MotionCommand::Type::Velocity)
+            {
+                run++;
+            }
+            this->_coalesced += run - i;
+            motors.move_velocity(this->_batch[run].pan, this->_batch[run].tilt);
+            i = run + 1;
+        } else
+        {
+            int32_t pan = 0;
+            int32_t tilt = 0;
+            size_t run = i;
+            while (run < count && this->_batch[run].type == MotionCommand::Type::MoveBy)
+            {
+                pan += this->_batch[run].pan;
+                tilt += this->_batch[run].tilt;
+                run++;
+            }
+            this->_coalesced += run - i - 1;
+            motors.move_by(pan, tilt);
+            i = run;
+        }
+        calls++;
+    }
+
+    return calls;
+}
@@ -0,0 +1,49 @@
+#include "motion_task.h"
+
+#include <Arduino.h>
+
+bool MotionTask::start()
+{
+    if (this->_handle.load())
+    {
+        return true;
+    }
+
+    // Hook first, so no post can slip in between the task starting and the hook being set
+    this->_queue.set_post_hook(&MotionTask::_wake, this);
+
+    TaskHandle_t handle = nullptr;
+    if (xTaskCreatePinnedToCore(&MotionTask::_run, "motion", MOTION_TASK_STACK_SIZE, this, MOTION_TASK_PRIORITY,
+                                &handle, MOTION_TASK_CORE) != pdPASS)
+    {
+        Serial.println("[Motion] Failed to create motion task");
+        this->_queue.set_post_hook(nullptr, nullptr);
+        return false;
+    }
+
+    this->_handle.store(handle);
+    return true;
+}
+
+void MotionTask::_run(void* arg)
+{
+    MotionTask* task = static_cast<MotionTask*>(arg);
+    task->_handle.store(xTaskGetCurrentTaskHandle()); // Wakeable before start() has returned
+
+    // Drain before the first sleep: posts made before the handle was published woke nobody
+    for (;;)
+    {
+        task->run_once();
+        ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(MOTION_TASK_IDLE_MS));
+    }
+}
+
+void MotionTask::_wake(void* arg)
+{
+    MotionTask* task = static_cast<MotionTask*>(arg);
+    TaskHandle_t handle = task->_handle.load();
+    if (handle)
+    {
+        xTaskNotifyGive(handle);
+    }
+}
@@ -1,5 +1,65 @@
 #include "movement_manager.h"
 
+#include <Arduino.h>
+
+#include "latency_probe.h"
+
+MovementManager::~MovementManager()
+{
+    if (this->_sample_timer)
+    {
+        esp_timer_stop(this->_sample_timer);
+        esp_timer_delete(this->_sample_timer);
+    }
+    this->_stepper.set_step_listener(nullptr, nullptr);
+}
+
+bool MovementManager::begin()
+{
+    if (this->_sample_timer)
+    {
+        return true;
+    }
+
+    esp_timer_create_args_t args = {};
+    args.callback = &MovementManager::_on_sample;
+    args.arg = this;
+    args.dispatch_method = ESP_TIMER_TASK;
+    args.name = "pose";
+
+    if (esp_timer_create(&args, &this->_sample_timer) != ESP_OK)
+    {
+        Serial.println("[Motion] Failed to create pose sampler");
+        this->_sample_timer = nullptr;
+        return false;
+    }
+
+    _on_sample(this); // Seed the history, so a lookup right away finds the current pose
+    esp_timer_start_periodic(this->_sample_timer, POSE_HISTORY_PERIOD_US);
+    return true;
+}
+
+void MovementManager::_on_sample(void* arg)
+{
+    MovementManager* motors = static_cast<MovementManager*>(arg);
+
+    TurretPose pose;
+    pose.timestamp_us = esp_timer_get_time();
+    pose.pan_steps = motors->_stepper.get_position();
+    pose.tilt_centidegrees = motors->_to_centidegrees(motors->_servo.get_pulse());
+    motors->_history.record(pose);
+}
+
+uint16_t MovementManager::_to_pulse(int32_t centidegrees) const
+{
+    return this->_servo.angle_to_pulse((float)centidegrees / CENTIDEGREES_PER_DEGREE);
+}
+
+int32_t MovementManager::_to_centidegrees(uint16_t pulse_us) const
+{
+    return (int32_t)lroundf(this->_servo.pulse_to_angle(pulse_us) * CENTIDEGREES_PER_DEGREE);
+}
+
 void MovementManager::move_relative(const std::tuple<MoveDirectionX, MoveDirectionY> move_directions)
 {
 
@@ -7,40 +67,232 @@ void MovementManager::move_relative(const std::tuple<MoveDirectionX, MoveDirecti
     MoveDirectionX x = std::get<0>(move_directions);
     MoveDirectionY y = std::get<1>(move_directions);
 
-    move_stepper(x);
-    move_servo(y);
+    int32_t pan_steps = (x == MoveDirectionX::Left) ? -this->_STEP_INCREMENT
+                        : (x == MoveDirectionX::Right) ? this->_STEP_INCREMENT
+                                                       : 0;
+    int32_t tilt_centidegrees = (y == MoveDirectionY::Up) ? this->_SERVO_INCREMENT
+                                : (y == MoveDirectionY::Down) ? -this->_SERVO_INCREMENT
+                                                              : 0;
+
+    move_by(pan_steps, tilt_centidegrees);
 }
 
-void MovementManager::move_stepper(const MoveDirectionX yaw_direction)
+void MovementManager::move_by(int32_t pan_steps, int32_t tilt_centidegrees)
 {
-    if (yaw_direction != MoveDirectionX::None)
+    if (pan_steps == 0 && tilt_centidegrees == 0)
     {
-        if (yaw_direction == MoveDirectionX::Left) // Rotate Left
-        {
-            this->_stepper.step(-this->_STEP_INCREMENT);
-        } else if (yaw_direction == MoveDirectionX::Right) // Rotate Right
+        return;
+    }
+
+    _end_velocity();
+    _move_to(this->_stepper.get_target() + pan_steps, this->_tilt_angle + tilt_centidegrees);
+}
+
+void MovementManager::move_absolute(int32_t pan_steps, int32_t tilt_centidegrees)
+{
+    _end_velocity();
+    _move_to(shortest_pan_target(this->_stepper.get_position(), pan_steps, this->_pan_min, this->_pan_max),
+             tilt_centidegrees);
+}
+
+void MovementManager::move_velocity(int32_t pan_steps_per_s, int32_t tilt_centidegrees_per_s)
+{
+    LATENCY_PROBE(Actuation);
+    if (pan_steps_per_s == 0 && tilt_centidegrees_per_s == 0)
+    {
+        _end_velocity();
+        return;
+    }
+
+    // Each axis runs on its own; a coordinated move still in progress no longer applies
+    portENTER_CRITICAL(&this->_lock);
+    this->_plan.active = false;
+    portEXIT_CRITICAL(&this->_lock);
+    this->_velocity = true;
+
+    if (pan_steps_per_s != 0)
+    {
+        int32_t limit = (pan_steps_per_s > 0) ? this->_pan_max : this->_pan_min;
+        this->_stepper.set_max_speed((float)abs(pan_steps_per_s));
+        if (limit != this->_stepper.get_target())
         {
-            this->_stepper.step(this->_STEP_INCREMENT);
+            this->_stepper.move_to(limit);
         }
+    } else
+    {
+        this->_stepper.stop();
     }
+
+    if (tilt_centidegrees_per_s != 0)
+    {
+        // Centidegrees to pulse microseconds, at the servo's calibrated scale
+        int32_t span_us = this->_servo.angle_to_pulse(SERVO_RANGE_DEG) - this->_servo.angle_to_pulse(0);
+        this->_servo.set_slew_rate(
+            (uint32_t)(abs(tilt_centidegrees_per_s) * span_us / (SERVO_RANGE_DEG * CENTIDEGREES_PER_DEGREE)));
+        this->_tilt_angle = (tilt_centidegrees_per_s > 0) ? this->_tilt_max : this->_tilt_min;
+        this->_servo.write_microseconds(_to_pulse(this->_tilt_angle));
+    } else
+    {
+        uint16_t pulse = this->_servo.get_pulse();
+        this->_servo.write_microseconds(pulse);
+        this->_tilt_angle = _to_centidegrees(pulse);
+    }
+}
+
+void MovementManager::_end_velocity()
+{
+    if (!this->_velocity)
+    {
+        return;
+    }
+    this->_velocity = false;
+
+    this->_stepper.stop();
+    this->_stepper.set_max_speed(STEPPER_DEFAULT_MAX_SPEED);
+
+    uint16_t pulse = this->_servo.get_pulse();
+    this->_servo.set_slew_rate(SERVO_DEFAULT_SLEW_US_PER_S);
+    this->_servo.write_microseconds(pulse);
+    this->_tilt_angle = _to_centidegrees(pulse);
+}
+
+void MovementManager::set_pan_limits(int32_t min_steps, int32_t max_steps)
+{
+    if (min_steps > 0 || max_steps < 0)
+    {
+        return; // Must contain the home position
+    }
+
+    this->_pan_min = min_steps;
+    this->_pan_max = max_steps;
+    _move_to(this->_stepper.get_target(), this->_tilt_angle);
+}
+
+void MovementManager::set_tilt_limits(int32_t min_degrees, int32_t max_degrees)
+{
+    if (min_degrees > max_degrees)
+    {
+        return;
+    }
+
+    this->_tilt_min = constrain(min_degrees, SERVO_MIN_ANGLE, SERVO_MAX_ANGLE) * CENTIDEGREES_PER_DEGREE;
+    this->_tilt_max = constrain(max_degrees, SERVO_MIN_ANGLE, SERVO_MAX_ANGLE) * CENTIDEGREES_PER_DEGREE;
+    _move_to(this->_stepper.get_target(), this->_tilt_angle);
+}
+
+int32_t MovementManager::shortest_pan_target(int32_t current_steps, int32_t requested_steps, int32_t min_steps,
+                                             int32_t max_steps)
+{
+    const int32_t revolution = STEPPER_NUMBER_OF_STEPS;
+
+    // Signed offset to the requested heading, wrapped into [-revolution / 2, revolution / 2)
+    int32_t offset = (requested_steps - current_steps) % revolution;
+    if (offset >= revolution / 2)
+    {
+        offset -= revolution;
+    } else if (offset < -revolution / 2)
+    {
+        offset += revolution;
+    }
+
+    int32_t target = current_steps + offset;
+
+    // The short way is blocked by a soft limit: go the long way round instead
+    if (target > max_steps && target - revolution >= min_steps)
+    {
+        target -= revolution;
+    } else if (target < min_steps && target + revolution <= max_steps)
+    {
+        target += revolution;
+    }
+
+    return constrain(target, min_steps, max_steps);
+}
+
+void MovementManager::move_stepper(const MoveDirectionX yaw_direction)
+{
+    move_relative(std::make_tuple(yaw_direction, MoveDirectionY::None));
 }
 
 void MovementManager::move_servo(const MoveDirectionY pitch_direction)
 {
-    if (pitch_direction != MoveDirectionY::None)
+    move_relative(std::make_tuple(MoveDirectionX::None, pitch_direction));
+}
+
+void MovementManager::_move_to(int32_t pan_target, int32_t tilt_target)
+{
+    LATENCY_PROBE(Actuation);
+    pan_target = constrain(pan_target, this->_pan_min, this->_pan_max);
+    tilt_target = constrain(tilt_target, this->_tilt_min, this->_tilt_max);
+
+    // Plan the tilt against the pan travel still ahead, starting from where both axes are now
+    portENTER_CRITICAL(&this->_lock);
+    int32_t pan_start = this->_stepper.get_position();
+    int32_t pan_span = abs(pan_target - pan_start);
+
+    int32_t tilt_start = this->_servo.get_target_pulse();
+    int32_t tilt_end = _to_pulse(tilt_target);
+
+    this->_tilt_angle = tilt_target;
+    bool moved = false;
+    this->_plan.active = pan_span > 0 && tilt_end != tilt_start;
+    if (this->_plan.active)
+    {
+        this->_plan.pan_start = pan_start;
+        this->_plan.pan_span = pan_span;
+        this->_plan.pan_sign = (pan_target > pan_start) ? 1 : -1;
+        this->_plan.tilt_start = tilt_start;
+        this->_plan.tilt_delta = tilt_end - tilt_start;
+    } else if (tilt_end != tilt_start)
     {
-        int current_angle = this->_servo.read();
-        int target_angle = current_angle;
+        moved = this->_servo.set_target_pulse(tilt_end); // Nothing to wait for on the pan axis
+    }
+    portEXIT_CRITICAL(&this->_lock);
 
-        if (pitch_direction == MoveDirectionY::Up) // Angle Up
+    // The LEDC driver is never called with the lock held
+    if (moved)
+    {
+        this->_servo.update_output();
+    }
+
+    if (pan_target != this->_stepper.get_target())
+    {
+        this->_stepper.move_to(pan_target);
+    }
+}
+
+void MovementManager::_on_pan_step(void* arg, int32_t position)
+{
+    static_cast<MovementManager*>(arg)->_follow_pan(position);
+}
+
+void MovementManager::_follow_pan(int32_t position)
+{
+    bool moved = false;
+    portENTER_CRITICAL(&this->_lock);
+    if (this->_plan.active)
+    {
+        // Fraction of the pan travel covered; 0 while still braking the wrong way
+        int32_t done = constrain((position - this->_plan.pan_start) * this->_plan.pan_sign, 0, this->_plan.pan_span);
+
+        // Same fraction of the tilt travel, rounded half away from zero
+        int32_t scaled = this->_plan.tilt_delta * done;
+        int32_t half = (scaled < 0) ? -(this->_plan.pan_span / 2) : this->_plan.pan_span / 2;
+        int32_t pulse = this->_plan.tilt_start + (scaled + half) / this->_plan.pan_span;
+
+        if (pulse != this->_servo.get_target_pulse())
         {
-            target_angle += this->_SERVO_INCREMENT;
-        } else if (pitch_direction == MoveDirectionY::Down) // Angle Down
+            moved = this->_servo.set_target_pulse(pulse);
+        }
+        if (done == this->_plan.pan_span)
         {
-            target_angle -= this->_SERVO_INCREMENT;
+            this->_plan.active = false;
         }
+    }
+    portEXIT_CRITICAL(&this->_lock);
 
-        target_angle = constrain(target_angle, SERVO_MIN_ANGLE, SERVO_MAX_ANGLE);
-        this->_servo.write(target_angle);
+    if (moved)
+    {
+        this->_servo.update_output();
     }
 }
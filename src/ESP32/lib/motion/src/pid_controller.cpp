@@ -0,0 +1,45 @@
+#include "pid_controller.h"
+
+#include <stdlib.h>
+
+/** @brief Clamps @p value into [-limit, limit]. */
+static inline int64_t clamp_symmetric(int64_t value, int64_t limit)
+{
+    return (value > limit) ? limit : (value < -limit) ? -limit : value;
+}
+
+int32_t PidController::update(int32_t error)
+{
+    // 1. Deadband: close enough, hold still and let the integral bleed off
+    if (abs(error) <= this->_gains.deadband)
+    {
+        this->_integral /= 2;
+        this->_has_previous = false;
+        return 0;
+    }
+
+    int32_t derivative = this->_has_previous ? (error - this->_previous_error) : 0;
+    this->_previous_error = error;
+    this->_has_previous = true;
+
+    // 2. Tentative integral, clamped
+    int64_t integral = clamp_symmetric((int64_t)this->_integral + error, this->_gains.integral_limit);
+
+    int64_t output = (int64_t)this->_gains.kp_q16 * error + (int64_t)this->_gains.ki_q16 * integral +
+                     (int64_t)this->_gains.kd_q16 * derivative;
+
+    // Round half away from zero back to output units
+    const int64_t half = (int64_t)1 << (PID_GAIN_SHIFT - 1);
+    output = (output >= 0) ? (output + half) >> PID_GAIN_SHIFT : -((-output + half) >> PID_GAIN_SHIFT);
+
+    // 3. Conditional integration: only keep the new integral if it does not push
+    // an already saturated output further into saturation
+    bool saturated = (output > this->_gains.output_limit && error > 0) ||
+                     (output < -this->_gains.output_limit && error < 0);
+    if (!saturated)
+    {
+        this->_integral = (int32_t)integral;
+    }
+
+    return (int32_t)clamp_symmetric(output, this->_gains.output_limit);
+}
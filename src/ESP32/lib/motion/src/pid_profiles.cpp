@@ -0,0 +1,92 @@
+#include "pid_profiles.h"
+
+#include <stdlib.h>
+
+#include "constants.h"
+#include "detection_result.h"
+
+#define PID_KP_FRACTION 0.70 /**< Share of the measured error removed by the P term in one update. */
+#define PID_KI_FRACTION 0.05 /**< Share of the accumulated error removed per update. */
+#define PID_KD_FRACTION 0.15 /**< Damping on the frame-to-frame error change. */
+
+#define PID_CALIBRATED_KP_FRACTION 0.90 /**< P share once the pixel scale is measured rather than assumed. */
+
+/** @brief Q16 gain turning a Q4 pixel error into actuator units. */
+static constexpr int32_t gain_q16(double units_per_pixel, double fraction)
+{
+    return (int32_t)(units_per_pixel * fraction * (1 << PID_GAIN_SHIFT) / (1 << DETECTION_SUBPIXEL_BITS));
+}
+
+/** @brief Pan gains for a frame @p width pixels wide, deadband in whole pixels. */
+static constexpr PidGains pan_gains(uint16_t width, int32_t deadband_px)
+{
+    return PidGains{gain_q16((double)CAMERA_HFOV_DEG * STEPPER_NUMBER_OF_STEPS / 360.0 / width, PID_KP_FRACTION),
+                    gain_q16((double)CAMERA_HFOV_DEG * STEPPER_NUMBER_OF_STEPS / 360.0 / width, PID_KI_FRACTION),
+                    gain_q16((double)CAMERA_HFOV_DEG * STEPPER_NUMBER_OF_STEPS / 360.0 / width, PID_KD_FRACTION),
+                    deadband_px << DETECTION_SUBPIXEL_BITS,
+                    (width / 4) << DETECTION_SUBPIXEL_BITS,
+                    CAMERA_HFOV_DEG * STEPPER_NUMBER_OF_STEPS / 360 / 2};
+}
+
+/** @brief Tilt gains for a frame @p height pixels tall, deadband in whole pixels. */
+static constexpr PidGains tilt_gains(uint16_t height, int32_t deadband_px)
+{
+    return PidGains{gain_q16((double)CAMERA_VFOV_DEG * CENTIDEGREES_PER_DEGREE / height, PID_KP_FRACTION),
+                    gain_q16((double)CAMERA_VFOV_DEG * CENTIDEGREES_PER_DEGREE / height, PID_KI_FRACTION),
+                    gain_q16((double)CAMERA_VFOV_DEG * CENTIDEGREES_PER_DEGREE / height, PID_KD_FRACTION),
+                    deadband_px << DETECTION_SUBPIXEL_BITS,
+                    (height / 4) << DETECTION_SUBPIXEL_BITS,
+                    CAMERA_VFOV_DEG * CENTIDEGREES_PER_DEGREE / 2};
+}
+
+static const PidProfile PID_PROFILES[] = {
+    {96, 96, pan_gains(96, 1), tilt_gains(96, 1)},       // FRAMESIZE_96X96
+    {160, 120, pan_gains(160, 2), tilt_gains(120, 2)},   // FRAMESIZE_QQVGA
+    {240, 176, pan_gains(240, 2), tilt_gains(176, 2)},   // FRAMESIZE_HQVGA
+    {320, 240, pan_gains(320, 3), tilt_gains(240, 3)},   // FRAMESIZE_QVGA
+    {400, 296, pan_gains(400, 3), tilt_gains(296, 3)},   // FRAMESIZE_CIF
+    {640, 480, pan_gains(640, 5), tilt_gains(480, 5)},   // FRAMESIZE_VGA
+    {800, 600, pan_gains(800, 6), tilt_gains(600, 6)},   // FRAMESIZE_SVGA
+    {1024, 768, pan_gains(1024, 8), tilt_gains(768, 8)}, // FRAMESIZE_XGA
+};
+
+static const size_t PID_PROFILE_COUNT = sizeof(PID_PROFILES) / sizeof(PID_PROFILES[0]);
+static const size_t PID_DEFAULT_PROFILE = 3; // QVGA, the Camera default
+
+const PidProfile& pid_profile_for_frame(uint16_t frame_width)
+{
+    if (frame_width == 0)
+    {
+        return PID_PROFILES[PID_DEFAULT_PROFILE];
+    }
+
+    size_t best = 0;
+    for (size_t i = 1; i < PID_PROFILE_COUNT; i++)
+    {
+        if (abs((int)PID_PROFILES[i].frame_width - frame_width) < abs((int)PID_PROFILES[best].frame_width - frame_width))
+        {
+            best = i;
+        }
+    }
+    return PID_PROFILES[best];
+}
+
+PidProfile pid_profile_for_calibration(const CameraCalibration& calibration, uint16_t frame_width,
+                                       uint16_t frame_height)
+{
+    PidProfile profile = pid_profile_for_frame(frame_width);
+    double steps_per_pixel = 1.0 / calibration.pan_px_per_step_at(frame_width);
+    double centidegrees_per_pixel = CENTIDEGREES_PER_DEGREE / calibration.tilt_px_per_degree_at(frame_height);
+
+    profile.frame_width = frame_width;
+    profile.frame_height = frame_height;
+    profile.pan.kp_q16 = gain_q16(steps_per_pixel, PID_CALIBRATED_KP_FRACTION);
+    profile.pan.ki_q16 = gain_q16(steps_per_pixel, PID_KI_FRACTION);
+    profile.pan.kd_q16 = gain_q16(steps_per_pixel, PID_KD_FRACTION);
+    profile.pan.output_limit = (int32_t)(steps_per_pixel * frame_width / 2);
+    profile.tilt.kp_q16 = gain_q16(centidegrees_per_pixel, PID_CALIBRATED_KP_FRACTION);
+    profile.tilt.ki_q16 = gain_q16(centidegrees_per_pixel, PID_KI_FRACTION);
+    profile.tilt.kd_q16 = gain_q16(centidegrees_per_pixel, PID_KD_FRACTION);
+    profile.tilt.output_limit = (int32_t)(centidegrees_per_pixel * frame_height / 2);
+    return profile;
+}
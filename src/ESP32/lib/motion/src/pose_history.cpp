@@ -0,0 +1,81 @@
+#include "pose_history.h"
+
+#include <math.h>
+
+void PoseHistory::record(const TurretPose& pose)
+{
+    portENTER_CRITICAL(&this->_lock);
+    this->_poses[this->_next] = pose;
+    this->_next = (this->_next + 1) % POSE_HISTORY_SIZE;
+    if (this->_count < POSE_HISTORY_SIZE)
+    {
+        this->_count++;
+    }
+    portEXIT_CRITICAL(&this->_lock);
+}
+
+void PoseHistory::clear()
+{
+    portENTER_CRITICAL(&this->_lock);
+    this->_next = 0;
+    this->_count = 0;
+    portEXIT_CRITICAL(&this->_lock);
+}
+
+size_t PoseHistory::size()
+{
+    portENTER_CRITICAL(&this->_lock);
+    size_t count = this->_count;
+    portEXIT_CRITICAL(&this->_lock);
+    return count;
+}
+
+bool PoseHistory::at(int64_t timestamp_us, TurretPose& pose)
+{
+    portENTER_CRITICAL(&this->_lock);
+    if (this->_count == 0)
+    {
+        portEXIT_CRITICAL(&this->_lock);
+        return false;
+    }
+
+    // Walk back from the newest sample to the first one at or before the timestamp
+    size_t newer = (this->_next + POSE_HISTORY_SIZE - 1) % POSE_HISTORY_SIZE;
+    TurretPose after = this->_poses[newer];
+    if (timestamp_us >= after.timestamp_us)
+    {
+        portEXIT_CRITICAL(&this->_lock);
+        pose = after;
+        pose.timestamp_us = timestamp_us;
+        return true;
+    }
+
+    TurretPose before = after;
+    bool found = false;
+    for (size_t i = 1; i < this->_count; i++)
+    {
+        size_t index = (newer + POSE_HISTORY_SIZE - i) % POSE_HISTORY_SIZE;
+        before = this->_poses[index];
+        if (before.timestamp_us <= timestamp_us)
+        {
+            found = true;
+            break;
+        }
+        after = before;
+    }
+    portEXIT_CRITICAL(&this->_lock);
+
+    if (!found)
+    {
+        return false;
+    }
+
+    int64_t span_us = after.timestamp_us - before.timestamp_us;
+    float fraction = span_us > 0 ? (float)(timestamp_us - before.timestamp_us) / span_us : 0.0f;
+
+    pose.timestamp_us = timestamp_us;
+    pose.pan_steps = before.pan_steps + (int32_t)lroundf((after.pan_steps - before.pan_steps) * fraction);
+    pose.tilt_centidegrees =
+        before.tilt_centidegrees + (int32_t)lroundf((after.tilt_centidegrees - before.tilt_centidegrees) * fraction);
+    return true;
+}
@@ -0,0 +1,46 @@
+#include "queued_movement_manager.h"
+
+void QueuedMovementManager::move_relative(std::tuple<MoveDirectionX, MoveDirectionY> move_directions)
+{
+    MotionCommand command = {};
+    command.type = MotionCommand::Type::Nudge;
+    command.nudge_x = std::get<0>(move_directions);
+    command.nudge_y = std::get<1>(move_directions);
+
+    if (command.nudge_x != MoveDirectionX::None || command.nudge_y != MoveDirectionY::None)
+    {
+        this->_producer.post(command);
+    }
+}
+
+void QueuedMovementManager::move_by(int32_t pan_steps, int32_t tilt_centidegrees)
+{
+    if (pan_steps == 0 && tilt_centidegrees == 0)
+    {
+        return;
+    }
+
+    MotionCommand command = {};
+    command.type = MotionCommand::Type::MoveBy;
+    command.pan = pan_steps;
+    command.tilt = tilt_centidegrees;
+    this->_producer.post(command);
+}
+
+void QueuedMovementManager::move_absolute(int32_t pan_steps, int32_t tilt_centidegrees)
+{
+    MotionCommand command = {};
+    command.type = MotionCommand::Type::MoveTo;
+    command.pan = pan_steps;
+    command.tilt = tilt_centidegrees;
+    this->_producer.post(command);
+}
+
+void QueuedMovementManager::move_velocity(int32_t pan_steps_per_s, int32_t tilt_centidegrees_per_s)
+{
+    MotionCommand command = {};
+    command.type = MotionCommand::Type::Velocity;
+    command.pan = pan_steps_per_s;
+    command.tilt = tilt_centidegrees_per_s;
+    this->_producer.post(command);
+}
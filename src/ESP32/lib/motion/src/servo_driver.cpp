@@ -0,0 +1,224 @@
+#include "servo_driver.h"
+
+#include <Arduino.h>
+#include <freertos/task.h>
+
+ServoDriver::ServoDriver(uint8_t pin, uint16_t min_pulse_us, uint16_t max_pulse_us)
+    : _pin(pin), _min_pulse_us(min_pulse_us), _max_pulse_us(max_pulse_us), _refresh_hz(SERVO_MIN_REFRESH_HZ),
+      _slew_us_per_s(SERVO_DEFAULT_SLEW_US_PER_S), _last_update_us(0), _reattaching(false), _writing(0), _timer(nullptr)
+{
+    this->_target_us = (uint16_t)((min_pulse_us + max_pulse_us) / 2);
+    this->_output_us = this->_target_us;
+}
+
+ServoDriver::~ServoDriver()
+{
+    if (this->_timer)
+    {
+        esp_timer_stop(this->_timer);
+        esp_timer_delete(this->_timer);
+    }
+}
+
+bool ServoDriver::begin()
+{
+    _attach();
+    update_output();
+
+    if (this->_timer)
+    {
+        return true;
+    }
+
+    esp_timer_create_args_t args = {};
+    args.callback = &ServoDriver::_on_timer;
+    args.arg = this;
+    args.dispatch_method = ESP_TIMER_TASK;
+    args.name = "servo";
+
+    if (esp_timer_create(&args, &this->_timer) != ESP_OK)
+    {
+        Serial.println("[Servo] Failed to create slew timer");
+        this->_timer = nullptr;
+        return false;
+    }
+    esp_timer_start_periodic(this->_timer, 1000000UL / this->_refresh_hz);
+    return true;
+}
+
+void ServoDriver::set_refresh_rate(uint16_t hz)
+{
+    portENTER_CRITICAL(&this->_lock);
+    this->_refresh_hz = constrain(hz, SERVO_MIN_REFRESH_HZ, SERVO_MAX_REFRESH_HZ);
+    portEXIT_CRITICAL(&this->_lock);
+
+    if (this->_timer)
+    {
+        esp_timer_stop(this->_timer);
+    }
+    if (this->_servo.attached())
+    {
+        // A tick already under way, or another caller, keeps updating the state
+        // meanwhile; only the pin waits until the channel is back. Writes that got
+        // past the check before it closed finish first
+        portENTER_CRITICAL(&this->_lock);
+        this->_reattaching = true;
+        portEXIT_CRITICAL(&this->_lock);
+        for (;;)
+        {
+            portENTER_CRITICAL(&this->_lock);
+            bool idle = this->_writing == 0;
+            portEXIT_CRITICAL(&this->_lock);
+            if (idle)
+            {
+                break;
+            }
+            vTaskDelay(1);
+        }
+
+        this->_servo.detach();
+        _attach();
+
+        portENTER_CRITICAL(&this->_lock);
+        this->_reattaching = false;
+        portEXIT_CRITICAL(&this->_lock);
+        update_output();
+    }
+    if (this->_timer)
+    {
+        esp_timer_start_periodic(this->_timer, 1000000UL / this->_refresh_hz);
+    }
+}
+
+void ServoDriver::set_slew_rate(uint32_t us_per_second)
+{
+    portENTER_CRITICAL(&this->_lock);
+    this->_slew_us_per_s = us_per_second;
+    portEXIT_CRITICAL(&this->_lock);
+}
+
+bool ServoDriver::set_target_pulse(uint16_t pulse_us)
+{
+    pulse_us = constrain(pulse_us, this->_min_pulse_us, this->_max_pulse_us);
+
+    portENTER_CRITICAL(&this->_lock);
+    this->_target_us = pulse_us;
+    bool moved = _advance(esp_timer_get_time()); // Start now instead of on the next timer tick
+    portEXIT_CRITICAL(&this->_lock);
+    return moved;
+}
+
+void ServoDriver::update_output()
+{
+    uint16_t written = 0; // Never a valid pulse, so the first pass always writes
+    for (;;)
+    {
+        // set_refresh_rate() writes the latest output itself once the channel is back
+        portENTER_CRITICAL(&this->_lock);
+        uint16_t pulse = this->_output_us;
+        bool skip = this->_reattaching || pulse == written;
+        this->_writing += skip ? 0 : 1;
+        portEXIT_CRITICAL(&this->_lock);
+        if (skip)
+        {
+            return;
+        }
+
+        this->_servo.writeMicroseconds(pulse);
+        written = pulse;
+
+        portENTER_CRITICAL(&this->_lock);
+        this->_writing--;
+        portEXIT_CRITICAL(&this->_lock);
+    }
+}
+
+uint16_t ServoDriver::angle_to_pulse(float degrees) const
+{
+    float pulse = this->_min_pulse_us + (this->_max_pulse_us - this->_min_pulse_us) * degrees / SERVO_RANGE_DEG;
+    return (uint16_t)constrain((int32_t)lroundf(pulse), (int32_t)this->_min_pulse_us, (int32_t)this->_max_pulse_us);
+}
+
+float ServoDriver::pulse_to_angle(uint16_t pulse_us) const
+{
+    return (float)(pulse_us - this->_min_pulse_us) * SERVO_RANGE_DEG / (this->_max_pulse_us - this->_min_pulse_us);
+}
+
+uint16_t ServoDriver::get_pulse()
+{
+    portENTER_CRITICAL(&this->_lock);
+    uint16_t pulse = this->_output_us;
+    portEXIT_CRITICAL(&this->_lock);
+    return pulse;
+}
+
+uint16_t ServoDriver::get_target_pulse()
+{
+    portENTER_CRITICAL(&this->_lock);
+    uint16_t pulse = this->_target_us;
+    portEXIT_CRITICAL(&this->_lock);
+    return pulse;
+}
+
+void ServoDriver::_on_timer(void* arg)
+{
+    ServoDriver* driver = static_cast<ServoDriver*>(arg);
+
+    portENTER_CRITICAL(&driver->_lock);
+    bool moved = driver->_advance(esp_timer_get_time());
+    portEXIT_CRITICAL(&driver->_lock);
+
+    if (moved)
+    {
+        driver->update_output();
+    }
+}
+
+bool ServoDriver::_advance(int64_t now_us)
+{
+    const int64_t frame_us = 1000000L / this->_refresh_hz;
+    if (this->_output_us == this->_target_us)
+    {
+        // Idle: the next write may use one frame's budget at once, never more
+        this->_last_update_us = now_us - frame_us;
+        return false;
+    }
+
+    int32_t remaining = (int32_t)this->_target_us - (int32_t)this->_output_us;
+    int32_t step = remaining;
+    int64_t carry_us = 0;
+    if (this->_slew_us_per_s != 0)
+    {
+        // Cap at one frame, plus the time one microsecond of travel takes, so a slew
+        // slower than a microsecond per frame still accumulates instead of stalling
+        int64_t cap_us = frame_us + (1000000L + this->_slew_us_per_s - 1) / (int64_t)this->_slew_us_per_s;
+        int64_t elapsed_us = now_us - this->_last_update_us;
+        if (elapsed_us > cap_us)
+        {
+            elapsed_us = cap_us;
+        }
+
+        int32_t budget = (int32_t)(this->_slew_us_per_s * elapsed_us / 1000000L);
+        if (budget == 0)
+        {
+            return false; // Let the budget accumulate until the next tick
+        }
+        step = constrain(remaining, -budget, budget);
+
+        // Keep the time the whole microseconds did not use, so slow rates come out exact
+        if (step != remaining)
+        {
+            carry_us = elapsed_us - (int64_t)budget * 1000000L / this->_slew_us_per_s;
+        }
+    }
+
+    this->_output_us = (uint16_t)(this->_output_us + step);
+    this->_last_update_us = now_us - carry_us;
+    return true;
+}
+
+void ServoDriver::_attach()
+{
+    this->_servo.setPeriodHertz(this->_refresh_hz);
+    this->_servo.attach(this->_pin, this->_min_pulse_us, this->_max_pulse_us);
+}
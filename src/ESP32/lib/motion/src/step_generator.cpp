@@ -0,0 +1,162 @@
+#include "step_generator.h"
+
+#include <math.h>
+
+StepGenerator::StepGenerator()
+    : _acceleration(1.0f), _c0(0.0f), _cmin(1.0f), _cn(0.0f), _speed(0.0f), _n(0), _direction(1), _position(0),
+      _target(0)
+{
+    set_max_speed(1.0f);
+    set_acceleration(1.0f);
+}
+
+void StepGenerator::set_max_speed(float steps_per_second)
+{
+    if (steps_per_second <= 0.0f)
+    {
+        return;
+    }
+
+    this->_cmin = 1000000.0f / steps_per_second;
+
+    // Already faster than the new limit: fold n back so the ramp decelerates to it
+    if (this->_n > 0)
+    {
+        this->_n = (int32_t)((this->_speed * this->_speed) / (2.0f * this->_acceleration));
+    }
+}
+
+void StepGenerator::set_acceleration(float steps_per_second2)
+{
+    if (steps_per_second2 <= 0.0f)
+    {
+        return;
+    }
+
+    // Keep the ramp position consistent with the new slope
+    if (this->_n != 0)
+    {
+        this->_n = (int32_t)(this->_n * (this->_acceleration / steps_per_second2));
+    }
+
+    // 0.676 corrects the error of the Taylor approximation on the first step
+    this->_c0 = 0.676f * sqrtf(2.0f / steps_per_second2) * 1000000.0f;
+    this->_acceleration = steps_per_second2;
+}
+
+uint32_t StepGenerator::start()
+{
+    if (is_moving())
+    {
+        return (uint32_t)(this->_cn + 0.5f);
+    }
+
+    this->_n = 0;
+    return _compute_next_interval();
+}
+
+uint32_t StepGenerator::tick(int8_t& step_direction)
+{
+    step_direction = 0;
+
+    if (!is_moving())
+    {
+        return 0;
+    }
+
+    this->_position += this->_direction;
+    step_direction = this->_direction;
+
+    return _compute_next_interval();
+}
+
+void StepGenerator::stop()
+{
+    if (!is_moving())
+    {
+        this->_target = this->_position;
+        return;
+    }
+
+    int32_t steps_to_stop = (int32_t)((this->_speed * this->_speed) / (2.0f * this->_acceleration)) + 1;
+    this->_target = this->_position + ((this->_speed > 0) ? steps_to_stop : -steps_to_stop);
+}
+
+void StepGenerator::set_position(int32_t position)
+{
+    if (is_moving())
+    {
+        return;
+    }
+
+    this->_position = position;
+    this->_target = position;
+    this->_n = 0;
+}
+
+uint32_t StepGenerator::_compute_next_interval()
+{
+    int32_t distance = this->_target - this->_position;
+    int32_t steps_to_stop = (int32_t)((this->_speed * this->_speed) / (2.0f * this->_acceleration));
+
+    if (distance == 0 && steps_to_stop <= 1)
+    {
+        // Arrived: we are at the target and slow enough to stop dead
+        this->_speed = 0.0f;
+        this->_n = 0;
+        return 0;
+    }
+
+    if (distance > 0)
+    {
+        if (this->_n > 0)
+        {
+            // Accelerating or cruising: start braking when the target is within
+            // braking distance, or when it moved behind us
+            if (steps_to_stop >= distance || this->_direction < 0)
+            {
+                this->_n = -steps_to_stop;
+            }
+        } else if (this->_n < 0)
+        {
+            // Braking: resume accelerating if the target moved further away
+            if (steps_to_stop < distance && this->_direction > 0)
+            {
+                this->_n = -this->_n;
+            }
+        }
+    } else if (distance < 0)
+    {
+        if (this->_n > 0)
+        {
+            if (steps_to_stop >= -distance || this->_direction > 0)
+            {
+                this->_n = -steps_to_stop;
+            }
+        } else if (this->_n < 0)
+        {
+            if (steps_to_stop < -distance && this->_direction < 0)
+            {
+                this->_n = -this->_n;
+            }
+        }
+    }
+
+    if (this->_n == 0)
+    {
+        // First step from rest (or after braking to a halt): pick the direction
+        this->_cn = this->_c0;
+        this->_direction = (distance > 0) ? 1 : -1;
+    } else
+    {
+        this->_cn = this->_cn - ((2.0f * this->_cn) / ((4.0f * this->_n) + 1.0f));
+        if (this->_cn < this->_cmin)
+        {
+            this->_cn = this->_cmin;
+        }
+    }
+    this->_n++;
+
+    this->_speed = (1000000.0f / this->_cn) * this->_direction;
+    return (uint32_t)(this->_cn + 0.5f);
+}
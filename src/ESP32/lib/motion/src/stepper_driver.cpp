@@ -0,0 +1,207 @@
+#include "stepper_driver.h"
+
+#include <Arduino.h>
+
+/** Coil states, bit i drives _pins[i]. Same order as Arduino Stepper's 4-wire sequence. */
+static const uint8_t FULL_STEP_SEQUENCE[4] = {0b0101, 0b0110, 0b1010, 0b1001};
+
+/** Full-step states interleaved with the single coil they share. */
+static const uint8_t HALF_STEP_SEQUENCE[8] = {0b0101, 0b0100, 0b0110, 0b0010, 0b1010, 0b1000, 0b1001, 0b0001};
+
+StepperDriver::StepperDriver(uint8_t pin1, uint8_t pin2, uint8_t pin3, uint8_t pin4, StepMode mode)
+    : _pins{pin1, pin2, pin3, pin4}, _mode(mode), _phase(0), _hold_when_idle(false), _running(false),
+      _timer(nullptr), _listener(nullptr), _listener_arg(nullptr)
+{
+    set_max_speed(STEPPER_DEFAULT_MAX_SPEED);
+    set_acceleration(STEPPER_DEFAULT_ACCELERATION);
+}
+
+StepperDriver::~StepperDriver()
+{
+    if (this->_timer)
+    {
+        esp_timer_stop(this->_timer);
+        esp_timer_delete(this->_timer);
+    }
+}
+
+bool StepperDriver::begin()
+{
+    for (uint8_t i = 0; i < 4; i++)
+    {
+        pinMode(this->_pins[i], OUTPUT);
+        digitalWrite(this->_pins[i], LOW);
+    }
+
+    if (this->_timer)
+    {
+        return true;
+    }
+
+    esp_timer_create_args_t args = {};
+    args.callback = &StepperDriver::_on_timer;
+    args.arg = this;
+    args.dispatch_method = ESP_TIMER_TASK;
+    args.name = "stepper";
+
+    if (esp_timer_create(&args, &this->_timer) != ESP_OK)
+    {
+        Serial.println("[Stepper] Failed to create step timer");
+        this->_timer = nullptr;
+        return false;
+    }
+    return true;
+}
+
+void StepperDriver::set_max_speed(float steps_per_second)
+{
+    portENTER_CRITICAL(&this->_lock);
+    this->_generator.set_max_speed(steps_per_second * _microsteps());
+    portEXIT_CRITICAL(&this->_lock);
+}
+
+void StepperDriver::set_acceleration(float steps_per_second2)
+{
+    portENTER_CRITICAL(&this->_lock);
+    this->_generator.set_acceleration(steps_per_second2 * _microsteps());
+    portEXIT_CRITICAL(&this->_lock);
+}
+
+void StepperDriver::set_step_listener(StepListener listener, void* arg)
+{
+    portENTER_CRITICAL(&this->_lock);
+    this->_listener = listener;
+    this->_listener_arg = arg;
+    portEXIT_CRITICAL(&this->_lock);
+}
+
+void StepperDriver::move_to(int32_t position)
+{
+    uint32_t first_interval = 0;
+
+    portENTER_CRITICAL(&this->_lock);
+    this->_generator.set_target(position * _microsteps());
+    if (!this->_running)
+    {
+        first_interval = this->_generator.start();
+        this->_running = (first_interval != 0);
+    }
+    portEXIT_CRITICAL(&this->_lock);
+
+    // Arm outside the critical section; a running move picks the target up on its next step
+    if (first_interval != 0 && this->_timer)
+    {
+        _write_phase(); // Pull the rotor onto the current phase before the first step
+        esp_timer_start_once(this->_timer, first_interval);
+    }
+}
+
+void StepperDriver::move_relative(int32_t steps)
+{
+    if (steps != 0)
+    {
+        move_to(get_target() + steps);
+    }
+}
+
+void StepperDriver::stop()
+{
+    portENTER_CRITICAL(&this->_lock);
+    this->_generator.stop();
+    portEXIT_CRITICAL(&this->_lock);
+}
+
+void StepperDriver::set_position(int32_t position)
+{
+    portENTER_CRITICAL(&this->_lock);
+    this->_generator.set_position(position * _microsteps());
+    portEXIT_CRITICAL(&this->_lock);
+}
+
+int32_t StepperDriver::get_position()
+{
+    portENTER_CRITICAL(&this->_lock);
+    int32_t position = this->_generator.get_position();
+    portEXIT_CRITICAL(&this->_lock);
+    return _to_steps(position);
+}
+
+float StepperDriver::get_exact_position()
+{
+    portENTER_CRITICAL(&this->_lock);
+    int32_t position = this->_generator.get_position();
+    portEXIT_CRITICAL(&this->_lock);
+    return (float)position / _microsteps();
+}
+
+int32_t StepperDriver::get_target()
+{
+    portENTER_CRITICAL(&this->_lock);
+    int32_t target = this->_generator.get_target();
+    portEXIT_CRITICAL(&this->_lock);
+    return _to_steps(target);
+}
+
+void StepperDriver::_on_timer(void* arg)
+{
+    static_cast<StepperDriver*>(arg)->_on_step();
+}
+
+void StepperDriver::_on_step()
+{
+    int8_t direction = 0;
+
+    portENTER_CRITICAL(&this->_lock);
+    uint32_t next_interval = this->_generator.tick(direction);
+    int32_t position = this->_generator.get_position();
+    if (direction == 0)
+    {
+        // End of the settle time: start whatever target arrived meanwhile
+        next_interval = this->_generator.start();
+    } else if (next_interval == 0)
+    {
+        // Last step: keep the final phase energised long enough for the rotor to land
+        next_interval = STEPPER_SETTLE_US;
+    }
+    this->_running = (next_interval != 0);
+    portEXIT_CRITICAL(&this->_lock);
+
+    if (direction != 0)
+    {
+        uint8_t length = (this->_mode == StepMode::HalfStep) ? 8 : 4;
+        this->_phase = (uint8_t)((this->_phase + length + direction) % length);
+        _write_phase();
+
+        if (this->_listener && position % _microsteps() == 0)
+        {
+            this->_listener(this->_listener_arg, position / _microsteps());
+        }
+    }
+
+    if (next_interval != 0)
+    {
+        esp_timer_start_once(this->_timer, next_interval);
+    } else if (!this->_hold_when_idle)
+    {
+        _release_coils();
+    }
+}
+
+void StepperDriver::_write_phase()
+{
+    uint8_t state =
+        (this->_mode == StepMode::HalfStep) ? HALF_STEP_SEQUENCE[this->_phase] : FULL_STEP_SEQUENCE[this->_phase];
+
+    for (uint8_t i = 0; i < 4; i++)
+    {
+        digitalWrite(this->_pins[i], (state >> i) & 1 ? HIGH : LOW);
+    }
+}
+
+void StepperDriver::_release_coils()
+{
+    for (uint8_t i = 0; i < 4; i++)
+    {
+        digitalWrite(this->_pins[i], LOW);
+    }
+}
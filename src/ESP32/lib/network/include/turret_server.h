@@ -5,9 +5,21 @@
 
 #pragma once
 
-#include "camera.h"
+#include "base_movement_manager.h"
+#include "frame_broker.h"
+#include <atomic>
 #include <esp_http_server.h>
 
+/** Broker slots left for stream clients once the detector holds one. */
+#define HTTP_MAX_STREAM_CLIENTS (FRAME_BROKER_MAX_SUBSCRIBERS - 1)
+#define HTTP_MAX_OPEN_SOCKETS 7          /**< All lwIP leaves the server: 10 sockets minus 3 internal ones. */
+#define HTTP_STREAM_TASK_STACK_SIZE 4096 /**< Bytes; the part header is the only buffer on the stack. */
+#define HTTP_STREAM_TASK_PRIORITY 3      /**< Below the frame broker, so a client never starves capture. */
+#define HTTP_STREAM_TASK_CORE 0          /**< With WiFi and the broker; core 1 runs motion and detection. */
+#define HTTP_STREAM_POLL_MS 10           /**< Sleep while stop() waits for the stream tasks to end. */
+
+static_assert(HTTP_MAX_OPEN_SOCKETS > HTTP_MAX_STREAM_CLIENTS, "Streams must leave a socket for /move");
+
 /**
  * @class HttpServer
  * @brief Manages the ESP32-CAM web interface and control API.
@@ -20,20 +32,61 @@ private:
     httpd_handle_t _server_handle = NULL; ///< Internal handle for the ESP-IDF server instance.
 
     /**
-     * @brief Static reference to the camera for use in C-style callbacks.
+     * @brief Static reference to the frame broker for use in C-style callbacks.
+     */
+    static FrameBroker* _broker_instance;
+
+    /**
+     * @brief Static reference to the turret motors for the command callback; may be null.
+     */
+    static BaseMovementManager* _movement_instance;
+
+    /**
+     * @brief One /stream client, handed from the server task to its own stream task.
+     * @details The server and the stream task share the socket; whichever lets go of
+     * it last closes it, so the descriptor cannot be reused while still being written.
+     */
+    struct StreamClient {
+        int fd;                          ///< Client socket.
+        httpd_handle_t server;           ///< Server the session belongs to.
+        FrameSubscription* subscription; ///< Released by the stream task; null while the slot is free.
+        bool hung_up;                    ///< The server dropped the session; the task closes the socket.
+        bool ended;                      ///< The task is gone; the server's close callback closes the socket.
+    };
+
+    static StreamClient _clients[HTTP_MAX_STREAM_CLIENTS]; ///< Guarded by _clients_lock.
+    static portMUX_TYPE _clients_lock;                     ///< Guards the flags in _clients.
+    static std::atomic<bool> _streaming;                   ///< Cleared by stop(); stream tasks check it per frame.
+    static std::atomic<uint8_t> _stream_count;             ///< Stream tasks still running.
+
+    /**
+     * @brief Session close callback: keeps a streaming socket open until its task lets go.
+     * @param server Server the session belongs to.
+     * @param fd Socket of the closed session.
+     */
+    static void _close_session(httpd_handle_t server, int fd);
+
+    /**
+     * @brief Body of one stream client's task.
+     * @details Pushes every frame the broker publishes to the client's socket until the
+     * client goes away or stop() is called, then closes the session and deletes itself.
+     * @param arg The client's StreamClient, owned by the task.
      */
-    static Camera* _camera_instance;
+    static void _stream_task(void* arg);
 
 public:
     /**
      * @brief Configures and launches the web server on port 80.
-     * @param camera Pointer to the initialized Camera object for streaming.
+     * @param broker Started FrameBroker; each stream client subscribes to it.
+     * @param movement_manager Motors driven by /move; without one, commands are only logged.
      * @return true if the server was created and handlers were registered.
      */
-    bool start(Camera* camera);
+    bool start(FrameBroker* broker, BaseMovementManager* movement_manager = nullptr);
 
     /**
      * @brief Shut down the server and unregister all URI handlers.
+     * @details Ends the stream tasks first and waits for them, as they send on the
+     * server's sockets.
      */
     void stop();
 
@@ -51,16 +104,38 @@ public:
 
     /**
      * @brief HTTP GET Handler for the MJPEG stream.
-     * @details Continuously captures frames from the camera and pushes them
-     * to the client using "multipart/x-mixed-replace".
+     * @details Subscribes to the FrameBroker and hands the socket to a stream task
+     * of its own, which pushes each published frame using "multipart/x-mixed-replace".
+     * The server task returns at once and keeps serving other clients and routes. Clients share
+     * one capture per frame; a slow one skips frames instead of slowing the others.
      * @param req Pointer to the HTTP request structure.
-     * @return esp_err_t ESP_OK on success.
+     * @return esp_err_t ESP_OK once the stream task owns the client.
      */
     static esp_err_t stream_handler(httpd_req_t* req);
 
+    /**
+     * @brief HTTP GET Handler for the per-stage latency histograms.
+     * @details Returns latency_report() as plain text: count, min, p50, p99 and max
+     * in microseconds for every probed stage since boot.
+     * @param req Pointer to the HTTP request structure.
+     * @return esp_err_t ESP_OK on success.
+     */
+    static esp_err_t latency_handler(httpd_req_t* req);
+
+    /**
+     * @brief HTTP GET Handler for the binary event trace.
+     * @details Streams trace_dump() as application/octet-stream; convert the saved
+     * file with src/tools/trace_to_chrome.py. Recording continues during the dump.
+     * @param req Pointer to the HTTP request structure.
+     * @return esp_err_t ESP_OK on success.
+     */
+    static esp_err_t trace_handler(httpd_req_t* req);
+
     /**
      * @brief HTTP GET Handler for control commands.
-     * @details Parses URL parameters (e.g., ?pan=90&tilt=45) to drive motors.
+     * @details Parses URL parameters (e.g., ?pan=90&tilt=45) and moves the turret to
+     * that absolute orientation in one command. Pan is in degrees from the power-on
+     * heading, tilt is the servo angle. An omitted axis keeps its current position.
      * @param req Pointer to the HTTP request structure.
      * @return esp_err_t ESP_OK on success.
      */
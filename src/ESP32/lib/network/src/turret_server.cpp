@@ -1,22 +1,55 @@
 #include "turret_server.h"
 #include <Arduino.h>
 #include <esp_log.h>
+#include <lwip/sockets.h>
 
+#include "constants.h"
 #include "esp_camera.h"
+#include "latency_probe.h"
+#include "trace.h"
 #include <index_html.h>
 
 #define _STREAM_CONTENT_TYPE "multipart/x-mixed-replace;boundary=123456789000000000000987654321"
 
+static const char* _STREAM_HEADER = "HTTP/1.1 200 OK\r\n"
+                                   "Content-Type: " _STREAM_CONTENT_TYPE "\r\n"
+                                   "Cache-Control: no-cache\r\n\r\n";
 static const char* _STREAM_BOUNDARY = "\r\n--123456789000000000000987654321\r\n";
 static const char* _STREAM_PART = "Content-Type: image/jpeg\r\nContent-Length: %u\r\n\r\n";
+static const uint32_t _STREAM_FRAME_TIMEOUT_MS = 1000; // Longest wait before re-checking stop() and the client
 
-Camera* HttpServer::_camera_instance = nullptr; // Init static pointer
+FrameBroker* HttpServer::_broker_instance = nullptr;           // Init static pointer
+BaseMovementManager* HttpServer::_movement_instance = nullptr; // Init static pointer
+HttpServer::StreamClient HttpServer::_clients[HTTP_MAX_STREAM_CLIENTS] = {};
+portMUX_TYPE HttpServer::_clients_lock = portMUX_INITIALIZER_UNLOCKED;
+std::atomic<bool> HttpServer::_streaming(false);
+std::atomic<uint8_t> HttpServer::_stream_count(0);
 
-bool HttpServer::start(Camera* camera)
+/** @brief Send the whole buffer on a socket the caller owns; false once the client is gone. */
+static bool send_all(int fd, const char* data, size_t size)
 {
-    this->_camera_instance = camera;
+    while (size > 0)
+    {
+        int sent = send(fd, data, size, 0);
+        if (sent <= 0)
+        {
+            return false;
+        }
+        data += sent;
+        size -= sent;
+    }
+    return true;
+}
+
+bool HttpServer::start(FrameBroker* broker, BaseMovementManager* movement_manager)
+{
+    this->_broker_instance = broker;
+    this->_movement_instance = movement_manager;
     httpd_config_t config = HTTPD_DEFAULT_CONFIG();
+    config.max_open_sockets = HTTP_MAX_OPEN_SOCKETS; // Every stream holds one for as long as it runs
+    config.close_fn = &HttpServer::_close_session;
 
+    this->_streaming.store(true);
     if (httpd_start(&this->_server_handle, &config) == ESP_OK)
     {
         // Define Root Route
@@ -31,6 +64,15 @@ bool HttpServer::start(Camera* camera)
         httpd_uri_t cmd_uri = {.uri = "/move", .method = HTTP_GET, .handler = cmd_handler, .user_ctx = NULL};
         httpd_register_uri_handler(this->_server_handle, &cmd_uri);
 
+        // Define the Latency Report Route
+        httpd_uri_t latency_uri = {
+            .uri = "/latency", .method = HTTP_GET, .handler = latency_handler, .user_ctx = NULL};
+        httpd_register_uri_handler(this->_server_handle, &latency_uri);
+
+        // Define the Event Trace Route
+        httpd_uri_t trace_uri = {.uri = "/trace", .method = HTTP_GET, .handler = trace_handler, .user_ctx = NULL};
+        httpd_register_uri_handler(this->_server_handle, &trace_uri);
+
         return true;
     }
     return false;
@@ -38,6 +80,13 @@ bool HttpServer::start(Camera* camera)
 
 void HttpServer::stop()
 {
+    // The stream tasks send on the server's sockets, so they go first
+    this->_streaming.store(false);
+    while (this->_stream_count.load() > 0)
+    {
+        vTaskDelay(pdMS_TO_TICKS(HTTP_STREAM_POLL_MS));
+    }
+
     if (this->_server_handle)
     {
         httpd_stop(this->_server_handle);
@@ -49,87 +98,182 @@ esp_err_t HttpServer::index_handler(httpd_req_t* req) { return httpd_resp_send(r
 
 esp_err_t HttpServer::stream_handler(httpd_req_t* req)
 {
-    camera_fb_t* fb = NULL;
-    esp_err_t res = ESP_OK;
-    size_t _jpg_buf_len = 0;
-    uint8_t* _jpg_buf = NULL;
-    char* part_buf[64];
-
-    // 1. Safety Check: Ensure camera and request are valid
+    // 1. Safety Check: Ensure broker and request are valid
     if (req == NULL)
     {
         return ESP_ERR_INVALID_ARG;
     }
 
-    if (HttpServer::_camera_instance == nullptr)
+    if (HttpServer::_broker_instance == nullptr)
     {
-        Serial.println("Stream Error: Camera instance is null");
+        Serial.println("Stream Error: Frame broker instance is null");
         return httpd_resp_send_500(req); // 500: internal server error
     }
 
-    // 2. Set the HTTP Response Header to Multipart
-    res = httpd_resp_set_type(req, _STREAM_CONTENT_TYPE);
-    if (res != ESP_OK)
+    // 2. Share the broker's captures instead of grabbing our own
+    FrameSubscription* subscription = HttpServer::_broker_instance->subscribe("stream");
+    if (subscription == nullptr)
     {
-        return res;
+        Serial.println("Stream Error: Too many stream clients");
+        return httpd_resp_send_500(req);
     }
 
-    Serial.println("Client connected to stream");
-
-    // 3. Start the Infinite Streaming Loop
-    while (true)
+    // 3. Claim a client slot for the socket
+    StreamClient* client = nullptr;
+    portENTER_CRITICAL(&HttpServer::_clients_lock);
+    for (StreamClient& slot : HttpServer::_clients)
     {
-        // Grab frame
-        fb = HttpServer::_camera_instance->capture();
-
-        if (!fb)
+        if (slot.subscription == nullptr)
         {
-            Serial.println("Camera capture failed");
-            res = ESP_FAIL;
-        } else
-        {
-            _jpg_buf_len = fb->len;
-            _jpg_buf = fb->buf;
+            slot = {httpd_req_to_sockfd(req), req->handle, subscription, false, false};
+            client = &slot;
+            break;
         }
+    }
+    portEXIT_CRITICAL(&HttpServer::_clients_lock);
 
-        if (res == ESP_OK)
+    // 4. Hand the client to its own task, so this one goes back to serving requests
+    if (client != nullptr)
+    {
+        HttpServer::_stream_count.fetch_add(1);
+        if (xTaskCreatePinnedToCore(&HttpServer::_stream_task, "stream", HTTP_STREAM_TASK_STACK_SIZE, client,
+                                    HTTP_STREAM_TASK_PRIORITY, nullptr, HTTP_STREAM_TASK_CORE) == pdPASS)
         {
-            // Send the boundary separator
-            res = httpd_resp_send_chunk(req, _STREAM_BOUNDARY, strlen(_STREAM_BOUNDARY));
+            Serial.println("Client connected to stream");
+            return ESP_OK;
+        }
+        HttpServer::_stream_count.fetch_sub(1);
 
-            // Send the part header (Content-Type and Content-Length)
-            if (res == ESP_OK)
-            {
-                size_t hlen = snprintf((char*)part_buf, 64, _STREAM_PART, _jpg_buf_len);
-                res = httpd_resp_send_chunk(req, (const char*)part_buf, hlen);
-            }
+        portENTER_CRITICAL(&HttpServer::_clients_lock);
+        *client = {};
+        portEXIT_CRITICAL(&HttpServer::_clients_lock);
+    }
 
-            // Send the actual JPEG binary data
-            if (res == ESP_OK)
-            {
-                res = httpd_resp_send_chunk(req, (const char*)_jpg_buf, _jpg_buf_len);
-            }
+    Serial.println("Stream Error: Failed to start the stream task");
+    HttpServer::_broker_instance->unsubscribe(subscription);
+    return httpd_resp_send_500(req);
+}
+
+void HttpServer::_stream_task(void* arg)
+{
+    StreamClient* client = (StreamClient*)arg;
+    FrameSubscription* subscription = client->subscription;
+    FrameRef fb;
+    char part_buf[64];
+
+    // 1. The response header; the parts follow until one side hangs up
+    bool sending = send_all(client->fd, _STREAM_HEADER, strlen(_STREAM_HEADER));
+
+    // 2. Stream every frame the broker publishes; a slow client skips to the newest
+    while (sending && HttpServer::_streaming.load())
+    {
+        portENTER_CRITICAL(&HttpServer::_clients_lock);
+        bool hung_up = client->hung_up;
+        portEXIT_CRITICAL(&HttpServer::_clients_lock);
+        if (hung_up)
+        {
+            break;
         }
 
-        // 4. Release the frame buffer back to the camera driver
-        if (fb)
+        // A stalled camera is not the client's fault; keep the connection and wait again
+        if (!subscription->wait(fb, pdMS_TO_TICKS(_STREAM_FRAME_TIMEOUT_MS)))
         {
-            HttpServer::_camera_instance->release(fb);
-            fb = NULL;
-            _jpg_buf = NULL;
+            continue;
         }
 
-        // 5. Check if the client closed the tab/browser
-        if (res != ESP_OK)
         {
-            Serial.println("Stream stopped: Client disconnected");
+            TRACE_SCOPE(StreamFrame, fb->len);
+
+            // Boundary separator, part header (Content-Type and Content-Length), then the JPEG itself
+            size_t hlen = snprintf(part_buf, sizeof(part_buf), _STREAM_PART, fb->len);
+            sending = send_all(client->fd, _STREAM_BOUNDARY, strlen(_STREAM_BOUNDARY)) &&
+                      send_all(client->fd, part_buf, hlen) && send_all(client->fd, (const char*)fb->buf, fb->len);
+        }
+
+        // 3. Drop our reference; the buffer goes back once every subscriber is done with it
+        fb.reset();
+    }
+
+    Serial.printf("Stream stopped: %u frames skipped\n", (unsigned)subscription->dropped());
+    HttpServer::_broker_instance->unsubscribe(subscription);
+
+    // 4. Whichever of the server and this task lets go of the socket last closes it
+    portENTER_CRITICAL(&HttpServer::_clients_lock);
+    int fd = client->fd;
+    httpd_handle_t server = client->server;
+    bool hung_up = client->hung_up;
+    if (hung_up)
+    {
+        *client = {};
+    } else
+    {
+        client->ended = true;
+    }
+    portEXIT_CRITICAL(&HttpServer::_clients_lock);
+
+    if (hung_up)
+    {
+        close(fd);
+    } else
+    {
+        httpd_sess_trigger_close(server, fd);
+    }
+
+    HttpServer::_stream_count.fetch_sub(1);
+    vTaskDelete(NULL);
+}
+
+void HttpServer::_close_session(httpd_handle_t server, int fd)
+{
+    (void)server;
+    bool streaming = false;
+
+    portENTER_CRITICAL(&HttpServer::_clients_lock);
+    for (StreamClient& client : HttpServer::_clients)
+    {
+        if (client.subscription != nullptr && client.fd == fd)
+        {
+            if (client.ended)
+            {
+                client = {};
+            } else
+            {
+                client.hung_up = true; // The task still writes to it and closes it on the way out
+                streaming = true;
+            }
             break;
         }
+    }
+    portEXIT_CRITICAL(&HttpServer::_clients_lock);
 
-        vTaskDelay(1);
+    if (!streaming)
+    {
+        close(fd);
     }
+}
+
+esp_err_t HttpServer::latency_handler(httpd_req_t* req)
+{
+    char report[LATENCY_REPORT_SIZE];
+    size_t length = latency_report(report, sizeof(report));
+
+    httpd_resp_set_type(req, "text/plain");
+    return httpd_resp_send(req, report, length);
+}
 
-    return res;
+/** @brief TraceWriter that sends each piece of the dump as one HTTP chunk. */
+static bool send_trace_chunk(const void* data, size_t size, void* arg)
+{
+    return httpd_resp_send_chunk((httpd_req_t*)arg, (const char*)data, size) == ESP_OK;
+}
+
+esp_err_t HttpServer::trace_handler(httpd_req_t* req)
+{
+    httpd_resp_set_type(req, "application/octet-stream");
+    httpd_resp_set_hdr(req, "Content-Disposition", "attachment; filename=\"turret.trace\"");
+
+    trace_dump(&send_trace_chunk, req);
+    return httpd_resp_send_chunk(req, NULL, 0); // End of the chunked response
 }
 
 esp_err_t HttpServer::cmd_handler(httpd_req_t* req)
@@ -143,26 +287,54 @@ esp_err_t HttpServer::cmd_handler(httpd_req_t* req)
 
     size_t buf_len = httpd_req_get_url_query_len(req) + 1;
 
+    // A truncated query could still move the motors, so refuse it whole
+    if (buf_len > sizeof(buf))
+    {
+        Serial.println("Command Error: Query string too long");
+        return httpd_resp_send_err(req, HTTPD_414_URI_TOO_LONG, "Query string too long");
+    }
+
     if (buf_len > 1)
     {
         if (httpd_req_get_url_query_str(req, buf, buf_len) == ESP_OK)
         {
             char param[32];
+            bool has_pan = false;
+            bool has_tilt = false;
+            int pan_val = 0;
+            int tilt_val = 0;
 
             // Extract "pan" value
             if (httpd_query_key_value(buf, "pan", param, sizeof(param)) == ESP_OK)
             {
-                int pan_val = atoi(param);
+                pan_val = atoi(param);
+                has_pan = true;
                 Serial.printf("Command Received: Pan to %d\n", pan_val);
-                // TODO: Call Servo/Motor function here: turret.movePan(pan_val);
             }
 
             // Extract "tilt" value
             if (httpd_query_key_value(buf, "tilt", param, sizeof(param)) == ESP_OK)
             {
-                int tilt_val = atoi(param);
+                tilt_val = atoi(param);
+                has_tilt = true;
                 Serial.printf("Command Received: Tilt to %d\n", tilt_val);
-                // TODO: Call Servo/Motor function here: turret.moveTilt(tilt_val);
+            }
+
+            // One absolute move for both axes; an omitted axis stays where it is. The page
+            // works in whole degrees, the movement manager in centidegrees
+            BaseMovementManager* motors = HttpServer::_movement_instance;
+            int32_t tilt_centidegrees = (int32_t)tilt_val * CENTIDEGREES_PER_DEGREE;
+            if (has_pan && motors != nullptr)
+            {
+                tilt_centidegrees = has_tilt ? tilt_centidegrees : motors->get_tilt_centidegrees();
+                motors->move_absolute((int32_t)pan_val * STEPPER_NUMBER_OF_STEPS / 360, tilt_centidegrees);
+            } else if (has_tilt && motors != nullptr)
+            {
+                // Leave a running pan move alone
+                motors->move_by(0, tilt_centidegrees - motors->get_tilt_centidegrees());
+            } else if (has_pan || has_tilt)
+            {
+                Serial.println("Command Error: No movement manager attached");
             }
         }
     }
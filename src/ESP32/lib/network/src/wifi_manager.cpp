@@ -1,6 +1,7 @@
 #include "wifi_manager.h"
 
 #include "secrets.h"
+#include "trace.h"
 
 void WifiManager::connect(const String& ssid, const String& password)
 {
@@ -31,6 +32,7 @@ void WifiManager::maintain()
     {
         last_check = now;
         bool current_state = is_connected();
+        TRACE_INSTANT(WifiCheck, current_state, 0);
 
         if (current_state && !last_state)
         {
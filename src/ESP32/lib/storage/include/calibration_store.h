@@ -0,0 +1,37 @@
+/**
+ * @file calibration_store.h
+ * @brief Keeps the camera calibration in NVS across reboots.
+ */
+
+#pragma once
+
+#include "camera_calibration.h"
+
+/**
+ * @class CalibrationStore
+ * @brief Static utility that reads and writes a CameraCalibration with Preferences.
+ * @details Each field is its own key in the "turret" namespace, so a firmware that
+ * adds fields can still read an older record.
+ */
+class CalibrationStore
+{
+public:
+    /**
+     * @brief Reads the stored calibration.
+     * @param calibration Receives the stored values; left unchanged if none are valid.
+     * @return true if a valid calibration was stored.
+     */
+    static bool load(CameraCalibration& calibration);
+
+    /**
+     * @brief Writes a calibration, replacing the stored one.
+     * @param calibration Values to store; invalid ones are refused.
+     * @return true if every key was written.
+     */
+    static bool save(const CameraCalibration& calibration);
+
+    /**
+     * @brief Erases the stored calibration, so the nominal lens profiles apply again.
+     */
+    static void clear();
+};
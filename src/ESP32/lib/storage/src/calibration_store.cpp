@@ -0,0 +1,64 @@
+#include "calibration_store.h"
+
+#include <Preferences.h>
+
+static const char* CALIBRATION_NAMESPACE = "turret";
+static const char* KEY_WIDTH = "cal_w";
+static const char* KEY_HEIGHT = "cal_h";
+static const char* KEY_PAN = "cal_pan";
+static const char* KEY_TILT = "cal_tilt";
+
+bool CalibrationStore::load(CameraCalibration& calibration)
+{
+    Preferences preferences;
+    if (!preferences.begin(CALIBRATION_NAMESPACE, true))
+    {
+        return false;
+    }
+
+    CameraCalibration stored;
+    stored.frame_width = preferences.getUShort(KEY_WIDTH, 0);
+    stored.frame_height = preferences.getUShort(KEY_HEIGHT, 0);
+    stored.pan_px_per_step = preferences.getFloat(KEY_PAN, 0.0f);
+    stored.tilt_px_per_degree = preferences.getFloat(KEY_TILT, 0.0f);
+    preferences.end();
+
+    if (!stored.is_valid())
+    {
+        return false;
+    }
+
+    calibration = stored;
+    return true;
+}
+
+bool CalibrationStore::save(const CameraCalibration& calibration)
+{
+    Preferences preferences;
+    if (!calibration.is_valid() || !preferences.begin(CALIBRATION_NAMESPACE, false))
+    {
+        return false;
+    }
+
+    bool written = preferences.putUShort(KEY_WIDTH, calibration.frame_width) > 0 &&
+                   preferences.putUShort(KEY_HEIGHT, calibration.frame_height) > 0 &&
+                   preferences.putFloat(KEY_PAN, calibration.pan_px_per_step) > 0 &&
+                   preferences.putFloat(KEY_TILT, calibration.tilt_px_per_degree) > 0;
+    preferences.end();
+    return written;
+}
+
+void CalibrationStore::clear()
+{
+    Preferences preferences;
+    if (!preferences.begin(CALIBRATION_NAMESPACE, false))
+    {
+        return;
+    }
+
+    preferences.remove(KEY_WIDTH);
+    preferences.remove(KEY_HEIGHT);
+    preferences.remove(KEY_PAN);
+    preferences.remove(KEY_TILT);
+    preferences.end();
+}
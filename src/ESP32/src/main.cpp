@@ -1,8 +1,16 @@
+#include "calibration_store.h"
+#include "calibrator.h"
 #include "constants.h"
 #include "controller.h"
+#include "frame_broker.h"
 #include "joystick.h"
+#include "latency_probe.h"
+#include "motion_task.h"
 #include "movement_manager.h"
+#include "queued_movement_manager.h"
 #include "test_detection.h"
+#include "trace.h"
+#include "tracking_pipeline.h"
 #include <Arduino.h>
 
 #include "secrets.h"
@@ -11,33 +19,182 @@
 #include "camera.h"
 #include "turret_server.h"
 
-Servo servo;
-Stepper stepper(STEPPER_NUMBER_OF_STEPS, STEPPER_PIN1, STEPPER_PIN3, STEPPER_PIN2, STEPPER_PIN4);
+ServoDriver servo(SERVO_PIN);
+StepperDriver stepper(STEPPER_PIN1, STEPPER_PIN3, STEPPER_PIN2, STEPPER_PIN4);
 
 MovementManager movement_manager(stepper, servo);
+MotionCommandQueue motion_queue;
+MotionTask motion_task(motion_queue, movement_manager);
+
+// One queue lane per context that moves the turret
+QueuedMovementManager controller_motion(motion_queue, movement_manager);
+QueuedMovementManager web_motion(motion_queue, movement_manager);
+
 TestDetection detection_manager;
 Joystick joystick(JOYSTICK_PIN_X, JOYSTICK_PIN_Y, JOYSTICK_PIN_Z);
 
-Controller controller(movement_manager, detection_manager, joystick);
+Controller controller(controller_motion, detection_manager, joystick);
 
 HttpServer http_server;
 static Camera camera;
+FrameBroker frame_broker(camera);
+TrackingPipeline pipeline(frame_broker, detection_manager, controller);
+
+#define TELEMETRY_LOG_MS 5000 /**< How often the loop or pipeline timing goes out over serial. */
+
+/**
+ * @brief Serial telemetry for whichever path moves the turret.
+ * @details Optional work of Controller::run() without a camera, and of the pipeline's
+ * actuate task with one; either way it runs between control updates, never inside one.
+ */
+static void log_telemetry(void*)
+{
+    static unsigned long last_log_ms = 0;
+    if (millis() - last_log_ms < TELEMETRY_LOG_MS)
+    {
+        return;
+    }
+    last_log_ms = millis();
+
+    if (pipeline.is_running())
+    {
+        PipelineStats stats = pipeline.stats();
+        Serial.printf("[Pipeline] captured %u, %u frames dropped, detected %u, %u results dropped, actuated %u\n",
+                      (unsigned)stats.captured, (unsigned)stats.frames_dropped, (unsigned)stats.detected,
+                      (unsigned)stats.results_dropped, (unsigned)stats.actuated);
+    } else
+    {
+        LoopStats stats = controller.loop_stats();
+        Serial.printf("[Loop] period %u us, worst %u us, %u/%u deadlines missed, detecting 1 in %u\n",
+                      (unsigned)stats.period_us, (unsigned)stats.worst_us, (unsigned)stats.deadline_misses,
+                      (unsigned)stats.iterations, (unsigned)stats.detect_divider);
+    }
+
+#if LATENCY_PROBES
+    static char report[LATENCY_REPORT_SIZE]; // Off the actuate task's stack
+    latency_report(report, sizeof(report));
+    Serial.print(report);
+#endif
+}
+
+#define LOOP_IDLE_MS 20            /**< loop() sleep while the pipeline runs: serial and WiFi upkeep only. */
+#define SERIAL_TRACE_LINE_BYTES 32 /**< Dump bytes per hex line of a serial trace dump. */
+
+/** @brief TraceWriter that prints the dump as hex lines, for trace_to_chrome.py to pick out of a serial log. */
+static bool print_trace_hex(const void* data, size_t size, void*)
+{
+    static const char digits[] = "0123456789abcdef";
+    const uint8_t* bytes = static_cast<const uint8_t*>(data);
+    char line[SERIAL_TRACE_LINE_BYTES * 2 + 2];
+
+    while (size > 0)
+    {
+        size_t count = size < SERIAL_TRACE_LINE_BYTES ? size : SERIAL_TRACE_LINE_BYTES;
+        for (size_t i = 0; i < count; i++)
+        {
+            line[2 * i] = digits[bytes[i] >> 4];
+            line[2 * i + 1] = digits[bytes[i] & 0x0F];
+        }
+        line[2 * count] = '\n';
+        line[2 * count + 1] = '\0';
+        Serial.print(line);
+
+        bytes += count;
+        size -= count;
+    }
+    return true;
+}
+
+/**
+ * @brief Serial commands, one character each, for reading the turret without WiFi.
+ * @details 't' dumps the event trace as hex between "[Trace] BEGIN" and "[Trace] END";
+ * save the serial log and pass it to src/tools/trace_to_chrome.py. 'l' prints the
+ * latency histograms at once, the same table /latency serves.
+ */
+static void poll_serial_commands()
+{
+    while (Serial.available() > 0)
+    {
+        switch (Serial.read())
+        {
+        case 't':
+        {
+            Serial.println("[Trace] BEGIN");
+            size_t events = trace_dump(&print_trace_hex, nullptr);
+            Serial.printf("[Trace] END %u events\n", (unsigned)events);
+            break;
+        }
+        case 'l':
+        {
+            static char report[LATENCY_REPORT_SIZE];
+            latency_report(report, sizeof(report));
+            Serial.print(report);
+            break;
+        }
+        default:
+            break;
+        }
+    }
+}
 
 void setup()
 {
     Serial.begin(BAUDRATE);
     Serial.println("[Serial] === SMART TURRET START ===");
     joystick.begin();
-    // camera.begin();
+    stepper.begin();
 
     WifiManager::connect(WIFI_SSID, WIFI_PASSWORD);
-    // http_server.start(&camera);
 
-    servo.attach(SERVO_PIN);
+    servo.begin();
+    movement_manager.begin();
+
+    // Hold the joystick button through boot to measure the camera scale again
+    CameraCalibration calibration;
+    bool camera_ready = camera.begin();
+    if (camera_ready && joystick.is_z_held())
+    {
+        Calibrator calibrator(movement_manager, camera);
+        if (calibrator.run(calibration))
+        {
+            CalibrationStore::save(calibration);
+        }
+    }
+    if (calibration.is_valid() || CalibrationStore::load(calibration))
+    {
+        controller.set_calibration(calibration);
+    }
+
+    motion_task.start();
+    controller.set_optional_work(&log_telemetry, nullptr);
+    pipeline.set_optional_work(&log_telemetry, nullptr);
+
+    // With a camera, capture, detection and actuation overlap on their own tasks;
+    // the broker captures once per frame for the detector and any stream clients
+    if (camera_ready)
+    {
+        frame_broker.start();
+        pipeline.start();
+    }
+
+    // Web page, /stream, /latency and /trace; /move posts to its own motion queue lane.
+    // Without a camera there is no broker to stream from, and /stream answers 500.
+    if (!http_server.start(camera_ready ? &frame_broker : nullptr, &web_motion))
+    {
+        Serial.println("[HTTP] Failed to start the server");
+    }
 }
 
 void loop()
 {
-    controller.run();
+    if (pipeline.is_running())
+    {
+        // The pipeline's tasks do the work; give their core back instead of spinning
+        vTaskDelay(pdMS_TO_TICKS(LOOP_IDLE_MS));
+    } else
+    {
+        controller.run(); // Paced to LOOP_BUDGET_US
+    }
+    poll_serial_commands();
     WifiManager::maintain();
 }
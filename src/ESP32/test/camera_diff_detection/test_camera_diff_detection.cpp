@@ -1,6 +1,7 @@
 #include <Arduino.h>
 #include <unity.h>
 #include "camera_diff_detection.h"
+#include "sigma_delta_background.h"
 #include <esp_camera.h>
 
 // Helper to create a dummy frame buffer for testing
@@ -64,6 +65,229 @@ void test_gradient_magnitude_logic(void) {
     TEST_ASSERT_EQUAL_UINT8(255, final_val);
 }
 
+// 4. Test Sigma-Delta background: static scene is learned, a new object is not
+void test_sigma_delta_detects_new_object(void) {
+    const size_t w = 32, h = 24;
+    uint8_t luma[w * h];
+    memset(luma, 100, sizeof(luma));
+
+    SigmaDeltaBackground background;
+    TEST_ASSERT_TRUE(background.begin(w * h));
+
+    // First frame only seeds the model
+    MotionMoments moments;
+    background.update(luma, w, h, moments);
+    TEST_ASSERT_TRUE(background.is_primed());
+    TEST_ASSERT_EQUAL_UINT32(0, moments.count);
+
+    // Paint a bright 4x4 block in the top-left corner
+    for (size_t y = 0; y < 4; y++) {
+        memset(&luma[y * w], 220, 4);
+    }
+
+    background.update(luma, w, h, moments);
+    TEST_ASSERT_EQUAL_UINT32(16, moments.count);
+    TEST_ASSERT_EQUAL_UINT32(4 * (0 + 1 + 2 + 3), moments.sum_x);
+}
+
+// 5. Test Sigma-Delta background: slow global drift is absorbed, not reported
+void test_sigma_delta_absorbs_slow_drift(void) {
+    const size_t w = 32, h = 24;
+    uint8_t luma[w * h];
+    memset(luma, 100, sizeof(luma));
+
+    SigmaDeltaBackground background;
+    TEST_ASSERT_TRUE(background.begin(w * h));
+
+    MotionMoments moments;
+    background.update(luma, w, h, moments);
+
+    // Brighten by one grey level per frame, the mean follows at the same rate
+    for (int level = 101; level < 140; level++) {
+        memset(luma, level, sizeof(luma));
+        background.update(luma, w, h, moments);
+    }
+
+    TEST_ASSERT_EQUAL_UINT32(0, moments.count);
+}
+
+// Helper to paint a 64x48 greyscale scene with one bright 8x8 block
+static void paint_block(uint8_t* luma, size_t block_x) {
+    memset(luma, 60, 64 * 48);
+    for (size_t y = 20; y < 28; y++) {
+        memset(&luma[y * 64 + block_x], 230, 8);
+    }
+}
+
+// 6. Test Three-Frame differencing: no ghost at the position the target left
+void test_three_frame_ignores_ghost(void) {
+    uint8_t luma[64 * 48];
+    camera_fb_t fb = {};
+    fb.buf = luma;
+    fb.len = sizeof(luma);
+    fb.width = 64;
+    fb.height = 48;
+    fb.format = PIXFORMAT_GRAYSCALE;
+
+    CameraDiffDetection two_frame(DiffMode::PreviousFrame);
+    CameraDiffDetection three_frame(DiffMode::ThreeFrame);
+
+    const size_t path[] = {0, 8, 56};
+    std::tuple<MoveDirectionX, MoveDirectionY> two_result, three_result;
+    for (size_t block_x : path) {
+        paint_block(luma, block_x);
+        two_result = two_frame.detect_object(&fb);
+        three_result = three_frame.detect_object(&fb);
+    }
+
+    // Two-frame differencing averages the ghost at x=8 with the target at x=56
+    TEST_ASSERT_EQUAL(MoveDirectionX::None, std::get<0>(two_result));
+    // The double difference only keeps the target's current position
+    TEST_ASSERT_EQUAL(MoveDirectionX::Right, std::get<0>(three_result));
+    TEST_ASSERT_EQUAL(MoveDirectionY::None, std::get<1>(three_result));
+}
+
+// 7. Test Illumination compensation: a global brightness step is not motion
+void test_lighting_step_is_suppressed(void) {
+    uint8_t luma[64 * 48];
+    camera_fb_t fb = {};
+    fb.buf = luma;
+    fb.len = sizeof(luma);
+    fb.width = 64;
+    fb.height = 48;
+    fb.format = PIXFORMAT_GRAYSCALE;
+
+    CameraDiffDetection detector(DiffMode::PreviousFrame);
+
+    // Textured scene, then the same scene 40 grey levels brighter
+    for (size_t i = 0; i < sizeof(luma); i++) {
+        luma[i] = 80 + (i * 7) % 40;
+    }
+    detector.detect_object(&fb);
+
+    for (size_t i = 0; i < sizeof(luma); i++) {
+        luma[i] += 40;
+    }
+    std::tuple<MoveDirectionX, MoveDirectionY> result = detector.detect_object(&fb);
+
+    TEST_ASSERT_EQUAL(MoveDirectionX::None, std::get<0>(result));
+    TEST_ASSERT_EQUAL(MoveDirectionY::None, std::get<1>(result));
+    TEST_ASSERT_EQUAL_UINT32(1, detector.get_suppressed_lighting_events());
+}
+
+// 8. Test Illumination compensation: the model takes on the new level, so each step counts once
+void test_lighting_step_counted_once(void) {
+    uint8_t luma[64 * 48];
+    camera_fb_t fb = {};
+    fb.buf = luma;
+    fb.len = sizeof(luma);
+    fb.width = 64;
+    fb.height = 48;
+    fb.format = PIXFORMAT_GRAYSCALE;
+
+    const DiffMode modes[] = {DiffMode::PreviousFrame, DiffMode::SigmaDelta, DiffMode::ThreeFrame};
+    for (DiffMode mode : modes) {
+        CameraDiffDetection detector(mode);
+
+        // Two steps of 40 grey levels, each followed by frames at the new exposure
+        const uint8_t levels[] = {80, 80, 80, 120, 120, 120, 120, 120, 120, 160, 160, 160, 160};
+        for (uint8_t level : levels) {
+            for (size_t i = 0; i < sizeof(luma); i++) {
+                luma[i] = level + (i * 7) % 40;
+            }
+            std::tuple<MoveDirectionX, MoveDirectionY> result = detector.detect_object(&fb);
+            TEST_ASSERT_EQUAL(MoveDirectionX::None, std::get<0>(result));
+            TEST_ASSERT_EQUAL(MoveDirectionY::None, std::get<1>(result));
+        }
+
+        TEST_ASSERT_EQUAL_UINT32(2, detector.get_suppressed_lighting_events());
+    }
+}
+
+// 9. Test Edge differencing: shading changes are ignored, new edges are not
+void test_edge_mode_ignores_shading(void) {
+    uint8_t luma[64 * 48];
+    camera_fb_t fb = {};
+    fb.buf = luma;
+    fb.len = sizeof(luma);
+    fb.width = 64;
+    fb.height = 48;
+    fb.format = PIXFORMAT_GRAYSCALE;
+
+    CameraDiffDetection edge_detector(DiffMode::Edge);
+    CameraDiffDetection luma_detector(DiffMode::PreviousFrame);
+    luma_detector.set_illumination_compensation(false);
+
+    paint_block(luma, 8);
+    edge_detector.detect_object(&fb);
+    luma_detector.detect_object(&fb);
+
+    // A shadow lifts off the right part of the scene: flat regions stay edge-free
+    for (size_t y = 0; y < 48; y++) {
+        for (size_t x = 40; x < 64; x++) {
+            luma[y * 64 + x] += 40;
+        }
+    }
+    std::tuple<MoveDirectionX, MoveDirectionY> edge_result = edge_detector.detect_object(&fb);
+    std::tuple<MoveDirectionX, MoveDirectionY> luma_result = luma_detector.detect_object(&fb);
+
+    TEST_ASSERT_EQUAL(MoveDirectionX::Right, std::get<0>(luma_result));
+    TEST_ASSERT_EQUAL(MoveDirectionX::None, std::get<0>(edge_result));
+
+    // A new 16x16 object appears in the brightened region
+    for (size_t y = 16; y < 32; y++) {
+        memset(&luma[y * 64 + 46], 230, 16);
+    }
+    edge_result = edge_detector.detect_object(&fb);
+    TEST_ASSERT_EQUAL(MoveDirectionX::Right, std::get<0>(edge_result));
+}
+
+// 10. Test DetectionResult: sub-pixel error, bounding box and timestamp
+void test_detect_reports_error_and_box(void) {
+    uint8_t luma[64 * 48];
+    memset(luma, 60, sizeof(luma));
+
+    camera_fb_t fb = {};
+    fb.buf = luma;
+    fb.len = sizeof(luma);
+    fb.width = 64;
+    fb.height = 48;
+    fb.format = PIXFORMAT_GRAYSCALE;
+    fb.timestamp.tv_sec = 3;
+    fb.timestamp.tv_usec = 250;
+
+    CameraDiffDetection detector(DiffMode::SigmaDelta);
+    FrameArena arena;
+    FrameContext context(arena);
+
+    context.attach(&fb);
+    TEST_ASSERT_FALSE(detector.detect(context).has_target());
+
+    // 8x8 block covering x 40..47, y 8..15: centre (44, 12), frame centre (32, 24)
+    for (size_t y = 8; y < 16; y++) {
+        memset(&luma[y * 64 + 40], 230, 8);
+    }
+    context.attach(&fb);
+    DetectionResult result = detector.detect(context);
+
+    TEST_ASSERT_TRUE(result.has_target());
+    TEST_ASSERT_EQUAL_INT16(12 << DETECTION_SUBPIXEL_BITS, result.error_x);
+    TEST_ASSERT_EQUAL_INT16(-(12 << DETECTION_SUBPIXEL_BITS), result.error_y);
+    TEST_ASSERT_EQUAL_UINT16(40, result.box.x);
+    TEST_ASSERT_EQUAL_UINT16(8, result.box.y);
+    TEST_ASSERT_EQUAL_UINT16(8, result.box.width);
+    TEST_ASSERT_EQUAL_UINT16(8, result.box.height);
+    TEST_ASSERT_EQUAL_INT64(3000250, result.timestamp_us);
+
+    // The legacy tuple view of the same offset
+    std::tuple<MoveDirectionX, MoveDirectionY> directions = result.to_directions(DIFF_CENTER_DEADZONE);
+    TEST_ASSERT_EQUAL(MoveDirectionX::None, std::get<0>(directions));
+    TEST_ASSERT_EQUAL(MoveDirectionY::None, std::get<1>(directions));
+    directions = result.to_directions(8);
+    TEST_ASSERT_EQUAL(MoveDirectionX::Right, std::get<0>(directions));
+    TEST_ASSERT_EQUAL(MoveDirectionY::Up, std::get<1>(directions));
+}
+
 void setup() {
     // Wait for hardware to stabilize
     delay(2000);
@@ -73,6 +297,13 @@ void setup() {
     RUN_TEST(test_rgb565_to_greyscale_logic);
     RUN_TEST(test_roberts_cross_null_handling);
     RUN_TEST(test_gradient_magnitude_logic);
+    RUN_TEST(test_sigma_delta_detects_new_object);
+    RUN_TEST(test_sigma_delta_absorbs_slow_drift);
+    RUN_TEST(test_three_frame_ignores_ghost);
+    RUN_TEST(test_lighting_step_is_suppressed);
+    RUN_TEST(test_lighting_step_counted_once);
+    RUN_TEST(test_edge_mode_ignores_shading);
+    RUN_TEST(test_detect_reports_error_and_box);
     
     UNITY_END();
 }
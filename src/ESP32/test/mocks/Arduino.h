@@ -0,0 +1,126 @@
+/**
+ * @file Arduino.h
+ * @brief Minimal host stand-in for the Arduino core used by the turret libraries.
+ * @details Time comes from mock_clock, so delay() also fires due esp_timer callbacks.
+ * Pin writes are latched in mock_arduino::pin_levels() and analog inputs are read
+ * from mock_arduino::analog_values(), both settable by the test.
+ */
+#pragma once
+
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <algorithm>
+#include <string>
+
+#include "mock_clock.h"
+
+#define HIGH 0x1
+#define LOW 0x0
+
+#define INPUT 0x01
+#define OUTPUT 0x03
+#define INPUT_PULLUP 0x05
+
+#define constrain(amt, low, high) ((amt) < (low) ? (low) : ((amt) > (high) ? (high) : (amt)))
+
+namespace mock_arduino
+{
+
+static const uint8_t PIN_COUNT = 40;
+
+inline int* pin_levels()
+{
+    static int levels[PIN_COUNT] = {};
+    return levels;
+}
+
+inline int* analog_values()
+{
+    static int values[PIN_COUNT] = {};
+    return values;
+}
+
+} // namespace mock_arduino
+
+inline void pinMode(uint8_t, uint8_t)
+{
+}
+
+inline void digitalWrite(uint8_t pin, uint8_t value)
+{
+    if (pin < mock_arduino::PIN_COUNT)
+    {
+        mock_arduino::pin_levels()[pin] = value;
+    }
+}
+
+inline int digitalRead(uint8_t pin)
+{
+    return (pin < mock_arduino::PIN_COUNT) ? mock_arduino::pin_levels()[pin] : LOW;
+}
+
+inline uint16_t analogRead(uint8_t pin)
+{
+    return (pin < mock_arduino::PIN_COUNT) ? (uint16_t)mock_arduino::analog_values()[pin] : 0;
+}
+
+inline void analogReadResolution(uint8_t)
+{
+}
+
+inline unsigned long micros()
+{
+    return (unsigned long)mock_clock::now_us();
+}
+
+inline unsigned long millis()
+{
+    return (unsigned long)(mock_clock::now_us() / 1000);
+}
+
+inline void delay(uint32_t ms)
+{
+    mock_clock::advance_us((int64_t)ms * 1000);
+}
+
+inline void delayMicroseconds(uint32_t us)
+{
+    mock_clock::advance_us(us);
+}
+
+inline long map(long x, long in_min, long in_max, long out_min, long out_max)
+{
+    return (x - in_min) * (out_max - out_min) / (in_max - in_min) + out_min;
+}
+
+/** @brief Arduino's String, close enough for logging. */
+typedef std::string String;
+
+/** @brief Serial port that prints to stdout. */
+class MockSerial
+{
+public:
+    void begin(unsigned long) {}
+    void print(const char* text) { fputs(text, stdout); }
+    void print(const std::string& text) { fputs(text.c_str(), stdout); }
+    template <typename T> void print(T value) { fputs(std::to_string(value).c_str(), stdout); }
+    void println() { fputs("\n", stdout); }
+    template <typename T> void println(const T& value)
+    {
+        print(value);
+        println();
+    }
+    template <typename... Args> void printf(const char* format, Args... args) { ::printf(format, args...); }
+};
+
+inline MockSerial& mock_serial()
+{
+    static MockSerial serial;
+    return serial;
+}
+
+#define Serial mock_serial()
@@ -0,0 +1,78 @@
+/**
+ * @file ESP32Servo.h
+ * @brief Host stand-in for the ESP32Servo library; remembers the last command.
+ */
+#pragma once
+
+#include <atomic>
+#include <thread>
+
+#include "Arduino.h"
+#include "freertos/FreeRTOS.h"
+
+namespace mock_servo
+{
+
+/** @brief Pulse writes made inside a critical section, where the real LEDC driver must not run. */
+inline std::atomic<int>& writes_in_critical()
+{
+    static std::atomic<int> writes(0);
+    return writes;
+}
+
+/** @brief Pulse writes made while the channel was detached, which the real driver drops. */
+inline std::atomic<int>& writes_while_detached()
+{
+    static std::atomic<int> writes(0);
+    return writes;
+}
+
+} // namespace mock_servo
+
+class Servo
+{
+private:
+    std::atomic<int> _pin{-1};
+    int _min_us = 544;
+    int _max_us = 2400;
+    int _period_hz = 50;
+    int _pulse_us = 1472;
+
+public:
+    int attach(int pin)
+    {
+        this->_pin = pin;
+        return 1;
+    }
+    int attach(int pin, int min_us, int max_us)
+    {
+        this->_min_us = min_us;
+        this->_max_us = max_us;
+        return attach(pin);
+    }
+    void detach()
+    {
+        this->_pin = -1;
+        std::this_thread::yield(); // Releasing the LEDC channel is not instant either
+    }
+    bool attached() const { return this->_pin >= 0; }
+    void setPeriodHertz(int hz) { this->_period_hz = hz; }
+    void write(int angle) { writeMicroseconds(map(constrain(angle, 0, 180), 0, 180, this->_min_us, this->_max_us)); }
+    void writeMicroseconds(int pulse_us)
+    {
+        if (mock_freertos::critical_nesting() > 0)
+        {
+            mock_servo::writes_in_critical()++;
+        }
+        if (!attached())
+        {
+            mock_servo::writes_while_detached()++;
+        }
+        if (attached())
+        {
+            this->_pulse_us = constrain(pulse_us, this->_min_us, this->_max_us);
+        }
+    }
+    int read() const { return map(this->_pulse_us, this->_min_us, this->_max_us, 0, 180); }
+    int readMicroseconds() const { return this->_pulse_us; }
+};
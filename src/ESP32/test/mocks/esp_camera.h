@@ -0,0 +1,171 @@
+/**
+ * @file esp_camera.h
+ * @brief Host stand-in for the esp32-camera driver.
+ * @details esp_camera_fb_get() asks a frame source installed by the test (e.g. a
+ * simulator rendering synthetic frames) instead of the sensor.
+ */
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/time.h>
+
+#include <atomic>
+
+#include "esp_err.h"
+
+typedef enum
+{
+    PIXFORMAT_RGB565,
+    PIXFORMAT_YUV422,
+    PIXFORMAT_YUV420,
+    PIXFORMAT_GRAYSCALE,
+    PIXFORMAT_JPEG,
+    PIXFORMAT_RGB888,
+} pixformat_t;
+
+typedef enum
+{
+    FRAMESIZE_96X96,
+    FRAMESIZE_QQVGA,
+    FRAMESIZE_QCIF,
+    FRAMESIZE_HQVGA,
+    FRAMESIZE_240X240,
+    FRAMESIZE_QVGA,
+    FRAMESIZE_CIF,
+    FRAMESIZE_HVGA,
+    FRAMESIZE_VGA,
+    FRAMESIZE_SVGA,
+    FRAMESIZE_XGA,
+    FRAMESIZE_HD,
+    FRAMESIZE_SXGA,
+    FRAMESIZE_UXGA,
+    FRAMESIZE_INVALID,
+} framesize_t;
+
+typedef enum
+{
+    JPG_SCALE_NONE,
+    JPG_SCALE_2X,
+    JPG_SCALE_4X,
+    JPG_SCALE_8X,
+} jpg_scale_t;
+
+typedef enum
+{
+    LEDC_CHANNEL_0,
+} ledc_channel_t;
+
+typedef enum
+{
+    LEDC_TIMER_0,
+} ledc_timer_t;
+
+typedef enum
+{
+    CAMERA_GRAB_WHEN_EMPTY,
+    CAMERA_GRAB_LATEST,
+} camera_grab_mode_t;
+
+typedef enum
+{
+    CAMERA_FB_IN_PSRAM,
+    CAMERA_FB_IN_DRAM,
+} camera_fb_location_t;
+
+typedef struct {
+    uint8_t* buf;
+    size_t len;
+    size_t width;
+    size_t height;
+    pixformat_t format;
+    struct timeval timestamp;
+} camera_fb_t;
+
+typedef struct {
+    int pin_pwdn;
+    int pin_reset;
+    int pin_xclk;
+    int pin_sccb_sda;
+    int pin_sccb_scl;
+    int pin_d7, pin_d6, pin_d5, pin_d4, pin_d3, pin_d2, pin_d1, pin_d0;
+    int pin_vsync;
+    int pin_href;
+    int pin_pclk;
+    int xclk_freq_hz;
+    ledc_timer_t ledc_timer;
+    ledc_channel_t ledc_channel;
+    pixformat_t pixel_format;
+    framesize_t frame_size;
+    int jpeg_quality;
+    size_t fb_count;
+    camera_fb_location_t fb_location;
+    camera_grab_mode_t grab_mode;
+} camera_config_t;
+
+typedef struct sensor_t {
+    int (*set_vflip)(struct sensor_t* sensor, int enable);
+} sensor_t;
+
+namespace mock_camera
+{
+
+/** @brief Produces the next frame, or nullptr if none is available. */
+typedef camera_fb_t* (*FrameSource)(void* arg);
+
+struct State {
+    FrameSource source = nullptr;
+    void* arg = nullptr;
+    std::atomic<uint32_t> frames_out{0}; /**< Frames handed out and not yet returned. */
+};
+
+inline State& state()
+{
+    static State instance;
+    return instance;
+}
+
+/** @brief Installs the frame source used by esp_camera_fb_get(). */
+inline void set_source(FrameSource source, void* arg)
+{
+    state().source = source;
+    state().arg = arg;
+}
+
+} // namespace mock_camera
+
+inline esp_err_t esp_camera_init(const camera_config_t*)
+{
+    return ESP_OK;
+}
+
+inline sensor_t* esp_camera_sensor_get()
+{
+    static sensor_t sensor = {[](sensor_t*, int) { return 0; }};
+    return &sensor;
+}
+
+inline camera_fb_t* esp_camera_fb_get()
+{
+    mock_camera::State& camera = mock_camera::state();
+    camera_fb_t* frame = camera.source ? camera.source(camera.arg) : nullptr;
+    if (frame)
+    {
+        camera.frames_out++;
+    }
+    return frame;
+}
+
+inline void esp_camera_fb_return(camera_fb_t* frame)
+{
+    if (frame)
+    {
+        mock_camera::state().frames_out--;
+    }
+}
+
+/** @brief No JPEG decoder on the host; simulated frames are GRAYSCALE or RGB565. */
+inline bool jpg2rgb565(const uint8_t*, size_t, uint8_t*, jpg_scale_t)
+{
+    return false;
+}
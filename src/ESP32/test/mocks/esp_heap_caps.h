@@ -0,0 +1,28 @@
+/**
+ * @file esp_heap_caps.h
+ * @brief Host stand-in for the ESP-IDF capability-based allocator.
+ */
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#define MALLOC_CAP_SPIRAM (1 << 10)
+#define MALLOC_CAP_INTERNAL (1 << 11)
+#define MALLOC_CAP_8BIT (1 << 2)
+
+inline void* heap_caps_malloc(size_t size, uint32_t)
+{
+    return malloc(size);
+}
+
+inline void* heap_caps_calloc(size_t count, size_t size, uint32_t)
+{
+    return calloc(count, size);
+}
+
+inline void heap_caps_free(void* ptr)
+{
+    free(ptr);
+}
@@ -0,0 +1,93 @@
+/**
+ * @file esp_timer.h
+ * @brief Host stand-in for esp_timer, backed by mock_clock.
+ */
+#pragma once
+
+#include <stdint.h>
+
+#include <algorithm>
+
+#include "esp_err.h"
+#include "mock_clock.h"
+
+typedef void (*esp_timer_cb_t)(void* arg);
+
+typedef enum
+{
+    ESP_TIMER_TASK,
+    ESP_TIMER_ISR,
+} esp_timer_dispatch_t;
+
+typedef struct {
+    esp_timer_cb_t callback;
+    void* arg;
+    esp_timer_dispatch_t dispatch_method;
+    const char* name;
+    bool skip_unhandled_events;
+} esp_timer_create_args_t;
+
+typedef mock_clock::Timer* esp_timer_handle_t;
+
+inline int64_t esp_timer_get_time()
+{
+    return mock_clock::now_us();
+}
+
+inline esp_err_t esp_timer_create(const esp_timer_create_args_t* args, esp_timer_handle_t* out_handle)
+{
+    if (!args || !args->callback || !out_handle)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+    *out_handle = new mock_clock::Timer{args->callback, args->arg, 0, 0, false};
+    mock_clock::timers().push_back(*out_handle);
+    return ESP_OK;
+}
+
+inline esp_err_t esp_timer_start_once(esp_timer_handle_t timer, uint64_t timeout_us)
+{
+    if (timer->armed)
+    {
+        return ESP_ERR_INVALID_STATE;
+    }
+    timer->deadline_us = mock_clock::now_us() + (int64_t)timeout_us;
+    timer->period_us = 0;
+    timer->armed = true;
+    return ESP_OK;
+}
+
+inline esp_err_t esp_timer_start_periodic(esp_timer_handle_t timer, uint64_t period_us)
+{
+    if (timer->armed)
+    {
+        return ESP_ERR_INVALID_STATE;
+    }
+    timer->deadline_us = mock_clock::now_us() + (int64_t)period_us;
+    timer->period_us = (int64_t)period_us;
+    timer->armed = true;
+    return ESP_OK;
+}
+
+inline esp_err_t esp_timer_stop(esp_timer_handle_t timer)
+{
+    if (!timer->armed)
+    {
+        return ESP_ERR_INVALID_STATE;
+    }
+    timer->armed = false;
+    return ESP_OK;
+}
+
+inline bool esp_timer_is_active(esp_timer_handle_t timer)
+{
+    return timer->armed;
+}
+
+inline esp_err_t esp_timer_delete(esp_timer_handle_t timer)
+{
+    std::vector<mock_clock::Timer*>& all = mock_clock::timers();
+    all.erase(std::remove(all.begin(), all.end(), timer), all.end());
+    delete timer;
+    return ESP_OK;
+}
@@ -0,0 +1,62 @@
+/**
+ * @file FreeRTOS.h
+ * @brief Host stand-in for the FreeRTOS critical-section primitives.
+ * @details portMUX_TYPE becomes a real spinlock so code under test stays correct
+ * when host tests drive it from several std::threads. Each thread also carries
+ * the core it pretends to run on and how deep it is in critical sections, so mocked
+ * drivers can check they are not called with interrupts off.
+ */
+#pragma once
+
+#include <stdint.h>
+
+#include <atomic>
+
+struct portMUX_TYPE {
+    std::atomic_flag flag = ATOMIC_FLAG_INIT;
+};
+
+#define portMUX_INITIALIZER_UNLOCKED {}
+
+namespace mock_freertos
+{
+
+/** @brief Core the calling thread runs on as far as xPortGetCoreID() is concerned; 0 unless set. */
+inline int& current_core()
+{
+    static thread_local int core = 0;
+    return core;
+}
+
+/** @brief Critical sections the calling thread is inside. */
+inline int& critical_nesting()
+{
+    static thread_local int nesting = 0;
+    return nesting;
+}
+
+} // namespace mock_freertos
+
+inline int xPortGetCoreID()
+{
+    return mock_freertos::current_core();
+}
+
+inline void vPortEnterCritical(portMUX_TYPE* mux)
+{
+    while (mux->flag.test_and_set(std::memory_order_acquire))
+    {
+    }
+    mock_freertos::critical_nesting()++;
+}
+
+inline void vPortExitCritical(portMUX_TYPE* mux)
+{
+    mock_freertos::critical_nesting()--;
+    mux->flag.clear(std::memory_order_release);
+}
+
+#define portENTER_CRITICAL(mux) vPortEnterCritical(mux)
+#define portEXIT_CRITICAL(mux) vPortExitCritical(mux)
+#define portENTER_CRITICAL_ISR(mux) vPortEnterCritical(mux)
+#define portEXIT_CRITICAL_ISR(mux) vPortExitCritical(mux)
@@ -0,0 +1,122 @@
+/**
+ * @file task.h
+ * @brief Host stand-in for FreeRTOS tasks and direct-to-task notifications.
+ * @details Tasks are detached std::threads running in real time; a pinned task
+ * reports its core through xPortGetCoreID(), the priority is ignored. Notifications use a mutex and a condition
+ * variable per task. Enough to run task bodies under host stress tests.
+ */
+#pragma once
+
+#include <stdint.h>
+
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+#include "FreeRTOS.h"
+
+typedef uint32_t TickType_t;
+typedef int BaseType_t;
+typedef unsigned int UBaseType_t;
+typedef void (*TaskFunction_t)(void*);
+
+#define pdFALSE 0
+#define pdTRUE 1
+#define pdPASS 1
+#define pdFAIL 0
+#define portMAX_DELAY 0xFFFFFFFFu
+#define portTICK_PERIOD_MS 1
+#define pdMS_TO_TICKS(ms) ((TickType_t)(ms))
+#define tskNO_AFFINITY 0x7FFFFFFF
+
+/** @brief Emulated task control block. */
+struct MockTask {
+    std::mutex mutex;
+    std::condition_variable wake;
+    uint32_t notifications = 0;
+};
+
+typedef MockTask* TaskHandle_t;
+
+namespace mock_freertos
+{
+
+inline MockTask*& current_task()
+{
+    static thread_local MockTask* task = nullptr;
+    return task;
+}
+
+} // namespace mock_freertos
+
+inline TaskHandle_t xTaskGetCurrentTaskHandle()
+{
+    if (!mock_freertos::current_task())
+    {
+        mock_freertos::current_task() = new MockTask(); // Threads not made by xTaskCreate
+    }
+    return mock_freertos::current_task();
+}
+
+inline BaseType_t xTaskCreatePinnedToCore(TaskFunction_t function, const char*, uint32_t, void* arg, UBaseType_t,
+                                          TaskHandle_t* out_handle, BaseType_t core)
+{
+    MockTask* task = new MockTask();
+    if (out_handle)
+    {
+        *out_handle = task;
+    }
+    std::thread([function, arg, task, core]() {
+        mock_freertos::current_task() = task;
+        mock_freertos::current_core() = (core == tskNO_AFFINITY) ? 0 : (int)core;
+        function(arg);
+    }).detach();
+    return pdPASS;
+}
+
+inline BaseType_t xTaskCreate(TaskFunction_t function, const char* name, uint32_t stack, void* arg,
+                              UBaseType_t priority, TaskHandle_t* out_handle)
+{
+    return xTaskCreatePinnedToCore(function, name, stack, arg, priority, out_handle, tskNO_AFFINITY);
+}
+
+/** @brief The task's thread ends when its function returns, so there is nothing to delete. */
+inline void vTaskDelete(TaskHandle_t)
+{
+}
+
+inline void vTaskDelay(TickType_t ticks)
+{
+    std::this_thread::sleep_for(std::chrono::milliseconds(ticks));
+}
+
+inline BaseType_t xTaskNotifyGive(TaskHandle_t task)
+{
+    {
+        std::lock_guard<std::mutex> lock(task->mutex);
+        task->notifications++;
+    }
+    task->wake.notify_one();
+    return pdPASS;
+}
+
+inline uint32_t ulTaskNotifyTake(BaseType_t clear_on_exit, TickType_t ticks)
+{
+    MockTask* task = xTaskGetCurrentTaskHandle();
+    std::unique_lock<std::mutex> lock(task->mutex);
+    if (ticks == portMAX_DELAY)
+    {
+        task->wake.wait(lock, [task]() { return task->notifications > 0; });
+    } else
+    {
+        task->wake.wait_for(lock, std::chrono::milliseconds(ticks), [task]() { return task->notifications > 0; });
+    }
+
+    uint32_t value = task->notifications;
+    if (value > 0)
+    {
+        task->notifications = clear_on_exit ? 0 : value - 1;
+    }
+    return value;
+}
@@ -0,0 +1,85 @@
+/**
+ * @file mock_clock.h
+ * @brief Virtual microsecond clock and esp_timer scheduler for host tests.
+ * @details Time only moves when a test calls mock_clock::advance_us() (or delay()).
+ * Armed esp_timer callbacks fire in deadline order at their exact virtual time,
+ * so timing assertions are deterministic and independent of the host.
+ */
+#pragma once
+
+#include <stdint.h>
+
+#include <algorithm>
+#include <vector>
+
+namespace mock_clock
+{
+
+/** @brief One emulated esp_timer. */
+struct Timer {
+    void (*callback)(void*);
+    void* arg;
+    int64_t deadline_us;
+    int64_t period_us; ///< 0 for one-shot timers.
+    bool armed;
+};
+
+/** @brief Current virtual time in µs. */
+inline int64_t& now_us()
+{
+    static int64_t now = 0;
+    return now;
+}
+
+/** @brief Every timer created and not yet deleted. */
+inline std::vector<Timer*>& timers()
+{
+    static std::vector<Timer*> all;
+    return all;
+}
+
+/** @brief Moves time forward by @p duration_us, firing due timers on the way. */
+inline void advance_us(int64_t duration_us)
+{
+    const int64_t end = now_us() + duration_us;
+
+    for (;;)
+    {
+        Timer* next = nullptr;
+        for (Timer* timer : timers())
+        {
+            if (timer->armed && timer->deadline_us <= end && (!next || timer->deadline_us < next->deadline_us))
+            {
+                next = timer;
+            }
+        }
+        if (!next)
+        {
+            break;
+        }
+
+        now_us() = std::max(now_us(), next->deadline_us);
+        if (next->period_us > 0)
+        {
+            next->deadline_us += next->period_us;
+        } else
+        {
+            next->armed = false;
+        }
+        next->callback(next->arg);
+    }
+
+    now_us() = end;
+}
+
+/** @brief Rewinds time to 0 and disarms every timer. */
+inline void reset()
+{
+    now_us() = 0;
+    for (Timer* timer : timers())
+    {
+        timer->armed = false;
+    }
+}
+
+} // namespace mock_clock
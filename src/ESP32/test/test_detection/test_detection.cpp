@@ -1,25 +1,137 @@
 #include <Arduino.h>
 #include <unity.h>
 #include "base_detection_module.h"
+#include "frame_context.h"
 
-// TODO: Add tests
+static uint8_t test_luma[32 * 24];
+static camera_fb_t test_frame;
 
 // This runs BEFORE every test case
 void setUp(void)
 {
+    for (size_t i = 0; i < sizeof(test_luma); i++)
+    {
+        test_luma[i] = (uint8_t)(i * 13);
+    }
+
+    test_frame = {};
+    test_frame.buf = test_luma;
+    test_frame.len = sizeof(test_luma);
+    test_frame.width = 32;
+    test_frame.height = 24;
+    test_frame.format = PIXFORMAT_GRAYSCALE;
 }
 
 // This runs AFTER every test case
 void tearDown(void) {
 }
 
+// 1. Each representation is computed once and then served from the cache
+void test_frame_context_caches_representations(void)
+{
+    FrameArena arena;
+    FrameContext context(arena);
+    TEST_ASSERT_TRUE(context.attach(&test_frame));
+
+    // Greyscale frames are used in place, no copy
+    TEST_ASSERT_EQUAL_PTR(test_luma, context.greyscale());
+
+    const uint8_t* edges = context.edges();
+    const uint32_t* integral = context.integral();
+    TEST_ASSERT_NOT_NULL(edges);
+    TEST_ASSERT_NOT_NULL(integral);
+
+    size_t used = arena.used();
+    TEST_ASSERT_EQUAL_PTR(edges, context.edges());
+    TEST_ASSERT_EQUAL_PTR(integral, context.integral());
+    TEST_ASSERT_EQUAL_UINT32(used, arena.used());
+
+    // Bottom-right entry of the summed-area table is the sum of every pixel
+    uint32_t total = 0;
+    for (size_t i = 0; i < sizeof(test_luma); i++)
+    {
+        total += test_luma[i];
+    }
+    TEST_ASSERT_EQUAL_UINT32(total, integral[33 * 25 - 1]);
+}
+
+// 2. Releasing the frame invalidates every cached representation
+void test_frame_context_release_invalidates(void)
+{
+    FrameArena arena;
+    FrameContext context(arena);
+    context.attach(&test_frame);
+    context.downsampled();
+    TEST_ASSERT_TRUE(arena.used() > 0);
+
+    context.release();
+    TEST_ASSERT_NULL(context.frame());
+    TEST_ASSERT_NULL(context.greyscale());
+    TEST_ASSERT_EQUAL_UINT32(0, arena.used());
+}
+
+// 3. Arena space is only taken for what is asked for, and kept for the next frame
+void test_frame_context_reserves_lazily(void)
+{
+    FrameArena arena;
+    FrameContext context(arena);
+    TEST_ASSERT_TRUE(context.attach(&test_frame));
+
+    // Luma of a greyscale frame needs no arena at all
+    context.greyscale();
+    TEST_ASSERT_EQUAL_UINT32(0, arena.capacity());
+
+    const uint8_t* edges = context.edges();
+    size_t edges_capacity = arena.capacity();
+    TEST_ASSERT_TRUE(edges_capacity < 33 * 25 * sizeof(uint32_t));
+
+    // Growing for the integral image leaves the edge map where it was
+    uint8_t first_edge = edges[0];
+    TEST_ASSERT_NOT_NULL(context.integral());
+    TEST_ASSERT_TRUE(arena.capacity() > edges_capacity);
+    TEST_ASSERT_EQUAL_PTR(edges, context.edges());
+    TEST_ASSERT_EQUAL_UINT8(first_edge, edges[0]);
+
+    // The next frame asks for the same and reuses the blocks
+    size_t capacity = arena.capacity();
+    context.attach(&test_frame);
+    context.edges();
+    context.integral();
+    TEST_ASSERT_EQUAL_UINT32(capacity, arena.capacity());
+}
+
+// 4. Luma lands in a caller-owned buffer and later representations read it from there
+void test_frame_context_greyscale_into_caller_buffer(void)
+{
+    FrameArena arena;
+    FrameContext context(arena);
+    TEST_ASSERT_TRUE(context.attach(&test_frame));
+
+    static uint8_t slot[32 * 24];
+    TEST_ASSERT_EQUAL_PTR(slot, context.greyscale_into(slot));
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(test_luma, slot, sizeof(slot));
+    TEST_ASSERT_EQUAL_PTR(slot, context.greyscale());
+    TEST_ASSERT_EQUAL_UINT32(0, arena.capacity());
+
+    // The edge map is derived from the slot, not from the frame
+    slot[0] = 0;
+    slot[33] = 255;
+    TEST_ASSERT_EQUAL_UINT8(255, context.edges()[0]);
+
+    context.release();
+    TEST_ASSERT_NULL(context.greyscale_into(slot));
+}
+
 // Entry point for the test
 void setup()
 {
     delay(2000); // Wait for hardware to stabilize
     UNITY_BEGIN();
 
-    TEST_ASSERT_TRUE(true);
+    RUN_TEST(test_frame_context_caches_representations);
+    RUN_TEST(test_frame_context_release_invalidates);
+    RUN_TEST(test_frame_context_reserves_lazily);
+    RUN_TEST(test_frame_context_greyscale_into_caller_buffer);
 
     UNITY_END();
 }
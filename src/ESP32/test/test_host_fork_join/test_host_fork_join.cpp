@@ -0,0 +1,200 @@
+#include <Arduino.h>
+#include <unity.h>
+
+#include <atomic>
+#include <thread>
+
+#include "camera_diff_detection.h"
+#include "fork_join.h"
+
+#define TEST_WIDTH 96
+#define TEST_HEIGHT 72
+#define TEST_FRAMES 12
+
+// Workers are tasks that never exit, so one started pool serves every test
+static ForkJoin workers;
+
+/** @brief Job that records which band ran on which thread. */
+struct RecordingJob {
+    std::atomic<uint32_t> runs[FORK_JOIN_WORKERS];
+    std::thread::id threads[FORK_JOIN_WORKERS];
+    size_t band_count[FORK_JOIN_WORKERS];
+};
+
+static void record_band(void* arg, size_t band, size_t band_count)
+{
+    RecordingJob* job = static_cast<RecordingJob*>(arg);
+    job->runs[band]++;
+    job->threads[band] = std::this_thread::get_id();
+    job->band_count[band] = band_count;
+}
+
+/** @brief Renders frame @p index: textured background, a moving square, and a lighting step halfway. */
+static void render(uint8_t* pixels, int index)
+{
+    int square_x = 10 + index * 5;
+    int square_y = 8 + index * 3;
+    int offset = (index >= TEST_FRAMES / 2) ? 12 : 0;
+
+    for (int y = 0; y < TEST_HEIGHT; y++)
+    {
+        for (int x = 0; x < TEST_WIDTH; x++)
+        {
+            int luma = 60 + ((x * 7 + y * 13) % 40) + offset;
+            if (x >= square_x && x < square_x + 12 && y >= square_y && y < square_y + 12)
+            {
+                luma = 220;
+            }
+            pixels[y * TEST_WIDTH + x] = (uint8_t)luma;
+        }
+    }
+}
+
+/** @brief Feeds the same frame sequence to a serial and a banded detector and compares every result. */
+static void check_mode_matches_serial(DiffMode mode)
+{
+    CameraDiffDetection serial(mode);
+    CameraDiffDetection banded(mode);
+    banded.set_workers(&workers);
+
+    static uint8_t pixels[TEST_WIDTH * TEST_HEIGHT];
+    camera_fb_t frame = {};
+    frame.buf = pixels;
+    frame.len = sizeof(pixels);
+    frame.width = TEST_WIDTH;
+    frame.height = TEST_HEIGHT;
+    frame.format = PIXFORMAT_GRAYSCALE;
+
+    FrameArena arena;
+    int targets = 0;
+    for (int i = 0; i < TEST_FRAMES; i++)
+    {
+        render(pixels, i);
+
+        FrameContext serial_context(arena);
+        serial_context.attach(&frame);
+        DetectionResult expected = serial.detect(serial_context);
+        serial_context.release();
+
+        FrameContext banded_context(arena);
+        banded_context.attach(&frame);
+        DetectionResult actual = banded.detect(banded_context);
+
+        TEST_ASSERT_EQUAL_INT16(expected.error_x, actual.error_x);
+        TEST_ASSERT_EQUAL_INT16(expected.error_y, actual.error_y);
+        TEST_ASSERT_EQUAL_UINT8(expected.confidence, actual.confidence);
+        TEST_ASSERT_EQUAL_UINT16(expected.box.x, actual.box.x);
+        TEST_ASSERT_EQUAL_UINT16(expected.box.y, actual.box.y);
+        TEST_ASSERT_EQUAL_UINT16(expected.box.width, actual.box.width);
+        TEST_ASSERT_EQUAL_UINT16(expected.box.height, actual.box.height);
+        targets += actual.has_target() ? 1 : 0;
+    }
+
+    TEST_ASSERT_TRUE(targets > 0); // The sequence exercised the moment merge
+    TEST_ASSERT_EQUAL_UINT32(serial.get_suppressed_lighting_events(), banded.get_suppressed_lighting_events());
+}
+
+// This runs BEFORE every test case
+void setUp(void)
+{
+}
+
+// This runs AFTER every test case
+void tearDown(void)
+{
+}
+
+// 1. Test a pool that was never started runs every band on the caller
+void test_unstarted_runs_serially(void)
+{
+    ForkJoin idle;
+    RecordingJob job = {};
+
+    idle.run(&record_band, &job);
+
+    for (size_t band = 0; band < FORK_JOIN_WORKERS; band++)
+    {
+        TEST_ASSERT_EQUAL_UINT32(1, job.runs[band].load());
+        TEST_ASSERT_TRUE(job.threads[band] == std::this_thread::get_id());
+        TEST_ASSERT_EQUAL_UINT32(FORK_JOIN_WORKERS, job.band_count[band]);
+    }
+}
+
+// 2. Test a started pool runs each band once on its own worker and returns only when all are done
+void test_started_runs_bands_on_workers(void)
+{
+    TEST_ASSERT_TRUE(workers.start());
+    TEST_ASSERT_TRUE(workers.is_started());
+
+    for (int round = 0; round < 1000; round++)
+    {
+        RecordingJob job = {};
+        workers.run(&record_band, &job);
+
+        for (size_t band = 0; band < FORK_JOIN_WORKERS; band++)
+        {
+            TEST_ASSERT_EQUAL_UINT32(1, job.runs[band].load());
+            TEST_ASSERT_TRUE(job.threads[band] != std::this_thread::get_id());
+        }
+        TEST_ASSERT_TRUE(job.threads[0] != job.threads[1]);
+    }
+}
+
+// 3. Test band boundaries cover every row exactly once
+void test_band_boundaries(void)
+{
+    TEST_ASSERT_EQUAL_UINT32(0, ForkJoin::band_begin(121, 0, 2));
+    TEST_ASSERT_EQUAL_UINT32(60, ForkJoin::band_begin(121, 1, 2));
+    TEST_ASSERT_EQUAL_UINT32(121, ForkJoin::band_begin(121, 2, 2));
+    TEST_ASSERT_EQUAL_UINT32(1, ForkJoin::band_begin(1, 1, 1));
+}
+
+// 4. Test merging band moments equals accumulating in one pass
+void test_moments_merge(void)
+{
+    MotionMoments whole;
+    MotionMoments top;
+    MotionMoments bottom;
+    const uint32_t pixels[][2] = {{3, 1}, {40, 2}, {7, 30}, {12, 31}, {0, 35}};
+
+    for (const auto& pixel : pixels)
+    {
+        whole.add(pixel[0], pixel[1]);
+        (pixel[1] < 30 ? top : bottom).add(pixel[0], pixel[1]);
+    }
+    MotionMoments merged;
+    merged.merge(top);
+    merged.merge(bottom);
+
+    TEST_ASSERT_EQUAL_UINT32(whole.count, merged.count);
+    TEST_ASSERT_EQUAL_UINT32(whole.sum_x, merged.sum_x);
+    TEST_ASSERT_EQUAL_UINT32(whole.sum_y, merged.sum_y);
+    TEST_ASSERT_EQUAL_UINT16(whole.min_x, merged.min_x);
+    TEST_ASSERT_EQUAL_UINT16(whole.max_x, merged.max_x);
+    TEST_ASSERT_EQUAL_UINT16(whole.min_y, merged.min_y);
+    TEST_ASSERT_EQUAL_UINT16(whole.max_y, merged.max_y);
+}
+
+// 5. Test every differencing mode gives the same result banded as in one pass
+void test_banded_detection_matches_serial(void)
+{
+    TEST_ASSERT_TRUE(workers.start());
+
+    check_mode_matches_serial(DiffMode::PreviousFrame);
+    check_mode_matches_serial(DiffMode::SigmaDelta);
+    check_mode_matches_serial(DiffMode::ThreeFrame);
+    check_mode_matches_serial(DiffMode::Edge);
+}
+
+int main()
+{
+    UNITY_BEGIN();
+
+    RUN_TEST(test_unstarted_runs_serially);
+    RUN_TEST(test_started_runs_bands_on_workers);
+    RUN_TEST(test_band_boundaries);
+    RUN_TEST(test_moments_merge);
+    RUN_TEST(test_banded_detection_matches_serial);
+
+    return UNITY_END();
+}
@@ -0,0 +1,242 @@
+#include <Arduino.h>
+#include <unity.h>
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+#include "camera.h"
+#include "frame_broker.h"
+#include "frame_ref.h"
+
+#define TEST_FRAME_POOL 1024 /**< Never reused within a test, so no frame is rewritten while held. */
+#define TEST_FRAME_PERIOD_MS 1
+#define CONSUMER_WAIT_MS 20
+
+static uint8_t pixels[TEST_FRAME_POOL][64];
+static camera_fb_t frames[TEST_FRAME_POOL];
+static uint32_t next_frame = 0;
+
+/** @brief mock_camera source numbering frames in capture order; runs dry after TEST_FRAME_POOL. */
+static camera_fb_t* capture(void*)
+{
+    if (next_frame >= TEST_FRAME_POOL)
+    {
+        return nullptr;
+    }
+
+    camera_fb_t* frame = &frames[next_frame];
+    frame->buf = pixels[next_frame];
+    frame->len = sizeof(pixels[0]);
+    frame->format = PIXFORMAT_JPEG;
+    frame->timestamp.tv_sec = 0;
+    frame->timestamp.tv_usec = (suseconds_t)next_frame; // Sequence number
+    next_frame++;
+    return frame;
+}
+
+/** @brief capture() at a sensor's pace, for the broker task. */
+static camera_fb_t* capture_paced(void* arg)
+{
+    std::this_thread::sleep_for(std::chrono::milliseconds(TEST_FRAME_PERIOD_MS));
+    return capture(arg);
+}
+
+static uint32_t frames_out() { return mock_camera::state().frames_out.load(); }
+
+static uint32_t sequence(const FrameRef& frame) { return (uint32_t)frame->timestamp.tv_usec; }
+
+// This runs BEFORE every test case
+void setUp(void)
+{
+    next_frame = 0;
+    mock_camera::set_source(&capture, nullptr);
+}
+
+// This runs AFTER every test case
+void tearDown(void)
+{
+    mock_camera::set_source(nullptr, nullptr);
+    TEST_ASSERT_EQUAL_UINT32(0, frames_out());
+    TEST_ASSERT_EQUAL_UINT32(0, FrameRef::frames_in_use());
+}
+
+// 1. Test two subscribers get the same capture without a second camera read
+void test_subscribers_share_capture(void)
+{
+    Camera camera;
+    FrameBroker broker(camera);
+    FrameSubscription* stream = broker.subscribe("stream");
+    FrameSubscription* detector = broker.subscribe("detector");
+    TEST_ASSERT_NOT_NULL(stream);
+    TEST_ASSERT_NOT_NULL(detector);
+    TEST_ASSERT_EQUAL_UINT32(2, broker.subscribers());
+
+    TEST_ASSERT_TRUE(broker.capture_once());
+    TEST_ASSERT_EQUAL_UINT32(1, broker.captured());
+    TEST_ASSERT_EQUAL_UINT32(1, frames_out());
+
+    FrameRef a, b;
+    TEST_ASSERT_TRUE(stream->wait(a, 0));
+    TEST_ASSERT_TRUE(detector->wait(b, 0));
+    TEST_ASSERT_TRUE(a.get() == b.get()); // Same buffer, no copy
+    TEST_ASSERT_EQUAL_UINT32(2, a.use_count());
+
+    a.reset();
+    TEST_ASSERT_EQUAL_UINT32(1, frames_out()); // The detector still holds it
+    b.reset();
+    TEST_ASSERT_EQUAL_UINT32(0, frames_out());
+
+    broker.unsubscribe(stream);
+    broker.unsubscribe(detector);
+}
+
+// 2. Test a slow subscriber only skips its own frames
+void test_slow_subscriber_drops_counted(void)
+{
+    Camera camera;
+    FrameBroker broker(camera);
+    FrameSubscription* slow = broker.subscribe("slow");
+    FrameSubscription* fast = broker.subscribe("fast");
+
+    FrameRef frame;
+    for (uint32_t i = 0; i < 4; i++)
+    {
+        broker.capture_once();
+        TEST_ASSERT_TRUE(fast->wait(frame, 0));
+        TEST_ASSERT_EQUAL_UINT32(i, sequence(frame));
+        frame.reset();
+    }
+    TEST_ASSERT_EQUAL_UINT32(1, frames_out()); // Only the slow subscriber's newest is held
+
+    TEST_ASSERT_TRUE(slow->wait(frame, 0));
+    TEST_ASSERT_EQUAL_UINT32(3, sequence(frame)); // Newest, never a backlog
+    frame.reset();
+    TEST_ASSERT_FALSE(slow->wait(frame, 0));
+
+    TEST_ASSERT_EQUAL_UINT32(3, slow->dropped());
+    TEST_ASSERT_EQUAL_UINT32(1, slow->received());
+    TEST_ASSERT_EQUAL_UINT32(0, fast->dropped());
+    TEST_ASSERT_EQUAL_UINT32(4, fast->received());
+
+    broker.unsubscribe(slow);
+    broker.unsubscribe(fast);
+}
+
+// 3. Test unsubscribe hands back the uncollected frame and a reused slot starts clean
+void test_unsubscribe_returns_frame(void)
+{
+    Camera camera;
+    FrameBroker broker(camera);
+    FrameSubscription* first = broker.subscribe("first");
+    broker.capture_once();
+    broker.capture_once();
+    TEST_ASSERT_EQUAL_UINT32(1, frames_out());
+
+    broker.unsubscribe(first);
+    TEST_ASSERT_EQUAL_UINT32(0, frames_out());
+    TEST_ASSERT_EQUAL_UINT32(0, broker.subscribers());
+    TEST_ASSERT_TRUE(broker.capture_once()); // Nobody listening: the frame goes straight back
+    TEST_ASSERT_EQUAL_UINT32(0, frames_out());
+
+    FrameSubscription* second = broker.subscribe("second");
+    FrameRef frame;
+    TEST_ASSERT_FALSE(second->wait(frame, 0));
+    TEST_ASSERT_EQUAL_UINT32(0, second->dropped());
+    TEST_ASSERT_EQUAL_STRING("second", second->name());
+    broker.unsubscribe(second);
+    broker.unsubscribe(nullptr);
+}
+
+// 4. Test the broker refuses subscribers beyond its slots
+void test_subscriber_limit(void)
+{
+    Camera camera;
+    FrameBroker broker(camera);
+    FrameSubscription* subscriptions[FRAME_BROKER_MAX_SUBSCRIBERS];
+    for (int i = 0; i < FRAME_BROKER_MAX_SUBSCRIBERS; i++)
+    {
+        subscriptions[i] = broker.subscribe("stream");
+        TEST_ASSERT_NOT_NULL(subscriptions[i]);
+    }
+    TEST_ASSERT_NULL(broker.subscribe("stream"));
+
+    broker.unsubscribe(subscriptions[0]);
+    subscriptions[0] = broker.subscribe("stream");
+    TEST_ASSERT_NOT_NULL(subscriptions[0]);
+
+    for (FrameSubscription* subscription : subscriptions)
+    {
+        broker.unsubscribe(subscription);
+    }
+}
+
+// 5. Test the broker task feeding consumers that come and go returns every frame
+void test_task_with_consumers(void)
+{
+    mock_camera::set_source(&capture_paced, nullptr);
+    Camera camera;
+    FrameBroker broker(camera);
+    std::atomic<bool> done{false};
+    std::atomic<uint32_t> collected{0};
+    std::atomic<bool> ordered{true};
+
+    auto consumer = [&](const char* name, int work_ms) {
+        while (!done.load())
+        {
+            // Reconnect now and then, as a browser tab would
+            FrameSubscription* subscription = broker.subscribe(name);
+            if (!subscription)
+            {
+                ordered = false;
+                return;
+            }
+            uint32_t last = 0;
+            bool first = true;
+            for (int i = 0; i < 10 && !done.load(); i++)
+            {
+                FrameRef frame;
+                if (subscription->wait(frame, pdMS_TO_TICKS(CONSUMER_WAIT_MS)))
+                {
+                    if (!first && sequence(frame) <= last)
+                    {
+                        ordered = false;
+                    }
+                    first = false;
+                    last = sequence(frame);
+                    collected++;
+                    std::this_thread::sleep_for(std::chrono::milliseconds(work_ms));
+                }
+            }
+            broker.unsubscribe(subscription);
+        }
+    };
+
+    TEST_ASSERT_TRUE(broker.start());
+    std::thread stream(consumer, "stream", 3);
+    std::thread detector(consumer, "detector", 0);
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+    done = true;
+    stream.join();
+    detector.join();
+    broker.stop();
+    TEST_ASSERT_FALSE(broker.is_running());
+
+    Serial.printf("[BROKER] captured %u, collected %u\n", (unsigned)broker.captured(), (unsigned)collected.load());
+    TEST_ASSERT_TRUE(collected.load() > 0);
+    TEST_ASSERT_TRUE(ordered.load());
+    TEST_ASSERT_EQUAL_UINT32(0, broker.subscribers());
+}
+
+int main()
+{
+    UNITY_BEGIN();
+
+    RUN_TEST(test_subscribers_share_capture);
+    RUN_TEST(test_slow_subscriber_drops_counted);
+    RUN_TEST(test_unsubscribe_returns_frame);
+    RUN_TEST(test_subscriber_limit);
+    RUN_TEST(test_task_with_consumers);
+
+    return UNITY_END();
+}
@@ -0,0 +1,162 @@
+#include <Arduino.h>
+#include <unity.h>
+
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "camera.h"
+#include "frame_context.h"
+#include "frame_ref.h"
+
+#define STRESS_THREADS 4
+#define STRESS_ROUNDS 20000
+
+static uint8_t pixels[16 * 8];
+static camera_fb_t frames[FRAME_REF_POOL_SIZE + 1];
+static size_t next_frame = 0;
+
+/** @brief mock_camera source cycling through the static frames. */
+static camera_fb_t* capture(void*)
+{
+    camera_fb_t* frame = &frames[next_frame++ % (FRAME_REF_POOL_SIZE + 1)];
+    frame->buf = pixels;
+    frame->len = sizeof(pixels);
+    frame->width = 16;
+    frame->height = 8;
+    frame->format = PIXFORMAT_GRAYSCALE;
+    return frame;
+}
+
+static uint32_t frames_out() { return mock_camera::state().frames_out.load(); }
+
+// This runs BEFORE every test case
+void setUp(void)
+{
+    mock_camera::set_source(&capture, nullptr);
+}
+
+// This runs AFTER every test case
+void tearDown(void)
+{
+    mock_camera::set_source(nullptr, nullptr);
+    TEST_ASSERT_EQUAL_UINT32(0, frames_out());
+    TEST_ASSERT_EQUAL_UINT32(0, FrameRef::frames_in_use());
+}
+
+// 1. Test the frame goes back to the driver only when the last copy is dropped
+void test_last_copy_returns_frame(void)
+{
+    Camera camera;
+    FrameRef first = camera.capture_ref();
+    TEST_ASSERT_TRUE((bool)first);
+    TEST_ASSERT_EQUAL_UINT32(1, first.use_count());
+
+    {
+        FrameRef stream = first;
+        FrameRef recorder;
+        recorder = stream;
+        TEST_ASSERT_EQUAL_UINT32(3, first.use_count());
+        TEST_ASSERT_TRUE(stream.get() == first.get()); // Same buffer, no copy
+    }
+    TEST_ASSERT_EQUAL_UINT32(1, first.use_count());
+    TEST_ASSERT_EQUAL_UINT32(1, frames_out());
+
+    first.reset();
+    TEST_ASSERT_FALSE((bool)first);
+    TEST_ASSERT_EQUAL_UINT32(0, frames_out());
+}
+
+// 2. Test moves transfer the reference without touching the count
+void test_move_transfers_reference(void)
+{
+    FrameRef source = FrameRef::adopt(esp_camera_fb_get());
+    camera_fb_t* frame = source.get();
+
+    FrameRef moved(std::move(source));
+    TEST_ASSERT_FALSE((bool)source);
+    TEST_ASSERT_TRUE(moved.get() == frame);
+    TEST_ASSERT_EQUAL_UINT32(1, moved.use_count());
+
+    FrameRef other = FrameRef::adopt(esp_camera_fb_get());
+    other = std::move(moved); // Drops other's frame
+    TEST_ASSERT_EQUAL_UINT32(1, frames_out());
+    TEST_ASSERT_TRUE(other.get() == frame);
+}
+
+// 3. Test an exhausted pool hands the frame straight back instead of leaking it
+void test_pool_exhaustion_returns_frame(void)
+{
+    std::vector<FrameRef> held;
+    for (int i = 0; i < FRAME_REF_POOL_SIZE; i++)
+    {
+        held.push_back(FrameRef::adopt(esp_camera_fb_get()));
+        TEST_ASSERT_TRUE((bool)held.back());
+    }
+    TEST_ASSERT_EQUAL_UINT32(FRAME_REF_POOL_SIZE, FrameRef::frames_in_use());
+
+    FrameRef overflow = FrameRef::adopt(esp_camera_fb_get());
+    TEST_ASSERT_FALSE((bool)overflow);
+    TEST_ASSERT_EQUAL_UINT32(FRAME_REF_POOL_SIZE, frames_out());
+
+    held.clear();
+    TEST_ASSERT_TRUE((bool)FrameRef::adopt(esp_camera_fb_get())); // Blocks are reused
+}
+
+// 4. Test a FrameContext keeps a shared frame alive until release()
+void test_frame_context_holds_reference(void)
+{
+    FrameArena arena;
+    FrameContext context(arena);
+    FrameRef frame = FrameRef::adopt(esp_camera_fb_get());
+
+    TEST_ASSERT_TRUE(context.attach(frame));
+    frame.reset();
+    TEST_ASSERT_EQUAL_UINT32(1, frames_out());
+    TEST_ASSERT_NOT_NULL(context.greyscale());
+
+    context.release();
+    TEST_ASSERT_EQUAL_UINT32(0, frames_out());
+}
+
+// 5. Test copies and drops racing on several threads return every frame exactly once
+void test_concurrent_copies(void)
+{
+    for (int round = 0; round < 200; round++)
+    {
+        FrameRef shared = FrameRef::adopt(esp_camera_fb_get());
+        std::vector<std::thread> threads;
+        for (int t = 0; t < STRESS_THREADS; t++)
+        {
+            FrameRef copy = shared; // Handed over by value, as subscribers would get it
+            threads.emplace_back([copy]() mutable {
+                for (int i = 0; i < STRESS_ROUNDS / 200; i++)
+                {
+                    FrameRef local = copy;
+                    local.reset();
+                }
+                copy.reset();
+            });
+        }
+        shared.reset();
+
+        for (std::thread& thread : threads)
+        {
+            thread.join();
+        }
+        TEST_ASSERT_EQUAL_UINT32(0, frames_out());
+    }
+}
+
+int main()
+{
+    UNITY_BEGIN();
+
+    RUN_TEST(test_last_copy_returns_frame);
+    RUN_TEST(test_move_transfers_reference);
+    RUN_TEST(test_pool_exhaustion_returns_frame);
+    RUN_TEST(test_frame_context_holds_reference);
+    RUN_TEST(test_concurrent_copies);
+
+    return UNITY_END();
+}
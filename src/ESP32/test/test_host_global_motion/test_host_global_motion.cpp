@@ -0,0 +1,121 @@
+#include <Arduino.h>
+#include <math.h>
+#include <unity.h>
+
+#include "detection_result.h"
+#include "global_motion.h"
+
+#define WIDTH 160
+#define HEIGHT 120
+
+static uint8_t reference[WIDTH * HEIGHT];
+static uint8_t shifted[WIDTH * HEIGHT];
+GlobalMotionEstimator* estimator;
+
+/** @brief Smooth, non-repeating texture sampled at (x, y) minus a sub-pixel shift. */
+static void render(uint8_t* luma, float dx, float dy, int brightness)
+{
+    for (int y = 0; y < HEIGHT; y++)
+    {
+        for (int x = 0; x < WIDTH; x++)
+        {
+            float u = x - dx;
+            float v = y - dy;
+            float value = 110.0f + 40.0f * sinf(u * 0.11f) + 25.0f * sinf(u * 0.047f + 1.0f) +
+                          35.0f * sinf(v * 0.13f + 0.5f) + 20.0f * sinf(v * 0.053f + u * 0.02f);
+            luma[y * WIDTH + x] = (uint8_t)constrain((int)lroundf(value) + brightness, 0, 255);
+        }
+    }
+}
+
+// This runs BEFORE every test case
+void setUp(void)
+{
+    estimator = new GlobalMotionEstimator();
+}
+
+// This runs AFTER every test case
+void tearDown(void)
+{
+    delete estimator;
+}
+
+// 1. Test a known sub-pixel translation is recovered on both axes
+void test_subpixel_shift(void)
+{
+    render(reference, 0.0f, 0.0f, 0);
+    TEST_ASSERT_TRUE(estimator->set_reference(reference, WIDTH, HEIGHT));
+
+    render(shifted, -12.25f, 7.5f, 0);
+    GlobalShift shift = estimator->estimate(shifted, WIDTH, HEIGHT, 32);
+
+    TEST_ASSERT_TRUE(shift.valid);
+    TEST_ASSERT_INT32_WITHIN(4, -196, shift.dx_q4); // -12.25 px
+    TEST_ASSERT_INT32_WITHIN(4, 120, shift.dy_q4);  // 7.5 px
+}
+
+// 2. Test an unchanged frame measures zero
+void test_no_motion(void)
+{
+    render(reference, 0.0f, 0.0f, 0);
+    TEST_ASSERT_TRUE(estimator->set_reference(reference, WIDTH, HEIGHT));
+
+    GlobalShift shift = estimator->estimate(reference, WIDTH, HEIGHT, 32);
+    TEST_ASSERT_TRUE(shift.valid);
+    TEST_ASSERT_EQUAL_INT32(0, shift.dx_q4);
+    TEST_ASSERT_EQUAL_INT32(0, shift.dy_q4);
+}
+
+// 3. Test a flat scene is refused instead of reporting a shift
+void test_flat_scene_invalid(void)
+{
+    memset(reference, 90, sizeof(reference));
+    TEST_ASSERT_FALSE(estimator->set_reference(reference, WIDTH, HEIGHT));
+    TEST_ASSERT_FALSE(estimator->estimate(reference, WIDTH, HEIGHT, 32).valid);
+}
+
+// 4. Test an exposure change between the frames does not bias the estimate
+void test_brightness_offset(void)
+{
+    render(reference, 0.0f, 0.0f, 0);
+    TEST_ASSERT_TRUE(estimator->set_reference(reference, WIDTH, HEIGHT));
+
+    render(shifted, 5.0f, -3.0f, 25);
+    GlobalShift shift = estimator->estimate(shifted, WIDTH, HEIGHT, 32);
+
+    TEST_ASSERT_TRUE(shift.valid);
+    TEST_ASSERT_INT32_WITHIN(4, 80, shift.dx_q4);
+    TEST_ASSERT_INT32_WITHIN(4, -48, shift.dy_q4);
+}
+
+// 5. Test a shift beyond the search range is reported invalid, not clipped
+void test_out_of_range_invalid(void)
+{
+    render(reference, 0.0f, 0.0f, 0);
+    TEST_ASSERT_TRUE(estimator->set_reference(reference, WIDTH, HEIGHT));
+
+    render(shifted, 20.0f, 0.0f, 0);
+    TEST_ASSERT_FALSE(estimator->estimate(shifted, WIDTH, HEIGHT, 8).valid);
+}
+
+// 6. Test a frame of another size is not compared with the reference
+void test_geometry_mismatch(void)
+{
+    render(reference, 0.0f, 0.0f, 0);
+    TEST_ASSERT_TRUE(estimator->set_reference(reference, WIDTH, HEIGHT));
+    TEST_ASSERT_FALSE(estimator->estimate(reference, WIDTH / 2, HEIGHT, 32).valid);
+}
+
+int main()
+{
+    UNITY_BEGIN();
+
+    RUN_TEST(test_subpixel_shift);
+    RUN_TEST(test_no_motion);
+    RUN_TEST(test_flat_scene_invalid);
+    RUN_TEST(test_brightness_offset);
+    RUN_TEST(test_out_of_range_invalid);
+    RUN_TEST(test_geometry_mismatch);
+
+    return UNITY_END();
+}
@@ -0,0 +1,118 @@
+#include <Arduino.h>
+#include <unity.h>
+
+#include "constants.h"
+#include "joystick.h"
+
+#define REST 1900 /**< Raw reading of a centered stick; not mid-scale, like a real HW-504. */
+
+Joystick* joystick;
+
+/** @brief Puts both axes at raw @p x, @p y. */
+static void set_stick(int x, int y)
+{
+    mock_arduino::analog_values()[JOYSTICK_PIN_X] = x;
+    mock_arduino::analog_values()[JOYSTICK_PIN_Y] = y;
+}
+
+/** @brief Lets the sampler run for @p samples periods. */
+static void run_samples(int samples)
+{
+    delayMicroseconds(samples * JOYSTICK_SAMPLE_PERIOD_US);
+}
+
+// This runs BEFORE every test case
+void setUp(void)
+{
+    set_stick(REST, REST);
+    joystick = new Joystick(JOYSTICK_PIN_X, JOYSTICK_PIN_Y, JOYSTICK_PIN_Z);
+    TEST_ASSERT_TRUE(joystick->begin());
+}
+
+// This runs AFTER every test case
+void tearDown(void)
+{
+    delete joystick;
+}
+
+// 1. Test a stick at rest reads centered and inactive
+void test_rest_is_centered(void)
+{
+    run_samples(10);
+    TEST_ASSERT_EQUAL_INT(0, joystick->get_x());
+    TEST_ASSERT_EQUAL_INT(0, joystick->get_y());
+    TEST_ASSERT_EQUAL_INT(0, joystick->get_speed_x());
+    TEST_ASSERT_FALSE(joystick->is_active());
+}
+
+// 2. Test the getters only read the sampler's latest value, never the ADC
+void test_getters_do_not_sample(void)
+{
+    set_stick(REST + 2000, REST - 1500);
+    TEST_ASSERT_EQUAL_INT(0, joystick->get_x()); // No sample taken yet
+    TEST_ASSERT_FALSE(joystick->is_active());
+
+    run_samples(60);
+    TEST_ASSERT_INT_WITHIN(8, 2000, joystick->get_x());
+    TEST_ASSERT_INT_WITHIN(8, -1500, joystick->get_y());
+    TEST_ASSERT_TRUE(joystick->is_active());
+}
+
+// 3. Test a step settles like a first-order filter with weight 1/2^JOYSTICK_FILTER_SHIFT
+void test_step_response(void)
+{
+    set_stick(REST + 1600, REST);
+
+    // After n samples the output has covered 1 - (3/4)^n of the step: 68% after 4
+    run_samples(4);
+    TEST_ASSERT_INT_WITHIN(40, 1090, joystick->get_x());
+
+    // Monotonic approach without overshoot
+    int previous = joystick->get_x();
+    for (int i = 0; i < 40; i++)
+    {
+        run_samples(1);
+        TEST_ASSERT_TRUE(joystick->get_x() >= previous);
+        TEST_ASSERT_TRUE(joystick->get_x() <= 1600);
+        previous = joystick->get_x();
+    }
+    TEST_ASSERT_INT_WITHIN(8, 1600, previous);
+}
+
+// 4. Test sample-to-sample ADC noise is smoothed away inside the deadzone
+void test_noise_is_filtered(void)
+{
+    for (int i = 0; i < 200; i++)
+    {
+        int noise = (i & 1) ? 400 : -400;
+        set_stick(REST + noise, REST - noise);
+        run_samples(1);
+        TEST_ASSERT_EQUAL_INT(0, joystick->get_x());
+        TEST_ASSERT_EQUAL_INT(0, joystick->get_y());
+    }
+}
+
+// 5. Test a destroyed joystick's sampler no longer runs
+void test_destroy_stops_sampler(void)
+{
+    delete joystick;
+    set_stick(0, 0);
+    run_samples(10); // Would write into freed memory if still armed
+
+    joystick = new Joystick(JOYSTICK_PIN_X, JOYSTICK_PIN_Y, JOYSTICK_PIN_Z);
+    TEST_ASSERT_EQUAL_INT(0, joystick->get_x()); // Not started: reads centered
+    TEST_ASSERT_FALSE(joystick->is_active());
+}
+
+int main()
+{
+    UNITY_BEGIN();
+
+    RUN_TEST(test_rest_is_centered);
+    RUN_TEST(test_getters_do_not_sample);
+    RUN_TEST(test_step_response);
+    RUN_TEST(test_noise_is_filtered);
+    RUN_TEST(test_destroy_stops_sampler);
+
+    return UNITY_END();
+}
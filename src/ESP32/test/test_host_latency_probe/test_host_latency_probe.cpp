@@ -0,0 +1,187 @@
+#include <Arduino.h>
+#include <unity.h>
+
+#include <string.h>
+#include <thread>
+#include <vector>
+
+#include "camera_diff_detection.h"
+#include "frame_context.h"
+#include "latency_probe.h"
+
+#define STRESS_THREADS 4
+#define STRESS_SAMPLES 20000
+
+#define TEST_FRAME_WIDTH 32
+#define TEST_FRAME_HEIGHT 24
+
+/** @brief Count of @p stage's histogram. */
+static uint32_t samples(LatencyStage stage) { return latency_histogram(stage).count(); }
+
+// This runs BEFORE every test case
+void setUp(void)
+{
+    latency_reset();
+}
+
+// This runs AFTER every test case
+void tearDown(void)
+{
+}
+
+// 1. Test samples land in the power-of-two bucket they belong to
+void test_bucket_boundaries(void)
+{
+    TEST_ASSERT_EQUAL_UINT32(0, LatencyHistogram::bucket_of(0));
+    TEST_ASSERT_EQUAL_UINT32(1, LatencyHistogram::bucket_of(1));
+    TEST_ASSERT_EQUAL_UINT32(2, LatencyHistogram::bucket_of(2));
+    TEST_ASSERT_EQUAL_UINT32(2, LatencyHistogram::bucket_of(3));
+    TEST_ASSERT_EQUAL_UINT32(11, LatencyHistogram::bucket_of(1024));
+    TEST_ASSERT_EQUAL_UINT32(11, LatencyHistogram::bucket_of(2047));
+    TEST_ASSERT_EQUAL_UINT32(LATENCY_BUCKETS - 1, LatencyHistogram::bucket_of(UINT32_MAX)); // Clamped
+
+    for (size_t bucket = 1; bucket < LATENCY_BUCKETS; bucket++)
+    {
+        TEST_ASSERT_EQUAL_UINT32(bucket, LatencyHistogram::bucket_of(LatencyHistogram::bucket_floor(bucket)));
+    }
+}
+
+// 2. Test min, max and the percentile estimates on a known distribution
+void test_percentiles(void)
+{
+    LatencyHistogram histogram;
+    TEST_ASSERT_EQUAL_UINT32(0, histogram.percentile_us(50));
+    TEST_ASSERT_EQUAL_UINT32(0, histogram.min_us());
+
+    // 1 ms typical with a 1 % tail at 20 ms, like a detector that sometimes stalls
+    for (int i = 0; i < 990; i++)
+    {
+        histogram.record(900 + (i % 200));
+    }
+    for (int i = 0; i < 10; i++)
+    {
+        histogram.record(20000);
+    }
+
+    TEST_ASSERT_EQUAL_UINT32(1000, histogram.count());
+    TEST_ASSERT_EQUAL_UINT32(900, histogram.min_us());
+    TEST_ASSERT_EQUAL_UINT32(20000, histogram.max_us());
+
+    uint32_t p50 = histogram.percentile_us(50);
+    uint32_t p99 = histogram.percentile_us(99);
+    uint32_t p100 = histogram.percentile_us(100);
+    TEST_ASSERT_TRUE(p50 >= 900 && p50 < 2048); // Right power of two
+    TEST_ASSERT_TRUE(p99 <= 2048);              // The tail starts just above p99
+    TEST_ASSERT_EQUAL_UINT32(20000, p100);      // Clamped to the largest sample
+    TEST_ASSERT_TRUE(p50 <= p99);
+
+    histogram.reset();
+    TEST_ASSERT_EQUAL_UINT32(0, histogram.count());
+    TEST_ASSERT_EQUAL_UINT32(0, histogram.max_us());
+}
+
+// 3. Test a probe records the time its scope was open
+void test_probe_times_scope(void)
+{
+    {
+        LATENCY_PROBE(Control);
+        delay(3); // Virtual clock
+    }
+    {
+        LATENCY_PROBE(Control);
+        delayMicroseconds(250);
+    }
+
+    const LatencyHistogram& control = latency_histogram(LatencyStage::Control);
+    TEST_ASSERT_EQUAL_UINT32(2, control.count());
+    TEST_ASSERT_EQUAL_UINT32(250, control.min_us());
+    TEST_ASSERT_EQUAL_UINT32(3000, control.max_us());
+    TEST_ASSERT_EQUAL_UINT32(0, samples(LatencyStage::Kernel));
+}
+
+// 4. Test the probes in the detection path fire once per frame
+void test_detection_path_probed(void)
+{
+    static uint16_t pixels[TEST_FRAME_WIDTH * TEST_FRAME_HEIGHT];
+    camera_fb_t frame = camera_fb_t();
+    frame.buf = (uint8_t*)pixels;
+    frame.len = sizeof(pixels);
+    frame.width = TEST_FRAME_WIDTH;
+    frame.height = TEST_FRAME_HEIGHT;
+    frame.format = PIXFORMAT_RGB565;
+
+    CameraDiffDetection detector(DiffMode::PreviousFrame);
+    FrameArena arena;
+    FrameContext context(arena);
+    for (int i = 0; i < 3; i++)
+    {
+        pixels[i] = 0xFFFF; // Something moves each frame
+        context.attach(&frame);
+        detector.detect(context);
+        context.release();
+    }
+
+    TEST_ASSERT_EQUAL_UINT32(3, samples(LatencyStage::Greyscale));
+    TEST_ASSERT_EQUAL_UINT32(2, samples(LatencyStage::Kernel)); // The first frame only primes the history
+    TEST_ASSERT_EQUAL_UINT32(3, samples(LatencyStage::Centroid));
+    TEST_ASSERT_EQUAL_UINT32(0, samples(LatencyStage::Decode)); // Not JPEG
+}
+
+// 5. Test records from several threads at once are all counted
+void test_concurrent_records(void)
+{
+    std::vector<std::thread> threads;
+    for (int t = 0; t < STRESS_THREADS; t++)
+    {
+        threads.emplace_back([t]() {
+            for (int i = 0; i < STRESS_SAMPLES; i++)
+            {
+                latency_histogram(LatencyStage::Actuation).record((uint32_t)(t * STRESS_SAMPLES + i + 1));
+            }
+        });
+    }
+    for (std::thread& thread : threads)
+    {
+        thread.join();
+    }
+
+    const LatencyHistogram& actuation = latency_histogram(LatencyStage::Actuation);
+    TEST_ASSERT_EQUAL_UINT32(STRESS_THREADS * STRESS_SAMPLES, actuation.count());
+    TEST_ASSERT_EQUAL_UINT32(1, actuation.min_us());
+    TEST_ASSERT_EQUAL_UINT32(STRESS_THREADS * STRESS_SAMPLES, actuation.max_us());
+}
+
+// 6. Test the report lists every stage and stays inside a short buffer
+void test_report(void)
+{
+    latency_histogram(LatencyStage::Capture).record(33000);
+
+    char report[LATENCY_REPORT_SIZE];
+    size_t length = latency_report(report, sizeof(report));
+    TEST_ASSERT_EQUAL_UINT32(strlen(report), length);
+    for (size_t stage = 0; stage < (size_t)LatencyStage::Count; stage++)
+    {
+        TEST_ASSERT_NOT_NULL(strstr(report, latency_stage_name((LatencyStage)stage)));
+    }
+    TEST_ASSERT_NOT_NULL(strstr(report, "33000"));
+
+    char small[40];
+    memset(small, 'x', sizeof(small));
+    length = latency_report(small, sizeof(small));
+    TEST_ASSERT_EQUAL_UINT32(sizeof(small) - 1, length);
+    TEST_ASSERT_TRUE(small[sizeof(small) - 1] == '\0');
+}
+
+int main()
+{
+    UNITY_BEGIN();
+
+    RUN_TEST(test_bucket_boundaries);
+    RUN_TEST(test_percentiles);
+    RUN_TEST(test_probe_times_scope);
+    RUN_TEST(test_detection_path_probed);
+    RUN_TEST(test_concurrent_records);
+    RUN_TEST(test_report);
+
+    return UNITY_END();
+}
@@ -0,0 +1,220 @@
+#include <Arduino.h>
+#include <unity.h>
+
+#include "constants.h"
+#include "controller.h"
+#include "loop_budget.h"
+
+#define TEST_FRAME_WIDTH 160
+#define TEST_FRAME_HEIGHT 120
+
+/** @brief Detector that spends a set amount of virtual time and always reports a target. */
+class TimedDetector : public BaseDetectionModule
+{
+public:
+    uint32_t work_ms = 0;
+    uint32_t calls = 0;
+
+    std::tuple<MoveDirectionX, MoveDirectionY> detect_object(camera_fb_t*) override
+    {
+        return std::make_tuple(MoveDirectionX::None, MoveDirectionY::None);
+    }
+
+    DetectionResult detect(FrameContext&) override
+    {
+        this->calls++;
+        delay(this->work_ms);
+
+        DetectionResult result;
+        result.error_x = 20 << DETECTION_SUBPIXEL_BITS;
+        result.confidence = 255;
+        result.frame_width = TEST_FRAME_WIDTH;
+        result.frame_height = TEST_FRAME_HEIGHT;
+        return result;
+    }
+};
+
+/** @brief Movement manager that counts absolute moves, i.e. control updates. */
+class CountingMovementManager : public BaseMovementManager
+{
+public:
+    uint32_t moves = 0;
+
+    void move_relative(std::tuple<MoveDirectionX, MoveDirectionY>) override {}
+    void move_by(int32_t, int32_t) override {}
+    void move_absolute(int32_t, int32_t) override { this->moves++; }
+    int32_t get_pan_position() override { return 0; }
+    int32_t get_tilt_centidegrees() override { return 0; }
+};
+
+/** @brief Optional work that spends a set amount of virtual time. */
+struct TimedWork {
+    uint32_t work_ms = 0;
+    uint32_t calls = 0;
+
+    static void run(void* arg)
+    {
+        TimedWork* work = static_cast<TimedWork*>(arg);
+        work->calls++;
+        delay(work->work_ms);
+    }
+};
+
+/** @brief A Controller with everything it drives. */
+struct Fixture {
+    TimedDetector detector;
+    CountingMovementManager motors;
+    Joystick joystick;
+    Controller controller;
+    TimedWork telemetry;
+
+    Fixture() : joystick(JOYSTICK_PIN_X, JOYSTICK_PIN_Y, JOYSTICK_PIN_Z), controller(motors, detector, joystick)
+    {
+        this->controller.set_optional_work(&TimedWork::run, &this->telemetry);
+    }
+
+    /** @brief Runs @p iterations of the loop, with @p idle_ms of other loop() work after each. */
+    void run(uint32_t iterations, uint32_t idle_ms = 0)
+    {
+        for (uint32_t i = 0; i < iterations; i++)
+        {
+            this->controller.run();
+            delay(idle_ms);
+        }
+    }
+};
+
+// This runs BEFORE every test case
+void setUp(void)
+{
+    mock_arduino::pin_levels()[JOYSTICK_PIN_Z] = HIGH; // Button released: stay in AI mode
+}
+
+// This runs AFTER every test case
+void tearDown(void)
+{
+}
+
+// 1. Test a loop within budget detects every iteration and never defers anything
+void test_within_budget_runs_everything(void)
+{
+    Fixture fixture;
+    fixture.detector.work_ms = 20;
+    fixture.telemetry.work_ms = 5;
+
+    fixture.run(50, 5);
+
+    LoopStats stats = fixture.controller.loop_stats();
+    TEST_ASSERT_EQUAL_UINT32(50, stats.iterations);
+    TEST_ASSERT_EQUAL_UINT32(0, stats.deadline_misses);
+    TEST_ASSERT_EQUAL_UINT32(1, stats.detect_divider);
+    TEST_ASSERT_EQUAL_UINT32(0, stats.detections_skipped);
+    TEST_ASSERT_EQUAL_UINT32(0, stats.optional_deferred);
+    TEST_ASSERT_EQUAL_UINT32(50, fixture.detector.calls);
+    TEST_ASSERT_EQUAL_UINT32(50, fixture.telemetry.calls);
+    TEST_ASSERT_UINT32_WITHIN(500, LOOP_BUDGET_US, stats.period_us); // 30 ms of work, the rest slept off
+    TEST_ASSERT_UINT32_WITHIN(500, 20000, stats.stage_us[(size_t)LoopStage::Detect]);
+}
+
+// 2. Test optional work waits for an iteration with room before detection is touched
+void test_optional_work_deferred_first(void)
+{
+    Fixture fixture;
+    fixture.detector.work_ms = 40;
+    fixture.telemetry.work_ms = 15;
+
+    fixture.run(40);
+
+    LoopStats stats = fixture.controller.loop_stats();
+    TEST_ASSERT_EQUAL_UINT32(1, stats.detect_divider); // Detection alone still fits
+    TEST_ASSERT_EQUAL_UINT32(40, fixture.detector.calls);
+    TEST_ASSERT_TRUE(stats.optional_deferred > 30);
+    TEST_ASSERT_TRUE(stats.deadline_misses <= 1); // Only the run that measured the telemetry
+}
+
+// 3. Test a detector slower than the budget is spread out while the loop keeps its period
+void test_slow_detection_rate_lowered(void)
+{
+    Fixture fixture;
+    fixture.detector.work_ms = 120;
+    fixture.telemetry.work_ms = 1;
+
+    int64_t start_us = esp_timer_get_time();
+    fixture.run(60);
+    int64_t elapsed_us = esp_timer_get_time() - start_us;
+
+    LoopStats stats = fixture.controller.loop_stats();
+    TEST_ASSERT_EQUAL_UINT32(3, stats.detect_divider); // ceil(120 ms / 50 ms)
+    TEST_ASSERT_UINT32_WITHIN(1500, LOOP_BUDGET_US, stats.period_us);
+    TEST_ASSERT_UINT32_WITHIN(LOOP_BUDGET_US, 60 * LOOP_BUDGET_US, (uint32_t)elapsed_us); // 20 Hz joystick polling
+    TEST_ASSERT_UINT32_WITHIN(1, 60 / 3, fixture.detector.calls); // One detection per three periods: 6.7 Hz
+    TEST_ASSERT_EQUAL_UINT32(fixture.detector.calls, fixture.motors.moves); // Every detection acted on
+    TEST_ASSERT_EQUAL_UINT32(fixture.detector.calls, stats.deadline_misses); // Only detecting iterations overrun
+    TEST_ASSERT_TRUE(fixture.telemetry.calls > 15); // Once the schedule is met again after each detection
+}
+
+// 4. Test an iteration with little to do sleeps off its period instead of starting the next one early
+void test_short_iterations_paced(void)
+{
+    Fixture fixture;
+    fixture.detector.work_ms = 2;
+
+    int64_t start_us = esp_timer_get_time();
+    fixture.run(20);
+    int64_t elapsed_us = esp_timer_get_time() - start_us;
+
+    LoopStats stats = fixture.controller.loop_stats();
+    TEST_ASSERT_EQUAL_UINT32(20, fixture.detector.calls);
+    TEST_ASSERT_EQUAL_UINT32(LOOP_BUDGET_US, stats.period_us);
+    TEST_ASSERT_EQUAL_UINT32(20 * LOOP_BUDGET_US, (uint32_t)elapsed_us);
+}
+
+// 5. Test the detection rate comes back once detection is cheap again
+void test_detection_rate_recovers(void)
+{
+    Fixture fixture;
+    fixture.detector.work_ms = 500;
+    fixture.run(40);
+    TEST_ASSERT_EQUAL_UINT32(LOOP_BUDGET_MAX_DETECT_DIVIDER, fixture.controller.loop_stats().detect_divider);
+
+    fixture.detector.work_ms = 10;
+    fixture.run(200);
+
+    LoopStats stats = fixture.controller.loop_stats();
+    TEST_ASSERT_EQUAL_UINT32(1, stats.detect_divider);
+    TEST_ASSERT_UINT32_WITHIN(1000, 500000, stats.worst_us); // The slow phase, remembered
+}
+
+// 6. Test USER mode never detects and keeps the loop short
+void test_user_mode_skips_detection(void)
+{
+    Fixture fixture;
+    fixture.detector.work_ms = 30;
+    fixture.controller.poll_input(); // Latch the released button
+    mock_arduino::pin_levels()[JOYSTICK_PIN_Z] = LOW;
+    fixture.controller.poll_input();
+    delay(BUTTON_DEBOUNCE_MS + 1);
+    fixture.controller.poll_input();
+    TEST_ASSERT_TRUE(fixture.controller.mode() == SystemControl::USER_MODE);
+
+    fixture.run(20, 10);
+
+    LoopStats stats = fixture.controller.loop_stats();
+    TEST_ASSERT_EQUAL_UINT32(0, fixture.detector.calls);
+    TEST_ASSERT_EQUAL_UINT32(0, stats.deadline_misses);
+    TEST_ASSERT_EQUAL_UINT32(20, fixture.telemetry.calls);
+}
+
+int main()
+{
+    UNITY_BEGIN();
+
+    RUN_TEST(test_within_budget_runs_everything);
+    RUN_TEST(test_optional_work_deferred_first);
+    RUN_TEST(test_slow_detection_rate_lowered);
+    RUN_TEST(test_short_iterations_paced);
+    RUN_TEST(test_detection_rate_recovers);
+    RUN_TEST(test_user_mode_skips_detection);
+
+    return UNITY_END();
+}
@@ -0,0 +1,219 @@
+#include <Arduino.h>
+#include <unity.h>
+
+#include "constants.h"
+#include "controller.h"
+#include "expo_curve.h"
+
+#define REST 1900 /**< Raw reading of a centered stick; the ADC reads 0 to 4095 around it. */
+
+/** @brief Detector that never sees anything; USER mode does not call it anyway. */
+class NullDetector : public BaseDetectionModule
+{
+public:
+    std::tuple<MoveDirectionX, MoveDirectionY> detect_object(camera_fb_t*) override
+    {
+        return std::make_tuple(MoveDirectionX::None, MoveDirectionY::None);
+    }
+
+    DetectionResult detect(FrameContext&) override { return DetectionResult(); }
+};
+
+/** @brief Movement manager with speed control that records the rates it was given. */
+class VelocityRecorder : public BaseMovementManager
+{
+public:
+    uint32_t velocity_calls = 0;
+    int32_t pan_rate = 0;
+    int32_t tilt_rate = 0;
+
+    void move_relative(std::tuple<MoveDirectionX, MoveDirectionY>) override {}
+    void move_by(int32_t, int32_t) override {}
+    void move_absolute(int32_t, int32_t) override {}
+    void move_velocity(int32_t pan_steps_per_s, int32_t tilt_centidegrees_per_s) override
+    {
+        this->velocity_calls++;
+        this->pan_rate = pan_steps_per_s;
+        this->tilt_rate = tilt_centidegrees_per_s;
+    }
+    int32_t get_pan_position() override { return 0; }
+    int32_t get_tilt_centidegrees() override { return 0; }
+};
+
+/** @brief Movement manager without speed control; only counts nudges to the right and up. */
+class NudgeCounter : public BaseMovementManager
+{
+public:
+    uint32_t right_up = 0;
+
+    void move_relative(std::tuple<MoveDirectionX, MoveDirectionY> move_directions) override
+    {
+        this->right_up += std::get<0>(move_directions) == MoveDirectionX::Right &&
+                          std::get<1>(move_directions) == MoveDirectionY::Up;
+    }
+    void move_by(int32_t, int32_t) override {}
+    void move_absolute(int32_t, int32_t) override {}
+    int32_t get_pan_position() override { return 0; }
+    int32_t get_tilt_centidegrees() override { return 0; }
+};
+
+/** @brief Puts the stick at @p x, @p y from its rest position and lets the filter settle. */
+static void deflect(int x, int y)
+{
+    mock_arduino::analog_values()[JOYSTICK_PIN_X] = REST + x;
+    mock_arduino::analog_values()[JOYSTICK_PIN_Y] = REST + y;
+    delay(200);
+}
+
+/** @brief Presses and releases the button through the debounce, toggling the mode. */
+static void toggle_mode(Controller& controller)
+{
+    controller.poll_input(); // Latch the released button
+    mock_arduino::pin_levels()[JOYSTICK_PIN_Z] = LOW;
+    controller.poll_input();
+    delay(BUTTON_DEBOUNCE_MS + 1);
+    controller.poll_input();
+    mock_arduino::pin_levels()[JOYSTICK_PIN_Z] = HIGH;
+    controller.poll_input();
+    delay(BUTTON_DEBOUNCE_MS + 1);
+    controller.poll_input();
+}
+
+NullDetector* detector;
+Joystick* joystick;
+
+// This runs BEFORE every test case
+void setUp(void)
+{
+    mock_arduino::pin_levels()[JOYSTICK_PIN_Z] = HIGH; // Button released: stay in AI mode
+    mock_arduino::analog_values()[JOYSTICK_PIN_X] = REST;
+    mock_arduino::analog_values()[JOYSTICK_PIN_Y] = REST;
+    detector = new NullDetector();
+    joystick = new Joystick(JOYSTICK_PIN_X, JOYSTICK_PIN_Y, JOYSTICK_PIN_Z);
+    joystick->begin();
+}
+
+// This runs AFTER every test case
+void tearDown(void)
+{
+    delete joystick;
+    delete detector;
+}
+
+// 1. Test the curve's end points, symmetry and the deadzone
+void test_curve_end_points(void)
+{
+    const ExpoCurve curve = {10, 400, 70, JOYSTICK_DEADZONE};
+
+    TEST_ASSERT_EQUAL_INT32(0, curve.apply(0));
+    TEST_ASSERT_EQUAL_INT32(0, curve.apply(JOYSTICK_DEADZONE - 1));
+    TEST_ASSERT_EQUAL_INT32(10, curve.apply(JOYSTICK_DEADZONE));
+    TEST_ASSERT_EQUAL_INT32(400, curve.apply(EXPO_INPUT_RANGE));
+    TEST_ASSERT_EQUAL_INT32(400, curve.apply(EXPO_INPUT_RANGE + 300)); // Past full travel
+    TEST_ASSERT_EQUAL_INT32(-400, curve.apply(-EXPO_INPUT_RANGE));
+    TEST_ASSERT_EQUAL_INT32(-curve.apply(1000), curve.apply(-1000));
+}
+
+// 2. Test expo keeps the middle of the travel slow and the response monotonic
+void test_curve_shape(void)
+{
+    const ExpoCurve linear = {0, 400, 0, 0};
+    const ExpoCurve cubic = {0, 400, 100, 0};
+    const ExpoCurve expo = {0, 400, 70, 0};
+
+    TEST_ASSERT_EQUAL_INT32(200, linear.apply(EXPO_INPUT_RANGE / 2));
+    TEST_ASSERT_EQUAL_INT32(50, cubic.apply(EXPO_INPUT_RANGE / 2));
+    TEST_ASSERT_INT32_WITHIN(1, 95, expo.apply(EXPO_INPUT_RANGE / 2)); // 0.3 * 200 + 0.7 * 50
+
+    int32_t previous = 0;
+    for (int32_t deflection = 0; deflection <= EXPO_INPUT_RANGE; deflection += 16)
+    {
+        int32_t rate = expo.apply(deflection);
+        TEST_ASSERT_TRUE(rate >= previous);
+        TEST_ASSERT_TRUE(rate <= linear.apply(deflection));
+        previous = rate;
+    }
+}
+
+// 3. Test USER mode turns deflection into rates while held, and stops once on release
+void test_user_mode_sends_rates(void)
+{
+    VelocityRecorder motors;
+    Controller controller(motors, *detector, *joystick);
+    toggle_mode(controller);
+    TEST_ASSERT_TRUE(controller.mode() == SystemControl::USER_MODE);
+
+    controller.poll_input();
+    TEST_ASSERT_EQUAL_UINT32(0, motors.velocity_calls); // Centered: nothing to say
+
+    const ExpoCurve pan = {MANUAL_PAN_MIN_RATE, MANUAL_PAN_MAX_RATE, MANUAL_EXPO_PERCENT, JOYSTICK_DEADZONE};
+    const ExpoCurve tilt = {MANUAL_TILT_MIN_RATE, MANUAL_TILT_MAX_RATE, MANUAL_EXPO_PERCENT, JOYSTICK_DEADZONE};
+    deflect(1000, -1800);
+    controller.poll_input();
+    TEST_ASSERT_INT32_WITHIN(2, pan.apply(1000), motors.pan_rate);
+    TEST_ASSERT_INT32_WITHIN(1, tilt.apply(-1800), motors.tilt_rate);
+    TEST_ASSERT_TRUE(motors.pan_rate > 0 && motors.tilt_rate < 0);
+
+    // Full deflection right reaches the top speed
+    deflect(EXPO_INPUT_RANGE + 100, 0);
+    controller.poll_input();
+    TEST_ASSERT_EQUAL_INT32(MANUAL_PAN_MAX_RATE, motors.pan_rate);
+    TEST_ASSERT_EQUAL_INT32(0, motors.tilt_rate);
+
+    deflect(0, 0);
+    uint32_t calls = motors.velocity_calls;
+    controller.poll_input();
+    controller.poll_input();
+    TEST_ASSERT_EQUAL_UINT32(calls + 1, motors.velocity_calls);
+    TEST_ASSERT_EQUAL_INT32(0, motors.pan_rate);
+    TEST_ASSERT_EQUAL_INT32(0, motors.tilt_rate);
+}
+
+// 4. Test switching back to AI mode stops a slew in progress
+void test_leaving_user_mode_stops(void)
+{
+    VelocityRecorder motors;
+    Controller controller(motors, *detector, *joystick);
+    const ExpoCurve gentle = {1, 50, 0, JOYSTICK_DEADZONE};
+    controller.set_manual_curves(gentle, gentle);
+    toggle_mode(controller);
+
+    deflect(-1800, 1800);
+    controller.poll_input();
+    TEST_ASSERT_EQUAL_INT32(gentle.apply(-1800), motors.pan_rate);
+    TEST_ASSERT_EQUAL_INT32(gentle.apply(1800), motors.tilt_rate);
+    TEST_ASSERT_TRUE(motors.pan_rate < 0);
+
+    toggle_mode(controller);
+    TEST_ASSERT_TRUE(controller.mode() == SystemControl::AI_MODE);
+    TEST_ASSERT_EQUAL_INT32(0, motors.pan_rate);
+    TEST_ASSERT_EQUAL_INT32(0, motors.tilt_rate);
+}
+
+// 5. Test a movement manager without speed control still gets one nudge per poll
+void test_fallback_nudges(void)
+{
+    NudgeCounter motors;
+    Controller controller(motors, *detector, *joystick);
+    toggle_mode(controller);
+
+    deflect(800, 800);
+    for (int i = 0; i < 5; i++)
+    {
+        controller.poll_input();
+    }
+    TEST_ASSERT_EQUAL_UINT32(5, motors.right_up);
+}
+
+int main()
+{
+    UNITY_BEGIN();
+
+    RUN_TEST(test_curve_end_points);
+    RUN_TEST(test_curve_shape);
+    RUN_TEST(test_user_mode_sends_rates);
+    RUN_TEST(test_leaving_user_mode_stops);
+    RUN_TEST(test_fallback_nudges);
+
+    return UNITY_END();
+}
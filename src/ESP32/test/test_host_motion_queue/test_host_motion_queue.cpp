@@ -0,0 +1,384 @@
+#include <Arduino.h>
+#include <unity.h>
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#include "motion_command_queue.h"
+#include "motion_task.h"
+#include "queued_movement_manager.h"
+#include "spsc_ring.h"
+
+#define STRESS_PRODUCERS 3
+#define STRESS_POSTS_PER_PRODUCER 20000
+#define STRESS_RING_ITEMS 1000000
+
+/** @brief Movement manager that only records what reached it. */
+class RecordingMovementManager : public BaseMovementManager
+{
+public:
+    std::atomic<int64_t> pan{0};
+    std::atomic<int64_t> tilt{0};
+    std::atomic<size_t> calls{0};
+    std::vector<int32_t> absolute_pans; // Read only after the consumer has stopped
+    int32_t pan_rate = 0;
+    int32_t tilt_rate = 0;
+
+    void move_relative(std::tuple<MoveDirectionX, MoveDirectionY> move_directions) override
+    {
+        pan += (std::get<0>(move_directions) == MoveDirectionX::Right)  ? 1
+               : (std::get<0>(move_directions) == MoveDirectionX::Left) ? -1
+                                                                        : 0;
+        calls++;
+    }
+
+    void move_by(int32_t pan_steps, int32_t tilt_centidegrees) override
+    {
+        pan += pan_steps;
+        tilt += tilt_centidegrees;
+        calls++;
+    }
+
+    void move_absolute(int32_t pan_steps, int32_t tilt_centidegrees) override
+    {
+        pan = pan_steps;
+        tilt = tilt_centidegrees;
+        absolute_pans.push_back(pan_steps);
+        calls++;
+    }
+
+    void move_velocity(int32_t pan_steps_per_s, int32_t tilt_centidegrees_per_s) override
+    {
+        pan_rate = pan_steps_per_s;
+        tilt_rate = tilt_centidegrees_per_s;
+        calls++;
+    }
+
+    int32_t get_pan_position() override { return (int32_t)pan; }
+    int32_t get_tilt_centidegrees() override { return (int32_t)tilt; }
+};
+
+static MotionCommand move_by_command(int32_t pan, int32_t tilt)
+{
+    MotionCommand command = {};
+    command.type = MotionCommand::Type::MoveBy;
+    command.pan = pan;
+    command.tilt = tilt;
+    return command;
+}
+
+static MotionCommand move_to_command(int32_t pan, int32_t tilt)
+{
+    MotionCommand command = move_by_command(pan, tilt);
+    command.type = MotionCommand::Type::MoveTo;
+    return command;
+}
+
+static MotionCommand velocity_command(int32_t pan_rate, int32_t tilt_rate)
+{
+    MotionCommand command = move_by_command(pan_rate, tilt_rate);
+    command.type = MotionCommand::Type::Velocity;
+    return command;
+}
+
+/** @brief Posts until the lane has room; a full lane is expected under stress. */
+static void post_blocking(MotionCommandQueue::Producer& producer, const MotionCommand& command)
+{
+    while (!producer.post(command))
+    {
+        std::this_thread::yield();
+    }
+}
+
+// This runs BEFORE every test case
+void setUp(void)
+{
+}
+
+// This runs AFTER every test case
+void tearDown(void)
+{
+}
+
+// 1. Test the ring is FIFO, rejects pushes when full and wraps around
+void test_spsc_ring_basics(void)
+{
+    SpscRing<int, 4> ring;
+    int value = 0;
+
+    TEST_ASSERT_FALSE(ring.pop(value));
+    for (int round = 0; round < 3; round++)
+    {
+        for (int i = 0; i < 4; i++)
+        {
+            TEST_ASSERT_TRUE(ring.push(round * 10 + i));
+        }
+        TEST_ASSERT_FALSE(ring.push(99));
+        TEST_ASSERT_EQUAL_size_t(4, ring.size());
+
+        for (int i = 0; i < 4; i++)
+        {
+            TEST_ASSERT_TRUE(ring.pop(value));
+            TEST_ASSERT_EQUAL_INT(round * 10 + i, value);
+        }
+        TEST_ASSERT_TRUE(ring.empty());
+    }
+}
+
+// 2. Test one producer and one consumer thread pass a million items in order
+void test_spsc_ring_two_threads(void)
+{
+    static SpscRing<uint32_t, 64> ring;
+    std::atomic<bool> in_order(true);
+
+    std::thread consumer([&in_order]() {
+        uint32_t expected = 0;
+        uint32_t value = 0;
+        while (expected < STRESS_RING_ITEMS)
+        {
+            if (ring.pop(value))
+            {
+                if (value != expected)
+                {
+                    in_order = false;
+                }
+                expected++;
+            }
+        }
+    });
+
+    for (uint32_t i = 0; i < STRESS_RING_ITEMS; i++)
+    {
+        while (!ring.push(i))
+        {
+            std::this_thread::yield();
+        }
+    }
+    consumer.join();
+
+    TEST_ASSERT_TRUE(in_order);
+    TEST_ASSERT_TRUE(ring.empty());
+}
+
+// 3. Test drain() keeps only the newest absolute target and folds relative moves
+void test_drain_coalesces(void)
+{
+    MotionCommandQueue queue;
+    RecordingMovementManager motors;
+    MotionCommandQueue::Producer producer = queue.make_producer();
+
+    for (int i = 0; i < 3; i++)
+    {
+        producer.post(move_by_command(1, 0));
+    }
+    producer.post(move_to_command(50, 80));
+    producer.post(move_to_command(100, 90));
+    producer.post(move_by_command(2, 1));
+    producer.post(move_by_command(3, 0));
+
+    MotionCommand nudge = {};
+    nudge.type = MotionCommand::Type::Nudge;
+    nudge.nudge_x = MoveDirectionX::Right;
+    producer.post(nudge);
+
+    // MoveTo(100, 90), MoveBy(5, 1), Nudge
+    TEST_ASSERT_EQUAL_size_t(3, queue.drain(motors));
+    TEST_ASSERT_EQUAL_INT64(106, motors.pan);
+    TEST_ASSERT_EQUAL_INT64(91, motors.tilt);
+    TEST_ASSERT_EQUAL_size_t(1, motors.absolute_pans.size());
+    TEST_ASSERT_EQUAL_UINT32(5, queue.get_coalesced());
+    TEST_ASSERT_EQUAL_size_t(0, queue.drain(motors));
+}
+
+// 4. Test lanes run out and a full lane rejects posts instead of blocking
+void test_lanes_and_overflow(void)
+{
+    MotionCommandQueue queue;
+    for (int i = 0; i < MOTION_QUEUE_MAX_PRODUCERS; i++)
+    {
+        TEST_ASSERT_TRUE(queue.make_producer().is_valid());
+    }
+    TEST_ASSERT_FALSE(queue.make_producer().is_valid());
+
+    MotionCommandQueue small_queue;
+    MotionCommandQueue::Producer producer = small_queue.make_producer();
+    for (int i = 0; i < MOTION_QUEUE_LANE_CAPACITY; i++)
+    {
+        TEST_ASSERT_TRUE(producer.post(move_by_command(1, 0)));
+    }
+    TEST_ASSERT_FALSE(producer.post(move_by_command(1, 0)));
+    TEST_ASSERT_EQUAL_UINT32(1, small_queue.get_dropped());
+}
+
+// 5. Test concurrent producers lose no relative move while the consumer drains
+void test_multi_producer_stress_relative(void)
+{
+    MotionCommandQueue queue;
+    RecordingMovementManager motors;
+    std::atomic<int> finished(0);
+
+    std::vector<std::thread> producers;
+    for (int p = 0; p < STRESS_PRODUCERS; p++)
+    {
+        producers.emplace_back([&queue, &finished]() {
+            MotionCommandQueue::Producer producer = queue.make_producer();
+            for (int i = 0; i < STRESS_POSTS_PER_PRODUCER; i++)
+            {
+                post_blocking(producer, move_by_command(1, (i % 2) ? 1 : -1));
+            }
+            finished++;
+        });
+    }
+
+    std::thread consumer([&queue, &motors, &finished]() {
+        while (finished.load() < STRESS_PRODUCERS)
+        {
+            queue.drain(motors);
+        }
+        queue.drain(motors);
+    });
+
+    for (std::thread& producer : producers)
+    {
+        producer.join();
+    }
+    consumer.join();
+
+    TEST_ASSERT_EQUAL_INT64(STRESS_PRODUCERS * STRESS_POSTS_PER_PRODUCER, motors.pan);
+    TEST_ASSERT_EQUAL_INT64(0, motors.tilt);
+    TEST_ASSERT_TRUE(motors.calls < (size_t)STRESS_PRODUCERS * STRESS_POSTS_PER_PRODUCER);
+}
+
+// 6. Test absolute targets from racing producers never regress to a stale one
+void test_multi_producer_stress_latest_wins(void)
+{
+    MotionCommandQueue queue;
+    RecordingMovementManager motors;
+    std::atomic<int> finished(0);
+
+    std::vector<std::thread> producers;
+    for (int p = 0; p < STRESS_PRODUCERS; p++)
+    {
+        producers.emplace_back([&queue, &finished, p]() {
+            MotionCommandQueue::Producer producer = queue.make_producer();
+            for (int i = 1; i <= STRESS_POSTS_PER_PRODUCER; i++)
+            {
+                post_blocking(producer, move_to_command(p * 1000000 + i, 0));
+            }
+            finished++;
+        });
+    }
+
+    std::thread consumer([&queue, &motors, &finished]() {
+        while (finished.load() < STRESS_PRODUCERS)
+        {
+            queue.drain(motors);
+        }
+        queue.drain(motors);
+    });
+
+    for (std::thread& producer : producers)
+    {
+        producer.join();
+    }
+    consumer.join();
+
+    // Per producer, applied targets only move forward
+    int32_t last_seen[STRESS_PRODUCERS] = {};
+    for (int32_t pan : motors.absolute_pans)
+    {
+        int p = pan / 1000000;
+        TEST_ASSERT_TRUE(pan > last_seen[p]);
+        last_seen[p] = pan;
+    }
+
+    // The turret ends on somebody's final target, never on a superseded one
+    TEST_ASSERT_EQUAL_INT64(STRESS_POSTS_PER_PRODUCER, motors.pan.load() % 1000000);
+}
+
+// 7. Test the motion task wakes on a post and applies it on its own thread
+void test_motion_task_applies_posts(void)
+{
+    // The task never exits, so everything it touches must outlive the test
+    MotionCommandQueue& queue = *new MotionCommandQueue();
+    RecordingMovementManager& motors = *new RecordingMovementManager();
+    MotionTask& task = *new MotionTask(queue, motors);
+    QueuedMovementManager facade(queue, motors);
+
+    TEST_ASSERT_TRUE(facade.is_valid());
+    TEST_ASSERT_TRUE(task.start());
+
+    facade.move_absolute(300, 45);
+    for (int i = 0; i < 200 && motors.calls == 0; i++)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+
+    TEST_ASSERT_EQUAL_INT32(300, facade.get_pan_position());
+    TEST_ASSERT_EQUAL_INT32(45, facade.get_tilt_centidegrees());
+}
+
+// 8. Test a command posted before the task starts is applied at once, not after the idle poll
+void test_motion_task_drains_on_start(void)
+{
+    MotionCommandQueue& queue = *new MotionCommandQueue();
+    RecordingMovementManager& motors = *new RecordingMovementManager();
+    MotionTask& task = *new MotionTask(queue, motors);
+    QueuedMovementManager facade(queue, motors);
+
+    facade.move_absolute(120, 30);
+    TEST_ASSERT_TRUE(task.start());
+    for (int i = 0; i < MOTION_TASK_IDLE_MS / 2 && motors.calls == 0; i++)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+
+    TEST_ASSERT_EQUAL_INT32(120, facade.get_pan_position());
+}
+
+// 9. Test only the newest of consecutive velocity commands is applied, in order with other moves
+void test_drain_velocity(void)
+{
+    MotionCommandQueue queue;
+    RecordingMovementManager motors;
+    MotionCommandQueue::Producer producer = queue.make_producer();
+
+    producer.post(velocity_command(100, 5));
+    producer.post(velocity_command(200, 10));
+    producer.post(move_by_command(3, 0));
+    producer.post(velocity_command(50, 0));
+    producer.post(velocity_command(0, 0));
+
+    // Velocity(200, 10), MoveBy(3, 0), Velocity(0, 0)
+    TEST_ASSERT_EQUAL_size_t(3, queue.drain(motors));
+    TEST_ASSERT_EQUAL_INT64(3, motors.pan);
+    TEST_ASSERT_EQUAL_INT32(0, motors.pan_rate);
+    TEST_ASSERT_EQUAL_INT32(0, motors.tilt_rate);
+    TEST_ASSERT_EQUAL_UINT32(2, queue.get_coalesced());
+
+    // An absolute target supersedes a slew posted before it
+    producer.post(velocity_command(300, 1));
+    producer.post(move_to_command(10, 90));
+    TEST_ASSERT_EQUAL_size_t(1, queue.drain(motors));
+    TEST_ASSERT_EQUAL_INT32(0, motors.pan_rate);
+    TEST_ASSERT_EQUAL_INT64(10, motors.pan);
+}
+
+int main()
+{
+    UNITY_BEGIN();
+
+    RUN_TEST(test_spsc_ring_basics);
+    RUN_TEST(test_spsc_ring_two_threads);
+    RUN_TEST(test_drain_coalesces);
+    RUN_TEST(test_lanes_and_overflow);
+    RUN_TEST(test_multi_producer_stress_relative);
+    RUN_TEST(test_multi_producer_stress_latest_wins);
+    RUN_TEST(test_motion_task_applies_posts);
+    RUN_TEST(test_motion_task_drains_on_start);
+    RUN_TEST(test_drain_velocity);
+
+    return UNITY_END();
+}
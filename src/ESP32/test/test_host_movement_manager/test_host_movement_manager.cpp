@@ -0,0 +1,317 @@
+#include <Arduino.h>
+#include <unity.h>
+
+#include "constants.h"
+#include "mock_clock.h"
+#include "movement_manager.h"
+
+#define QUARTER_TURN (STEPPER_NUMBER_OF_STEPS / 4)
+#define HALF_TURN (STEPPER_NUMBER_OF_STEPS / 2)
+
+StepperDriver* stepper;
+ServoDriver* servo;
+MovementManager* movement_manager;
+
+/** @brief Servo output rounded to whole degrees. */
+static int tilt_output()
+{
+    return (int)lroundf(servo->get_angle());
+}
+
+/** @brief Whole degrees in the movement manager's tilt unit. */
+static int32_t centi(int32_t degrees)
+{
+    return degrees * CENTIDEGREES_PER_DEGREE;
+}
+
+/** @brief Lets the background stepper finish whatever it is doing. */
+static void wait_for_stepper()
+{
+    for (int i = 0; i < 100 && stepper->is_moving(); i++)
+    {
+        mock_clock::advance_us(100000);
+    }
+}
+
+// This runs BEFORE every test case
+void setUp(void)
+{
+    mock_clock::reset();
+    stepper = new StepperDriver(STEPPER_PIN1, STEPPER_PIN3, STEPPER_PIN2, STEPPER_PIN4);
+    stepper->begin();
+    servo = new ServoDriver(SERVO_PIN);
+    servo->set_refresh_rate(SERVO_MAX_REFRESH_HZ);
+    servo->begin();
+    movement_manager = new MovementManager(*stepper, *servo);
+    mock_servo::writes_in_critical() = 0;
+}
+
+// This runs AFTER every test case
+void tearDown(void)
+{
+    delete movement_manager;
+    delete servo;
+    delete stepper;
+}
+
+// 1. Test the planner takes the short way round and honours the soft limits
+void test_shortest_pan_target(void)
+{
+    // Plain short moves
+    TEST_ASSERT_EQUAL_INT32(100, MovementManager::shortest_pan_target(0, 100, PAN_MIN_STEPS, PAN_MAX_STEPS));
+    TEST_ASSERT_EQUAL_INT32(-100, MovementManager::shortest_pan_target(0, -100, PAN_MIN_STEPS, PAN_MAX_STEPS));
+
+    // 270 degrees right is 90 degrees left
+    TEST_ASSERT_EQUAL_INT32(-QUARTER_TURN,
+                            MovementManager::shortest_pan_target(0, 3 * QUARTER_TURN, PAN_MIN_STEPS, PAN_MAX_STEPS));
+
+    // From -200, heading 2048 + 100 is 300 steps away to the right, not 1748 to the left
+    TEST_ASSERT_EQUAL_INT32(
+        100, MovementManager::shortest_pan_target(-200, STEPPER_NUMBER_OF_STEPS + 100, PAN_MIN_STEPS, PAN_MAX_STEPS));
+
+    // Near the right limit the short way would wind past it, so go back the long way
+    TEST_ASSERT_EQUAL_INT32(PAN_MAX_STEPS + 100 - STEPPER_NUMBER_OF_STEPS,
+                            MovementManager::shortest_pan_target(PAN_MAX_STEPS - 10, PAN_MAX_STEPS + 100,
+                                                                 PAN_MIN_STEPS, PAN_MAX_STEPS));
+
+    // Limits narrower than a turn: unreachable headings clamp to the closest limit
+    TEST_ASSERT_EQUAL_INT32(QUARTER_TURN, MovementManager::shortest_pan_target(0, HALF_TURN - 100, -QUARTER_TURN,
+                                                                               QUARTER_TURN));
+}
+
+// 2. Test move_absolute drives both axes to the requested orientation
+void test_move_absolute(void)
+{
+    movement_manager->move_absolute(QUARTER_TURN, centi(120));
+    TEST_ASSERT_EQUAL_INT32(centi(120), movement_manager->get_tilt_centidegrees());
+    TEST_ASSERT_TRUE(stepper->is_moving());
+
+    wait_for_stepper();
+    TEST_ASSERT_EQUAL_INT32(QUARTER_TURN, movement_manager->get_pan_position());
+    TEST_ASSERT_EQUAL_INT(120, tilt_output());
+
+    // Home again the short way
+    movement_manager->move_absolute(STEPPER_NUMBER_OF_STEPS, centi(SERVO_CENTER_ANGLE));
+    wait_for_stepper();
+    TEST_ASSERT_EQUAL_INT32(0, movement_manager->get_pan_position());
+    TEST_ASSERT_EQUAL_INT32(centi(SERVO_CENTER_ANGLE), movement_manager->get_tilt_centidegrees());
+}
+
+// 3. Test relative moves stop at the soft limits on both axes
+void test_soft_limits(void)
+{
+    movement_manager->set_pan_limits(-50, 50);
+    movement_manager->set_tilt_limits(60, 100);
+
+    movement_manager->move_by(500, centi(45));
+    TEST_ASSERT_EQUAL_INT32(50, stepper->get_target());
+    TEST_ASSERT_EQUAL_INT32(centi(100), movement_manager->get_tilt_centidegrees());
+
+    for (int i = 0; i < 30; i++)
+    {
+        movement_manager->move_relative(std::make_tuple(MoveDirectionX::Left, MoveDirectionY::Down));
+    }
+    TEST_ASSERT_EQUAL_INT32(-50, stepper->get_target());
+    TEST_ASSERT_EQUAL_INT32(centi(60), movement_manager->get_tilt_centidegrees());
+
+    wait_for_stepper();
+    TEST_ASSERT_EQUAL_INT32(-50, movement_manager->get_pan_position());
+}
+
+// 4. Test tilt comes from the commanded angle, not from reading the servo back
+void test_tilt_uses_commanded_angle(void)
+{
+    movement_manager->move_by(0, centi(10));
+    servo->write_angle(0); // Somebody else touched the servo
+    movement_manager->move_relative(std::make_tuple(MoveDirectionX::None, MoveDirectionY::Up));
+    mock_clock::advance_us(1000000); // Let the slew limiter get there
+
+    TEST_ASSERT_EQUAL_INT32(centi(SERVO_CENTER_ANGLE + 15), movement_manager->get_tilt_centidegrees());
+    TEST_ASSERT_EQUAL_INT(SERVO_CENTER_ANGLE + 15, tilt_output());
+}
+
+// 5. Test a diagonal move keeps tilt in step with pan so both axes arrive together
+void test_coordinated_move(void)
+{
+    const int32_t pan_travel = 200;
+    const int32_t tilt_travel = 40;
+
+    movement_manager->move_by(pan_travel, centi(tilt_travel));
+    TEST_ASSERT_EQUAL_INT(SERVO_CENTER_ANGLE, tilt_output()); // Nothing moved yet
+
+    bool checked_halfway = false;
+    int distinct_pulses = 0;
+    uint16_t last_pulse = servo->get_pulse();
+    for (int i = 0; i < 100000 && stepper->is_moving(); i++)
+    {
+        mock_clock::advance_us(100);
+
+        int32_t pan = movement_manager->get_pan_position();
+        uint16_t pulse = servo->get_pulse();
+        TEST_ASSERT_TRUE(pulse >= last_pulse); // Monotonic, no jumps back
+        distinct_pulses += (pulse != last_pulse);
+        last_pulse = pulse;
+
+        // The servo is never more than a fraction of a degree off the pan's progress
+        float expected = SERVO_CENTER_ANGLE + (float)tilt_travel * pan / pan_travel;
+        TEST_ASSERT_FLOAT_WITHIN(0.5f, expected, servo->get_angle());
+
+        if (pan == pan_travel / 2)
+        {
+            TEST_ASSERT_FLOAT_WITHIN(0.5f, SERVO_CENTER_ANGLE + tilt_travel / 2, servo->get_angle());
+            checked_halfway = true;
+        }
+    }
+
+    TEST_ASSERT_TRUE(checked_halfway);
+    TEST_ASSERT_EQUAL_INT32(pan_travel, movement_manager->get_pan_position());
+    TEST_ASSERT_EQUAL_INT(SERVO_CENTER_ANGLE + tilt_travel, tilt_output());
+
+    // Finer than whole degrees: no staircase
+    TEST_ASSERT_TRUE(distinct_pulses > 2 * tilt_travel);
+}
+
+// 6. Test a retarget mid-move re-plans tilt from where the servo already is
+void test_coordinated_retarget(void)
+{
+    movement_manager->move_absolute(400, centi(130));
+    for (int i = 0; i < 100000 && movement_manager->get_pan_position() < 200; i++)
+    {
+        mock_clock::advance_us(100);
+    }
+    int angle_at_retarget = tilt_output();
+    TEST_ASSERT_TRUE(angle_at_retarget > SERVO_CENTER_ANGLE && angle_at_retarget < 130);
+
+    // Pan turns back home while tilt heads further down
+    movement_manager->move_absolute(0, centi(50));
+    wait_for_stepper();
+
+    TEST_ASSERT_EQUAL_INT32(0, movement_manager->get_pan_position());
+    TEST_ASSERT_EQUAL_INT(50, tilt_output());
+}
+
+// 7. Test the pose history remembers where the turret was during a move
+void test_pose_history(void)
+{
+    TurretPose pose;
+    TEST_ASSERT_FALSE(movement_manager->get_pose_at(0, pose)); // Nothing recorded before begin()
+
+    TEST_ASSERT_TRUE(movement_manager->begin());
+    movement_manager->move_absolute(200, centi(SERVO_CENTER_ANGLE + 20));
+
+    mock_clock::advance_us(200000);
+    int64_t mid_move_us = mock_clock::now_us();
+    int32_t mid_pan = stepper->get_position();
+    int32_t mid_tilt = (int32_t)lroundf(servo->get_angle() * CENTIDEGREES_PER_DEGREE);
+    TEST_ASSERT_TRUE(mid_pan > 0 && mid_pan < 200);
+
+    wait_for_stepper();
+    TEST_ASSERT_EQUAL_INT32(200, stepper->get_position());
+
+    TEST_ASSERT_TRUE(movement_manager->get_pose_at(mid_move_us, pose));
+    TEST_ASSERT_INT32_WITHIN(2, mid_pan, pose.pan_steps);
+    TEST_ASSERT_INT32_WITHIN(50, mid_tilt, pose.tilt_centidegrees);
+
+    // Now is the latest sample
+    TEST_ASSERT_TRUE(movement_manager->get_pose_at(mock_clock::now_us(), pose));
+    TEST_ASSERT_EQUAL_INT32(200, pose.pan_steps);
+    TEST_ASSERT_INT32_WITHIN(10, centi(SERVO_CENTER_ANGLE + 20), pose.tilt_centidegrees);
+}
+
+// 8. Test velocity mode slews at the commanded rates and positional moves resume from where it stopped
+void test_velocity_mode(void)
+{
+    const int32_t pan_rate = 200;
+    const int32_t tilt_rate = 20;
+
+    movement_manager->move_velocity(pan_rate, centi(tilt_rate));
+    mock_clock::advance_us(1000000);
+
+    // One second at the rate, less what the acceleration ramp cost at the start
+    int32_t ramp_loss = (int32_t)(pan_rate * pan_rate / (2 * STEPPER_DEFAULT_ACCELERATION)) + 2;
+    TEST_ASSERT_INT32_WITHIN(ramp_loss, pan_rate - ramp_loss / 2, movement_manager->get_pan_position());
+    TEST_ASSERT_FLOAT_WITHIN(1.0f, SERVO_CENTER_ANGLE + tilt_rate, servo->get_angle());
+    TEST_ASSERT_TRUE(stepper->is_moving());
+
+    // Stop: the stepper brakes, the servo holds where it got to
+    movement_manager->move_velocity(0, 0);
+    wait_for_stepper();
+    int32_t stopped_pan = movement_manager->get_pan_position();
+    int stopped_tilt = tilt_output();
+    TEST_ASSERT_TRUE(stopped_pan > pan_rate - ramp_loss && stopped_pan < pan_rate + ramp_loss);
+    TEST_ASSERT_INT32_WITHIN(CENTIDEGREES_PER_DEGREE / 2, centi(stopped_tilt),
+                             movement_manager->get_tilt_centidegrees());
+    mock_clock::advance_us(500000);
+    TEST_ASSERT_EQUAL_INT(stopped_tilt, tilt_output());
+
+    // Positional moves start from the stop, faster again than the slew rate allowed
+    movement_manager->move_by(-300, centi(-20));
+    mock_clock::advance_us(500000);
+    TEST_ASSERT_TRUE(stopped_pan - movement_manager->get_pan_position() > 120);
+    wait_for_stepper();
+    TEST_ASSERT_EQUAL_INT32(stopped_pan - 300, movement_manager->get_pan_position());
+    TEST_ASSERT_EQUAL_INT(stopped_tilt - 20, tilt_output());
+}
+
+// 9. Test a velocity slew stops at the soft limits and reverses on a negative rate
+void test_velocity_limits_and_reversal(void)
+{
+    movement_manager->set_pan_limits(-100, 100);
+    movement_manager->set_tilt_limits(60, 100);
+
+    movement_manager->move_velocity(STEPPER_DEFAULT_MAX_SPEED, centi(90));
+    mock_clock::advance_us(2000000);
+    TEST_ASSERT_EQUAL_INT32(100, movement_manager->get_pan_position());
+    TEST_ASSERT_EQUAL_INT(100, tilt_output());
+
+    movement_manager->move_velocity(-STEPPER_DEFAULT_MAX_SPEED, centi(-90));
+    mock_clock::advance_us(100000);
+    TEST_ASSERT_TRUE(movement_manager->get_pan_position() < 100);
+    mock_clock::advance_us(2000000);
+    TEST_ASSERT_EQUAL_INT32(-100, movement_manager->get_pan_position());
+    TEST_ASSERT_EQUAL_INT(60, tilt_output());
+}
+
+// 10. Test the servo pin is never written with a critical section held
+void test_servo_written_outside_lock(void)
+{
+    // Tilt slaved to pan, then tilt alone
+    movement_manager->move_by(200, centi(30));
+    wait_for_stepper();
+    movement_manager->move_by(0, centi(-60));
+    mock_clock::advance_us(500000);
+
+    TEST_ASSERT_EQUAL_INT(SERVO_CENTER_ANGLE - 30, tilt_output());
+    TEST_ASSERT_EQUAL_INT(0, mock_servo::writes_in_critical().load());
+}
+
+// 11. Test a tilt correction smaller than a degree still reaches the servo
+void test_sub_degree_tilt(void)
+{
+    uint16_t start_pulse = servo->get_pulse();
+    movement_manager->move_by(0, 30);
+    mock_clock::advance_us(100000);
+
+    TEST_ASSERT_EQUAL_INT32(centi(SERVO_CENTER_ANGLE) + 30, movement_manager->get_tilt_centidegrees());
+    TEST_ASSERT_EQUAL_UINT16(servo->angle_to_pulse(SERVO_CENTER_ANGLE + 0.3f), servo->get_pulse());
+    TEST_ASSERT_TRUE(servo->get_pulse() > start_pulse);
+}
+
+int main()
+{
+    UNITY_BEGIN();
+
+    RUN_TEST(test_shortest_pan_target);
+    RUN_TEST(test_move_absolute);
+    RUN_TEST(test_soft_limits);
+    RUN_TEST(test_tilt_uses_commanded_angle);
+    RUN_TEST(test_coordinated_move);
+    RUN_TEST(test_coordinated_retarget);
+    RUN_TEST(test_pose_history);
+    RUN_TEST(test_velocity_mode);
+    RUN_TEST(test_velocity_limits_and_reversal);
+    RUN_TEST(test_servo_written_outside_lock);
+    RUN_TEST(test_sub_degree_tilt);
+
+    return UNITY_END();
+}
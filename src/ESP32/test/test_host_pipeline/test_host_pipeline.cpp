@@ -0,0 +1,317 @@
+#include <Arduino.h>
+#include <unity.h>
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#include "constants.h"
+#include "controller.h"
+#include "tracking_pipeline.h"
+
+#define TEST_FRAME_WIDTH 160
+#define TEST_FRAME_HEIGHT 120
+#define TEST_FRAME_POOL 8
+
+/** @brief Camera stand-in: a pool of frames numbered in capture order. */
+struct FakeSensor {
+    uint8_t pixels[TEST_FRAME_POOL][TEST_FRAME_WIDTH * TEST_FRAME_HEIGHT];
+    camera_fb_t frames[TEST_FRAME_POOL];
+    uint32_t next = 0;
+    int frame_period_ms = 0; /**< Sleep per capture, as the sensor would block. */
+
+    FakeSensor()
+    {
+        for (int i = 0; i < TEST_FRAME_POOL; i++)
+        {
+            this->frames[i] = camera_fb_t();
+            this->frames[i].buf = this->pixels[i];
+            this->frames[i].len = sizeof(this->pixels[i]);
+            this->frames[i].width = TEST_FRAME_WIDTH;
+            this->frames[i].height = TEST_FRAME_HEIGHT;
+            this->frames[i].format = PIXFORMAT_GRAYSCALE;
+        }
+    }
+
+    static camera_fb_t* capture(void* arg)
+    {
+        FakeSensor* sensor = static_cast<FakeSensor*>(arg);
+        if (sensor->frame_period_ms)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(sensor->frame_period_ms));
+        }
+
+        camera_fb_t* frame = &sensor->frames[sensor->next % TEST_FRAME_POOL];
+        frame->timestamp.tv_sec = 0;
+        frame->timestamp.tv_usec = (suseconds_t)sensor->next; // Sequence number, read back by the detector
+        sensor->next++;
+        return frame;
+    }
+};
+
+/** @brief Detector that reports a fixed target and records which frames it saw. */
+class SequenceDetector : public BaseDetectionModule
+{
+public:
+    int work_ms = 0;                     /**< Sleep per frame, as a real detector would compute. */
+    std::vector<uint32_t> seen;          /**< Frame sequence numbers; read only after the pipeline has stopped. */
+    std::atomic<int> active{0};          /**< Detections currently running; must never exceed one. */
+    std::atomic<bool> overlapped{false}; /**< Set if two detections ever ran at once. */
+
+    std::tuple<MoveDirectionX, MoveDirectionY> detect_object(camera_fb_t*) override
+    {
+        return std::make_tuple(MoveDirectionX::None, MoveDirectionY::None);
+    }
+
+    DetectionResult detect(FrameContext& context) override
+    {
+        if (++this->active > 1)
+        {
+            this->overlapped = true;
+        }
+        if (this->work_ms)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(this->work_ms));
+        }
+        this->seen.push_back((uint32_t)context.frame()->timestamp.tv_usec);
+        this->active--;
+
+        DetectionResult result;
+        result.error_x = 20 << DETECTION_SUBPIXEL_BITS;
+        result.confidence = 255;
+        result.frame_width = TEST_FRAME_WIDTH;
+        result.frame_height = TEST_FRAME_HEIGHT;
+        return result;
+    }
+};
+
+/** @brief Movement manager that records absolute moves. */
+class RecordingMovementManager : public BaseMovementManager
+{
+public:
+    std::atomic<int32_t> pan{0};
+    std::atomic<size_t> moves{0};
+
+    void move_relative(std::tuple<MoveDirectionX, MoveDirectionY>) override {}
+    void move_by(int32_t, int32_t) override {}
+
+    void move_absolute(int32_t pan_steps, int32_t) override
+    {
+        this->pan = pan_steps;
+        this->moves++;
+    }
+
+    int32_t get_pan_position() override { return this->pan; }
+    int32_t get_tilt_centidegrees() override { return 0; }
+};
+
+/** @brief The pipeline under test with everything it drives. */
+struct Fixture {
+    FakeSensor sensor;
+    SequenceDetector detector;
+    RecordingMovementManager motors;
+    Joystick joystick;
+    Camera camera;
+    FrameBroker broker;
+    Controller controller;
+    TrackingPipeline pipeline;
+
+    Fixture()
+        : joystick(JOYSTICK_PIN_X, JOYSTICK_PIN_Y, JOYSTICK_PIN_Z), broker(camera),
+          controller(motors, detector, joystick), pipeline(broker, detector, controller)
+    {
+        mock_camera::set_source(&FakeSensor::capture, &this->sensor);
+    }
+
+    ~Fixture() { mock_camera::set_source(nullptr, nullptr); }
+};
+
+/** @brief Runs the broker and pipeline tasks for @p duration_ms of real time. */
+static void run_for(Fixture& fixture, int duration_ms)
+{
+    TEST_ASSERT_TRUE(fixture.pipeline.start());
+    TEST_ASSERT_TRUE(fixture.pipeline.is_running());
+    TEST_ASSERT_TRUE(fixture.broker.start());
+    std::this_thread::sleep_for(std::chrono::milliseconds(duration_ms));
+    fixture.broker.stop(); // Source first, so the counters settle
+    fixture.pipeline.stop();
+    TEST_ASSERT_FALSE(fixture.pipeline.is_running());
+}
+
+// This runs BEFORE every test case
+void setUp(void)
+{
+    mock_arduino::pin_levels()[JOYSTICK_PIN_Z] = HIGH; // Button released: stay in AI mode
+}
+
+// This runs AFTER every test case
+void tearDown(void)
+{
+}
+
+// 1. Test a full subscription hands the older frame back and the detector gets the newest
+void test_stages_keep_latest_frame(void)
+{
+    Fixture fixture;
+    TEST_ASSERT_TRUE(fixture.pipeline.subscribe());
+
+    TEST_ASSERT_TRUE(fixture.broker.capture_once());
+    TEST_ASSERT_TRUE(fixture.broker.capture_once());
+    TEST_ASSERT_EQUAL_UINT32(1, mock_camera::state().frames_out.load()); // Frame 0 went straight back
+
+    TEST_ASSERT_TRUE(fixture.pipeline.detect_once(0));
+    TEST_ASSERT_EQUAL_UINT32(0, mock_camera::state().frames_out.load()); // Returned after detection
+    TEST_ASSERT_EQUAL_UINT32(1, fixture.detector.seen.size());
+    TEST_ASSERT_EQUAL_UINT32(1, fixture.detector.seen[0]);
+    TEST_ASSERT_FALSE(fixture.pipeline.detect_once(0)); // Nothing left
+
+    TEST_ASSERT_TRUE(fixture.pipeline.actuate_once(0));
+    TEST_ASSERT_EQUAL_UINT32(1, fixture.motors.moves.load());
+    TEST_ASSERT_TRUE(fixture.motors.pan.load() > 0); // Target right of centre
+
+    PipelineStats stats = fixture.pipeline.stats();
+    TEST_ASSERT_EQUAL_UINT32(2, stats.captured);
+    TEST_ASSERT_EQUAL_UINT32(1, stats.frames_dropped);
+    TEST_ASSERT_EQUAL_UINT32(1, stats.detected);
+    TEST_ASSERT_EQUAL_UINT32(0, stats.results_dropped);
+    TEST_ASSERT_EQUAL_UINT32(1, stats.actuated);
+}
+
+// 2. Test a frame still waiting when the pipeline goes away is returned to the camera
+void test_destruction_returns_queued_frames(void)
+{
+    {
+        Fixture fixture;
+        fixture.pipeline.subscribe();
+        fixture.broker.capture_once();
+        TEST_ASSERT_EQUAL_UINT32(1, mock_camera::state().frames_out.load());
+    }
+    TEST_ASSERT_EQUAL_UINT32(0, mock_camera::state().frames_out.load());
+}
+
+// 3. Test a slow detector skips to the newest frame and every frame is accounted for
+void test_slow_detector_drops_stale_frames(void)
+{
+    Fixture fixture;
+    fixture.sensor.frame_period_ms = 2;
+    fixture.detector.work_ms = 10;
+
+    run_for(fixture, 300);
+
+    PipelineStats stats = fixture.pipeline.stats();
+    Serial.printf("[PIPELINE] captured %u, dropped %u, detected %u, actuated %u\n", (unsigned)stats.captured,
+                  (unsigned)stats.frames_dropped, (unsigned)stats.detected, (unsigned)stats.actuated);
+
+    TEST_ASSERT_EQUAL_UINT32(0, mock_camera::state().frames_out.load());
+    TEST_ASSERT_FALSE(fixture.detector.overlapped.load());
+    TEST_ASSERT_TRUE(stats.frames_dropped > 0);
+    TEST_ASSERT_TRUE(stats.detected > 0);
+    // Each frame was either detected, dropped, or still waiting at stop()
+    TEST_ASSERT_TRUE(stats.captured - stats.detected - stats.frames_dropped <= 1);
+    TEST_ASSERT_TRUE(stats.detected - stats.actuated - stats.results_dropped <= PIPELINE_RESULT_QUEUE_DEPTH);
+    TEST_ASSERT_EQUAL_UINT32(stats.actuated, fixture.motors.moves.load());
+
+    for (size_t i = 1; i < fixture.detector.seen.size(); i++)
+    {
+        TEST_ASSERT_TRUE(fixture.detector.seen[i] > fixture.detector.seen[i - 1]); // Never an older frame
+    }
+}
+
+// 4. Test the broker's capture overlaps detection, so throughput follows the slowest stage, not the sum
+void test_stages_overlap(void)
+{
+    const int stage_ms = 10;
+    const int duration_ms = 400;
+
+    Fixture fixture;
+    fixture.sensor.frame_period_ms = stage_ms;
+    fixture.detector.work_ms = stage_ms;
+
+    run_for(fixture, duration_ms);
+
+    PipelineStats stats = fixture.pipeline.stats();
+    const uint32_t sequential = duration_ms / (2 * stage_ms);
+    Serial.printf("[PIPELINE] detected %u in %d ms, sequential would manage %u\n", (unsigned)stats.detected,
+                  duration_ms, (unsigned)sequential);
+
+    TEST_ASSERT_TRUE(stats.detected > sequential * 3 / 2);
+    TEST_ASSERT_EQUAL_UINT32(0, mock_camera::state().frames_out.load());
+}
+
+// 5. Test USER mode keeps the pipeline running but leaves the motors to the joystick
+void test_user_mode_ignores_detections(void)
+{
+    Fixture fixture;
+    fixture.controller.poll_input(); // Latch the released button
+    mock_arduino::pin_levels()[JOYSTICK_PIN_Z] = LOW;
+    fixture.controller.poll_input();
+    delay(BUTTON_DEBOUNCE_MS + 1);
+    fixture.controller.poll_input();
+    TEST_ASSERT_TRUE(fixture.controller.mode() == SystemControl::USER_MODE);
+
+    fixture.pipeline.subscribe();
+    fixture.broker.capture_once();
+    fixture.pipeline.detect_once(0);
+    TEST_ASSERT_TRUE(fixture.pipeline.actuate_once(0));
+    TEST_ASSERT_EQUAL_UINT32(0, fixture.motors.moves.load());
+}
+
+// 6. Test a pipeline that is never started leaves every broker slot to the stream clients
+void test_slot_taken_on_start(void)
+{
+    Fixture fixture;
+    TEST_ASSERT_EQUAL_UINT32(0, fixture.broker.subscribers());
+
+    TEST_ASSERT_TRUE(fixture.pipeline.start());
+    TEST_ASSERT_EQUAL_UINT32(1, fixture.broker.subscribers());
+    TEST_ASSERT_TRUE(fixture.pipeline.subscribe()); // Already held, no second slot
+    TEST_ASSERT_EQUAL_UINT32(1, fixture.broker.subscribers());
+    fixture.pipeline.stop();
+}
+
+// 7. Test optional work runs on the actuate task, so telemetry is reported while the pipeline tracks
+void test_optional_work_on_actuate_task(void)
+{
+    struct Telemetry {
+        std::thread::id test_thread = std::this_thread::get_id();
+        std::atomic<uint32_t> calls{0};
+        std::atomic<uint32_t> on_test_thread{0};
+
+        static void run(void* arg)
+        {
+            Telemetry* telemetry = static_cast<Telemetry*>(arg);
+            telemetry->calls++;
+            if (std::this_thread::get_id() == telemetry->test_thread)
+            {
+                telemetry->on_test_thread++;
+            }
+        }
+    } telemetry;
+
+    Fixture fixture;
+    fixture.sensor.frame_period_ms = 5;
+    fixture.pipeline.set_optional_work(&Telemetry::run, &telemetry);
+
+    run_for(fixture, 100);
+
+    PipelineStats stats = fixture.pipeline.stats();
+    TEST_ASSERT_TRUE(stats.actuated > 0);
+    TEST_ASSERT_TRUE(telemetry.calls.load() >= stats.actuated); // After every actuation
+    TEST_ASSERT_EQUAL_UINT32(0, telemetry.on_test_thread.load());
+}
+
+int main()
+{
+    UNITY_BEGIN();
+
+    RUN_TEST(test_stages_keep_latest_frame);
+    RUN_TEST(test_destruction_returns_queued_frames);
+    RUN_TEST(test_slow_detector_drops_stale_frames);
+    RUN_TEST(test_stages_overlap);
+    RUN_TEST(test_user_mode_ignores_detections);
+    RUN_TEST(test_slot_taken_on_start);
+    RUN_TEST(test_optional_work_on_actuate_task);
+
+    return UNITY_END();
+}
@@ -0,0 +1,172 @@
+#include <Arduino.h>
+#include <math.h>
+#include <unity.h>
+
+#include "constants.h"
+#include "detection_result.h"
+#include "lens_model.h"
+#include "pixel_angle_lut.h"
+
+#define ONE_Q4 (1 << DETECTION_SUBPIXEL_BITS)
+#define ONE_Q8 ((float)(1 << PIXEL_ANGLE_FRACTION_BITS))
+
+PixelAngleLut lut;
+
+// This runs BEFORE every test case
+void setUp(void)
+{
+}
+
+// This runs AFTER every test case
+void tearDown(void)
+{
+}
+
+/** @brief Looks up whole-pixel coordinates and returns float degrees. */
+static void lookup_degrees(float x, float y, float& pan_deg, float& tilt_deg)
+{
+    int32_t pan_q8 = 0;
+    int32_t tilt_q8 = 0;
+    lut.lookup((int32_t)lroundf(x * ONE_Q4), (int32_t)lroundf(y * ONE_Q4), pan_q8, tilt_q8);
+    pan_deg = pan_q8 / ONE_Q8;
+    tilt_deg = tilt_q8 / ONE_Q8;
+}
+
+// 1. Test the frame centre and edges land on the axis and half the field of view
+void test_centre_and_edges(void)
+{
+    lut.build(LensModel::nominal(320, 240), 320, 240);
+    float pan = 0.0f;
+    float tilt = 0.0f;
+
+    lookup_degrees(0.0f, 0.0f, pan, tilt);
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, 0.0f, pan);
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, 0.0f, tilt);
+
+    lookup_degrees(160.0f, 0.0f, pan, tilt);
+    TEST_ASSERT_FLOAT_WITHIN(0.02f, CAMERA_HFOV_DEG / 2.0f, pan);
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, 0.0f, tilt);
+
+    lookup_degrees(0.0f, -120.0f, pan, tilt);
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, 0.0f, pan);
+    TEST_ASSERT_FLOAT_WITHIN(0.02f, -CAMERA_VFOV_DEG / 2.0f, tilt);
+}
+
+// 2. Test the table follows the lens model everywhere, corners included, at several frame sizes
+void test_matches_model(void)
+{
+    const uint16_t sizes[][2] = {{96, 96}, {160, 120}, {320, 240}, {1600, 1200}};
+    for (size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++)
+    {
+        uint16_t width = sizes[s][0];
+        uint16_t height = sizes[s][1];
+        LensModel lens = LensModel::nominal(width, height);
+        lut.build(lens, width, height);
+
+        float worst = 0.0f;
+        for (float fy = -0.5f; fy <= 0.5f; fy += 0.0625f)
+        {
+            for (float fx = -0.5f; fx <= 0.5f; fx += 0.03125f)
+            {
+                float expected_pan = 0.0f;
+                float expected_tilt = 0.0f;
+                float pan = 0.0f;
+                float tilt = 0.0f;
+                lens.pixel_to_angles(fx * width, fy * height, expected_pan, expected_tilt);
+                lookup_degrees(fx * width, fy * height, pan, tilt);
+                worst = fmaxf(worst, fmaxf(fabsf(pan - expected_pan), fabsf(tilt - expected_tilt)));
+            }
+        }
+        TEST_ASSERT_TRUE(worst < 0.05f);
+    }
+}
+
+// 3. Test barrel distortion is undone: near the edges a pixel lies further out than a pinhole would put it
+void test_barrel_correction(void)
+{
+    LensModel lens = LensModel::nominal(320, 240);
+    LensModel pinhole = lens;
+    pinhole.k1 = 0.0f;
+    lut.build(lens, 320, 240);
+
+    float pan = 0.0f;
+    float tilt = 0.0f;
+    float pinhole_pan = 0.0f;
+    float pinhole_tilt = 0.0f;
+
+    lookup_degrees(150.0f, 110.0f, pan, tilt);
+    pinhole.pixel_to_angles(150.0f, 110.0f, pinhole_pan, pinhole_tilt);
+    TEST_ASSERT_TRUE(pan > pinhole_pan + 0.4f);
+    TEST_ASSERT_TRUE(tilt > pinhole_tilt + 0.4f);
+
+    // Close to the axis the two agree
+    lookup_degrees(8.0f, 6.0f, pan, tilt);
+    pinhole.pixel_to_angles(8.0f, 6.0f, pinhole_pan, pinhole_tilt);
+    TEST_ASSERT_FLOAT_WITHIN(0.02f, pinhole_pan, pan);
+    TEST_ASSERT_FLOAT_WITHIN(0.02f, pinhole_tilt, tilt);
+}
+
+// 4. Test the model round-trips between pixels and angles
+void test_model_round_trip(void)
+{
+    LensModel lens = LensModel::nominal(320, 240);
+    const float points[][2] = {{0.0f, 0.0f}, {100.0f, -50.0f}, {-160.0f, 120.0f}, {37.5f, 119.0f}};
+    for (size_t i = 0; i < sizeof(points) / sizeof(points[0]); i++)
+    {
+        float pan = 0.0f;
+        float tilt = 0.0f;
+        float x = 0.0f;
+        float y = 0.0f;
+        lens.pixel_to_angles(points[i][0], points[i][1], pan, tilt);
+        lens.angles_to_pixel(pan, tilt, x, y);
+        TEST_ASSERT_FLOAT_WITHIN(0.01f, points[i][0], x);
+        TEST_ASSERT_FLOAT_WITHIN(0.01f, points[i][1], y);
+    }
+}
+
+// 5. Test a calibration with a wider scale than nominal narrows the field of view
+void test_calibrated_lens(void)
+{
+    CameraCalibration calibration;
+    calibration.frame_width = 160;
+    calibration.frame_height = 120;
+    calibration.pan_px_per_step = 0.6f;
+    calibration.tilt_px_per_degree = 3.2f;
+
+    LensModel lens = LensModel::calibrated(calibration, 320, 240);
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, 320.0f / (1.2f * STEPPER_NUMBER_OF_STEPS / 360.0f), lens.hfov_deg);
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, 240.0f / 6.4f, lens.vfov_deg);
+    TEST_ASSERT_FLOAT_WITHIN(0.001f, CAMERA_DISTORTION_K1, lens.k1);
+}
+
+// 6. Test coordinates beyond the frame clamp to its edge and an unbuilt table returns zero
+void test_clamp_and_unbuilt(void)
+{
+    lut.build(LensModel::nominal(160, 120), 160, 120);
+    float edge = 0.0f;
+    float beyond = 0.0f;
+    float tilt = 0.0f;
+    lookup_degrees(80.0f, 60.0f, edge, tilt);
+    lookup_degrees(400.0f, 300.0f, beyond, tilt);
+    TEST_ASSERT_EQUAL_FLOAT(edge, beyond);
+
+    lut.clear();
+    TEST_ASSERT_FALSE(lut.is_built());
+    lookup_degrees(40.0f, 20.0f, edge, tilt);
+    TEST_ASSERT_EQUAL_FLOAT(0.0f, edge);
+    TEST_ASSERT_EQUAL_FLOAT(0.0f, tilt);
+}
+
+int main()
+{
+    UNITY_BEGIN();
+
+    RUN_TEST(test_centre_and_edges);
+    RUN_TEST(test_matches_model);
+    RUN_TEST(test_barrel_correction);
+    RUN_TEST(test_model_round_trip);
+    RUN_TEST(test_calibrated_lens);
+    RUN_TEST(test_clamp_and_unbuilt);
+
+    return UNITY_END();
+}
@@ -0,0 +1,100 @@
+#include <Arduino.h>
+#include <unity.h>
+
+#include "pose_history.h"
+
+PoseHistory* history;
+
+/** @brief Records a sample. */
+static void record(int64_t timestamp_us, int32_t pan_steps, int32_t tilt_centidegrees)
+{
+    TurretPose pose;
+    pose.timestamp_us = timestamp_us;
+    pose.pan_steps = pan_steps;
+    pose.tilt_centidegrees = tilt_centidegrees;
+    history->record(pose);
+}
+
+// This runs BEFORE every test case
+void setUp(void)
+{
+    history = new PoseHistory();
+}
+
+// This runs AFTER every test case
+void tearDown(void)
+{
+    delete history;
+}
+
+// 1. Test an empty history has no answer
+void test_empty(void)
+{
+    TurretPose pose;
+    TEST_ASSERT_EQUAL_UINT32(0, history->size());
+    TEST_ASSERT_FALSE(history->at(1000, pose));
+}
+
+// 2. Test a time between two samples is interpolated on both axes
+void test_interpolation(void)
+{
+    record(1000, 0, 9000);
+    record(2000, 100, 8000);
+    record(3000, 100, 8000);
+
+    TurretPose pose;
+    TEST_ASSERT_TRUE(history->at(1250, pose));
+    TEST_ASSERT_EQUAL_INT64(1250, pose.timestamp_us);
+    TEST_ASSERT_EQUAL_INT32(25, pose.pan_steps);
+    TEST_ASSERT_EQUAL_INT32(8750, pose.tilt_centidegrees);
+
+    // Exactly on a sample
+    TEST_ASSERT_TRUE(history->at(2000, pose));
+    TEST_ASSERT_EQUAL_INT32(100, pose.pan_steps);
+}
+
+// 3. Test times after the newest sample get the newest pose and older ones are refused
+void test_bounds(void)
+{
+    record(1000, 10, 9000);
+    record(2000, 20, 9100);
+
+    TurretPose pose;
+    TEST_ASSERT_TRUE(history->at(5000, pose));
+    TEST_ASSERT_EQUAL_INT32(20, pose.pan_steps);
+    TEST_ASSERT_EQUAL_INT32(9100, pose.tilt_centidegrees);
+
+    TEST_ASSERT_FALSE(history->at(999, pose));
+}
+
+// 4. Test the ring overwrites the oldest samples once full
+void test_wrap_around(void)
+{
+    for (int i = 0; i < POSE_HISTORY_SIZE + 10; i++)
+    {
+        record(i * 1000, i, 9000);
+    }
+    TEST_ASSERT_EQUAL_UINT32(POSE_HISTORY_SIZE, history->size());
+
+    TurretPose pose;
+    TEST_ASSERT_FALSE(history->at(5000, pose)); // Overwritten
+    TEST_ASSERT_TRUE(history->at(10500, pose)); // Oldest kept is 10 ms
+    TEST_ASSERT_EQUAL_INT32(11, pose.pan_steps);
+    TEST_ASSERT_TRUE(history->at((POSE_HISTORY_SIZE + 5) * 1000 + 400, pose));
+    TEST_ASSERT_EQUAL_INT32(POSE_HISTORY_SIZE + 5, pose.pan_steps);
+
+    history->clear();
+    TEST_ASSERT_FALSE(history->at(10500, pose));
+}
+
+int main()
+{
+    UNITY_BEGIN();
+
+    RUN_TEST(test_empty);
+    RUN_TEST(test_interpolation);
+    RUN_TEST(test_bounds);
+    RUN_TEST(test_wrap_around);
+
+    return UNITY_END();
+}
@@ -0,0 +1,172 @@
+#include <Arduino.h>
+#include <unity.h>
+
+#include <atomic>
+#include <thread>
+
+#include "constants.h"
+#include "mock_clock.h"
+#include "servo_driver.h"
+
+#define CENTER_PULSE ((SERVO_DEFAULT_MIN_PULSE_US + SERVO_DEFAULT_MAX_PULSE_US) / 2)
+
+ServoDriver* servo;
+
+// This runs BEFORE every test case
+void setUp(void)
+{
+    mock_clock::reset();
+    servo = new ServoDriver(SERVO_PIN);
+    mock_servo::writes_in_critical() = 0;
+    mock_servo::writes_while_detached() = 0;
+}
+
+// This runs AFTER every test case
+void tearDown(void)
+{
+    delete servo;
+}
+
+// 1. Test angles map to pulses with sub-degree resolution and stay in range
+void test_angle_resolution(void)
+{
+    TEST_ASSERT_EQUAL_UINT16(SERVO_DEFAULT_MIN_PULSE_US, servo->angle_to_pulse(0.0f));
+    TEST_ASSERT_EQUAL_UINT16(SERVO_DEFAULT_MAX_PULSE_US, servo->angle_to_pulse(SERVO_RANGE_DEG));
+    TEST_ASSERT_EQUAL_UINT16(SERVO_DEFAULT_MIN_PULSE_US, servo->angle_to_pulse(-10.0f));
+
+    // A tenth of a degree is a whole microsecond here, so it reaches the pin
+    TEST_ASSERT_TRUE(servo->angle_to_pulse(90.5f) > servo->angle_to_pulse(90.0f));
+    TEST_ASSERT_FLOAT_WITHIN(0.1f, 90.5f, servo->pulse_to_angle(servo->angle_to_pulse(90.5f)));
+}
+
+// 2. Test the refresh rate is clamped to what servos accept
+void test_refresh_rate_clamped(void)
+{
+    servo->set_refresh_rate(1000);
+    TEST_ASSERT_EQUAL_UINT16(SERVO_MAX_REFRESH_HZ, servo->get_refresh_rate());
+    servo->set_refresh_rate(10);
+    TEST_ASSERT_EQUAL_UINT16(SERVO_MIN_REFRESH_HZ, servo->get_refresh_rate());
+}
+
+// 3. Test a large jump is swept at the slew rate instead of in one frame
+void test_slew_limits_large_jumps(void)
+{
+    const uint32_t slew = 5000;
+    servo->set_slew_rate(slew);
+    servo->set_refresh_rate(SERVO_MAX_REFRESH_HZ);
+    TEST_ASSERT_TRUE(servo->begin());
+    mock_clock::advance_us(100000);
+
+    servo->write_microseconds(SERVO_DEFAULT_MAX_PULSE_US);
+    TEST_ASSERT_EQUAL_UINT16(SERVO_DEFAULT_MAX_PULSE_US, servo->get_target_pulse());
+
+    // Never faster than the slew rate (plus one frame of head start)
+    const int64_t frame_us = 1000000 / SERVO_MAX_REFRESH_HZ;
+    int64_t start_us = mock_clock::now_us();
+    while (servo->get_pulse() != SERVO_DEFAULT_MAX_PULSE_US && mock_clock::now_us() - start_us < 2000000)
+    {
+        mock_clock::advance_us(1000);
+        int64_t elapsed_us = mock_clock::now_us() - start_us + frame_us;
+        TEST_ASSERT_TRUE((servo->get_pulse() - CENTER_PULSE) <= (int64_t)slew * elapsed_us / 1000000);
+    }
+
+    // And about as fast: 928 µs of travel at 5000 µs/s is ~186 ms
+    int64_t sweep_us = mock_clock::now_us() - start_us;
+    TEST_ASSERT_EQUAL_UINT16(SERVO_DEFAULT_MAX_PULSE_US, servo->get_pulse());
+    TEST_ASSERT_INT_WITHIN(10000, (SERVO_DEFAULT_MAX_PULSE_US - CENTER_PULSE) * 1000000L / slew, sweep_us);
+}
+
+// 4. Test a small correction goes out immediately, without waiting for a frame
+void test_small_correction_is_immediate(void)
+{
+    servo->set_refresh_rate(SERVO_MIN_REFRESH_HZ);
+    TEST_ASSERT_TRUE(servo->begin());
+    mock_clock::advance_us(1000000);
+
+    servo->write_microseconds(CENTER_PULSE + 20);
+    TEST_ASSERT_EQUAL_UINT16(CENTER_PULSE + 20, servo->get_pulse());
+}
+
+// 5. Test slew limiting can be switched off
+void test_unlimited_slew(void)
+{
+    servo->set_slew_rate(0);
+    TEST_ASSERT_TRUE(servo->begin());
+
+    servo->write_angle(0.0f);
+    TEST_ASSERT_EQUAL_UINT16(SERVO_DEFAULT_MIN_PULSE_US, servo->get_pulse());
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, 0.0f, servo->get_angle());
+}
+
+// 6. Test a slew slower than one microsecond per frame still moves, at its own rate
+void test_slow_slew_accumulates(void)
+{
+    const uint32_t slew = 20; // About 2 degrees per second
+    servo->set_slew_rate(slew);
+    servo->set_refresh_rate(SERVO_MIN_REFRESH_HZ);
+    TEST_ASSERT_TRUE(servo->begin());
+    mock_clock::advance_us(1000000);
+
+    servo->write_microseconds(CENTER_PULSE + 100);
+    mock_clock::advance_us(1000000);
+    TEST_ASSERT_INT_WITHIN(3, CENTER_PULSE + (int)slew, servo->get_pulse());
+    mock_clock::advance_us(1000000);
+    TEST_ASSERT_INT_WITHIN(3, CENTER_PULSE + 2 * (int)slew, servo->get_pulse());
+}
+
+// 7. Test the LEDC output is written outside the driver's critical section
+void test_pin_written_outside_lock(void)
+{
+    TEST_ASSERT_TRUE(servo->begin());
+    servo->write_microseconds(SERVO_DEFAULT_MAX_PULSE_US);
+    mock_clock::advance_us(100000);
+
+    // Retargeting alone leaves the pin to update_output(), or to the next tick
+    servo->set_target_pulse(SERVO_DEFAULT_MIN_PULSE_US);
+    servo->update_output();
+    mock_clock::advance_us(1000000);
+
+    TEST_ASSERT_EQUAL_UINT16(SERVO_DEFAULT_MIN_PULSE_US, servo->get_pulse());
+    TEST_ASSERT_EQUAL_INT(0, mock_servo::writes_in_critical().load());
+}
+
+// 8. Test changing the refresh rate never lets a write hit the channel while it is detached
+void test_refresh_change_while_writing(void)
+{
+    servo->set_slew_rate(0);
+    TEST_ASSERT_TRUE(servo->begin());
+
+    std::atomic<bool> done(false);
+    std::thread writer([&done]() {
+        for (uint16_t i = 0; !done.load(); i++)
+        {
+            servo->write_microseconds((i & 1) ? SERVO_DEFAULT_MIN_PULSE_US : SERVO_DEFAULT_MAX_PULSE_US);
+            std::this_thread::yield();
+        }
+    });
+    for (int i = 0; i < 500; i++)
+    {
+        servo->set_refresh_rate((i & 1) ? SERVO_MIN_REFRESH_HZ : SERVO_MAX_REFRESH_HZ);
+    }
+    done = true;
+    writer.join();
+
+    TEST_ASSERT_EQUAL_INT(0, mock_servo::writes_while_detached().load());
+    TEST_ASSERT_EQUAL_UINT16(SERVO_MIN_REFRESH_HZ, servo->get_refresh_rate());
+}
+
+int main()
+{
+    UNITY_BEGIN();
+
+    RUN_TEST(test_angle_resolution);
+    RUN_TEST(test_refresh_rate_clamped);
+    RUN_TEST(test_slew_limits_large_jumps);
+    RUN_TEST(test_small_correction_is_immediate);
+    RUN_TEST(test_unlimited_slew);
+    RUN_TEST(test_slow_slew_accumulates);
+    RUN_TEST(test_pin_written_outside_lock);
+    RUN_TEST(test_refresh_change_while_writing);
+
+    return UNITY_END();
+}
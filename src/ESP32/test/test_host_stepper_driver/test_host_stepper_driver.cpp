@@ -0,0 +1,300 @@
+#include <Arduino.h>
+#include <unity.h>
+
+#include <vector>
+
+#include "mock_clock.h"
+#include "step_generator.h"
+#include "stepper_driver.h"
+
+#define TEST_MAX_SPEED 800.0f     // steps/s
+#define TEST_ACCELERATION 3200.0f // steps/s^2
+
+// Test pins, Arduino Stepper constructor order
+#define TEST_PIN1 13
+#define TEST_PIN2 5
+#define TEST_PIN3 33
+#define TEST_PIN4 18
+
+/** @brief Step timestamps and directions recorded under the virtual clock. */
+struct StepTrace {
+    std::vector<int64_t> times_us;
+    std::vector<int8_t> directions;
+};
+
+/**
+ * @brief Drives a StepGenerator the way StepperDriver does, on a virtual clock.
+ * @param retarget_after Step count after which @p new_target is applied (-1 = never).
+ */
+static StepTrace simulate(StepGenerator& generator, int32_t target, int32_t retarget_after = -1,
+                          int32_t new_target = 0)
+{
+    StepTrace trace;
+    int64_t now = 0;
+
+    generator.set_target(target);
+    uint32_t interval = generator.start();
+    while (interval != 0 && trace.times_us.size() < 100000)
+    {
+        now += interval;
+        int8_t direction = 0;
+        interval = generator.tick(direction);
+        trace.times_us.push_back(now);
+        trace.directions.push_back(direction);
+
+        if ((int32_t)trace.times_us.size() == retarget_after)
+        {
+            generator.set_target(new_target);
+        }
+    }
+    return trace;
+}
+
+/** @brief Signed step rate between steps i-1 and i (steps/s). */
+static float velocity_at(const StepTrace& trace, size_t i)
+{
+    return 1000000.0f / (float)(trace.times_us[i] - trace.times_us[i - 1]) * trace.directions[i];
+}
+
+/** @brief Largest |dv/dt| over the trace, ignoring the first steps from rest and reversals. */
+static float peak_acceleration(const StepTrace& trace)
+{
+    float peak = 0.0f;
+    for (size_t i = 3; i < trace.times_us.size(); i++)
+    {
+        // Through zero speed the step rate says nothing about acceleration
+        if (trace.directions[i] != trace.directions[i - 2])
+        {
+            continue;
+        }
+        float dv = velocity_at(trace, i) - velocity_at(trace, i - 1);
+        float dt = (float)(trace.times_us[i] - trace.times_us[i - 2]) / 2000000.0f;
+        peak = std::max(peak, fabsf(dv / dt));
+    }
+    return peak;
+}
+
+static StepGenerator make_generator()
+{
+    StepGenerator generator;
+    generator.set_max_speed(TEST_MAX_SPEED);
+    generator.set_acceleration(TEST_ACCELERATION);
+    return generator;
+}
+
+// This runs BEFORE every test case
+void setUp(void)
+{
+    mock_clock::reset();
+}
+
+// This runs AFTER every test case
+void tearDown(void)
+{
+}
+
+// 1. Test a long move follows the trapezoid: ramp up, cruise at max speed, ramp down
+void test_long_move_is_trapezoidal(void)
+{
+    StepGenerator generator = make_generator();
+    StepTrace trace = simulate(generator, 2000);
+
+    TEST_ASSERT_EQUAL_INT32(2000, generator.get_position());
+    TEST_ASSERT_EQUAL_size_t(2000, trace.times_us.size());
+    TEST_ASSERT_FALSE(generator.is_moving());
+
+    // Never faster than the cruise speed (1 µs rounding)
+    for (size_t i = 1; i < trace.times_us.size(); i++)
+    {
+        TEST_ASSERT_TRUE(trace.times_us[i] - trace.times_us[i - 1] >= (int64_t)(1000000.0f / TEST_MAX_SPEED) - 1);
+    }
+
+    // Cruise reached in the middle of the move
+    TEST_ASSERT_FLOAT_WITHIN(5.0f, TEST_MAX_SPEED, velocity_at(trace, 1000));
+
+    // Acceleration bounded by the configured ramp (recurrence error is a few percent)
+    TEST_ASSERT_TRUE(peak_acceleration(trace) < TEST_ACCELERATION * 1.15f);
+
+    // Total time matches d/v + v/a within 5 %
+    float expected_s = 2000.0f / TEST_MAX_SPEED + TEST_MAX_SPEED / TEST_ACCELERATION;
+    TEST_ASSERT_FLOAT_WITHIN(expected_s * 0.05f, expected_s, trace.times_us.back() / 1000000.0f);
+}
+
+// 2. Test a short move turns into a triangle that never reaches cruise speed
+void test_short_move_is_triangular(void)
+{
+    StepGenerator generator = make_generator();
+    StepTrace trace = simulate(generator, -60);
+
+    TEST_ASSERT_EQUAL_INT32(-60, generator.get_position());
+    float peak = 0.0f;
+    for (size_t i = 1; i < trace.times_us.size(); i++)
+    {
+        TEST_ASSERT_EQUAL_INT8(-1, trace.directions[i]);
+        peak = std::max(peak, fabsf(velocity_at(trace, i)));
+    }
+
+    // v_peak = sqrt(a * d) for a symmetric triangle
+    TEST_ASSERT_FLOAT_WITHIN(60.0f, sqrtf(TEST_ACCELERATION * 60.0f), peak);
+    TEST_ASSERT_TRUE(peak < TEST_MAX_SPEED);
+}
+
+// 3. Test reversing the target mid-move brakes, turns around and lands exactly
+void test_retarget_behind_reverses_smoothly(void)
+{
+    StepGenerator generator = make_generator();
+    StepTrace trace = simulate(generator, 1000, 300, -200);
+
+    TEST_ASSERT_EQUAL_INT32(-200, generator.get_position());
+
+    // Braking distance v^2 / 2a carries the motor past the retarget point first
+    int32_t position = 0;
+    int32_t furthest = 0;
+    for (size_t i = 0; i < trace.directions.size(); i++)
+    {
+        position += trace.directions[i];
+        furthest = std::max(furthest, position);
+    }
+    TEST_ASSERT_TRUE(furthest > 300);
+    TEST_ASSERT_EQUAL_INT8(-1, trace.directions.back());
+    TEST_ASSERT_TRUE(peak_acceleration(trace) < TEST_ACCELERATION * 1.15f);
+}
+
+// 4. Test extending the target mid-move keeps cruising without slowing down
+void test_retarget_further_keeps_speed(void)
+{
+    StepGenerator generator = make_generator();
+    StepTrace trace = simulate(generator, 500, 400, 1500);
+
+    TEST_ASSERT_EQUAL_INT32(1500, generator.get_position());
+    for (size_t i = 380; i < 1200; i++)
+    {
+        TEST_ASSERT_TRUE(fabsf(velocity_at(trace, i)) > TEST_MAX_SPEED * 0.9f);
+    }
+}
+
+// 5. Test the driver returns immediately and plays the half-step sequence on the timer
+void test_driver_is_non_blocking_half_step(void)
+{
+    static const uint8_t pins[4] = {TEST_PIN1, TEST_PIN2, TEST_PIN3, TEST_PIN4};
+    static const uint8_t expected[8] = {0b0101, 0b0100, 0b0110, 0b0010, 0b1010, 0b1000, 0b1001, 0b0001};
+
+    StepperDriver driver(TEST_PIN1, TEST_PIN2, TEST_PIN3, TEST_PIN4, StepMode::HalfStep);
+    TEST_ASSERT_TRUE(driver.begin());
+
+    driver.move_relative(20);
+    TEST_ASSERT_TRUE(driver.is_moving());
+    TEST_ASSERT_EQUAL_INT32(0, driver.get_position());
+    TEST_ASSERT_EQUAL_INT32(20, driver.get_target());
+
+    // Walk the clock one µs at a time and record every coil change
+    std::vector<uint8_t> states;
+    uint8_t last = 0xFF;
+    while (driver.is_moving() && mock_clock::now_us() < 1000000)
+    {
+        mock_clock::advance_us(1);
+        uint8_t state = 0;
+        for (uint8_t i = 0; i < 4; i++)
+        {
+            state |= (digitalRead(pins[i]) ? 1 : 0) << i;
+        }
+        if (state != last)
+        {
+            states.push_back(state);
+            last = state;
+        }
+    }
+
+    TEST_ASSERT_FALSE(driver.is_moving());
+    TEST_ASSERT_EQUAL_INT32(20, driver.get_position());
+
+    // 40 half steps: the starting phase, the forward sequence, then coils released after settling
+    TEST_ASSERT_EQUAL_size_t(42, states.size());
+    for (size_t i = 0; i < 41; i++)
+    {
+        TEST_ASSERT_EQUAL_UINT8(expected[i % 8], states[i]);
+    }
+    TEST_ASSERT_EQUAL_UINT8(0, states.back());
+}
+
+// 6. Test relative moves accumulate on the target while the motor is still moving
+void test_driver_relative_moves_accumulate(void)
+{
+    StepperDriver driver(TEST_PIN1, TEST_PIN2, TEST_PIN3, TEST_PIN4, StepMode::FullStep);
+    TEST_ASSERT_TRUE(driver.begin());
+
+    driver.move_relative(50);
+    mock_clock::advance_us(20000);
+    driver.move_relative(50);
+    driver.move_relative(-30);
+    TEST_ASSERT_EQUAL_INT32(70, driver.get_target());
+
+    mock_clock::advance_us(2000000);
+    TEST_ASSERT_FALSE(driver.is_moving());
+    TEST_ASSERT_EQUAL_INT32(70, driver.get_position());
+}
+
+/** @brief Runs @p driver until its coils have changed @p changes times; false if it stopped first. */
+static bool run_until_coil_changes(StepperDriver& driver, int changes)
+{
+    static const uint8_t pins[4] = {TEST_PIN1, TEST_PIN2, TEST_PIN3, TEST_PIN4};
+    int seen = 0;
+    uint8_t last = 0xFF;
+    while (driver.is_moving() && mock_clock::now_us() < 10000000)
+    {
+        mock_clock::advance_us(1);
+        uint8_t state = 0;
+        for (uint8_t i = 0; i < 4; i++)
+        {
+            state |= (digitalRead(pins[i]) ? 1 : 0) << i;
+        }
+        if (state != last)
+        {
+            last = state;
+            if (++seen > changes) // The first change is the starting phase, not a step
+            {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+// 7. Test a half-step between two full steps reads as the lower one on both sides of zero
+void test_half_step_position_rounds_down(void)
+{
+    StepperDriver forward(TEST_PIN1, TEST_PIN2, TEST_PIN3, TEST_PIN4, StepMode::HalfStep);
+    TEST_ASSERT_TRUE(forward.begin());
+    forward.move_relative(2);
+    TEST_ASSERT_TRUE(run_until_coil_changes(forward, 1));
+    TEST_ASSERT_EQUAL_INT32(0, forward.get_position()); // Half-step +1
+    TEST_ASSERT_TRUE(run_until_coil_changes(forward, 1));
+    TEST_ASSERT_EQUAL_INT32(1, forward.get_position()); // Half-step +2
+    mock_clock::advance_us(1000000);
+
+    StepperDriver backward(TEST_PIN1, TEST_PIN2, TEST_PIN3, TEST_PIN4, StepMode::HalfStep);
+    TEST_ASSERT_TRUE(backward.begin());
+    backward.move_relative(-2);
+    TEST_ASSERT_TRUE(run_until_coil_changes(backward, 1));
+    TEST_ASSERT_EQUAL_INT32(-1, backward.get_position()); // Half-step -1: rounded down, not towards zero
+    TEST_ASSERT_EQUAL_FLOAT(-0.5f, backward.get_exact_position());
+    TEST_ASSERT_TRUE(run_until_coil_changes(backward, 1));
+    TEST_ASSERT_EQUAL_INT32(-1, backward.get_position()); // Half-step -2
+    mock_clock::advance_us(1000000);
+    TEST_ASSERT_EQUAL_INT32(-2, backward.get_position());
+}
+
+int main()
+{
+    UNITY_BEGIN();
+
+    RUN_TEST(test_long_move_is_trapezoidal);
+    RUN_TEST(test_short_move_is_triangular);
+    RUN_TEST(test_retarget_behind_reverses_smoothly);
+    RUN_TEST(test_retarget_further_keeps_speed);
+    RUN_TEST(test_driver_is_non_blocking_half_step);
+    RUN_TEST(test_driver_relative_moves_accumulate);
+    RUN_TEST(test_half_step_position_rounds_down);
+
+    return UNITY_END();
+}
@@ -0,0 +1,221 @@
+#include <Arduino.h>
+#include <unity.h>
+
+#include <string.h>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+
+#include "latency_probe.h"
+#include "trace.h"
+
+#define STRESS_WRITERS 3
+#define STRESS_EVENTS 50000
+
+/** @brief TraceWriter that appends the dump to a byte vector. */
+static bool collect(const void* data, size_t size, void* arg)
+{
+    std::vector<uint8_t>* bytes = static_cast<std::vector<uint8_t>*>(arg);
+    bytes->insert(bytes->end(), (const uint8_t*)data, (const uint8_t*)data + size);
+    return true;
+}
+
+/** @brief TraceWriter that gives up after the header. */
+static bool refuse_events(const void*, size_t size, void*) { return size == sizeof(TraceDumpHeader); }
+
+/** @brief Splits a dump back into its header and events. */
+static void parse(const std::vector<uint8_t>& bytes, TraceDumpHeader& header, std::vector<TraceEvent>& events)
+{
+    TEST_ASSERT_TRUE(bytes.size() >= sizeof(header));
+    memcpy(&header, bytes.data(), sizeof(header));
+    TEST_ASSERT_EQUAL_UINT32(0, (bytes.size() - sizeof(header)) % sizeof(TraceEvent));
+
+    events.resize((bytes.size() - sizeof(header)) / sizeof(TraceEvent));
+    if (!events.empty())
+    {
+        memcpy(events.data(), bytes.data() + sizeof(header), events.size() * sizeof(TraceEvent));
+    }
+}
+
+// This runs BEFORE every test case
+void setUp(void)
+{
+    trace_clear();
+    mock_freertos::current_core() = 0;
+}
+
+// This runs AFTER every test case
+void tearDown(void)
+{
+}
+
+// 1. Test an event comes back from the ring exactly as recorded
+void test_record_and_read(void)
+{
+    mock_freertos::current_core() = 1;
+    trace_record(TraceId::StreamFrame, TracePhase::Instant, 0xDEADBEEF, 7, 0xFFFFFFFF);
+
+    TraceEvent event;
+    TEST_ASSERT_EQUAL_UINT32(0, trace_ring(0).head());
+    TEST_ASSERT_EQUAL_UINT32(1, trace_ring(1).head());
+    TEST_ASSERT_TRUE(trace_ring(1).read(0, event));
+    TEST_ASSERT_EQUAL_HEX32(0xDEADBEEF, event.timestamp_us);
+    TEST_ASSERT_EQUAL_UINT32((uint16_t)TraceId::StreamFrame, event.id);
+    TEST_ASSERT_EQUAL_UINT32((uint8_t)TracePhase::Instant, event.phase);
+    TEST_ASSERT_EQUAL_UINT32(1, event.core);
+    TEST_ASSERT_EQUAL_UINT32(7, event.arg0);
+    TEST_ASSERT_EQUAL_HEX32(0xFFFFFFFF, event.arg1);
+    TEST_ASSERT_FALSE(trace_ring(1).read(1, event)); // Not recorded yet
+}
+
+// 2. Test a full ring keeps the newest events and the dump counts what was lost
+void test_wrap_keeps_newest(void)
+{
+    const uint32_t total = TRACE_RING_SIZE + 100;
+    for (uint32_t i = 0; i < total; i++)
+    {
+        trace_record(TraceId::WifiCheck, TracePhase::Instant, i, i, 0);
+    }
+
+    TraceEvent event;
+    TEST_ASSERT_FALSE(trace_ring(0).read(99, event)); // Overwritten
+    TEST_ASSERT_TRUE(trace_ring(0).read(100, event));
+    TEST_ASSERT_EQUAL_UINT32(100, event.arg0);
+
+    std::vector<uint8_t> bytes;
+    TEST_ASSERT_EQUAL_UINT32(TRACE_RING_SIZE, trace_dump(&collect, &bytes));
+    TraceDumpHeader header;
+    std::vector<TraceEvent> events;
+    parse(bytes, header, events);
+    TEST_ASSERT_EQUAL_HEX32(TRACE_DUMP_MAGIC, header.magic);
+    TEST_ASSERT_EQUAL_UINT32(TRACE_DUMP_VERSION, header.version);
+    TEST_ASSERT_EQUAL_UINT32(sizeof(TraceEvent), header.event_size);
+    TEST_ASSERT_EQUAL_UINT32(100, header.overwritten);
+    TEST_ASSERT_EQUAL_UINT32(TRACE_RING_SIZE, events.size());
+    TEST_ASSERT_EQUAL_UINT32(100, events.front().arg0); // Oldest kept first
+    TEST_ASSERT_EQUAL_UINT32(total - 1, events.back().arg0);
+}
+
+// 3. Test scopes and latency probes become slices with their start time and duration
+void test_scopes_record_slices(void)
+{
+    int64_t start = esp_timer_get_time();
+    {
+        TRACE_SCOPE(FramePublish, 3);
+        delay(2);
+    }
+    {
+        LATENCY_PROBE(Kernel);
+        delayMicroseconds(700);
+    }
+    TRACE_COUNTER(FramesInUse, 5);
+
+    std::vector<uint8_t> bytes;
+    TEST_ASSERT_EQUAL_UINT32(3, trace_dump(&collect, &bytes));
+    TraceDumpHeader header;
+    std::vector<TraceEvent> events;
+    parse(bytes, header, events);
+
+    TEST_ASSERT_EQUAL_UINT32((uint16_t)TraceId::FramePublish, events[0].id);
+    TEST_ASSERT_EQUAL_UINT32((uint8_t)TracePhase::Complete, events[0].phase);
+    TEST_ASSERT_EQUAL_UINT32((uint32_t)start, events[0].timestamp_us);
+    TEST_ASSERT_EQUAL_UINT32(2000, events[0].arg0);
+    TEST_ASSERT_EQUAL_UINT32(3, events[0].arg1);
+
+    TEST_ASSERT_EQUAL_UINT32((uint16_t)TraceId::Kernel, events[1].id);
+    TEST_ASSERT_EQUAL_UINT32((uint32_t)start + 2000, events[1].timestamp_us);
+    TEST_ASSERT_EQUAL_UINT32(700, events[1].arg0);
+
+    TEST_ASSERT_EQUAL_UINT32((uint8_t)TracePhase::Counter, events[2].phase);
+    TEST_ASSERT_EQUAL_UINT32(5, events[2].arg0);
+    TEST_ASSERT_EQUAL_UINT64((uint64_t)esp_timer_get_time(), header.now_us);
+}
+
+// 4. Test pinned tasks record into their own core's ring
+void test_tasks_use_their_core(void)
+{
+    std::atomic<int> finished{0};
+    auto body = [](void* arg) {
+        std::atomic<int>* done = static_cast<std::atomic<int>*>(arg);
+        TRACE_INSTANT(Detect, xPortGetCoreID(), 0);
+        (*done)++;
+        vTaskDelete(nullptr);
+    };
+    TaskHandle_t handles[2];
+    xTaskCreatePinnedToCore(body, "core0", 2048, &finished, 1, &handles[0], 0);
+    xTaskCreatePinnedToCore(body, "core1", 2048, &finished, 1, &handles[1], 1);
+    while (finished.load() < 2)
+    {
+        std::this_thread::yield();
+    }
+
+    TraceEvent event;
+    for (uint32_t core = 0; core < TRACE_CORES; core++)
+    {
+        TEST_ASSERT_EQUAL_UINT32(1, trace_ring(core).head());
+        TEST_ASSERT_TRUE(trace_ring(core).read(0, event));
+        TEST_ASSERT_EQUAL_UINT32(core, event.core);
+        TEST_ASSERT_EQUAL_UINT32(core, event.arg0);
+    }
+
+    std::vector<uint8_t> bytes;
+    TEST_ASSERT_EQUAL_UINT32(0, trace_dump(&refuse_events, &bytes)); // Writer abort stops the dump
+}
+
+// 5. Test a dump taken while writers race on one core never contains a torn event
+void test_dump_during_writes(void)
+{
+    std::vector<std::thread> writers;
+    for (int w = 0; w < STRESS_WRITERS; w++)
+    {
+        writers.emplace_back([w]() {
+            for (uint32_t i = 0; i < STRESS_EVENTS; i++)
+            {
+                uint32_t value = ((uint32_t)w << 24) | i;
+                trace_record(TraceId::StreamFrame, TracePhase::Instant, value, value, ~value);
+            }
+        });
+    }
+
+    // Dump over and over until the writers are done, then once more with the ring at rest
+    size_t dumped = 0;
+    bool writing = true;
+    while (writing)
+    {
+        writing = trace_ring(0).head() < STRESS_WRITERS * STRESS_EVENTS;
+        std::vector<uint8_t> bytes;
+        trace_dump(&collect, &bytes);
+        TraceDumpHeader header;
+        std::vector<TraceEvent> events;
+        parse(bytes, header, events);
+        for (const TraceEvent& event : events)
+        {
+            TEST_ASSERT_EQUAL_HEX32(event.timestamp_us, event.arg0);
+            TEST_ASSERT_EQUAL_HEX32(~event.arg0, event.arg1);
+        }
+        dumped += events.size();
+    }
+
+    for (std::thread& writer : writers)
+    {
+        writer.join();
+    }
+    TEST_ASSERT_EQUAL_UINT32(STRESS_WRITERS * STRESS_EVENTS, trace_ring(0).head());
+    TEST_ASSERT_TRUE(dumped > 0);
+}
+
+int main()
+{
+    UNITY_BEGIN();
+
+    RUN_TEST(test_record_and_read);
+    RUN_TEST(test_wrap_keeps_newest);
+    RUN_TEST(test_scopes_record_slices);
+    RUN_TEST(test_tasks_use_their_core);
+    RUN_TEST(test_dump_during_writes);
+
+    return UNITY_END();
+}
@@ -0,0 +1,152 @@
+#include <Arduino.h>
+#include <unity.h>
+
+#include "turret_sim.h"
+
+// This runs BEFORE every test case
+void setUp(void)
+{
+}
+
+// This runs AFTER every test case
+void tearDown(void)
+{
+}
+
+// 1. Test a target popping up off-centre is acquired and held
+void test_static_target_acquired(void)
+{
+    SimTarget target;
+    target.azimuth_deg = 12.0f;
+    target.elevation_deg = 6.0f;
+    target.appear_s = 1.0f;
+
+    TurretSimulator sim(target, DiffMode::SigmaDelta);
+    SimReport report = sim.run(6.0f);
+    report.print("static pop-up");
+
+    TEST_ASSERT_TRUE(report.acquired());
+    TEST_ASSERT_TRUE(report.time_to_acquire_s < 1.0f);
+    TEST_ASSERT_TRUE(report.steady_state_rms_deg < 1.0f);
+    TEST_ASSERT_TRUE(report.pan_duty < 0.2f); // Settles instead of hunting
+}
+
+// 2. Test a target crossing the scene is followed on both axes
+void test_moving_target_tracked(void)
+{
+    SimTarget target;
+    target.azimuth_deg = -10.0f;
+    target.elevation_deg = -4.0f;
+    target.azimuth_rate_deg_s = 8.0f;
+    target.elevation_rate_deg_s = 2.0f;
+
+    TurretSimulator sim(target, DiffMode::ThreeFrame);
+    SimReport report = sim.run(8.0f);
+    report.print("moving crossing");
+
+    TEST_ASSERT_TRUE(report.acquired());
+    TEST_ASSERT_TRUE(report.time_to_acquire_s < 2.0f);
+    TEST_ASSERT_TRUE(report.steady_state_rms_deg < 2.0f);
+    TEST_ASSERT_FLOAT_WITHIN(3.0f, 8.0f * 8.0f - 10.0f, sim.pan_deg()); // Still on it at the end
+}
+
+// 3. Test an empty scene never moves the motors
+void test_empty_scene_idle(void)
+{
+    SimTarget target;
+    target.appear_s = 1000.0f;
+
+    TurretSimulator sim(target, DiffMode::PreviousFrame);
+    SimReport report = sim.run(3.0f);
+    report.print("empty scene");
+
+    TEST_ASSERT_EQUAL_UINT32(3 * SIM_FRAME_RATE_HZ, report.frames);
+    TEST_ASSERT_EQUAL_FLOAT(0.0f, report.pan_duty);
+    TEST_ASSERT_EQUAL_FLOAT(0.0f, report.tilt_duty);
+    TEST_ASSERT_EQUAL_FLOAT(0.0f, sim.pan_deg());
+}
+
+// 4. Test the same scenario always gives the same report
+void test_deterministic(void)
+{
+    SimTarget target;
+    target.azimuth_deg = 5.0f;
+    target.azimuth_rate_deg_s = -6.0f;
+
+    SimReport first;
+    SimReport second;
+    {
+        TurretSimulator sim(target, DiffMode::PreviousFrame);
+        first = sim.run(4.0f);
+    }
+    {
+        TurretSimulator sim(target, DiffMode::PreviousFrame);
+        second = sim.run(4.0f);
+    }
+
+    TEST_ASSERT_EQUAL_FLOAT(first.time_to_acquire_s, second.time_to_acquire_s);
+    TEST_ASSERT_EQUAL_FLOAT(first.steady_state_rms_deg, second.steady_state_rms_deg);
+    TEST_ASSERT_EQUAL_FLOAT(first.pan_duty, second.pan_duty);
+}
+
+// 5. Test calibration recovers the simulated optics and tracking still converges with it
+void test_calibrated_tracking(void)
+{
+    SimTarget target;
+    target.azimuth_deg = -14.0f;
+    target.elevation_deg = 5.0f;
+    target.appear_s = 8.0f;
+
+    TurretSimulator sim(target, DiffMode::SigmaDelta);
+    CameraCalibration calibration;
+    TEST_ASSERT_TRUE(sim.calibrate(calibration));
+    Serial.printf("[SIM] calibration        pan %.4f px/step, tilt %.4f px/deg\n", calibration.pan_px_per_step,
+                  calibration.tilt_px_per_degree);
+
+    const float pan_truth = (float)SIM_FRAME_WIDTH / CAMERA_HFOV_DEG * 360.0f / STEPPER_NUMBER_OF_STEPS;
+    const float tilt_truth = (float)SIM_FRAME_HEIGHT / CAMERA_VFOV_DEG;
+    TEST_ASSERT_EQUAL_UINT16(SIM_FRAME_WIDTH, calibration.frame_width);
+    TEST_ASSERT_FLOAT_WITHIN(pan_truth * 0.05f, pan_truth, calibration.pan_px_per_step);
+    TEST_ASSERT_FLOAT_WITHIN(tilt_truth * 0.05f, tilt_truth, calibration.tilt_px_per_degree);
+    TEST_ASSERT_EQUAL_FLOAT(0.0f, sim.pan_deg()); // Back where it started
+    TEST_ASSERT_TRUE(millis() < 7000);             // Done before the target appears
+
+    SimReport report = sim.run(12.0f - millis() / 1000.0f);
+    report.print("calibrated pop-up");
+
+    TEST_ASSERT_TRUE(report.acquired());
+    TEST_ASSERT_TRUE(report.time_to_acquire_s < 1.0f);
+    TEST_ASSERT_TRUE(report.steady_state_rms_deg < 1.0f);
+}
+
+// 6. Test a target popping up in a corner of the frame is held without distortion-driven corrections
+void test_corner_target_acquired(void)
+{
+    SimTarget target;
+    target.azimuth_deg = 22.0f;
+    target.elevation_deg = -16.0f;
+    target.size_deg = 4.0f;
+    target.appear_s = 1.0f;
+
+    TurretSimulator sim(target, DiffMode::SigmaDelta);
+    SimReport report = sim.run(5.0f);
+    report.print("corner pop-up");
+
+    TEST_ASSERT_TRUE(report.acquired());
+    TEST_ASSERT_TRUE(report.time_to_acquire_s < 0.8f);
+    TEST_ASSERT_TRUE(report.steady_state_rms_deg < 0.5f); // No late correction rounds after the first pass
+}
+
+int main()
+{
+    UNITY_BEGIN();
+
+    RUN_TEST(test_static_target_acquired);
+    RUN_TEST(test_moving_target_tracked);
+    RUN_TEST(test_empty_scene_idle);
+    RUN_TEST(test_deterministic);
+    RUN_TEST(test_calibrated_tracking);
+    RUN_TEST(test_corner_target_acquired);
+
+    return UNITY_END();
+}
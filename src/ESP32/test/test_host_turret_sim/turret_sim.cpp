@@ -0,0 +1,230 @@
+#include "turret_sim.h"
+
+#include <Arduino.h>
+#include <math.h>
+#include <string.h>
+
+#include "mock_clock.h"
+
+void SimReport::print(const char* name) const
+{
+    Serial.printf("[SIM] %-18s frames %4u | acquire %6.2f s | steady-state %5.2f deg RMS, %5.2f max | "
+                  "duty pan %3.0f%% tilt %3.0f%%\n",
+                  name, (unsigned)this->frames, this->time_to_acquire_s, this->steady_state_rms_deg,
+                  this->steady_state_max_deg, this->pan_duty * 100.0f, this->tilt_duty * 100.0f);
+}
+
+TurretSimulator::TurretSimulator(const SimTarget& target, DiffMode mode)
+    : _stepper(STEPPER_PIN1, STEPPER_PIN3, STEPPER_PIN2, STEPPER_PIN4), _servo(SERVO_PIN), _motors(_stepper, _servo),
+      _detector(mode), _joystick(JOYSTICK_PIN_X, JOYSTICK_PIN_Y, JOYSTICK_PIN_Z),
+      _controller(_motors, _detector, _joystick, &_camera), _target(target), _horn_deg(SERVO_CENTER_ANGLE),
+      _horn_updated_us(0), _textured(false), _noise_state(12345), _frame(), _frame_ready(false)
+{
+    mock_clock::reset();
+    mock_arduino::pin_levels()[JOYSTICK_PIN_Z] = HIGH; // Button released: stay in AI mode
+
+    this->_stepper.begin();
+    this->_servo.begin();
+    this->_motors.begin();
+
+    this->_frame.buf = this->_pixels;
+    this->_frame.len = sizeof(this->_pixels);
+    this->_frame.width = SIM_FRAME_WIDTH;
+    this->_frame.height = SIM_FRAME_HEIGHT;
+    this->_frame.format = PIXFORMAT_GRAYSCALE;
+
+    LensModel lens = LensModel::nominal(SIM_FRAME_WIDTH, SIM_FRAME_HEIGHT);
+    this->_pixel_pan_deg.resize(SIM_FRAME_WIDTH * SIM_FRAME_HEIGHT);
+    this->_pixel_tilt_deg.resize(SIM_FRAME_WIDTH * SIM_FRAME_HEIGHT);
+    for (int y = 0; y < SIM_FRAME_HEIGHT; y++)
+    {
+        for (int x = 0; x < SIM_FRAME_WIDTH; x++)
+        {
+            lens.pixel_to_angles(x + 0.5f - SIM_FRAME_WIDTH / 2.0f, y + 0.5f - SIM_FRAME_HEIGHT / 2.0f,
+                                 this->_pixel_pan_deg[y * SIM_FRAME_WIDTH + x],
+                                 this->_pixel_tilt_deg[y * SIM_FRAME_WIDTH + x]);
+        }
+    }
+
+    mock_camera::set_source(&TurretSimulator::_capture, this);
+}
+
+TurretSimulator::~TurretSimulator()
+{
+    mock_camera::set_source(nullptr, nullptr);
+}
+
+SimReport TurretSimulator::run(float duration_s)
+{
+    const int64_t frame_us = 1000000 / SIM_FRAME_RATE_HZ;
+    const int64_t end_us = mock_clock::now_us() + (int64_t)(duration_s * 1000000.0f);
+
+    SimReport report;
+    uint32_t ticks = 0;
+    uint32_t pan_busy = 0;
+    uint32_t tilt_busy = 0;
+    int64_t next_capture_us = mock_clock::now_us() + frame_us;
+    int64_t next_run_us = -1;
+
+    while (mock_clock::now_us() < end_us)
+    {
+        mock_clock::advance_us(SIM_TICK_US);
+        int64_t now_us = mock_clock::now_us();
+
+        float horn_before = this->_horn_deg;
+        _update_horn();
+        ticks++;
+        pan_busy += this->_stepper.is_moving() ? 1 : 0;
+        tilt_busy += (this->_horn_deg != horn_before) ? 1 : 0;
+
+        if (now_us >= next_capture_us)
+        {
+            float time_s = now_us / 1000000.0f;
+            _render(time_s);
+            report.frames++;
+            next_run_us = now_us + SIM_PIPELINE_LATENCY_US;
+            next_capture_us += frame_us;
+
+            if (time_s >= this->_target.appear_s)
+            {
+                float azimuth = 0.0f;
+                float elevation = 0.0f;
+                _target_at(time_s, azimuth, elevation);
+                this->_errors.push_back(hypotf(azimuth - pan_deg(), elevation - tilt_deg()));
+            }
+        }
+
+        if (next_run_us >= 0 && now_us >= next_run_us)
+        {
+            this->_controller.run_once(); // The frame schedule paces it here
+            next_run_us = -1;
+        }
+    }
+
+    report.pan_duty = ticks ? (float)pan_busy / ticks : 0.0f;
+    report.tilt_duty = ticks ? (float)tilt_busy / ticks : 0.0f;
+
+    // Acquired at the first frame that starts a run of SIM_ACQUIRE_HOLD_FRAMES on target
+    size_t count = this->_errors.size();
+    for (size_t i = 0; i + SIM_ACQUIRE_HOLD_FRAMES <= count; i++)
+    {
+        bool held = true;
+        for (size_t j = i; j < i + SIM_ACQUIRE_HOLD_FRAMES && held; j++)
+        {
+            held = this->_errors[j] <= SIM_ACQUIRE_DEG;
+        }
+        if (!held)
+        {
+            continue;
+        }
+
+        report.time_to_acquire_s = (float)i / SIM_FRAME_RATE_HZ;
+
+        float sum_squares = 0.0f;
+        for (size_t j = i; j < count; j++)
+        {
+            sum_squares += this->_errors[j] * this->_errors[j];
+            report.steady_state_max_deg = fmaxf(report.steady_state_max_deg, this->_errors[j]);
+        }
+        report.steady_state_rms_deg = sqrtf(sum_squares / (count - i));
+        break;
+    }
+
+    return report;
+}
+
+bool TurretSimulator::calibrate(CameraCalibration& calibration)
+{
+    this->_textured = true;
+    Calibrator calibrator(this->_motors, this->_camera);
+    bool calibrated = calibrator.run(calibration);
+    this->_textured = false;
+
+    if (calibrated)
+    {
+        this->_controller.set_calibration(calibration);
+    }
+    return calibrated;
+}
+
+float TurretSimulator::pan_deg()
+{
+    // The rotor's real angle, half steps included: the rendered scene must not inherit get_position()'s rounding
+    return this->_stepper.get_exact_position() * 360.0f / STEPPER_NUMBER_OF_STEPS;
+}
+
+camera_fb_t* TurretSimulator::_capture(void* arg)
+{
+    TurretSimulator* sim = static_cast<TurretSimulator*>(arg);
+    if (!sim->_frame_ready)
+    {
+        sim->_render(mock_clock::now_us() / 1000000.0f);
+    }
+
+    sim->_frame_ready = false;
+    return &sim->_frame;
+}
+
+void TurretSimulator::_render(float time_s)
+{
+    _update_horn();
+
+    bool target_visible = time_s >= this->_target.appear_s;
+    float azimuth = 0.0f;
+    float elevation = 0.0f;
+    _target_at(time_s, azimuth, elevation);
+    const float half_size = this->_target.size_deg / 2.0f;
+    const float pan = pan_deg();
+    const float tilt = tilt_deg();
+
+    // Every pixel looks along its own bearing, image rows growing downwards
+    for (size_t i = 0; i < sizeof(this->_pixels); i++)
+    {
+        float pixel_azimuth = pan + this->_pixel_pan_deg[i];
+        float pixel_elevation = tilt - this->_pixel_tilt_deg[i];
+
+        int luma = this->_textured ? _backdrop(pixel_azimuth, pixel_elevation) : SIM_BACKGROUND_LUMA;
+        if (target_visible && fabsf(pixel_azimuth - azimuth) <= half_size &&
+            fabsf(pixel_elevation - elevation) <= half_size)
+        {
+            luma = SIM_TARGET_LUMA;
+        }
+        this->_pixels[i] = (uint8_t)(luma + _noise());
+    }
+
+    int64_t now_us = mock_clock::now_us();
+    this->_frame.timestamp.tv_sec = (time_t)(now_us / 1000000);
+    this->_frame.timestamp.tv_usec = (suseconds_t)(now_us % 1000000);
+    this->_frame_ready = true;
+}
+
+void TurretSimulator::_update_horn()
+{
+    int64_t now_us = mock_clock::now_us();
+    const float max_step = SIM_SERVO_SPEED_DEG_S * (now_us - this->_horn_updated_us) / 1000000.0f;
+    float commanded = this->_servo.get_angle();
+
+    this->_horn_deg += constrain(commanded - this->_horn_deg, -max_step, max_step);
+    this->_horn_updated_us = now_us;
+}
+
+uint8_t TurretSimulator::_backdrop(float azimuth_deg, float elevation_deg) const
+{
+    // Incommensurate waves, so no shift within the calibration search range repeats the scene
+    float value = 128.0f + SIM_TEXTURE_LUMA * (sinf(azimuth_deg * 0.35f) + sinf(azimuth_deg * 0.13f + 1.0f) +
+                                               sinf(elevation_deg * 0.41f + 0.5f) +
+                                               0.6f * sinf(elevation_deg * 0.17f + azimuth_deg * 0.07f));
+    return (uint8_t)constrain((int)value, SIM_NOISE_LUMA, 255 - SIM_NOISE_LUMA);
+}
+
+void TurretSimulator::_target_at(float time_s, float& azimuth_deg, float& elevation_deg) const
+{
+    azimuth_deg = this->_target.azimuth_deg + this->_target.azimuth_rate_deg_s * time_s;
+    elevation_deg = this->_target.elevation_deg + this->_target.elevation_rate_deg_s * time_s;
+}
+
+int TurretSimulator::_noise()
+{
+    this->_noise_state = this->_noise_state * 1664525u + 1013904223u;
+    return (int)((this->_noise_state >> 16) % (2 * SIM_NOISE_LUMA + 1)) - SIM_NOISE_LUMA;
+}
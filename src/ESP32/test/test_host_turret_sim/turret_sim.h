@@ -0,0 +1,158 @@
+/**
+ * @file turret_sim.h
+ * @brief Closed-loop turret simulator: real control code, simulated physics and camera.
+ */
+#pragma once
+
+#include <stdint.h>
+
+#include <vector>
+
+#include "calibrator.h"
+#include "camera.h"
+#include "camera_calibration.h"
+#include "camera_diff_detection.h"
+#include "constants.h"
+#include "controller.h"
+#include "joystick.h"
+#include "lens_model.h"
+#include "movement_manager.h"
+#include "servo_driver.h"
+#include "stepper_driver.h"
+
+#define SIM_FRAME_WIDTH 160           /**< QQVGA, the smallest profile with room for a target. */
+#define SIM_FRAME_HEIGHT 120          /**< QQVGA. */
+#define SIM_FRAME_RATE_HZ 15          /**< Camera frame rate. */
+#define SIM_PIPELINE_LATENCY_US 40000 /**< Capture to Controller::run_once(); must stay below one frame. */
+#define SIM_TICK_US 1000              /**< Physics and duty sampling step. */
+#define SIM_BACKGROUND_LUMA 60        /**< Flat scene behind the target. */
+#define SIM_TARGET_LUMA 200           /**< Target brightness. */
+#define SIM_NOISE_LUMA 6              /**< Sensor noise amplitude, well under DIFF_PIXEL_THRESHOLD. */
+#define SIM_TEXTURE_LUMA 30           /**< Amplitude of each wave of the calibration backdrop. */
+#define SIM_SERVO_SPEED_DEG_S 600.0f  /**< SG90 horn speed: 60 degrees in 0.1 s. */
+#define SIM_ACQUIRE_DEG 2.0f          /**< Pointing error that counts as on target. */
+#define SIM_ACQUIRE_HOLD_FRAMES 5     /**< Frames the error must stay inside SIM_ACQUIRE_DEG. */
+
+/**
+ * @struct SimTarget
+ * @brief A square target moving at constant angular velocity.
+ * @details Angles are in the turret frame: azimuth 0 is the power-on pan heading
+ * (positive to the right), and elevation 0 is the servo at SERVO_CENTER_ANGLE
+ * (positive up).
+ */
+struct SimTarget {
+    float azimuth_deg = 0.0f;          /**< Azimuth at t = 0. */
+    float elevation_deg = 0.0f;        /**< Elevation at t = 0. */
+    float azimuth_rate_deg_s = 0.0f;   /**< Angular velocity, positive to the right. */
+    float elevation_rate_deg_s = 0.0f; /**< Angular velocity, positive up. */
+    float size_deg = 6.0f;             /**< Edge length of the square. */
+    float appear_s = 0.0f;             /**< Time the target enters the scene. */
+};
+
+/**
+ * @struct SimReport
+ * @brief Tracking performance of one simulated run.
+ */
+struct SimReport {
+    uint32_t frames = 0;               /**< Frames captured. */
+    float time_to_acquire_s = -1.0f;   /**< From appearance to holding SIM_ACQUIRE_DEG; < 0 if never. */
+    float steady_state_rms_deg = 0.0f; /**< RMS pointing error from acquisition to the end. */
+    float steady_state_max_deg = 0.0f; /**< Worst pointing error from acquisition to the end. */
+    float pan_duty = 0.0f;             /**< Share of the run the stepper was moving. */
+    float tilt_duty = 0.0f;            /**< Share of the run the servo horn was moving. */
+
+    /** @return true if the target was acquired. */
+    bool acquired() const { return this->time_to_acquire_s >= 0.0f; }
+
+    /** @brief Prints a one-line summary tagged with @p name. */
+    void print(const char* name) const;
+};
+
+/**
+ * @class TurretSimulator
+ * @brief Runs the real Controller, MovementManager, drivers and detector against a
+ * simulated turret and scene.
+ * @details The stepper and servo drivers run on the mock clock unchanged, so pan is
+ * exactly the StepperDriver position, in STEPPER_NUMBER_OF_STEPS per turn. The servo
+ * horn follows the commanded pulse at SIM_SERVO_SPEED_DEG_S. Each frame is rendered
+ * from the true pose as a GRAYSCALE camera_fb_t through the nominal LensModel: a
+ * CAMERA_HFOV_DEG x CAMERA_VFOV_DEG field of view with CAMERA_DISTORTION_K1 barrel. Controller::run_once() receives it
+ * SIM_PIPELINE_LATENCY_US later, through the real Camera and esp_camera_fb_get().
+ * Other callers of the camera, such as the Calibrator, get a frame rendered on demand.
+ *
+ * Everything is deterministic: the same target gives the same report on every run,
+ * which makes the simulator a regression harness for the control loop.
+ */
+class TurretSimulator
+{
+private:
+    StepperDriver _stepper;
+    ServoDriver _servo;
+    MovementManager _motors;
+    CameraDiffDetection _detector;
+    Joystick _joystick;
+    Camera _camera;
+    Controller _controller;
+
+    SimTarget _target;
+    float _horn_deg;                                     /**< Physical servo angle. */
+    int64_t _horn_updated_us;                            /**< Clock time _horn_deg was last advanced to. */
+    bool _textured;                                      /**< Render a textured backdrop instead of a flat one. */
+    uint32_t _noise_state;                               /**< LCG state for sensor noise. */
+    uint8_t _pixels[SIM_FRAME_WIDTH * SIM_FRAME_HEIGHT]; /**< Frame buffer of _frame. */
+    camera_fb_t _frame;                                  /**< Last rendered frame. */
+    bool _frame_ready;                                   /**< _frame was rendered and not yet captured. */
+    std::vector<float> _errors;                          /**< Pointing error per frame, from appearance. */
+    std::vector<float> _pixel_pan_deg;                   /**< Bearing of each pixel right of the optical axis. */
+    std::vector<float> _pixel_tilt_deg;                  /**< Bearing of each pixel below the optical axis. */
+
+    /** @brief mock_camera frame source trampoline. */
+    static camera_fb_t* _capture(void* arg);
+
+    /** @brief Renders the scene as seen from the current pose into _frame. */
+    void _render(float time_s);
+
+    /** @brief Advances the servo horn towards its commanded angle up to the current time. */
+    void _update_horn();
+
+    /** @return Backdrop luma in the direction (azimuth, elevation). */
+    uint8_t _backdrop(float azimuth_deg, float elevation_deg) const;
+
+    /** @brief Target azimuth and elevation at @p time_s. */
+    void _target_at(float time_s, float& azimuth_deg, float& elevation_deg) const;
+
+    /** @return Uniform noise in [-SIM_NOISE_LUMA, SIM_NOISE_LUMA]. */
+    int _noise();
+
+public:
+    /**
+     * @brief Builds the turret at its power-on pose, looking at azimuth 0 and elevation 0.
+     * @param target Scene to track.
+     * @param mode Detector reference model.
+     */
+    TurretSimulator(const SimTarget& target, DiffMode mode);
+    ~TurretSimulator();
+
+    TurretSimulator(const TurretSimulator&) = delete;
+    TurretSimulator& operator=(const TurretSimulator&) = delete;
+
+    /**
+     * @brief Runs the closed loop for @p duration_s of simulated time.
+     * @return Acquisition time, steady-state error and motor duty.
+     */
+    SimReport run(float duration_s);
+
+    /**
+     * @brief Runs the real Calibrator against a textured backdrop and hands the result
+     * to the Controller.
+     * @param calibration Receives the measured scales.
+     * @return true if the calibration succeeded.
+     */
+    bool calibrate(CameraCalibration& calibration);
+
+    /** @return Pan heading in degrees, from the stepper position. */
+    float pan_deg();
+
+    /** @return Physical tilt elevation in degrees. */
+    float tilt_deg() const { return this->_horn_deg - SERVO_CENTER_ANGLE; }
+};
@@ -0,0 +1,72 @@
+#include <Arduino.h>
+#include <unity.h>
+#include "detection_result.h"
+#include "pid_controller.h"
+#include "pid_profiles.h"
+
+// 1.0 in Q16, handy for unit gains
+#define ONE_Q16 (1 << PID_GAIN_SHIFT)
+
+// 1. A pure P loop scales the error
+void test_proportional_only(void)
+{
+    PidController pid({ONE_Q16 / 2, 0, 0, 0, 1000, 1000});
+
+    TEST_ASSERT_EQUAL_INT32(50, pid.update(100));
+    TEST_ASSERT_EQUAL_INT32(-50, pid.update(-100));
+}
+
+// 2. Errors inside the deadband produce no motion
+void test_deadband_holds_still(void)
+{
+    PidController pid({ONE_Q16, 0, 0, 8, 1000, 1000});
+
+    TEST_ASSERT_EQUAL_INT32(0, pid.update(8));
+    TEST_ASSERT_EQUAL_INT32(0, pid.update(-3));
+    TEST_ASSERT_EQUAL_INT32(9, pid.update(9));
+}
+
+// 3. The integral stops growing while the output is saturated
+void test_anti_windup(void)
+{
+    PidController pid({0, ONE_Q16, 0, 0, 1000, 10});
+
+    // Each update would add 50 to the integral, but the output is pinned at 10
+    for (int i = 0; i < 20; i++)
+    {
+        TEST_ASSERT_EQUAL_INT32(10, pid.update(50));
+    }
+
+    // One opposite error must be able to leave saturation immediately
+    TEST_ASSERT_TRUE(pid.update(-50) <= 0);
+}
+
+// 4. The QVGA profile removes most of a pan error in one update
+void test_qvga_profile_scale(void)
+{
+    const PidProfile& profile = pid_profile_for_frame(320);
+    TEST_ASSERT_EQUAL_UINT16(320, profile.frame_width);
+    TEST_ASSERT_EQUAL_PTR(&profile, &pid_profile_for_frame(0));
+    TEST_ASSERT_EQUAL_UINT16(640, pid_profile_for_frame(600).frame_width);
+
+    PidController pan({profile.pan.kp_q16, 0, 0, profile.pan.deadband, 1, 1000});
+
+    // 100 px right of centre is ~16.5 degrees, ~94 steps; 70% of that in one move
+    int32_t steps = pan.update(100 << DETECTION_SUBPIXEL_BITS);
+    TEST_ASSERT_INT32_WITHIN(3, 66, steps);
+}
+
+void setup()
+{
+    delay(2000); // Wait for hardware to stabilize
+    UNITY_BEGIN();
+
+    RUN_TEST(test_proportional_only);
+    RUN_TEST(test_deadband_holds_still);
+    RUN_TEST(test_anti_windup);
+    RUN_TEST(test_qvga_profile_scale);
+
+    UNITY_END();
+}
+
+void loop() {}
@@ -0,0 +1,181 @@
+import sys
+import json
+import struct
+from pathlib import Path
+
+# Layout of include/trace.h: TraceDumpHeader, then TraceEvent records to the end
+HEADER_FORMAT = "<IHHIIQ"
+EVENT_FORMAT = "<IHBBII"
+TRACE_DUMP_MAGIC = 0x31435254
+TRACE_DUMP_VERSION = 1
+
+# Markers around the hex dump the firmware prints for the 't' serial command
+SERIAL_DUMP_BEGIN = "[Trace] BEGIN"
+SERIAL_DUMP_END = "[Trace] END"
+
+PHASE_COMPLETE = 0
+PHASE_INSTANT = 1
+PHASE_COUNTER = 2
+
+# Mirrors the TraceId enum in include/trace.h
+EVENT_NAMES = {
+    0: "capture",
+    1: "decode",
+    2: "greyscale",
+    3: "kernel",
+    4: "centroid",
+    5: "control",
+    6: "actuation",
+    16: "loop iteration",
+    17: "loop deadline miss",
+    18: "detect",
+    32: "frame publish",
+    33: "frame dropped",
+    34: "stream frame",
+    35: "frames in use",
+    48: "wifi check",
+}
+
+
+def extract_serial_dump(data: bytes) -> bytes:
+    """
+    Pull the binary dump out of a saved serial log, if that is what was given.
+
+    Args:
+        data: A binary dump from /trace, or a serial log holding one or more hex dumps.
+
+    Returns:
+        The bytes of the last dump in the log, or data itself when it holds no serial dump.
+    """
+    # A binary dump from /trace starts with its magic number
+    if data[:4] == struct.pack("<I", TRACE_DUMP_MAGIC):
+        return data
+
+    text = data.decode("ascii", errors="ignore")
+    start = text.rfind(SERIAL_DUMP_BEGIN)
+    if start < 0:
+        return data
+
+    dump = bytearray()
+    for line in text[start:].splitlines()[1:]:
+        line = line.strip()
+        if line.startswith(SERIAL_DUMP_END):
+            break
+        # Other tasks keep logging during the dump; their lines are not hex
+        try:
+            dump += bytes.fromhex(line)
+        except ValueError:
+            continue
+    return bytes(dump)
+
+
+def parse_dump(data: bytes) -> tuple:
+    """
+    Split a binary trace dump into its header and events.
+
+    Args:
+        data: Bytes returned by the turret's /trace endpoint, or taken from a serial log.
+
+    Returns:
+        A (header, events) tuple: header is a dict, events a list of dicts.
+    """
+    header_size = struct.calcsize(HEADER_FORMAT)
+    if len(data) < header_size:
+        raise Exception("Dump is shorter than its header")
+
+    magic, version, event_size, ring_size, overwritten, now_us = struct.unpack_from(HEADER_FORMAT, data)
+    if magic != TRACE_DUMP_MAGIC:
+        raise Exception(f"Not a trace dump (magic 0x{magic:08X})")
+    if version != TRACE_DUMP_VERSION or event_size != struct.calcsize(EVENT_FORMAT):
+        raise Exception(f"Unsupported dump version {version} with {event_size} byte events")
+
+    header = {"ring_size": ring_size, "overwritten": overwritten, "now_us": now_us}
+
+    # A dump cut short by the connection ends in a partial record; drop it
+    events = []
+    for offset in range(header_size, len(data) - event_size + 1, event_size):
+        timestamp, event_id, phase, core, arg0, arg1 = struct.unpack_from(EVENT_FORMAT, data, offset)
+        events.append({"ts": unwrap_timestamp(timestamp, now_us), "id": event_id, "phase": phase,
+                       "core": core, "arg0": arg0, "arg1": arg1})
+
+    return header, events
+
+
+def unwrap_timestamp(timestamp: int, now_us: int) -> int:
+    """
+    Turn a 32-bit event timestamp back into full microseconds since boot.
+
+    Events are recorded with the low 32 bits of esp_timer_get_time(), which wrap
+    every 71 minutes; every event held in the ring is younger than that.
+
+    Args:
+        timestamp: Low 32 bits of the event time.
+        now_us: Full time at the dump.
+
+    Returns:
+        The event time in microseconds since boot.
+    """
+    return now_us - (((now_us & 0xFFFFFFFF) - timestamp) & 0xFFFFFFFF)
+
+
+def to_chrome_trace(events: list) -> dict:
+    """
+    Convert decoded events into the Chrome trace event format.
+
+    Each core becomes a thread of one process, so the viewer shows a track per core.
+
+    Args:
+        events: Events from parse_dump().
+
+    Returns:
+        A dict ready to be written as JSON for chrome://tracing or ui.perfetto.dev.
+    """
+    trace_events = []
+    for core in sorted({event["core"] for event in events}):
+        trace_events.append({"name": "thread_name", "ph": "M", "pid": 0, "tid": core,
+                             "args": {"name": f"core {core}"}})
+
+    for event in sorted(events, key=lambda e: e["ts"]):
+        name = EVENT_NAMES.get(event["id"], f"event {event['id']}")
+        entry = {"name": name, "pid": 0, "tid": event["core"], "ts": event["ts"]}
+
+        if event["phase"] == PHASE_COMPLETE:
+            entry.update({"ph": "X", "dur": event["arg0"], "args": {"arg": event["arg1"]}})
+        elif event["phase"] == PHASE_COUNTER:
+            entry.update({"ph": "C", "args": {"value": event["arg0"]}})
+        else:
+            entry.update({"ph": "i", "s": "t", "args": {"arg0": event["arg0"], "arg1": event["arg1"]}})
+
+        trace_events.append(entry)
+
+    return {"traceEvents": trace_events, "displayTimeUnit": "ms"}
+
+
+def main(args):
+    # Input validation
+    if not args or len(args) < 1:
+        print("Usage: python trace_to_chrome.py <turret.trace | serial.log> [output.json]")
+        print("Output file defaults to the input name with a .json suffix (e.g., turret.trace -> turret.json)")
+        sys.exit(1)
+
+    dump_path = Path(args[0]).expanduser().resolve()
+    output_path = Path(args[1]).expanduser().resolve() if len(args) > 1 else dump_path.with_suffix(".json")
+
+    try:
+        header, events = parse_dump(extract_serial_dump(dump_path.read_bytes()))
+
+        with output_path.open('w', encoding='utf-8') as f:
+            json.dump(to_chrome_trace(events), f)
+
+        print(f"Converted {len(events)} events to: {output_path}")
+        if header["overwritten"]:
+            print(f"{header['overwritten']} older events were overwritten before the dump")
+
+    except FileNotFoundError:
+        print(f"\nThe file \"{dump_path}\" was not found.")
+    except Exception as e:
+        print(f"An error has occured during processing: {e}")
+
+
+if __name__ == "__main__":
+    main(sys.argv[1:])